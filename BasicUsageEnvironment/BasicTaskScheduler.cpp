@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "BasicUsageEnvironment.hh"
 #include "HandlerSet.hh"
+#include "EventLoopWorkQueue.hh"
 #include <stdio.h>
 #if defined(_QNX4)
 #include <sys/select.h>
@@ -87,7 +88,22 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
     tv_timeToDelay.tv_usec = maxDelayTime%MILLION;
   }
 
-  int selectResult = select(fMaxNumSockets, &readSet, &writeSet, &exceptionSet, &tv_timeToDelay);
+  // Also wait for work to be posted (by "postWork()"), unless there's already some work waiting to be handled:
+  int numSockets = fMaxNumSockets;
+  int const wakeupSocketNum = fWorkQueue->wakeupSocketNum();
+  if (wakeupSocketNum >= 0
+#if !defined(__WIN32__) && !defined(_WIN32) && defined(FD_SETSIZE)
+      && wakeupSocketNum < (int)(FD_SETSIZE)
+#endif
+      ) {
+    FD_SET((unsigned)wakeupSocketNum, &readSet);
+    if (wakeupSocketNum+1 > numSockets) numSockets = wakeupSocketNum+1;
+  }
+  if (!fWorkQueue->isEmpty()) {
+    tv_timeToDelay.tv_sec = tv_timeToDelay.tv_usec = 0;
+  }
+
+  int selectResult = select(numSockets, &readSet, &writeSet, &exceptionSet, &tv_timeToDelay);
   if (selectResult < 0) {
 #if defined(__WIN32__) || defined(_WIN32)
     int err = WSAGetLastError();
@@ -126,6 +142,10 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
       }
   }
 
+  if (selectResult > 0 && wakeupSocketNum >= 0 && FD_ISSET(wakeupSocketNum, &readSet)) {
+    fWorkQueue->noteWakeup();
+  }
+
   // Call the handler function for one readable socket:
   HandlerIterator iter(*fHandlers);
   HandlerDescriptor* handler;
@@ -150,7 +170,7 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
       fLastHandledSocketNum = sock;
           // Note: we set "fLastHandledSocketNum" before calling the handler,
           // in case the handler calls "doEventLoop()" reentrantly.
-      (*handler->handlerProc)(handler->clientData, resultConditionSet);
+      callSocketHandler(handler->handlerProc, handler->clientData, resultConditionSet);
       break;
     }
   }
@@ -168,7 +188,7 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
 	fLastHandledSocketNum = sock;
 	    // Note: we set "fLastHandledSocketNum" before calling the handler,
             // in case the handler calls "doEventLoop()" reentrantly.
-	(*handler->handlerProc)(handler->clientData, resultConditionSet);
+	callSocketHandler(handler->handlerProc, handler->clientData, resultConditionSet);
 	break;
       }
     }
@@ -197,7 +217,7 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
 	fTriggersAwaitingHandling[i] = False;
 #endif
 	if (fTriggeredEventHandlers[i] != NULL) {
-	  (*fTriggeredEventHandlers[i])(fTriggeredEventClientDatas[i]);
+	  callEventTriggerHandler(i);
 	}
 
 	fLastUsedTriggerMask = mask;
@@ -207,8 +227,14 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
     } while (i != fLastUsedTriggerNum);
   }
 
+  // Also handle any work that was posted (from this or other threads) using "postWork()":
+  handlePostedWork();
+
   // Also handle any delayed event that may have come due.
   fDelayQueue.handleAlarm();
+
+  // Finally, if profiling is enabled, report the profile if we've been asked to (via a signal):
+  checkForProfileReportRequest();
 }
 
 void BasicTaskScheduler
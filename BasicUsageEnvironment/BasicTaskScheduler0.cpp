@@ -19,6 +19,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "BasicUsageEnvironment0.hh"
 #include "HandlerSet.hh"
+#include "EventLoopProfiler.hh"
+#include "EventLoopWorkQueue.hh"
+#include <signal.h>
 
 ////////// A subclass of DelayQueueEntry,
 //////////     used to implement BasicTaskScheduler0::scheduleDelayedTask()
@@ -40,13 +43,52 @@ private:
   void* fClientData;
 };
 
+////////// A variant of "AlarmHandler" that's used (instead) when profiling is enabled.
+////////// It records how late the task was dispatched (relative to its scheduled time), and how long it took.
+
+class ProfiledAlarmHandler: public DelayQueueEntry {
+public:
+  ProfiledAlarmHandler(BasicTaskScheduler0& scheduler,
+		       TaskFunc* proc, void* clientData, DelayInterval timeToDelay, intptr_t token)
+    : DelayQueueEntry(timeToDelay, token), fScheduler(scheduler), fProc(proc), fClientData(clientData) {
+    EventLoopProfiler::timeNow(fDueTime);
+    fDueTime.tv_sec += timeToDelay.seconds();
+    fDueTime.tv_usec += timeToDelay.useconds();
+    if (fDueTime.tv_usec >= 1000000) {
+      fDueTime.tv_sec += fDueTime.tv_usec/1000000;
+      fDueTime.tv_usec %= 1000000;
+    }
+  }
+
+private: // redefined virtual functions
+  virtual void handleTimeout() {
+    EventLoopProfiler* profiler = fScheduler.fProfiler; // in case profiling has been disabled since we were created
+    if (profiler == NULL) {
+      (*fProc)(fClientData);
+    } else {
+      struct timeval startTime;
+      profiler->noteLag(CALLBACK_DELAYED_TASK, EventLoopProfiler::uSecondsSince(fDueTime, startTime));
+      (*fProc)(fClientData);
+      profiler->noteCallback(CALLBACK_DELAYED_TASK, (void const*)fProc, startTime);
+    }
+    DelayQueueEntry::handleTimeout();
+  }
+
+private:
+  BasicTaskScheduler0& fScheduler;
+  TaskFunc* fProc;
+  void* fClientData;
+  struct timeval fDueTime;
+};
+
 
 ////////// BasicTaskScheduler0 //////////
 
 BasicTaskScheduler0::BasicTaskScheduler0()
   : fTokenCounter(0), fLastHandledSocketNum(-1),
     fLastUsedTriggerMask(1), fLastUsedTriggerNum(MAX_NUM_EVENT_TRIGGERS-1),
-    fEventTriggersAreBeingUsed(False) {
+    fEventTriggersAreBeingUsed(False), fWorkQueue(new EventLoopWorkQueue),
+    fProfiler(NULL), fProfilerStorage(NULL), fProfileReportEnv(NULL) {
   fHandlers = new HandlerSet;
   for (unsigned i = 0; i < MAX_NUM_EVENT_TRIGGERS; ++i) {
 #ifndef NO_STD_LIB
@@ -56,11 +98,14 @@ BasicTaskScheduler0::BasicTaskScheduler0()
 #endif
     fTriggeredEventHandlers[i] = NULL;
     fTriggeredEventClientDatas[i] = NULL;
+    fTriggerTimes[i].tv_sec = fTriggerTimes[i].tv_usec = 0;
   }
 }
 
 BasicTaskScheduler0::~BasicTaskScheduler0() {
   delete fHandlers;
+  delete fWorkQueue;
+  delete fProfilerStorage;
 }
 
 TaskToken BasicTaskScheduler0::scheduleDelayedTask(int64_t microseconds,
@@ -68,7 +113,9 @@ TaskToken BasicTaskScheduler0::scheduleDelayedTask(int64_t microseconds,
 						   void* clientData) {
   if (microseconds < 0) microseconds = 0;
   DelayInterval timeToDelay((long)(microseconds/1000000), (long)(microseconds%1000000));
-  AlarmHandler* alarmHandler = new AlarmHandler(proc, clientData, timeToDelay, ++fTokenCounter);
+  DelayQueueEntry* alarmHandler = fProfiler == NULL
+    ? (DelayQueueEntry*)(new AlarmHandler(proc, clientData, timeToDelay, ++fTokenCounter))
+    : (DelayQueueEntry*)(new ProfiledAlarmHandler(*this, proc, clientData, timeToDelay, ++fTokenCounter));
   fDelayQueue.addEntry(alarmHandler);
 
   return (void*)(alarmHandler->token());
@@ -144,6 +191,11 @@ void BasicTaskScheduler0::triggerEvent(EventTriggerId eventTriggerId, void* clie
   for (unsigned i = 0; i < MAX_NUM_EVENT_TRIGGERS; ++i) {
     if ((eventTriggerId&mask) != 0) {
       fTriggeredEventClientDatas[i] = clientData;
+      if (fProfiler != NULL) {
+	EventLoopProfiler::timeNow(fTriggerTimes[i]);
+      } else {
+	fTriggerTimes[i].tv_sec = fTriggerTimes[i].tv_usec = 0;
+      }
 #ifndef NO_STD_LIB
       (void)fTriggersAwaitingHandling[i].test_and_set();
 #else
@@ -154,6 +206,109 @@ void BasicTaskScheduler0::triggerEvent(EventTriggerId eventTriggerId, void* clie
   }
 }
 
+Boolean BasicTaskScheduler0::postWork(TaskFunc* proc, void* clientData) {
+  if (proc == NULL) return False;
+  if (fProfiler == NULL) return fWorkQueue->post(proc, clientData);
+
+  struct timeval postTime;
+  EventLoopProfiler::timeNow(postTime);
+  return fWorkQueue->post(proc, clientData, &postTime);
+}
+
+void BasicTaskScheduler0::handlePostedWork() {
+  // Note that we handle at most EVENT_LOOP_WORK_QUEUE_MAX_BATCH_SIZE items at a time, so that a burst of posted work
+  // can't starve socket handlers and delayed tasks.  Any remaining items get handled next time.
+  TaskFunc* proc; void* clientData; struct timeval postTime;
+  for (unsigned i = 0; i < EVENT_LOOP_WORK_QUEUE_MAX_BATCH_SIZE; ++i) {
+    if (!fWorkQueue->getNextItem(proc, clientData, postTime)) break;
+    if (fProfiler == NULL) {
+      (*proc)(clientData);
+    } else {
+      callProfiledTaskFunc(CALLBACK_POSTED_WORK, proc, clientData, postTime);
+    }
+  }
+}
+
+
+Boolean BasicTaskScheduler0::enableProfiling(Boolean enable) {
+  if (enable) {
+    if (fProfilerStorage == NULL) {
+      fProfilerStorage = new EventLoopProfiler;
+    } else {
+      fProfilerStorage->reset();
+    }
+    fProfiler = fProfilerStorage;
+  } else {
+    fProfiler = NULL; // but keep "fProfilerStorage", because pending "ProfiledAlarmHandler"s may still refer to us
+  }
+
+  return True;
+}
+
+void BasicTaskScheduler0::reportProfile(UsageEnvironment& env, unsigned maxNumCallbackSites) {
+  if (fProfilerStorage == NULL) {
+    env << "Event loop profiling has not been enabled\n";
+    return;
+  }
+  fProfilerStorage->report(env, maxNumCallbackSites);
+}
+
+static sig_atomic_t volatile profileReportRequested = 0;
+
+static void profileReportSignalHandler(int signalNum) {
+  profileReportRequested = 1;
+  signal(signalNum, profileReportSignalHandler); // in case the signal handler gets reset when called
+}
+
+void BasicTaskScheduler0::reportProfileOnSignal(UsageEnvironment& env, int signalNum) {
+  fProfileReportEnv = &env;
+  signal(signalNum, profileReportSignalHandler);
+}
+
+void BasicTaskScheduler0
+::callSocketHandler(BackgroundHandlerProc* handlerProc, void* clientData, int resultConditionSet) {
+  if (fProfiler == NULL) {
+    (*handlerProc)(clientData, resultConditionSet);
+  } else {
+    EventLoopProfiler* profiler = fProfiler; // in case the handler changes "fProfiler"
+    struct timeval startTime;
+    EventLoopProfiler::timeNow(startTime);
+    (*handlerProc)(clientData, resultConditionSet);
+    profiler->noteCallback(CALLBACK_SOCKET_HANDLER, (void const*)handlerProc, startTime);
+  }
+}
+
+void BasicTaskScheduler0::callEventTriggerHandler(unsigned triggerNum) {
+  TaskFunc* handlerProc = fTriggeredEventHandlers[triggerNum];
+  void* clientData = fTriggeredEventClientDatas[triggerNum];
+  if (fProfiler == NULL) {
+    (*handlerProc)(clientData);
+  } else {
+    callProfiledTaskFunc(CALLBACK_EVENT_TRIGGER, handlerProc, clientData, fTriggerTimes[triggerNum]);
+  }
+}
+
+void BasicTaskScheduler0
+::callProfiledTaskFunc(int kind, TaskFunc* proc, void* clientData, struct timeval const& readyTime) {
+  EventLoopProfiler* profiler = fProfiler; // in case "proc" changes "fProfiler"
+  struct timeval startTime;
+  if (readyTime.tv_sec == 0 && readyTime.tv_usec == 0) {
+    // We don't know when this call was requested (because profiling was enabled only since then):
+    EventLoopProfiler::timeNow(startTime);
+  } else {
+    profiler->noteLag((EventLoopCallbackKind)kind, EventLoopProfiler::uSecondsSince(readyTime, startTime));
+  }
+  (*proc)(clientData);
+  profiler->noteCallback((EventLoopCallbackKind)kind, (void const*)proc, startTime);
+}
+
+void BasicTaskScheduler0::checkForProfileReportRequest() {
+  if (profileReportRequested && fProfileReportEnv != NULL) {
+    profileReportRequested = 0;
+    reportProfile(*fProfileReportEnv);
+  }
+}
+
 
 ////////// HandlerSet (etc.) implementation //////////
 
@@ -0,0 +1,203 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// Basic Usage Environment: for a simple, non-scripted, console application
+// Optional profiling of the callbacks (socket handlers, delayed tasks, event trigger handlers, and posted work)
+// that are dispatched from the event loop.
+// Implementation
+
+#include "EventLoopProfiler.hh"
+#include "GroupsockHelper.hh" // for "gettimeofday()"
+#include <stdio.h>
+
+////////// CallbackSiteStats (the statistics that we record for each callback site) //////////
+
+class CallbackSiteStats {
+public:
+  CallbackSiteStats(EventLoopCallbackKind kind, void const* proc);
+
+  void noteCallback(unsigned uSeconds);
+
+public:
+  EventLoopCallbackKind fKind;
+  void const* fProc;
+  u_int64_t fNumCalls;
+  u_int64_t fTotalTime, fMaxTime; // microseconds
+  u_int64_t fCounts[EVENT_LOOP_PROFILER_NUM_BUCKETS];
+};
+
+CallbackSiteStats::CallbackSiteStats(EventLoopCallbackKind kind, void const* proc)
+  : fKind(kind), fProc(proc), fNumCalls(0), fTotalTime(0), fMaxTime(0) {
+  for (unsigned i = 0; i < EVENT_LOOP_PROFILER_NUM_BUCKETS; ++i) fCounts[i] = 0;
+}
+
+void CallbackSiteStats::noteCallback(unsigned uSeconds) {
+  ++fNumCalls;
+  fTotalTime += uSeconds;
+  if (uSeconds > fMaxTime) fMaxTime = uSeconds;
+  ++fCounts[EventLoopProfiler::bucketIndex(uSeconds)];
+}
+
+
+////////// EventLoopProfiler implementation //////////
+
+EventLoopProfiler::EventLoopProfiler()
+  : fCallbackSites(HashTable::create(ONE_WORD_HASH_KEYS)) {
+  reset();
+}
+
+EventLoopProfiler::~EventLoopProfiler() {
+  CallbackSiteStats* stats;
+  while ((stats = (CallbackSiteStats*)fCallbackSites->RemoveNext()) != NULL) {
+    delete stats;
+  }
+  delete fCallbackSites;
+}
+
+void EventLoopProfiler::timeNow(struct timeval& tv) {
+  gettimeofday(&tv, NULL);
+}
+
+unsigned EventLoopProfiler::bucketIndex(unsigned uSeconds) {
+  unsigned i = 0;
+  unsigned limit = 10;
+  while (i < EVENT_LOOP_PROFILER_NUM_BUCKETS-1 && uSeconds >= limit) {
+    ++i;
+    limit *= 10;
+  }
+  return i;
+}
+
+int64_t EventLoopProfiler::uSecondsSince(struct timeval const& startTime, struct timeval& timeNow) {
+  gettimeofday(&timeNow, NULL);
+  return (timeNow.tv_sec - startTime.tv_sec)*(int64_t)1000000 + (timeNow.tv_usec - startTime.tv_usec);
+}
+
+void EventLoopProfiler
+::noteCallback(EventLoopCallbackKind kind, void const* proc, struct timeval const& startTime) {
+  struct timeval timeNow;
+  int64_t uSeconds = uSecondsSince(startTime, timeNow);
+  if (uSeconds < 0) uSeconds = 0; // the clock went backwards
+  else if (uSeconds > 0xFFFFFFFF) uSeconds = 0xFFFFFFFF;
+
+  CallbackSiteStats* stats = (CallbackSiteStats*)(fCallbackSites->Lookup((char const*)proc));
+  if (stats == NULL) {
+    stats = new CallbackSiteStats(kind, proc);
+    fCallbackSites->Add((char const*)proc, stats);
+  }
+  stats->noteCallback((unsigned)uSeconds);
+}
+
+void EventLoopProfiler::noteLag(EventLoopCallbackKind kind, int64_t uSecondsLate) {
+  if (uSecondsLate < 0) uSecondsLate = 0;
+  else if (uSecondsLate > 0xFFFFFFFF) uSecondsLate = 0xFFFFFFFF;
+
+  ++fLagCounts[kind][bucketIndex((unsigned)uSecondsLate)];
+  ++fNumLagSamples[kind];
+  fTotalLag[kind] += uSecondsLate;
+  if ((u_int64_t)uSecondsLate > fMaxLag[kind]) fMaxLag[kind] = uSecondsLate;
+}
+
+static char const* const kindNames[EVENT_LOOP_PROFILER_NUM_CALLBACK_KINDS] = { "socket", "task", "trigger", "work" };
+static char const* const lagNames[EVENT_LOOP_PROFILER_NUM_CALLBACK_KINDS]
+  = { NULL/*not measured*/, "Delayed task lag (after the scheduled time)", "Event trigger lag (after \"triggerEvent()\")",
+      "Posted work lag (after \"postWork()\")" };
+static char const* const bucketNames[EVENT_LOOP_PROFILER_NUM_BUCKETS]
+  = { "<10us", "<100us", "<1ms", "<10ms", "<100ms", "<1s", ">=1s" };
+
+void EventLoopProfiler::report(UsageEnvironment& env, unsigned maxNumCallbackSites) {
+  char line[300];
+
+  struct timeval timeNow;
+  int64_t uSecondsProfiled = uSecondsSince(fStartTime, timeNow);
+  snprintf(line, sizeof line, "Event loop profile (over the past %.3f seconds):\n", uSecondsProfiled/1000000.0);
+  env << line;
+
+  // Collect all of the callback site records into an array, so that we can pick out the ones with the largest total time.
+  // (We expect only a modest number of distinct callback sites, so a simple selection sort is fine.)
+  unsigned const numSites = fCallbackSites->numEntries();
+  CallbackSiteStats** sites = new CallbackSiteStats*[numSites+1];
+  unsigned n = 0;
+  HashTable::Iterator* iter = HashTable::Iterator::create(*fCallbackSites);
+  char const* key; // dummy
+  CallbackSiteStats* stats;
+  while (n < numSites && (stats = (CallbackSiteStats*)(iter->next(key))) != NULL) sites[n++] = stats;
+  delete iter;
+
+  if (maxNumCallbackSites > n) maxNumCallbackSites = n;
+  snprintf(line, sizeof line, "  %-8s %-18s %10s %12s %9s %9s",
+	   "kind", "callback", "calls", "total(us)", "mean(us)", "max(us)");
+  env << line;
+  for (unsigned b = 0; b < EVENT_LOOP_PROFILER_NUM_BUCKETS; ++b) {
+    snprintf(line, sizeof line, " %8s", bucketNames[b]);
+    env << line;
+  }
+  env << "\n";
+
+  for (unsigned i = 0; i < maxNumCallbackSites; ++i) {
+    // Move the remaining site with the largest total time into position "i":
+    unsigned best = i;
+    for (unsigned j = i+1; j < n; ++j) {
+      if (sites[j]->fTotalTime > sites[best]->fTotalTime) best = j;
+    }
+    stats = sites[best]; sites[best] = sites[i]; sites[i] = stats;
+
+    snprintf(line, sizeof line, "  %-8s %-18p %10llu %12llu %9llu %9llu",
+	     kindNames[stats->fKind], stats->fProc,
+	     (unsigned long long)stats->fNumCalls, (unsigned long long)stats->fTotalTime,
+	     (unsigned long long)(stats->fTotalTime/stats->fNumCalls), (unsigned long long)stats->fMaxTime);
+    env << line;
+    for (unsigned b = 0; b < EVENT_LOOP_PROFILER_NUM_BUCKETS; ++b) {
+      snprintf(line, sizeof line, " %8llu", (unsigned long long)stats->fCounts[b]);
+      env << line;
+    }
+    env << "\n";
+  }
+  if (n > maxNumCallbackSites) {
+    snprintf(line, sizeof line, "  (%u other callback sites not shown)\n", n - maxNumCallbackSites);
+    env << line;
+  }
+  delete[] sites;
+
+  for (unsigned k = 0; k < EVENT_LOOP_PROFILER_NUM_CALLBACK_KINDS; ++k) {
+    if (lagNames[k] == NULL) continue;
+
+    snprintf(line, sizeof line, "  %s: %llu calls; mean %llu us; max %llu us;", lagNames[k],
+	     (unsigned long long)fNumLagSamples[k],
+	     (unsigned long long)(fNumLagSamples[k] == 0 ? 0 : fTotalLag[k]/fNumLagSamples[k]),
+	     (unsigned long long)fMaxLag[k]);
+    env << line;
+    for (unsigned b = 0; b < EVENT_LOOP_PROFILER_NUM_BUCKETS; ++b) {
+      snprintf(line, sizeof line, " %s:%llu", bucketNames[b], (unsigned long long)fLagCounts[k][b]);
+      env << line;
+    }
+    env << "\n";
+  }
+  env << "  (Socket handlers' lag is not measured.)\n";
+}
+
+void EventLoopProfiler::reset() {
+  CallbackSiteStats* stats;
+  while ((stats = (CallbackSiteStats*)fCallbackSites->RemoveNext()) != NULL) {
+    delete stats;
+  }
+
+  for (unsigned k = 0; k < EVENT_LOOP_PROFILER_NUM_CALLBACK_KINDS; ++k) {
+    for (unsigned i = 0; i < EVENT_LOOP_PROFILER_NUM_BUCKETS; ++i) fLagCounts[k][i] = 0;
+    fNumLagSamples[k] = fTotalLag[k] = fMaxLag[k] = 0;
+  }
+  gettimeofday(&fStartTime, NULL);
+}
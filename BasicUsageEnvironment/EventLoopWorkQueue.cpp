@@ -0,0 +1,174 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// Basic Usage Environment: for a simple, non-scripted, console application
+// A lock-free, multiple-producer, single-consumer queue of work items (each a (function, client data) pair), used to
+// implement "TaskScheduler::postWork()".  Any thread may post items; they are executed (in batches) by the event loop.
+// Implementation
+
+#include "EventLoopWorkQueue.hh"
+#if !defined(__WIN32__) && !defined(_WIN32)
+#include <unistd.h>
+#include <fcntl.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#define USE_EVENTFD 1
+#endif
+#endif
+
+// The queue is the well-known 'intrusive MPSC queue' (due to Dmitry Vyukov): Producers atomically exchange the 'tail'
+// pointer with their new item, then link the previous tail to it.  The (single) consumer follows 'next' links from a
+// 'stub' item at the head.  Posting never blocks, and never waits for other producers or for the consumer.
+// (Without the standard library, we use the GCC/Clang atomic builtins instead of "std::atomic".)
+
+class EventLoopWorkItem {
+public:
+  EventLoopWorkItem(TaskFunc* proc, void* clientData, struct timeval const* postTime)
+    : fProc(proc), fClientData(clientData) {
+    if (postTime != NULL) {
+      fPostTime = *postTime;
+    } else {
+      fPostTime.tv_sec = fPostTime.tv_usec = 0;
+    }
+#ifndef NO_STD_LIB
+    fNext.store(NULL, std::memory_order_relaxed);
+#else
+    fNext = NULL;
+#endif
+  }
+
+  TaskFunc* fProc;
+  void* fClientData;
+  struct timeval fPostTime;
+#ifndef NO_STD_LIB
+  std::atomic<EventLoopWorkItem*> fNext;
+#else
+  EventLoopWorkItem* volatile fNext;
+#endif
+};
+
+static EventLoopWorkItem* loadNext(EventLoopWorkItem* item) {
+#ifndef NO_STD_LIB
+  return item->fNext.load(std::memory_order_acquire);
+#else
+  return __atomic_load_n(&item->fNext, __ATOMIC_ACQUIRE);
+#endif
+}
+
+EventLoopWorkQueue::EventLoopWorkQueue()
+  : fWakeupReadFd(-1), fWakeupWriteFd(-1) {
+  fHead = new EventLoopWorkItem(NULL, NULL, NULL); // the initial 'stub'
+#ifndef NO_STD_LIB
+  fTail.store(fHead);
+  fWakeupIsPending.clear();
+#else
+  fTail = fHead;
+  fWakeupIsPending = 0;
+#endif
+
+#ifdef USE_EVENTFD
+  fWakeupReadFd = fWakeupWriteFd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+#elif !defined(__WIN32__) && !defined(_WIN32)
+  int fds[2];
+  if (pipe(fds) == 0) {
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0)|O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL, 0)|O_NONBLOCK);
+    fWakeupReadFd = fds[0]; fWakeupWriteFd = fds[1];
+  }
+#endif
+}
+
+EventLoopWorkQueue::~EventLoopWorkQueue() {
+  // Delete the stub, and any items that were never handled:
+  while (fHead != NULL) {
+    EventLoopWorkItem* next = loadNext(fHead);
+    delete fHead;
+    fHead = next;
+  }
+
+#if !defined(__WIN32__) && !defined(_WIN32)
+  if (fWakeupReadFd >= 0) close(fWakeupReadFd);
+  if (fWakeupWriteFd >= 0 && fWakeupWriteFd != fWakeupReadFd) close(fWakeupWriteFd);
+#endif
+}
+
+Boolean EventLoopWorkQueue::post(TaskFunc* proc, void* clientData, struct timeval const* postTime) {
+  EventLoopWorkItem* item = new EventLoopWorkItem(proc, clientData, postTime);
+  if (item == NULL) return False;
+
+  // Make "item" the new tail, then link the previous tail to it:
+#ifndef NO_STD_LIB
+  EventLoopWorkItem* prev = fTail.exchange(item, std::memory_order_acq_rel);
+  prev->fNext.store(item, std::memory_order_release);
+
+  if (!fWakeupIsPending.test_and_set(std::memory_order_acq_rel)) signalWakeup();
+#else
+  EventLoopWorkItem* prev = __atomic_exchange_n(&fTail, item, __ATOMIC_ACQ_REL);
+  __atomic_store_n(&prev->fNext, item, __ATOMIC_RELEASE);
+
+  if (!__atomic_test_and_set(&fWakeupIsPending, __ATOMIC_ACQ_REL)) signalWakeup();
+#endif
+
+  return True;
+}
+
+Boolean EventLoopWorkQueue::isEmpty() const {
+  return loadNext(fHead) == NULL;
+}
+
+Boolean EventLoopWorkQueue::getNextItem(TaskFunc*& proc, void*& clientData, struct timeval& postTime) {
+  EventLoopWorkItem* next = loadNext(fHead);
+  if (next == NULL) return False;
+      // Note: This can also happen (briefly) if a producer has exchanged the tail, but not yet linked it.
+      // In that case, the item will be seen next time.
+
+  // "next" becomes the new stub; the old stub is deleted:
+  proc = next->fProc;
+  clientData = next->fClientData;
+  postTime = next->fPostTime;
+  delete fHead;
+  fHead = next;
+
+  return True;
+}
+
+void EventLoopWorkQueue::noteWakeup() {
+  // Empty the wakeup descriptor, then allow producers to signal it again.  (We do this *before* dequeueing items, so
+  // that any item that's posted after this point will either be dequeued now, or will cause another wakeup.)
+#ifdef USE_EVENTFD
+  u_int64_t counter;
+  while (read(fWakeupReadFd, &counter, sizeof counter) > 0) {}
+#elif !defined(__WIN32__) && !defined(_WIN32)
+  char buf[64];
+  while (read(fWakeupReadFd, buf, sizeof buf) > 0) {}
+#endif
+
+#ifndef NO_STD_LIB
+  fWakeupIsPending.clear(std::memory_order_release);
+#else
+  __atomic_clear(&fWakeupIsPending, __ATOMIC_RELEASE);
+#endif
+}
+
+void EventLoopWorkQueue::signalWakeup() {
+#ifdef USE_EVENTFD
+  u_int64_t one = 1;
+  if (write(fWakeupWriteFd, &one, sizeof one) < 0) {} // ignore errors; the descriptor is already readable
+#elif !defined(__WIN32__) && !defined(_WIN32)
+  char c = 0;
+  if (fWakeupWriteFd >= 0 && write(fWakeupWriteFd, &c, 1) < 0) {} // ditto
+#endif
+}
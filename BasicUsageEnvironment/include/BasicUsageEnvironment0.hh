@@ -66,6 +66,8 @@ private:
 };
 
 class HandlerSet; // forward
+class EventLoopProfiler; // forward
+class EventLoopWorkQueue; // forward
 
 // Note: You may redefine MAX_NUM_EVENT_TRIGGERS,
 // but it must be <= the number of bits in an "EventTriggerId"
@@ -96,10 +98,27 @@ public:
   virtual EventTriggerId createEventTrigger(TaskFunc* eventHandlerProc);
   virtual void deleteEventTrigger(EventTriggerId eventTriggerId);
   virtual void triggerEvent(EventTriggerId eventTriggerId, void* clientData = NULL);
+  virtual Boolean postWork(TaskFunc* proc, void* clientData = NULL);
+
+  virtual Boolean enableProfiling(Boolean enable = True);
+  virtual void reportProfile(UsageEnvironment& env, unsigned maxNumCallbackSites = 10);
+  virtual void reportProfileOnSignal(UsageEnvironment& env, int signalNum);
 
 protected:
   BasicTaskScheduler0();
 
+  // Used (by subclasses' "SingleStep()" implementations) to call callbacks, profiling them if profiling is enabled:
+  void callSocketHandler(BackgroundHandlerProc* handlerProc, void* clientData, int resultConditionSet);
+  void callEventTriggerHandler(unsigned triggerNum);
+  void handlePostedWork();
+      // called once per "SingleStep()", to call (up to EVENT_LOOP_WORK_QUEUE_MAX_BATCH_SIZE) items posted by "postWork()"
+  void checkForProfileReportRequest();
+      // called once per "SingleStep()", to handle any request (via a signal) to report the profile
+
+private:
+  void callProfiledTaskFunc(int kind, TaskFunc* proc, void* clientData, struct timeval const& readyTime);
+      // "kind" is an "EventLoopCallbackKind"; "readyTime" is when the call was requested (or zero, if not known)
+
 protected:
   // To implement delayed operations:
   intptr_t fTokenCounter;
@@ -118,8 +137,18 @@ protected:
   u_int32_t fLastUsedTriggerMask; // implemented as a 32-bit bitmap
   TaskFunc* fTriggeredEventHandlers[MAX_NUM_EVENT_TRIGGERS];
   void* fTriggeredEventClientDatas[MAX_NUM_EVENT_TRIGGERS];
+  struct timeval fTriggerTimes[MAX_NUM_EVENT_TRIGGERS]; // when each event was triggered (recorded only if profiling)
   unsigned fLastUsedTriggerNum; // in the range [0,MAX_NUM_EVENT_TRIGGERS)
   Boolean fEventTriggersAreBeingUsed;
+
+  // To implement "postWork()":
+  EventLoopWorkQueue* fWorkQueue;
+
+  // To implement (optional) profiling:
+  friend class ProfiledAlarmHandler;
+  EventLoopProfiler* fProfiler; // non-NULL iff profiling is currently enabled
+  EventLoopProfiler* fProfilerStorage; // created when profiling is first enabled
+  UsageEnvironment* fProfileReportEnv; // non-NULL iff we report the profile when a signal is received
 };
 
 #endif
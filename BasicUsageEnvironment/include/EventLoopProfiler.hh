@@ -0,0 +1,75 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// Basic Usage Environment: for a simple, non-scripted, console application
+// Optional profiling of the callbacks (socket handlers, delayed tasks, event trigger handlers, and posted work)
+// that are dispatched from the event loop.
+// C++ header
+
+#ifndef _EVENT_LOOP_PROFILER_HH
+#define _EVENT_LOOP_PROFILER_HH
+
+#ifndef _USAGE_ENVIRONMENT_HH
+#include "UsageEnvironment.hh"
+#endif
+#ifndef _HASH_TABLE_HH
+#include "HashTable.hh"
+#endif
+
+#define EVENT_LOOP_PROFILER_NUM_BUCKETS 7
+    // Callback durations (and event loop lag) are recorded in the buckets:
+    // <10us, <100us, <1ms, <10ms, <100ms, <1s, >=1s
+
+typedef enum {
+  CALLBACK_SOCKET_HANDLER,
+  CALLBACK_DELAYED_TASK,
+  CALLBACK_EVENT_TRIGGER,
+  CALLBACK_POSTED_WORK
+} EventLoopCallbackKind;
+#define EVENT_LOOP_PROFILER_NUM_CALLBACK_KINDS 4
+
+class EventLoopProfiler {
+public:
+  EventLoopProfiler();
+  virtual ~EventLoopProfiler();
+
+  static void timeNow(struct timeval& tv);
+  static unsigned bucketIndex(unsigned uSeconds);
+  static int64_t uSecondsSince(struct timeval const& startTime, struct timeval& timeNow);
+      // also sets "timeNow" to the current time
+
+  void noteCallback(EventLoopCallbackKind kind, void const* proc, struct timeval const& startTime);
+      // Records a callback (to "proc") that began at "startTime", and has just returned.
+      // Callbacks are profiled by 'callback site' - i.e., by the function that was called - not by 'client data'.
+  void noteLag(EventLoopCallbackKind kind, int64_t uSecondsLate);
+      // Records how late a callback was dispatched: For a delayed task, after its scheduled time; for an event trigger
+      // handler, after "triggerEvent()" was called; for posted work, after "postWork()" was called.
+      // (Socket handlers have no lag that we can measure, because we don't know when their data arrived.)
+
+  void report(UsageEnvironment& env, unsigned maxNumCallbackSites);
+      // Outputs the callback sites that have taken the most total time, followed by event loop lag statistics
+  void reset();
+
+private:
+  HashTable* fCallbackSites; // maps callback function addresses to "CallbackSiteStats" records
+  // Lag statistics, for each kind of callback:
+  u_int64_t fLagCounts[EVENT_LOOP_PROFILER_NUM_CALLBACK_KINDS][EVENT_LOOP_PROFILER_NUM_BUCKETS];
+  u_int64_t fNumLagSamples[EVENT_LOOP_PROFILER_NUM_CALLBACK_KINDS];
+  u_int64_t fTotalLag[EVENT_LOOP_PROFILER_NUM_CALLBACK_KINDS], fMaxLag[EVENT_LOOP_PROFILER_NUM_CALLBACK_KINDS]; // us
+  struct timeval fStartTime; // when we were created (or last reset)
+};
+
+#endif
@@ -0,0 +1,74 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// Basic Usage Environment: for a simple, non-scripted, console application
+// A lock-free, multiple-producer, single-consumer queue of work items (each a (function, client data) pair), used to
+// implement "TaskScheduler::postWork()".  Any thread may post items; they are executed (in batches) by the event loop.
+// C++ header
+
+#ifndef _EVENT_LOOP_WORK_QUEUE_HH
+#define _EVENT_LOOP_WORK_QUEUE_HH
+
+#ifndef _USAGE_ENVIRONMENT_HH
+#include "UsageEnvironment.hh"
+#endif
+
+class EventLoopWorkItem; // forward
+
+#ifndef EVENT_LOOP_WORK_QUEUE_MAX_BATCH_SIZE
+#define EVENT_LOOP_WORK_QUEUE_MAX_BATCH_SIZE 256
+    // the maximum number of work items that we handle in each pass through the event loop
+    // (to ensure that socket handlers and delayed tasks still make progress)
+#endif
+
+class EventLoopWorkQueue {
+public:
+  EventLoopWorkQueue();
+  virtual ~EventLoopWorkQueue(); // any items still in the queue are discarded (without being called)
+
+  // Called from any thread:
+  Boolean post(TaskFunc* proc, void* clientData, struct timeval const* postTime = NULL);
+      // Returns False only if memory for the new item could not be allocated.
+      // "postTime" (if non-NULL) is recorded with the item (for profiling).
+
+  // Called only from the event loop thread:
+  int wakeupSocketNum() const { return fWakeupReadFd; }
+      // A file descriptor that becomes readable when items have been posted (and that should therefore be included in
+      // our "select()" call).  -1 if this platform has no such mechanism; in that case the queue is serviced only
+      // when the event loop next wakes up for some other reason (e.g., socket activity, or a delayed task).
+  Boolean isEmpty() const;
+  Boolean getNextItem(TaskFunc*& proc, void*& clientData, struct timeval& postTime);
+      // Dequeues the oldest item, returning its parameters.  Returns False iff the queue is (currently) empty.
+      // ("postTime" is zero if none was recorded.)
+  void noteWakeup();
+      // called when "wakeupSocketNum()" is readable, before items are dequeued
+
+private:
+  void signalWakeup();
+
+private:
+  EventLoopWorkItem* fHead; // accessed only by the consumer; always points to a 'stub' (already-consumed) item
+#ifndef NO_STD_LIB
+  std::atomic<EventLoopWorkItem*> fTail; // the most recently posted item
+  std::atomic_flag fWakeupIsPending;
+#else
+  EventLoopWorkItem* volatile fTail; // updated using the compiler's atomic builtins
+  char volatile fWakeupIsPending; // ditto
+#endif
+  int fWakeupReadFd, fWakeupWriteFd; // the same file descriptor if we're using "eventfd()"
+};
+
+#endif
@@ -49,6 +49,18 @@ void UsageEnvironment::internalError() {
   abort();
 }
 
+Boolean UsageEnvironment::enableEventLoopProfiling(Boolean enable) {
+  return fScheduler.enableProfiling(enable);
+}
+
+void UsageEnvironment::reportEventLoopProfile(unsigned maxNumCallbackSites) {
+  fScheduler.reportProfile(*this, maxNumCallbackSites);
+}
+
+void UsageEnvironment::reportEventLoopProfileOnSignal(int signalNum) {
+  fScheduler.reportProfileOnSignal(*this, signalNum);
+}
+
 
 TaskScheduler::TaskScheduler() {
 }
@@ -67,3 +79,18 @@ void TaskScheduler::rescheduleDelayedTask(TaskToken& task,
 void TaskScheduler::internalError() {
   abort();
 }
+
+Boolean TaskScheduler::postWork(TaskFunc* /*proc*/, void* /*clientData*/) {
+  return False; // by default, posting work is not supported
+}
+
+Boolean TaskScheduler::enableProfiling(Boolean /*enable*/) {
+  return False; // by default, profiling is not supported
+}
+
+void TaskScheduler::reportProfile(UsageEnvironment& env, unsigned /*maxNumCallbackSites*/) {
+  env << "Event loop profiling is not supported by this task scheduler\n";
+}
+
+void TaskScheduler::reportProfileOnSignal(UsageEnvironment& /*env*/, int /*signalNum*/) {
+}
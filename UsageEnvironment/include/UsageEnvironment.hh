@@ -82,6 +82,14 @@ public:
 
   virtual void internalError(); // used to 'handle' a 'should not occur'-type error condition within the library.
 
+  // event loop profiling (if supported by our task scheduler):
+  Boolean enableEventLoopProfiling(Boolean enable = True);
+  void reportEventLoopProfile(unsigned maxNumCallbackSites = 10);
+      // outputs the profile (using "operator<<()")
+  void reportEventLoopProfileOnSignal(int signalNum);
+      // arranges for "reportEventLoopProfile()" to be called (from within the event loop) whenever
+      // signal "signalNum" (e.g., SIGUSR1) is received
+
   // 'errno'
   virtual int getErrno() const = 0;
 
@@ -173,6 +181,12 @@ public:
       // it should not be called again with the same 'event trigger id' until after its event
       // has been handled.)
 
+  virtual Boolean postWork(TaskFunc* proc, void* clientData = NULL);
+      // Causes "proc(clientData)" to be called (once) from the event loop.  Like "triggerEvent()", this may be called
+      // from any thread, but - unlike "triggerEvent()" - it needs no previously-created trigger, and may be called any
+      // number of times (from any number of threads) before the work is handled; each call is handled separately, in order.
+      // Returns False if this is not supported by the scheduler (the default implementation).
+
   // The following two functions are deprecated, and are provided for backwards-compatibility only:
   void turnOnBackgroundReadHandling(int socketNum, BackgroundHandlerProc* handlerProc, void* clientData) {
     setBackgroundHandling(socketNum, SOCKET_READABLE, handlerProc, clientData);
@@ -181,6 +195,15 @@ public:
 
   virtual void internalError(); // used to 'handle' a 'should not occur'-type error condition within the library.
 
+  // Optional profiling of the callbacks (socket handlers, delayed tasks, event trigger handlers, and posted work) that
+  // the event loop dispatches.  (By default, profiling is not supported; "enableProfiling()" returns False.)
+  virtual Boolean enableProfiling(Boolean enable = True);
+      // Returns True iff profiling is supported.  (Enabling profiling also resets any previously-collected profile.)
+  virtual void reportProfile(UsageEnvironment& env, unsigned maxNumCallbackSites = 10);
+      // Outputs (to "env") the callback sites that have taken the most total time, and statistics on event loop 'lag'
+  virtual void reportProfileOnSignal(UsageEnvironment& env, int signalNum);
+      // Arranges for "reportProfile(env)" to be called (from within the event loop) whenever signal "signalNum" is received
+
 protected:
   TaskScheduler(); // abstract base class
 };
@@ -221,6 +221,10 @@ AC3AudioStreamParser
 		 &AC3AudioStreamFramer::handleNewData, usingSource),
     fUsingSource(usingSource), fHaveParsedAFrame(False),
     fSavedFrame(NULL), fSavedFrameSize(0) {
+  if (usingSource->fOurStreamCode != 0) {
+    // Each read will begin with a stream code header, which "testStreamCode()" needs to remove:
+    disablePrefetching();
+  }
 }
 
 AC3AudioStreamParser::~AC3AudioStreamParser() {
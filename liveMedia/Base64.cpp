@@ -22,20 +22,26 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include <strDup.hh>
 #include <string.h>
 
-static char base64DecodeTable[256];
-
-static void initBase64DecodeTable() {
-  int i;
-  for (i = 0; i < 256; ++i) base64DecodeTable[i] = (char)0x80;
-      // default value: invalid
-
-  for (i = 'A'; i <= 'Z'; ++i) base64DecodeTable[i] = 0 + (i - 'A');
-  for (i = 'a'; i <= 'z'; ++i) base64DecodeTable[i] = 26 + (i - 'a');
-  for (i = '0'; i <= '9'; ++i) base64DecodeTable[i] = 52 + (i - '0');
-  base64DecodeTable[(unsigned char)'+'] = 62;
-  base64DecodeTable[(unsigned char)'/'] = 63;
-  base64DecodeTable[(unsigned char)'='] = 0;
-}
+// Maps each Base64 character to its 6-bit value.  All other characters (including the '=' padding character) map to 0.
+// (Note that this means that an invalid character is decoded as if it were 'A'.)
+static unsigned char const base64DecodeTable[256] = {
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 62,  0,  0,  0, 63,
+  52, 53, 54, 55, 56, 57, 58, 59, 60, 61,  0,  0,  0,  0,  0,  0,
+   0,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+  15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,  0,  0,  0,  0,  0,
+   0, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+  41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
+};
 
 unsigned char* base64Decode(char const* in, unsigned& resultSize,
 			    Boolean trimTrailingZeros) {
@@ -46,77 +52,84 @@ unsigned char* base64Decode(char const* in, unsigned& resultSize,
 unsigned char* base64Decode(char const* in, unsigned inSize,
 			    unsigned& resultSize,
 			    Boolean trimTrailingZeros) {
-  static Boolean haveInitializedBase64DecodeTable = False;
-  if (!haveInitializedBase64DecodeTable) {
-    initBase64DecodeTable();
-    haveInitializedBase64DecodeTable = True;
-  }
+  unsigned char* result = new unsigned char[base64DecodedMaxSize(inSize) + 1];
+  resultSize = base64DecodeInto(in, inSize, result, trimTrailingZeros);
 
-  unsigned char* out = new unsigned char[inSize+1]; // ensures we have enough space
-  int k = 0;
-  int paddingCount = 0;
-  int const jMax = inSize - 3;
-     // in case "inSize" is not a multiple of 4 (although it should be)
-  for (int j = 0; j < jMax; j += 4) {
-    char inTmp[4], outTmp[4];
-    for (int i = 0; i < 4; ++i) {
-      inTmp[i] = in[i+j];
-      if (inTmp[i] == '=') ++paddingCount;
-      outTmp[i] = base64DecodeTable[(unsigned char)inTmp[i]];
-      if ((outTmp[i]&0x80) != 0) outTmp[i] = 0; // this happens only if there was an invalid character; pretend that it was 'A'
-    }
+  return result;
+}
 
-    out[k++] = (outTmp[0]<<2) | (outTmp[1]>>4);
-    out[k++] = (outTmp[1]<<4) | (outTmp[2]>>2);
-    out[k++] = (outTmp[2]<<6) | outTmp[3];
+unsigned base64DecodeInto(char const* inSigned, unsigned inSize, unsigned char* out,
+			  Boolean trimTrailingZeros) {
+  unsigned char const* in = (unsigned char const*)inSigned;
+  unsigned k = 0;
+  unsigned paddingCount = 0;
+
+  // Decode each group of 4 input characters into 3 output bytes.  (Any final partial group - if "inSize" is not a
+  // multiple of 4, although it should be - is ignored.)  Because we read each group before writing its output (which
+  // is never past the group's position in the input), "out" may be the same as "in":
+  for (unsigned j = 0; j + 4 <= inSize; j += 4) {
+    unsigned char const c0 = in[j], c1 = in[j+1], c2 = in[j+2], c3 = in[j+3];
+    paddingCount += (c0 == '=') + (c1 == '=') + (c2 == '=') + (c3 == '=');
+
+    unsigned const bits
+      = (base64DecodeTable[c0]<<18) | (base64DecodeTable[c1]<<12) | (base64DecodeTable[c2]<<6) | base64DecodeTable[c3];
+    out[k++] = bits>>16;
+    out[k++] = bits>>8;
+    out[k++] = bits;
   }
 
   if (trimTrailingZeros) {
     while (paddingCount > 0 && k > 0 && out[k-1] == '\0') { --k; --paddingCount; }
   }
-  resultSize = k;
-  unsigned char* result = new unsigned char[resultSize];
-  memmove(result, out, resultSize);
-  delete[] out;
 
-  return result;
+  return k;
 }
 
 static const char base64Char[] =
 "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-char* base64Encode(char const* origSigned, unsigned origLength) {
-  unsigned char const* orig = (unsigned char const*)origSigned; // in case any input bytes have the MSB set
+char* base64Encode(char const* orig, unsigned origLength) {
   if (orig == NULL) return NULL;
 
+  char* result = new char[base64EncodedSize(origLength) + 1]; // allow for trailing '\0'
+  (void)base64EncodeInto(orig, origLength, result);
+
+  return result;
+}
+
+unsigned base64EncodeInto(char const* origSigned, unsigned origLength, char* result) {
+  unsigned char const* orig = (unsigned char const*)origSigned; // in case any input bytes have the MSB set
+
   unsigned const numOrig24BitValues = origLength/3;
   Boolean havePadding = origLength > numOrig24BitValues*3;
   Boolean havePadding2 = origLength == numOrig24BitValues*3 + 2;
   unsigned const numResultBytes = 4*(numOrig24BitValues + havePadding);
-  char* result = new char[numResultBytes+1]; // allow for trailing '\0'
 
   // Map each full group of 3 input bytes into 4 output base-64 characters:
   unsigned i;
   for (i = 0; i < numOrig24BitValues; ++i) {
-    result[4*i+0] = base64Char[(orig[3*i]>>2)&0x3F];
-    result[4*i+1] = base64Char[(((orig[3*i]&0x3)<<4) | (orig[3*i+1]>>4))&0x3F];
-    result[4*i+2] = base64Char[((orig[3*i+1]<<2) | (orig[3*i+2]>>6))&0x3F];
-    result[4*i+3] = base64Char[orig[3*i+2]&0x3F];
+    unsigned const bits = (orig[0]<<16) | (orig[1]<<8) | orig[2];
+    result[0] = base64Char[bits>>18];
+    result[1] = base64Char[(bits>>12)&0x3F];
+    result[2] = base64Char[(bits>>6)&0x3F];
+    result[3] = base64Char[bits&0x3F];
+    orig += 3; result += 4;
   }
 
-  // Now, take padding into account.  (Note: i == numOrig24BitValues)
+  // Now, take padding into account:
   if (havePadding) {
-    result[4*i+0] = base64Char[(orig[3*i]>>2)&0x3F];
+    result[0] = base64Char[(orig[0]>>2)&0x3F];
     if (havePadding2) {
-      result[4*i+1] = base64Char[(((orig[3*i]&0x3)<<4) | (orig[3*i+1]>>4))&0x3F];
-      result[4*i+2] = base64Char[(orig[3*i+1]<<2)&0x3F];
+      result[1] = base64Char[(((orig[0]&0x3)<<4) | (orig[1]>>4))&0x3F];
+      result[2] = base64Char[(orig[1]<<2)&0x3F];
     } else {
-      result[4*i+1] = base64Char[((orig[3*i]&0x3)<<4)&0x3F];
-      result[4*i+2] = '=';
+      result[1] = base64Char[((orig[0]&0x3)<<4)&0x3F];
+      result[2] = '=';
     }
-    result[4*i+3] = '=';
+    result[3] = '=';
+    result += 4;
   }
 
-  result[numResultBytes] = '\0';
-  return result;
+  *result = '\0';
+  return numResultBytes;
 }
@@ -149,6 +149,118 @@ int BitVector::get_expGolombSigned() {
   }
 }
 
+////////// BitReader //////////
+
+BitReader::BitReader(u_int8_t const* baseBytePtr,
+		     unsigned baseBitOffset,
+		     unsigned totNumBits)
+  : fNextByte(baseBytePtr + baseBitOffset/8), fCache(0), fNumCachedBits(0),
+    fTotNumBits(totNumBits), fCurBitIndex(0) {
+  unsigned const endBitOffset = baseBitOffset%8 + totNumBits;
+  fLimit = fNextByte + (endBitOffset+7)/8;
+  fLastByteMask = endBitOffset%8 == 0 ? 0xFF : (u_int8_t)(0xFF << (8 - endBitOffset%8));
+
+  // Discard any bits (in the first byte) that precede the data:
+  unsigned const numBitsToDiscard = baseBitOffset%8;
+  if (numBitsToDiscard > 0) {
+    refill();
+    fCache <<= numBitsToDiscard; fNumCachedBits -= numBitsToDiscard;
+  }
+}
+
+void BitReader::refill() {
+  while (fNumCachedBits <= 56) {
+    if (fNextByte >= fLimit) {
+      // We've reached the end of the data; the rest of the cache is 0s:
+      fNumCachedBits = 64;
+      return;
+    }
+
+    u_int8_t nextByte = *fNextByte++;
+    if (fNextByte == fLimit) nextByte &= fLastByteMask;
+    fCache |= ((u_int64_t)nextByte) << (56 - fNumCachedBits);
+    fNumCachedBits += 8;
+  }
+}
+
+void BitReader::skipBits(unsigned numBits) {
+  if (numBits > fTotNumBits - curBitIndex()) numBits = fTotNumBits - curBitIndex(); // as with "BitVector"
+  fCurBitIndex += numBits;
+
+  if (numBits < fNumCachedBits) {
+    fCache <<= numBits; fNumCachedBits -= numBits;
+    return;
+  }
+
+  // Skip past all of the cached bits, and then any whole bytes:
+  numBits -= fNumCachedBits;
+  fCache = 0; fNumCachedBits = 0;
+  unsigned numBytesToSkip = numBits/8;
+  if (numBytesToSkip > (unsigned)(fLimit - fNextByte)) numBytesToSkip = fLimit - fNextByte;
+  fNextByte += numBytesToSkip;
+
+  unsigned const numBitsToDiscard = numBits%8;
+  if (numBitsToDiscard > 0) {
+    refill();
+    fCache <<= numBitsToDiscard; fNumCachedBits -= numBitsToDiscard;
+  }
+}
+
+static unsigned countLeadingZeroBits(u_int64_t word) { // "word" != 0
+#if defined(__GNUC__)
+  return __builtin_clzll(word);
+#else
+  unsigned result = 0;
+  while ((word&0xFF00000000000000ULL) == 0) { result += 8; word <<= 8; }
+  while ((word&0x8000000000000000ULL) == 0) { ++result; word <<= 1; }
+  return result;
+#endif
+}
+
+unsigned BitReader::get_expGolomb() {
+  if (fNumCachedBits <= 56) refill();
+
+  // Common case: The whole code (up to 28 leading 0 bits, a 1 bit, then as many value bits as leading 0 bits) is
+  // already cached, and lies within the data:
+  if (fCache != 0) {
+    unsigned const numLeadingZeros = countLeadingZeroBits(fCache);
+    unsigned const codeSize = 2*numLeadingZeros + 1;
+    if (numLeadingZeros <= 28 && fCurBitIndex + codeSize <= fTotNumBits) {
+      unsigned result = (unsigned)(fCache >> (64-codeSize)) - 1;
+      fCache <<= codeSize; fNumCachedBits -= codeSize;
+      fCurBitIndex += codeSize;
+      return result;
+    }
+  }
+
+  return get_expGolomb1();
+}
+
+unsigned BitReader::get_expGolomb1() {
+  // This is the same algorithm as "BitVector::get_expGolomb()" (which also defines what we return for codes that are
+  // too long, or that are truncated by the end of the data):
+  unsigned numLeadingZeroBits = 0;
+  unsigned codeStart = 1;
+
+  while (get1Bit() == 0 && fCurBitIndex < fTotNumBits) {
+    ++numLeadingZeroBits;
+    codeStart *= 2;
+  }
+
+  return codeStart - 1 + getBits(numLeadingZeroBits);
+}
+
+int BitReader::get_expGolombSigned() {
+  unsigned codeNum = get_expGolomb();
+
+  if ((codeNum&1) == 0) { // even
+    return -(int)(codeNum/2);
+  } else { // odd
+    return (codeNum+1)/2;
+  }
+}
+
+
 void shiftBits(unsigned char* toBasePtr, unsigned toBitOffset,
 	       unsigned char const* fromBasePtr, unsigned fromBitOffset,
 	       unsigned numBits) {
@@ -0,0 +1,157 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// A per-environment pool of buffers for incoming RTP packets (used by "BufferedPacket")
+// Implementation
+
+#include "BufferedPacketPool.hh"
+#include "MediaMetrics.hh"
+
+////////// BufferedPacketPoolSlab //////////
+
+class BufferedPacketPoolSlab {
+public:
+  BufferedPacketPoolSlab(BufferedPacketPoolSlab* next)
+    : fNext(next) {
+    fSlots = new unsigned char[BUFFERED_PACKET_POOL_SLOTS_PER_SLAB*BUFFERED_PACKET_POOL_SMALL_SLOT_SIZE];
+  }
+  virtual ~BufferedPacketPoolSlab() {
+    delete[] fSlots;
+    delete fNext;
+  }
+
+public:
+  BufferedPacketPoolSlab* fNext;
+  unsigned char* fSlots;
+};
+
+// Free slots are linked together using a pointer stored at the start of each slot:
+#define NEXT_FREE_SLOT(slot) (*(unsigned char**)(slot))
+
+
+////////// BufferedPacketPool implementation //////////
+
+BufferedPacketPool& BufferedPacketPool::ourPool(UsageEnvironment& env) {
+  _Tables* ourTables = _Tables::getOurTables(env);
+  if (ourTables->bufferedPacketPool == NULL) {
+    ourTables->bufferedPacketPool = new BufferedPacketPool(env);
+  }
+  return *(BufferedPacketPool*)(ourTables->bufferedPacketPool);
+}
+
+BufferedPacketPool* BufferedPacketPool::lookup(UsageEnvironment& env) {
+  _Tables* ourTables = _Tables::getOurTables(env, False);
+  return ourTables == NULL ? NULL : (BufferedPacketPool*)(ourTables->bufferedPacketPool);
+}
+
+BufferedPacketPool::BufferedPacketPool(UsageEnvironment& env)
+  : fEnv(env), fSlabs(NULL), fFreeSmallSlots(NULL), fFreeLargeSlots(NULL), fNumFreeLargeSlots(0),
+    fNumSmallSlots(0), fNumSmallSlotsInUse(0), fNumLargeSlots(0), fNumLargeSlotsInUse(0),
+    fNumTruncatedDatagrams(0), fMetrics(NULL) {
+  MetricsRegistry* metricsRegistry = MetricsRegistry::lookup(env);
+  if (metricsRegistry != NULL) fMetrics = new BufferedPacketPoolMetrics(*metricsRegistry);
+}
+
+BufferedPacketPool::~BufferedPacketPool() {
+  delete fMetrics;
+  delete fSlabs;
+  while (fFreeLargeSlots != NULL) {
+    unsigned char* slot = fFreeLargeSlots;
+    fFreeLargeSlots = NEXT_FREE_SLOT(slot);
+    delete[] slot;
+  }
+}
+
+unsigned char* BufferedPacketPool::allocateSlot(unsigned minSize, unsigned& resultSlotSize) {
+  unsigned char* slot;
+  if (minSize <= BUFFERED_PACKET_POOL_SMALL_SLOT_SIZE) {
+    if (fFreeSmallSlots == NULL) addSlab();
+    slot = fFreeSmallSlots;
+    fFreeSmallSlots = NEXT_FREE_SLOT(slot);
+    ++fNumSmallSlotsInUse;
+    resultSlotSize = BUFFERED_PACKET_POOL_SMALL_SLOT_SIZE;
+  } else {
+    if (fFreeLargeSlots != NULL) {
+      slot = fFreeLargeSlots;
+      fFreeLargeSlots = NEXT_FREE_SLOT(slot);
+      --fNumFreeLargeSlots;
+    } else {
+      slot = new unsigned char[BUFFERED_PACKET_POOL_LARGE_SLOT_SIZE];
+      ++fNumLargeSlots;
+    }
+    ++fNumLargeSlotsInUse;
+    resultSlotSize = BUFFERED_PACKET_POOL_LARGE_SLOT_SIZE;
+  }
+
+  updateMetrics();
+  return slot;
+}
+
+void BufferedPacketPool::freeSlot(unsigned char* slot, unsigned slotSize) {
+  if (slot == NULL) return;
+
+  if (slotSize == BUFFERED_PACKET_POOL_SMALL_SLOT_SIZE) {
+    NEXT_FREE_SLOT(slot) = fFreeSmallSlots;
+    fFreeSmallSlots = slot;
+    --fNumSmallSlotsInUse;
+  } else {
+    if (fNumFreeLargeSlots < BUFFERED_PACKET_POOL_MAX_FREE_LARGE_SLOTS) {
+      NEXT_FREE_SLOT(slot) = fFreeLargeSlots;
+      fFreeLargeSlots = slot;
+      ++fNumFreeLargeSlots;
+    } else {
+      delete[] slot;
+      --fNumLargeSlots;
+    }
+    --fNumLargeSlotsInUse;
+  }
+  updateMetrics();
+
+  if (fNumSmallSlotsInUse == 0 && fNumLargeSlotsInUse == 0) {
+    // Nothing is using the pool any more, so we can delete ourselves (to reclaim space):
+    _Tables* ourTables = _Tables::getOurTables(fEnv);
+    delete this;
+    ourTables->bufferedPacketPool = NULL;
+    ourTables->reclaimIfPossible();
+  }
+}
+
+void BufferedPacketPool::noteTruncatedDatagram() {
+  ++fNumTruncatedDatagrams;
+  if (fMetrics != NULL) fMetrics->truncatedDatagrams.increment();
+}
+
+void BufferedPacketPool::addSlab() {
+  fSlabs = new BufferedPacketPoolSlab(fSlabs);
+
+  // Add each of the new slab's slots to the free list:
+  for (unsigned i = BUFFERED_PACKET_POOL_SLOTS_PER_SLAB; i > 0; --i) {
+    unsigned char* slot = &fSlabs->fSlots[(i-1)*BUFFERED_PACKET_POOL_SMALL_SLOT_SIZE];
+    NEXT_FREE_SLOT(slot) = fFreeSmallSlots;
+    fFreeSmallSlots = slot;
+  }
+  fNumSmallSlots += BUFFERED_PACKET_POOL_SLOTS_PER_SLAB;
+}
+
+void BufferedPacketPool::updateMetrics() {
+  if (fMetrics == NULL) return;
+
+  fMetrics->smallSlots.set(fNumSmallSlots);
+  fMetrics->smallSlotsInUse.set(fNumSmallSlotsInUse);
+  fMetrics->largeSlots.set(fNumLargeSlots);
+  fMetrics->largeSlotsInUse.set(fNumLargeSlotsInUse);
+}
@@ -61,6 +61,8 @@ DeviceSource::DeviceSource(UsageEnvironment& env,
 }
 
 DeviceSource::~DeviceSource() {
+  releaseBorrowedFrame(); // in case we lent a frame that wasn't taken (see "deliverFrame()" below)
+
   // Any instance-specific 'destruction' (i.e., resetting) of the device would be done here:
   //%%% TO BE WRITTEN %%%
 
@@ -126,20 +128,34 @@ void DeviceSource::deliverFrame() {
   unsigned newFrameSize = 0; //%%% TO BE WRITTEN %%%
 
   // Deliver the data here:
-  if (newFrameSize > fMaxSize) {
-    fFrameSize = fMaxSize;
-    fNumTruncatedBytes = newFrameSize - fMaxSize;
+  if (borrowedFrameIsAllowed()) {
+    // Our downstream object (e.g., a "H264VideoStreamDiscreteFramer" feeding a "H264VideoRTPSink") accepts 'borrowed'
+    // frames, so we can lend it the frame data - e.g., a hardware encoder's buffer - without copying it.
+    // "releaseFrame()" will be called (later, from within the event loop) when it has finished with the data.
+    // (Note that the buffer must remain valid until then - even if the device produces more frames in the meantime.)
+    deliverBorrowedFrame(newFrameDataStart, newFrameSize, releaseFrame, this);
   } else {
-    fFrameSize = newFrameSize;
+    if (newFrameSize > fMaxSize) {
+      fFrameSize = fMaxSize;
+      fNumTruncatedBytes = newFrameSize - fMaxSize;
+    } else {
+      fFrameSize = newFrameSize;
+    }
+    memmove(fTo, newFrameDataStart, fFrameSize);
   }
   gettimeofday(&fPresentationTime, NULL); // If you have a more accurate time - e.g., from an encoder - then use that instead.
   // If the device is *not* a 'live source' (e.g., it comes instead from a file or buffer), then set "fDurationInMicroseconds" here.
-  memmove(fTo, newFrameDataStart, fFrameSize);
 
   // After delivering the data, inform the reader that it is now available:
   FramedSource::afterGetting(this);
 }
 
+void DeviceSource::releaseFrame(void* /*clientData*/, unsigned char* /*frame*/) {
+  // This function is called when our downstream object has finished with a frame that we lent it (using
+  // "deliverBorrowedFrame()").  The buffer can now be returned to the device (e.g., re-queued to the encoder):
+  //%%% TO BE WRITTEN %%%
+}
+
 
 // The following code would be called to signal that a new frame of data has become available.
 // This (unlike other "LIVE555 Streaming Media" library code) may be called from a separate thread.
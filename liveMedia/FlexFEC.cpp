@@ -0,0 +1,234 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// XOR-based Forward Error Correction for RTP streams ("flexfec": RFC 8627)
+// Implementation
+
+#include "FlexFEC.hh"
+#include "GroupsockHelper.hh" // for "our_random()"
+#include <string.h>
+
+// The layout of a repair packet (as we send it):
+//   RTP header (12 bytes), with CC=1
+//   CSRC: the SSRC of the protected stream (4 bytes)
+//   FEC header (12 bytes): R=0, F=1, P/X/CC recovery, M/PT recovery, length recovery, TS recovery, SN base, L, D=0
+//   Repair payload: the XOR of the protected packets' data following their (12-byte) RTP headers
+#define RTP_HEADER_SIZE 12
+#define FEC_HEADER_SIZE 12
+#define REPAIR_PACKET_HEADERS_SIZE (RTP_HEADER_SIZE + 4/*CSRC*/ + FEC_HEADER_SIZE)
+
+static void xorBytes(unsigned char* to, unsigned char const* from, unsigned numBytes) {
+  // XOR a 64-bit word at a time (a loop that compilers can also vectorize), then any remaining bytes.
+  // ("memcpy()" is used to access the words, because the data need not be aligned.)
+  while (numBytes >= 8) {
+    u_int64_t toWord, fromWord;
+    memcpy(&toWord, to, 8); memcpy(&fromWord, from, 8);
+    toWord ^= fromWord;
+    memcpy(to, &toWord, 8);
+    to += 8; from += 8; numBytes -= 8;
+  }
+  while (numBytes-- > 0) *to++ ^= *from++;
+}
+
+static u_int16_t get16(unsigned char const* p) { return (p[0]<<8)|p[1]; }
+static u_int32_t get32(unsigned char const* p) { return (p[0]<<24)|(p[1]<<16)|(p[2]<<8)|p[3]; }
+static void put16(unsigned char* p, u_int16_t val) { p[0] = val>>8; p[1] = (unsigned char)val; }
+static void put32(unsigned char* p, u_int32_t val) {
+  p[0] = val>>24; p[1] = (unsigned char)(val>>16); p[2] = (unsigned char)(val>>8); p[3] = (unsigned char)val;
+}
+
+
+////////// FlexFECEncoder implementation //////////
+
+FlexFECEncoder::FlexFECEncoder(unsigned char fecPayloadType, unsigned numPacketsPerRepairPacket, unsigned maxPacketSize)
+  : fFECPayloadType(fecPayloadType),
+    fNumPacketsPerRepairPacket(numPacketsPerRepairPacket == 0 ? 1
+			       : numPacketsPerRepairPacket > 255 ? 255 : numPacketsPerRepairPacket), // "L" is 8 bits
+    fMaxPayloadSize(maxPacketSize > RTP_HEADER_SIZE ? maxPacketSize - RTP_HEADER_SIZE : 0),
+    fNumPacketsProtected(0), fMaxPayloadSizeProtected(0), fRepairPacketSize(0) {
+  fSeqNo = (u_int16_t)our_random();
+  fSSRC = our_random32();
+  fPayloadXOR = new unsigned char[fMaxPayloadSize];
+  memset(fPayloadXOR, 0, fMaxPayloadSize);
+  fRepairPacket = new unsigned char[REPAIR_PACKET_HEADERS_SIZE + fMaxPayloadSize];
+}
+
+FlexFECEncoder::~FlexFECEncoder() {
+  delete[] fRepairPacket;
+  delete[] fPayloadXOR;
+}
+
+Boolean FlexFECEncoder::addPacket(unsigned char const* packet, unsigned packetSize) {
+  if (packetSize < RTP_HEADER_SIZE) return False; // sanity check
+  u_int16_t seqNo = get16(&packet[2]);
+  unsigned payloadSize = packetSize - RTP_HEADER_SIZE;
+
+  if (fNumPacketsProtected > 0 && (u_int16_t)(fSNBase + fNumPacketsProtected) != seqNo) {
+    // There was a discontinuity in sequence numbers, so abandon the current group, and start a new one:
+    memset(fPayloadXOR, 0, fMaxPayloadSizeProtected);
+    fNumPacketsProtected = fMaxPayloadSizeProtected = 0;
+  }
+  if (payloadSize > fMaxPayloadSize) return False; // shouldn't happen; the packet can't be protected
+
+  if (fNumPacketsProtected == 0) {
+    // Begin a new group:
+    fSNBase = seqNo;
+    fHeaderBitsXOR[0] = fHeaderBitsXOR[1] = 0;
+    fLengthXOR = 0;
+    fTimestampXOR = 0;
+  }
+
+  fHeaderBitsXOR[0] ^= packet[0]; fHeaderBitsXOR[1] ^= packet[1];
+  fLengthXOR ^= (u_int16_t)payloadSize;
+  fLastTimestamp = get32(&packet[4]);
+  fTimestampXOR ^= fLastTimestamp;
+  xorBytes(fPayloadXOR, &packet[RTP_HEADER_SIZE], payloadSize);
+  if (payloadSize > fMaxPayloadSizeProtected) fMaxPayloadSizeProtected = payloadSize;
+
+  if (++fNumPacketsProtected < fNumPacketsPerRepairPacket) return False;
+
+  buildRepairPacket(get32(&packet[8]));
+
+  // Reset for the next group:
+  memset(fPayloadXOR, 0, fMaxPayloadSizeProtected);
+  fNumPacketsProtected = fMaxPayloadSizeProtected = 0;
+  return True;
+}
+
+void FlexFECEncoder::buildRepairPacket(u_int32_t protectedSSRC) {
+  unsigned char* p = fRepairPacket;
+
+  // RTP header:
+  p[0] = 0x81; // version 2; no padding or extension; CC=1
+  p[1] = fFECPayloadType; // M=0
+  put16(&p[2], fSeqNo++);
+  put32(&p[4], fLastTimestamp);
+  put32(&p[8], fSSRC);
+  put32(&p[12], protectedSSRC); // CSRC
+
+  // FEC header:
+  unsigned char* fecHeader = &p[RTP_HEADER_SIZE + 4];
+  fecHeader[0] = 0x40 | (fHeaderBitsXOR[0]&0x3F); // R=0, F=1, P/X/CC recovery
+  fecHeader[1] = fHeaderBitsXOR[1]; // M/PT recovery
+  put16(&fecHeader[2], fLengthXOR);
+  put32(&fecHeader[4], fTimestampXOR);
+  put16(&fecHeader[8], fSNBase);
+  fecHeader[10] = (unsigned char)fNumPacketsPerRepairPacket; // L
+  fecHeader[11] = 0; // D=0: 1-D, non-interleaved ('row') protection
+
+  // Repair payload:
+  memcpy(&p[REPAIR_PACKET_HEADERS_SIZE], fPayloadXOR, fMaxPayloadSizeProtected);
+  fRepairPacketSize = REPAIR_PACKET_HEADERS_SIZE + fMaxPayloadSizeProtected;
+}
+
+
+////////// FlexFECDecoder implementation //////////
+
+FlexFECDecoder::FlexFECDecoder() {
+  fPackets = new unsigned char[FLEXFEC_DECODER_HISTORY_SIZE*FLEXFEC_DECODER_MAX_PACKET_SIZE];
+  for (unsigned i = 0; i < FLEXFEC_DECODER_HISTORY_SIZE; ++i) fSlots[i].fPacketSize = 0;
+  fRecoveredPacket = new unsigned char[FLEXFEC_DECODER_MAX_PACKET_SIZE];
+}
+
+FlexFECDecoder::~FlexFECDecoder() {
+  delete[] fRecoveredPacket;
+  delete[] fPackets;
+}
+
+void FlexFECDecoder::addMediaPacket(unsigned char const* packet, unsigned packetSize) {
+  if (packetSize < RTP_HEADER_SIZE || packetSize > FLEXFEC_DECODER_MAX_PACKET_SIZE) return;
+
+  u_int16_t seqNum = get16(&packet[2]);
+  Slot& slot = fSlots[seqNum%FLEXFEC_DECODER_HISTORY_SIZE];
+  memcpy(slotPacket(seqNum), packet, packetSize);
+  slot.fSeqNum = seqNum;
+  slot.fSSRC = get32(&packet[8]);
+  slot.fPacketSize = packetSize;
+}
+
+FlexFECDecoder::Slot* FlexFECDecoder::lookupSlot(u_int16_t seqNum, u_int32_t SSRC) {
+  Slot& slot = fSlots[seqNum%FLEXFEC_DECODER_HISTORY_SIZE];
+  return slot.fPacketSize > 0 && slot.fSeqNum == seqNum && slot.fSSRC == SSRC ? &slot : NULL;
+}
+
+unsigned char const* FlexFECDecoder
+::recoverPacket(unsigned char const* repairPacket, unsigned repairPacketSize, unsigned& recoveredPacketSize) {
+  // Check the repair packet's RTP header.  We handle only the (single) protected SSRC in the CSRC list:
+  if (repairPacketSize < RTP_HEADER_SIZE) return NULL;
+  unsigned cc = repairPacket[0]&0x0F;
+  if (cc == 0 || (repairPacket[0]&0x30) != 0) return NULL; // no CSRC, or padding or a header extension
+  unsigned headersSize = RTP_HEADER_SIZE + 4*cc + FEC_HEADER_SIZE;
+  if (repairPacketSize < headersSize) return NULL;
+  u_int32_t protectedSSRC = get32(&repairPacket[RTP_HEADER_SIZE]);
+
+  // Check the FEC header.  We handle only the fixed ("F=1") header, with 'row' ("D=0") protection:
+  unsigned char const* fecHeader = &repairPacket[RTP_HEADER_SIZE + 4*cc];
+  if ((fecHeader[0]&0xC0) != 0x40) return NULL; // not R=0, F=1
+  u_int16_t snBase = get16(&fecHeader[8]);
+  unsigned L = fecHeader[10];
+  unsigned D = fecHeader[11];
+  if (L == 0 || D != 0) return NULL;
+
+  // We can recover a packet only if it's the only one (of those protected) that's missing:
+  unsigned numMissing = 0;
+  u_int16_t missingSeqNum = 0;
+  for (unsigned i = 0; i < L; ++i) {
+    u_int16_t seqNum = snBase + i;
+    if (lookupSlot(seqNum, protectedSSRC) == NULL) {
+      if (++numMissing > 1) return NULL;
+      missingSeqNum = seqNum;
+    }
+  }
+  if (numMissing == 0) return NULL; // nothing to recover
+
+  // Recover the missing packet's header fields and length, then its payload:
+  unsigned char headerBits[2] = { fecHeader[0], fecHeader[1] };
+  u_int16_t length = get16(&fecHeader[2]);
+  u_int32_t timestamp = get32(&fecHeader[4]);
+  for (unsigned i = 0; i < L; ++i) {
+    u_int16_t seqNum = snBase + i;
+    if (seqNum == missingSeqNum) continue;
+
+    Slot* slot = lookupSlot(seqNum, protectedSSRC);
+    unsigned char const* packet = slotPacket(seqNum);
+    headerBits[0] ^= packet[0]; headerBits[1] ^= packet[1];
+    length ^= (u_int16_t)(slot->fPacketSize - RTP_HEADER_SIZE);
+    timestamp ^= get32(&packet[4]);
+  }
+  unsigned repairPayloadSize = repairPacketSize - headersSize;
+  if (length > repairPayloadSize || RTP_HEADER_SIZE + length > FLEXFEC_DECODER_MAX_PACKET_SIZE) return NULL;
+
+  unsigned char* payload = &fRecoveredPacket[RTP_HEADER_SIZE];
+  memcpy(payload, &repairPacket[headersSize], length);
+  for (unsigned i = 0; i < L; ++i) {
+    u_int16_t seqNum = snBase + i;
+    if (seqNum == missingSeqNum) continue;
+
+    unsigned otherPayloadSize = lookupSlot(seqNum, protectedSSRC)->fPacketSize - RTP_HEADER_SIZE;
+    xorBytes(payload, &slotPacket(seqNum)[RTP_HEADER_SIZE], otherPayloadSize < length ? otherPayloadSize : length);
+  }
+
+  fRecoveredPacket[0] = 0x80 | (headerBits[0]&0x3F); // version 2
+  fRecoveredPacket[1] = headerBits[1];
+  put16(&fRecoveredPacket[2], missingSeqNum);
+  put32(&fRecoveredPacket[4], timestamp);
+  put32(&fRecoveredPacket[8], protectedSSRC);
+  recoveredPacketSize = RTP_HEADER_SIZE + length;
+
+  addMediaPacket(fRecoveredPacket, recoveredPacketSize); // in case it's needed to recover another packet later
+  return fRecoveredPacket;
+}
@@ -27,11 +27,14 @@ FramedSource::FramedSource(UsageEnvironment& env)
   : MediaSource(env),
     fAfterGettingFunc(NULL), fAfterGettingClientData(NULL),
     fOnCloseFunc(NULL), fOnCloseClientData(NULL),
-    fIsCurrentlyAwaitingData(False) {
+    fIsCurrentlyAwaitingData(False),
+    fBorrowedFrameIsAllowed(False), fBorrowedFrame(NULL),
+    fBorrowedFrameReleaseFunc(NULL), fBorrowedFrameReleaseClientData(NULL) {
   fPresentationTime.tv_sec = fPresentationTime.tv_usec = 0; // initially
 }
 
 FramedSource::~FramedSource() {
+  releaseBorrowedFrame();
 }
 
 Boolean FramedSource::isFramedSource() const {
@@ -65,6 +68,8 @@ void FramedSource::getNextFrame(unsigned char* to, unsigned maxSize,
     envir().internalError();
   }
 
+  releaseBorrowedFrame(); // in case the downstream object didn't take the last frame that we lent it
+
   fTo = to;
   fMaxSize = maxSize;
   fNumTruncatedBytes = 0; // by default; could be changed by doGetNextFrame()
@@ -84,6 +89,7 @@ void FramedSource::afterGetting(FramedSource* source) {
       // indicates that we can be read again
       // Note that this needs to be done here, in case the "fAfterFunc"
       // called below tries to read another frame (which it usually will)
+  source->fBorrowedFrameIsAllowed = False; // the downstream object must allow this again, for each frame
 
   if (source->fAfterGettingFunc != NULL) {
     (*(source->fAfterGettingFunc))(source->fAfterGettingClientData,
@@ -107,6 +113,8 @@ void FramedSource::handleClosure() {
 
 void FramedSource::stopGettingFrames() {
   fIsCurrentlyAwaitingData = False; // indicates that we can be read again
+  fBorrowedFrameIsAllowed = False;
+  releaseBorrowedFrame();
   fAfterGettingFunc = NULL;
   fOnCloseFunc = NULL;
 
@@ -120,6 +128,36 @@ void FramedSource::doStopGettingFrames() {
   // Subclasses may wish to redefine this function.
 }
 
+Boolean FramedSource
+::takeBorrowedFrame(unsigned char*& frame, releaseFrameFunc*& releaseFunc, void*& releaseClientData) {
+  if (fBorrowedFrame == NULL) return False;
+
+  frame = fBorrowedFrame;
+  releaseFunc = fBorrowedFrameReleaseFunc;
+  releaseClientData = fBorrowedFrameReleaseClientData;
+  fBorrowedFrame = NULL; // the caller now owns it
+  return True;
+}
+
+void FramedSource::deliverBorrowedFrame(unsigned char* frame, unsigned frameSize,
+					releaseFrameFunc* releaseFunc, void* releaseClientData) {
+  releaseBorrowedFrame(); // sanity check; there shouldn't be one
+
+  fBorrowedFrame = frame;
+  fBorrowedFrameReleaseFunc = releaseFunc;
+  fBorrowedFrameReleaseClientData = releaseClientData;
+  fFrameSize = frameSize;
+  fNumTruncatedBytes = 0; // because the downstream object's buffer size doesn't apply
+}
+
+void FramedSource::releaseBorrowedFrame() {
+  if (fBorrowedFrame == NULL) return;
+
+  unsigned char* frame = fBorrowedFrame;
+  fBorrowedFrame = NULL;
+  if (fBorrowedFrameReleaseFunc != NULL) (*fBorrowedFrameReleaseFunc)(fBorrowedFrameReleaseClientData, frame);
+}
+
 unsigned FramedSource::maxFrameSize() const {
   // By default, this source has no maximum frame size.
   return 0;
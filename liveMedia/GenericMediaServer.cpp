@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "GenericMediaServer.hh"
+#include "MediaMetrics.hh"
 #include <GroupsockHelper.hh>
 #if defined(__WIN32__) || defined(_WIN32) || defined(_QNX4)
 #define snprintf _snprintf
@@ -127,9 +128,17 @@ GenericMediaServer
     fClientConnections(HashTable::create(ONE_WORD_HASH_KEYS)),
     fClientSessions(HashTable::create(STRING_HASH_KEYS)),
     fPreviousClientSessionId(0),
-    fTLSCertificateFileName(NULL), fTLSPrivateKeyFileName(NULL) {
+    fTLSCertificateFileName(NULL), fTLSPrivateKeyFileName(NULL), fTLSUsesKernelTLS(False), fTLSContext(NULL),
+    fMetrics(NULL) {
   ignoreSigPipeOnSocket(fServerSocketIPv4); // so that clients on the same host that are killed don't also kill us
   ignoreSigPipeOnSocket(fServerSocketIPv6); // ditto
+
+  MetricsRegistry* metricsRegistry = MetricsRegistry::lookup(env);
+  if (metricsRegistry != NULL) {
+    char labels[100];
+    snprintf(labels, sizeof labels, "server=\"%s\",port=\"%u\"", name(), ntohs(ourPort.num()));
+    fMetrics = new MediaServerMetrics(*metricsRegistry, labels);
+  }
   
   // Arrange to handle connections from others:
   env.taskScheduler().turnOnBackgroundReadHandling(fServerSocketIPv4, incomingConnectionHandlerIPv4, this);
@@ -143,7 +152,9 @@ GenericMediaServer::~GenericMediaServer() {
   envir().taskScheduler().turnOffBackgroundReadHandling(fServerSocketIPv6);
   ::closeSocket(fServerSocketIPv6);
 
+  delete fTLSContext;
   delete[] fTLSCertificateFileName; delete[] fTLSPrivateKeyFileName;
+  delete fMetrics;
 }
 
 void GenericMediaServer::cleanup() {
@@ -241,6 +252,7 @@ void GenericMediaServer::incomingConnectionHandlerOnSocket(int serverSocket) {
   ignoreSigPipeOnSocket(clientSocket); // so that clients on the same host that are killed don't also kill us
   makeSocketNonBlocking(clientSocket);
   increaseSendBufferTo(envir(), clientSocket, 50*1024);
+  if (fMetrics != NULL) fMetrics->connectionsAccepted.increment();
   
 #ifdef DEBUG
   envir() << "accept()ed connection from " << AddressString(clientAddr).val() << "\n";
@@ -251,9 +263,14 @@ void GenericMediaServer::incomingConnectionHandlerOnSocket(int serverSocket) {
 }
 
 void GenericMediaServer
-::setTLSFileNames(char const* certFileName, char const* privKeyFileName) {
+::setTLSFileNames(char const* certFileName, char const* privKeyFileName, Boolean useKernelTLS) {
   delete[] fTLSCertificateFileName; fTLSCertificateFileName = strDup(certFileName);
   delete[] fTLSPrivateKeyFileName; fTLSPrivateKeyFileName = strDup(privKeyFileName);
+  fTLSUsesKernelTLS = useKernelTLS;
+
+  // Any existing shared TLS context is now out of date.  (Connections that were already given it - including those
+  // that haven't yet done their TLS handshake - keep their own reference to its state; see "ServerTLSState::setContext()".)
+  delete fTLSContext; fTLSContext = NULL;
 }
 
 
@@ -268,11 +285,20 @@ GenericMediaServer::ClientConnection
 
   // Add ourself to our 'client connections' table:
   fOurServer.fClientConnections->Add((char const*)this, this);
+  if (fOurServer.fMetrics != NULL) {
+    fOurServer.fMetrics->clientConnections.set(fOurServer.fClientConnections->numEntries());
+  }
   
   if (useTLS) {
     // Perform extra processing to handle a TLS connection:
     fTLS.setCertificateAndPrivateKeyFileNames(ourServer.fTLSCertificateFileName,
 					      ourServer.fTLSPrivateKeyFileName);
+    if (ourServer.fTLSContext == NULL) {
+      ourServer.fTLSContext
+	= ServerTLSContext::createNew(envir(), ourServer.fTLSCertificateFileName, ourServer.fTLSPrivateKeyFileName,
+				      ourServer.fTLSUsesKernelTLS);
+    }
+    fTLS.setContext(ourServer.fTLSContext); // if NULL, then this connection sets up its own TLS context
     fTLS.isNeeded = True;
 
     fTLS.tlsAcceptIsNeeded = True; // call fTLS.accept() the next time the socket is readable
@@ -287,6 +313,9 @@ GenericMediaServer::ClientConnection
 GenericMediaServer::ClientConnection::~ClientConnection() {
   // Remove ourself from the server's 'client connections' hash table before we go:
   fOurServer.fClientConnections->Remove((char const*)this);
+  if (fOurServer.fMetrics != NULL) {
+    fOurServer.fMetrics->clientConnections.set(fOurServer.fClientConnections->numEntries());
+  }
   
   closeSockets();
 }
@@ -314,6 +343,10 @@ void GenericMediaServer::ClientConnection::incomingRequestHandler() {
     }
 
     fInputTLS->tlsAcceptIsNeeded = False;
+    if (fOurServer.fMetrics != NULL) {
+      fOurServer.fMetrics->tlsHandshakes.increment();
+      if (fInputTLS->sessionWasResumed()) fOurServer.fMetrics->tlsSessionsResumed.increment();
+    }
     // We can now read data, as usual:
   }
 
@@ -351,6 +384,7 @@ GenericMediaServer::ClientSession::~ClientSession() {
   char sessionIdStr[8+1];
   sprintf(sessionIdStr, "%08X", fOurSessionId);
   fOurServer.fClientSessions->Remove(sessionIdStr);
+  if (fOurServer.fMetrics != NULL) fOurServer.fMetrics->clientSessions.set(fOurServer.numClientSessions());
   
   if (fOurServerMediaSession != NULL) {
     fOurServerMediaSession->decrementReferenceCount();
@@ -411,6 +445,7 @@ GenericMediaServer::ClientSession* GenericMediaServer::createNewClientSessionWit
 
   ClientSession* clientSession = createNewClientSession(sessionId);
   if (clientSession != NULL) fClientSessions->Add(sessionIdStr, clientSession);
+  if (fMetrics != NULL) fMetrics->clientSessions.set(numClientSessions());
 
   return clientSession;
 }
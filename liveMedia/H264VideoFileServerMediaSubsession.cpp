@@ -79,8 +79,8 @@ void H264VideoFileServerMediaSubsession::checkForAuxSDPLine1() {
   }
 }
 
-char const* H264VideoFileServerMediaSubsession::getAuxSDPLine(RTPSink* rtpSink, FramedSource* inputSource) {
-  if (fAuxSDPLine != NULL) return fAuxSDPLine; // it's already been set up (for a previous client)
+Boolean H264VideoFileServerMediaSubsession::startGettingAuxSDPLine(RTPSink* rtpSink, FramedSource* inputSource) {
+  if (fAuxSDPLine != NULL) return True; // it's already been set up (for a previous client)
 
   if (fDummyRTPSink == NULL) { // we're not already setting it up for another, concurrent stream
     // Note: For H264 video files, the 'config' information ("profile-level-id" and "sprop-parameter-sets") isn't known
@@ -95,7 +95,13 @@ char const* H264VideoFileServerMediaSubsession::getAuxSDPLine(RTPSink* rtpSink,
     checkForAuxSDPLine(this);
   }
 
-  envir().taskScheduler().doEventLoop(&fDoneFlag);
+  return fDoneFlag != 0;
+}
+
+char const* H264VideoFileServerMediaSubsession::getAuxSDPLine(RTPSink* rtpSink, FramedSource* inputSource) {
+  if (!startGettingAuxSDPLine(rtpSink, inputSource)) {
+    envir().taskScheduler().doEventLoop(&fDoneFlag);
+  }
 
   return fAuxSDPLine;
 }
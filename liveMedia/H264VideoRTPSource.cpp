@@ -119,32 +119,29 @@ char const* H264VideoRTPSource::MIMEtype() const {
 SPropRecord* parseSPropParameterSets(char const* sPropParameterSetsStr,
                                      // result parameter:
                                      unsigned& numSPropRecords) {
-  // Make a copy of the input string, so we can replace the commas with '\0's:
-  char* inStr = strDup(sPropParameterSetsStr);
-  if (inStr == NULL) {
+  if (sPropParameterSetsStr == NULL) {
     numSPropRecords = 0;
     return NULL;
   }
 
   // Count the number of commas (and thus the number of parameter sets):
   numSPropRecords = 1;
-  char* s;
-  for (s = inStr; *s != '\0'; ++s) {
-    if (*s == ',') {
-      ++numSPropRecords;
-      *s = '\0';
-    }
+  char const* s;
+  for (s = sPropParameterSetsStr; *s != '\0'; ++s) {
+    if (*s == ',') ++numSPropRecords;
   }
 
-  // Allocate and fill in the result array:
+  // Allocate and fill in the result array, decoding each (comma-separated) parameter set directly from the input string:
   SPropRecord* resultArray = new SPropRecord[numSPropRecords];
-  s = inStr;
+  s = sPropParameterSetsStr;
   for (unsigned i = 0; i < numSPropRecords; ++i) {
-    resultArray[i].sPropBytes = base64Decode(s, resultArray[i].sPropLength);
-    s += strlen(s) + 1;
+    char const* end = s;
+    while (*end != ',' && *end != '\0') ++end;
+
+    resultArray[i].sPropBytes = base64Decode(s, end - s, resultArray[i].sPropLength);
+    s = end + 1;
   }
 
-  delete[] inStr;
   return resultArray;
 }
 
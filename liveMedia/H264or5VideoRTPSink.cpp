@@ -52,16 +52,22 @@ private:
                           struct timeval presentationTime,
                           unsigned durationInMicroseconds);
   void reset();
+  void doneWithNALUnit();
 
 private:
   int fHNumber;
   unsigned fInputBufferSize;
   unsigned fMaxOutputPacketSize;
   unsigned char* fInputBuffer;
-  unsigned fNumValidDataBytes;
-  unsigned fCurDataOffset;
+  unsigned char* fNALUnit; // the NAL unit that we're currently delivering (in "fInputBuffer", or borrowed); NULL if none
+  unsigned fNALUnitSize;
+  unsigned fCurDataOffset; // the offset (within "fNALUnit") of the next data to deliver
+  u_int8_t fFUHeader[3]; // the header bytes (H.264: 2; H.265: 3) that we prepend to each FU packet
   unsigned fSaveNumTruncatedBytes;
   Boolean fLastFragmentCompletedNALUnit;
+  // If our input source lent us the NAL unit (so we deliver fragments directly from it):
+  releaseFrameFunc* fBorrowedNALUnitReleaseFunc; // non-NULL iff "fNALUnit" is borrowed
+  void* fBorrowedNALUnitReleaseClientData;
 };
 
 
@@ -163,33 +169,40 @@ H264or5Fragmenter::H264or5Fragmenter(int hNumber,
 				     unsigned inputBufferMax, unsigned maxOutputPacketSize)
   : FramedFilter(env, inputSource),
     fHNumber(hNumber),
-    fInputBufferSize(inputBufferMax+1), fMaxOutputPacketSize(maxOutputPacketSize) {
+    fInputBufferSize(inputBufferMax), fMaxOutputPacketSize(maxOutputPacketSize),
+    fNALUnit(NULL), fBorrowedNALUnitReleaseFunc(NULL), fBorrowedNALUnitReleaseClientData(NULL) {
   fInputBuffer = new unsigned char[fInputBufferSize];
   reset();
 }
 
 H264or5Fragmenter::~H264or5Fragmenter() {
+  doneWithNALUnit(); // in case it's borrowed
   delete[] fInputBuffer;
   detachInputSource(); // so that the subsequent ~FramedFilter() doesn't delete it
 }
 
 void H264or5Fragmenter::doGetNextFrame() {
-  if (fNumValidDataBytes == 1) {
-    // We have no NAL unit data currently in the buffer.  Read a new one:
-    fInputSource->getNextFrame(&fInputBuffer[1], fInputBufferSize - 1,
+  if (fNALUnit == NULL) {
+    // We have no NAL unit data currently.  Read a new one.
+    // (If our source can lend us the NAL unit - e.g., from a hardware encoder's buffer - then we deliver fragments
+    // directly from that, rather than first copying it into "fInputBuffer".)
+    fInputSource->allowBorrowedFrame();
+    fInputSource->getNextFrame(fInputBuffer, fInputBufferSize,
 			       afterGettingFrame, this,
 			       FramedSource::handleClosure, this);
   } else {
-    // We have NAL unit data in the buffer.  There are three cases to consider:
-    // 1. There is a new NAL unit in the buffer, and it's small enough to deliver
+    // We have NAL unit data.  There are three cases to consider:
+    // 1. There is a new NAL unit, and it's small enough to deliver
     //    to the RTP sink (as is).
-    // 2. There is a new NAL unit in the buffer, but it's too large to deliver to
+    // 2. There is a new NAL unit, but it's too large to deliver to
     //    the RTP sink in its entirety.  Deliver the first fragment of this data,
     //    as a FU packet, with one extra preceding header byte (for the "FU header").
-    // 3. There is a NAL unit in the buffer, and we've already delivered some
+    // 3. There is a NAL unit, and we've already delivered some
     //    fragment(s) of this.  Deliver the next fragment of this data,
     //    as a FU packet, with two (H.264) or three (H.265) extra preceding header bytes
     //    (for the "NAL header" and the "FU header").
+    // Note that we never modify the NAL unit data itself (because it might be borrowed);
+    // instead, we write any header bytes directly to "fTo".
 
     if (fMaxSize < fMaxOutputPacketSize) { // shouldn't happen
       envir() << "H264or5Fragmenter::doGetNextFrame(): fMaxSize ("
@@ -198,65 +211,58 @@ void H264or5Fragmenter::doGetNextFrame() {
       fMaxSize = fMaxOutputPacketSize;
     }
 
+    unsigned const numFUHeaderBytes = fHNumber == 264 ? 2 : 3;
     fLastFragmentCompletedNALUnit = True; // by default
-    if (fCurDataOffset == 1) { // case 1 or 2
-      if (fNumValidDataBytes - 1 <= fMaxSize) { // case 1
-	memmove(fTo, &fInputBuffer[1], fNumValidDataBytes - 1);
-	fFrameSize = fNumValidDataBytes - 1;
-	fCurDataOffset = fNumValidDataBytes;
+    if (fCurDataOffset == 0) { // case 1 or 2
+      if (fNALUnitSize <= fMaxSize) { // case 1
+	memmove(fTo, fNALUnit, fNALUnitSize);
+	fFrameSize = fNALUnitSize;
+	fCurDataOffset = fNALUnitSize;
       } else { // case 2
 	// We need to send the NAL unit data as FU packets.  Deliver the first
-	// packet now.  Note that we add "NAL header" and "FU header" bytes to the front
-	// of the packet (overwriting the existing "NAL header").
+	// packet now.  Note that we replace the existing "NAL header" with "NAL header" and "FU header" bytes.
 	if (fHNumber == 264) {
-	  fInputBuffer[0] = (fInputBuffer[1] & 0xE0) | 28; // FU indicator
-	  fInputBuffer[1] = 0x80 | (fInputBuffer[1] & 0x1F); // FU header (with S bit)
+	  fFUHeader[0] = (fNALUnit[0] & 0xE0) | 28; // FU indicator
+	  fFUHeader[1] = 0x80 | (fNALUnit[0] & 0x1F); // FU header (with S bit)
 	} else { // 265
-	  u_int8_t nal_unit_type = (fInputBuffer[1]&0x7E)>>1;
-	  fInputBuffer[0] = (fInputBuffer[1] & 0x81) | (49<<1); // Payload header (1st byte)
-	  fInputBuffer[1] = fInputBuffer[2]; // Payload header (2nd byte)
-	  fInputBuffer[2] = 0x80 | nal_unit_type; // FU header (with S bit)
+	  u_int8_t nal_unit_type = (fNALUnit[0]&0x7E)>>1;
+	  fFUHeader[0] = (fNALUnit[0] & 0x81) | (49<<1); // Payload header (1st byte)
+	  fFUHeader[1] = fNALUnit[1]; // Payload header (2nd byte)
+	  fFUHeader[2] = 0x80 | nal_unit_type; // FU header (with S bit)
 	}
-	memmove(fTo, fInputBuffer, fMaxSize);
+	unsigned const numNALHeaderBytes = numFUHeaderBytes - 1; // these are replaced by the FU header bytes
+	memmove(fTo, fFUHeader, numFUHeaderBytes);
+	memmove(&fTo[numFUHeaderBytes], &fNALUnit[numNALHeaderBytes], fMaxSize - numFUHeaderBytes);
 	fFrameSize = fMaxSize;
-	fCurDataOffset += fMaxSize - 1;
+	fCurDataOffset = numNALHeaderBytes + (fMaxSize - numFUHeaderBytes);
 	fLastFragmentCompletedNALUnit = False;
       }
     } else { // case 3
       // We are sending this NAL unit data as FU packets.  We've already sent the
       // first packet (fragment).  Now, send the next fragment.  Note that we add
-      // "NAL header" and "FU header" bytes to the front.  (We reuse these bytes that
+      // "NAL header" and "FU header" bytes to the front.  (We reuse the bytes that
       // we already sent for the first fragment, but clear the S bit, and add the E
       // bit if this is the last fragment.)
-      unsigned numExtraHeaderBytes;
-      if (fHNumber == 264) {
-	fInputBuffer[fCurDataOffset-2] = fInputBuffer[0]; // FU indicator
-	fInputBuffer[fCurDataOffset-1] = fInputBuffer[1]&~0x80; // FU header (no S bit)
-	numExtraHeaderBytes = 2;
-      } else { // 265
-	fInputBuffer[fCurDataOffset-3] = fInputBuffer[0]; // Payload header (1st byte)
-	fInputBuffer[fCurDataOffset-2] = fInputBuffer[1]; // Payload header (2nd byte)
-	fInputBuffer[fCurDataOffset-1] = fInputBuffer[2]&~0x80; // FU header (no S bit)
-	numExtraHeaderBytes = 3;
-      }
-      unsigned numBytesToSend = numExtraHeaderBytes + (fNumValidDataBytes - fCurDataOffset);
+      fFUHeader[numFUHeaderBytes-1] &=~ 0x80; // FU header (no S bit)
+      unsigned numBytesToSend = numFUHeaderBytes + (fNALUnitSize - fCurDataOffset);
       if (numBytesToSend > fMaxSize) {
 	// We can't send all of the remaining data this time:
 	numBytesToSend = fMaxSize;
 	fLastFragmentCompletedNALUnit = False;
       } else {
 	// This is the last fragment:
-	fInputBuffer[fCurDataOffset-1] |= 0x40; // set the E bit in the FU header
+	fFUHeader[numFUHeaderBytes-1] |= 0x40; // set the E bit in the FU header
 	fNumTruncatedBytes = fSaveNumTruncatedBytes;
       }
-      memmove(fTo, &fInputBuffer[fCurDataOffset-numExtraHeaderBytes], numBytesToSend);
+      memmove(fTo, fFUHeader, numFUHeaderBytes);
+      memmove(&fTo[numFUHeaderBytes], &fNALUnit[fCurDataOffset], numBytesToSend - numFUHeaderBytes);
       fFrameSize = numBytesToSend;
-      fCurDataOffset += numBytesToSend - numExtraHeaderBytes;
+      fCurDataOffset += numBytesToSend - numFUHeaderBytes;
     }
 
-    if (fCurDataOffset >= fNumValidDataBytes) {
+    if (fCurDataOffset >= fNALUnitSize) {
       // We're done with this data.  Reset the pointers for receiving new data:
-      fNumValidDataBytes = fCurDataOffset = 1;
+      doneWithNALUnit();
     }
 
     // Complete delivery to the client:
@@ -283,7 +289,13 @@ void H264or5Fragmenter::afterGettingFrame1(unsigned frameSize,
 					   unsigned numTruncatedBytes,
 					   struct timeval presentationTime,
 					   unsigned durationInMicroseconds) {
-  fNumValidDataBytes += frameSize;
+  fNALUnit = fInputBuffer;
+  if (!fInputSource->takeBorrowedFrame(fNALUnit, fBorrowedNALUnitReleaseFunc, fBorrowedNALUnitReleaseClientData)) {
+    fBorrowedNALUnitReleaseFunc = NULL;
+  }
+  fNALUnitSize = frameSize;
+  fCurDataOffset = 0;
+  if (fNALUnitSize == 0) doneWithNALUnit(); // there's nothing to deliver, so read again
   fSaveNumTruncatedBytes = numTruncatedBytes;
   fPresentationTime = presentationTime;
   fDurationInMicroseconds = durationInMicroseconds;
@@ -293,7 +305,17 @@ void H264or5Fragmenter::afterGettingFrame1(unsigned frameSize,
 }
 
 void H264or5Fragmenter::reset() {
-  fNumValidDataBytes = fCurDataOffset = 1;
+  doneWithNALUnit();
   fSaveNumTruncatedBytes = 0;
   fLastFragmentCompletedNALUnit = True;
 }
+
+void H264or5Fragmenter::doneWithNALUnit() {
+  if (fBorrowedNALUnitReleaseFunc != NULL) {
+    releaseFrameFunc* releaseFunc = fBorrowedNALUnitReleaseFunc;
+    fBorrowedNALUnitReleaseFunc = NULL;
+    (*releaseFunc)(fBorrowedNALUnitReleaseClientData, fNALUnit);
+  }
+  fNALUnit = NULL;
+  fNALUnitSize = fCurDataOffset = 0;
+}
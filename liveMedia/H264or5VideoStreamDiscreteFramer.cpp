@@ -97,6 +97,9 @@ void H264or5VideoStreamDiscreteFramer::doGetNextFrame() {
     // Arrange to read data (which should be a complete H.264 or H.265 NAL unit)
     // from our data source, directly into the client's input buffer.
     // After reading this, we'll do some parsing on the frame.
+    // (If our client accepts borrowed frames, and we're not prepending a start code, then our source may lend us the
+    // NAL unit instead, and we pass it on to our client, without copying it.)
+    if (borrowedFrameIsAllowed() && !fIncludeStartCodeInOutput) fInputSource->allowBorrowedFrame();
     fInputSource->getNextFrame(fTo, fMaxSize,
 			       afterGettingFrame, this,
 			       FramedSource::handleClosure, this);
@@ -116,12 +119,17 @@ void H264or5VideoStreamDiscreteFramer
 ::afterGettingFrame1(unsigned frameSize, unsigned numTruncatedBytes,
                      struct timeval presentationTime,
                      unsigned durationInMicroseconds) {
+  // Check whether our source lent us the NAL unit (rather than copying it to "fTo"):
+  u_int8_t* frame = fTo;
+  releaseFrameFunc* releaseFunc; void* releaseClientData;
+  Boolean const frameIsBorrowed = fInputSource->takeBorrowedFrame(frame, releaseFunc, releaseClientData);
+
   // Get the "nal_unit_type", to see if this NAL unit is one that we want to save a copy of:
   u_int8_t nal_unit_type;
   if (fHNumber == 264 && frameSize >= 1) {
-    nal_unit_type = fTo[0]&0x1F;
+    nal_unit_type = frame[0]&0x1F;
   } else if (fHNumber == 265 && frameSize >= 2) {
-    nal_unit_type = (fTo[0]&0x7E)>>1;
+    nal_unit_type = (frame[0]&0x7E)>>1;
   } else {
     // This is too short to be a valid NAL unit, so just assume a bogus nal_unit_type
     nal_unit_type = 0xFF;
@@ -132,20 +140,24 @@ void H264or5VideoStreamDiscreteFramer
   // *not* data that consists of discrete NAL units.)
   // Once again, to be clear: The NAL units that you feed to a "H264or5VideoStreamDiscreteFramer"
   // MUST NOT include start codes.
-  if (frameSize >= 4 && fTo[0] == 0 && fTo[1] == 0 && ((fTo[2] == 0 && fTo[3] == 1) || fTo[2] == 1)) {
+  if (frameSize >= 4 && frame[0] == 0 && frame[1] == 0 && ((frame[2] == 0 && frame[3] == 1) || frame[2] == 1)) {
     envir() << "H264or5VideoStreamDiscreteFramer error: MPEG 'start code' seen in the input\n";
   } else if (isVPS(nal_unit_type)) { // Video parameter set (VPS)
-    saveCopyOfVPS(fTo, frameSize);
+    saveCopyOfVPS(frame, frameSize);
   } else if (isSPS(nal_unit_type)) { // Sequence parameter set (SPS)
-    saveCopyOfSPS(fTo, frameSize);
+    saveCopyOfSPS(frame, frameSize);
   } else if (isPPS(nal_unit_type)) { // Picture parameter set (PPS)
-    saveCopyOfPPS(fTo, frameSize);
+    saveCopyOfPPS(frame, frameSize);
   }
 
   fPictureEndMarker = nalUnitEndsAccessUnit(nal_unit_type);
 
   // Finally, complete delivery to the client:
-  fFrameSize = fIncludeStartCodeInOutput ? (4+frameSize) : frameSize;
+  if (frameIsBorrowed) {
+    deliverBorrowedFrame(frame, frameSize, releaseFunc, releaseClientData); // pass it on
+  } else {
+    fFrameSize = fIncludeStartCodeInOutput ? (4+frameSize) : frameSize;
+  }
   fNumTruncatedBytes = numTruncatedBytes;
   fPresentationTime = presentationTime;
   fDurationInMicroseconds = durationInMicroseconds;
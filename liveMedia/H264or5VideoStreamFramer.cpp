@@ -52,9 +52,9 @@ private:
 
   void analyze_video_parameter_set_data(unsigned& num_units_in_tick, unsigned& time_scale);
   void analyze_seq_parameter_set_data(unsigned& num_units_in_tick, unsigned& time_scale);
-  void profile_tier_level(BitVector& bv, unsigned max_sub_layers_minus1);
-  void analyze_vui_parameters(BitVector& bv, unsigned& num_units_in_tick, unsigned& time_scale);
-  void analyze_hrd_parameters(BitVector& bv);
+  void profile_tier_level(BitReader& bv, unsigned max_sub_layers_minus1);
+  void analyze_vui_parameters(BitReader& bv, unsigned& num_units_in_tick, unsigned& time_scale);
+  void analyze_hrd_parameters(BitReader& bv);
   void analyze_sei_data(u_int8_t nal_unit_type);
   void analyze_sei_payload(unsigned payloadType, unsigned payloadSize, u_int8_t* payload);
 
@@ -356,7 +356,7 @@ public:
 #define DEBUG_TAB do {} while (0)
 #endif
 
-void H264or5VideoStreamParser::profile_tier_level(BitVector& bv, unsigned max_sub_layers_minus1) {
+void H264or5VideoStreamParser::profile_tier_level(BitReader& bv, unsigned max_sub_layers_minus1) {
   bv.skipBits(96);
 
   unsigned i;
@@ -379,7 +379,7 @@ void H264or5VideoStreamParser::profile_tier_level(BitVector& bv, unsigned max_su
 }
 
 void H264or5VideoStreamParser
-::analyze_vui_parameters(BitVector& bv,
+::analyze_vui_parameters(BitReader& bv,
 			 unsigned& num_units_in_tick, unsigned& time_scale) {
   Boolean aspect_ratio_info_present_flag = bv.get1BitBoolean();
   DEBUG_PRINT(aspect_ratio_info_present_flag);
@@ -463,7 +463,7 @@ void H264or5VideoStreamParser
   DEBUG_PRINT(pic_struct_present_flag);
 }
 
-void H264or5VideoStreamParser::analyze_hrd_parameters(BitVector& bv) {
+void H264or5VideoStreamParser::analyze_hrd_parameters(BitReader& bv) {
   DEBUG_TAB;
   unsigned cpb_cnt_minus1 = bv.get_expGolomb();
   DEBUG_PRINT(cpb_cnt_minus1);
@@ -500,7 +500,7 @@ void H264or5VideoStreamParser
   unsigned vpsSize;
   removeEmulationBytes(vps, sizeof vps, vpsSize);
 
-  BitVector bv(vps, 0, 8*vpsSize);
+  BitReader bv(vps, 0, 8*vpsSize);
 
   // Assert: fHNumber == 265 (because this function is called only when parsing H.265)
   unsigned i;
@@ -553,7 +553,7 @@ void H264or5VideoStreamParser
   unsigned spsSize;
   removeEmulationBytes(sps, sizeof sps, spsSize);
 
-  BitVector bv(sps, 0, 8*spsSize);
+  BitReader bv(sps, 0, 8*spsSize);
 
   if (fHNumber == 264) {
     bv.skipBits(8); // forbidden_zero_bit; nal_ref_idc; nal_unit_type
@@ -930,7 +930,7 @@ void H264or5VideoStreamParser::analyze_sei_data(u_int8_t nal_unit_type) {
 void H264or5VideoStreamParser
 ::analyze_sei_payload(unsigned payloadType, unsigned payloadSize, u_int8_t* payload) {
   if (payloadType == 1/* pic_timing, for both H.264 and H.265 */) {
-    BitVector bv(payload, 0, 8*payloadSize);
+    BitReader bv(payload, 0, 8*payloadSize);
 
     DEBUG_TAB;
     if (CpbDpbDelaysPresentFlag) {
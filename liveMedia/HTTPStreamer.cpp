@@ -0,0 +1,441 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// A sink that delivers a "ServerMediaSession" - as a MPEG Transport Stream - to one or more HTTP clients
+// Implementation
+
+#include "HTTPStreamer.hh"
+#include "MPEG2TransportStreamFramer.hh"
+#include "MPEG2TransportStreamFromESSource.hh"
+#include "H264VideoStreamDiscreteFramer.hh"
+#include "H265VideoStreamDiscreteFramer.hh"
+#include "RTSPCommon.hh" // for "dateHeader()"
+#include "liveMedia_version.hh"
+#include <GroupsockHelper.hh>
+
+#ifndef HTTP_STREAMER_SOCKET_SEND_BUFFER_SIZE
+#define HTTP_STREAMER_SOCKET_SEND_BUFFER_SIZE (256*1024)
+#endif
+
+////////// HTTPStreamerChunk //////////
+
+// Data to be sent to one or more clients.  It's deleted when the last of these has sent it.
+
+class HTTPStreamerChunk {
+public:
+  HTTPStreamerChunk(char const* prefix, unsigned char const* data, unsigned dataSize, char const* suffix)
+    : fReferenceCount(0) {
+    unsigned const prefixSize = strlen(prefix);
+    unsigned const suffixSize = strlen(suffix);
+    fSize = prefixSize + dataSize + suffixSize;
+    fBytes = new unsigned char[fSize];
+    memcpy(fBytes, prefix, prefixSize);
+    if (dataSize > 0) memcpy(&fBytes[prefixSize], data, dataSize);
+    memcpy(&fBytes[prefixSize+dataSize], suffix, suffixSize);
+  }
+
+  void incrementReferenceCount() { ++fReferenceCount; }
+  void decrementReferenceCount() { if (--fReferenceCount == 0) delete this; }
+
+public:
+  unsigned char* fBytes;
+  unsigned fSize;
+
+private:
+  virtual ~HTTPStreamerChunk() { delete[] fBytes; }
+
+private:
+  unsigned fReferenceCount;
+};
+
+
+////////// HTTPStreamerClient //////////
+
+class HTTPStreamerClient {
+public:
+  HTTPStreamerClient(HTTPStreamer& streamer, int socketNum);
+  virtual ~HTTPStreamerClient();
+
+  Boolean enqueue(HTTPStreamerChunk* chunk, Boolean isFinalChunk);
+      // Returns False (without queueing "chunk") if our queue is full
+  Boolean sendQueuedData();
+      // Returns False if the client has gone away, or if we've sent it all of its data (so it should be removed)
+
+public:
+  HTTPStreamerClient* fNext;
+
+private:
+  void updateBackgroundHandling();
+  static void socketHandler(void* clientData, int mask);
+  void socketHandler1(int mask);
+
+private:
+  HTTPStreamer& fStreamer;
+  int fSocketNum;
+  HTTPStreamerChunk* fQueue[HTTP_STREAMER_MAX_QUEUED_CHUNKS]; // a circular buffer
+  unsigned fQueueHead, fQueueSize;
+  unsigned fNumBytesSentFromHead;
+  Boolean fHaveQueuedFinalChunk, fAreHandlingWritability;
+};
+
+HTTPStreamerClient::HTTPStreamerClient(HTTPStreamer& streamer, int socketNum)
+  : fNext(NULL), fStreamer(streamer), fSocketNum(socketNum),
+    fQueueHead(0), fQueueSize(0), fNumBytesSentFromHead(0),
+    fHaveQueuedFinalChunk(False), fAreHandlingWritability(False) {
+  increaseSendBufferTo(fStreamer.envir(), fSocketNum, HTTP_STREAMER_SOCKET_SEND_BUFFER_SIZE);
+  fStreamer.envir().taskScheduler()
+    .setBackgroundHandling(fSocketNum, SOCKET_READABLE|SOCKET_EXCEPTION, socketHandler, this);
+}
+
+HTTPStreamerClient::~HTTPStreamerClient() {
+  fStreamer.envir().taskScheduler().disableBackgroundHandling(fSocketNum);
+  ::closeSocket(fSocketNum);
+
+  while (fQueueSize > 0) {
+    fQueue[fQueueHead]->decrementReferenceCount();
+    fQueueHead = (fQueueHead+1)%HTTP_STREAMER_MAX_QUEUED_CHUNKS;
+    --fQueueSize;
+  }
+}
+
+Boolean HTTPStreamerClient::enqueue(HTTPStreamerChunk* chunk, Boolean isFinalChunk) {
+  if (fQueueSize == HTTP_STREAMER_MAX_QUEUED_CHUNKS) return False;
+
+  chunk->incrementReferenceCount();
+  fQueue[(fQueueHead+fQueueSize)%HTTP_STREAMER_MAX_QUEUED_CHUNKS] = chunk;
+  ++fQueueSize;
+  if (isFinalChunk) fHaveQueuedFinalChunk = True;
+
+  return True;
+}
+
+Boolean HTTPStreamerClient::sendQueuedData() {
+  while (fQueueSize > 0) {
+    HTTPStreamerChunk* chunk = fQueue[fQueueHead];
+    int result = send(fSocketNum, (char const*)&chunk->fBytes[fNumBytesSentFromHead],
+		      chunk->fSize - fNumBytesSentFromHead, MSG_NOSIGNAL);
+    if (result < 0) {
+      int const err = fStreamer.envir().getErrno();
+      if (err != EAGAIN && err != EWOULDBLOCK) return False; // the client has gone away
+      break; // we'll try again when the socket becomes writable
+    }
+
+    fNumBytesSentFromHead += result;
+    if (fNumBytesSentFromHead < chunk->fSize) break; // the socket's send buffer is full
+
+    // We've sent this chunk:
+    chunk->decrementReferenceCount();
+    fQueueHead = (fQueueHead+1)%HTTP_STREAMER_MAX_QUEUED_CHUNKS;
+    --fQueueSize;
+    fNumBytesSentFromHead = 0;
+  }
+
+  if (fQueueSize == 0 && fHaveQueuedFinalChunk) return False; // we're done
+
+  updateBackgroundHandling();
+  return True;
+}
+
+void HTTPStreamerClient::updateBackgroundHandling() {
+  // We always handle readability (to detect the client closing its connection), but handle writability only while we
+  // have queued data that couldn't be sent immediately:
+  Boolean const needToHandleWritability = fQueueSize > 0;
+  if (needToHandleWritability == fAreHandlingWritability) return; // no change
+
+  fAreHandlingWritability = needToHandleWritability;
+  fStreamer.envir().taskScheduler()
+    .setBackgroundHandling(fSocketNum, SOCKET_READABLE|SOCKET_EXCEPTION|(fAreHandlingWritability ? SOCKET_WRITABLE : 0),
+			   socketHandler, this);
+}
+
+void HTTPStreamerClient::socketHandler(void* clientData, int mask) {
+  HTTPStreamerClient* client = (HTTPStreamerClient*)clientData;
+  client->socketHandler1(mask);
+}
+
+void HTTPStreamerClient::socketHandler1(int mask) {
+  if ((mask&SOCKET_EXCEPTION) != 0) {
+    fStreamer.removeClient(this);
+    return;
+  }
+
+  if ((mask&SOCKET_READABLE) != 0) {
+    // We don't expect any more data from the client (and ignore it if we get it), but check whether it has gone away:
+    char buffer[1000];
+    int result = recv(fSocketNum, buffer, sizeof buffer, 0);
+    if (result == 0 || (result < 0 && fStreamer.envir().getErrno() != EAGAIN
+			&& fStreamer.envir().getErrno() != EWOULDBLOCK)) {
+      fStreamer.removeClient(this);
+      return;
+    }
+  }
+
+  if ((mask&SOCKET_WRITABLE) != 0 && !sendQueuedData()) {
+    fStreamer.removeClient(this);
+    return;
+  }
+}
+
+
+////////// HTTPStreamer implementation //////////
+
+HTTPStreamer* HTTPStreamer::createNew(UsageEnvironment& env, ServerMediaSession& session, unsigned clientSessionId,
+				      HTTPStreamerEndedFunc* endedFunc, void* endedClientData) {
+  HTTPStreamer* streamer = new HTTPStreamer(env, session, clientSessionId, endedFunc, endedClientData);
+  if (streamer->fTSSource == NULL) {
+    // We couldn't find anything to stream:
+    Medium::close(streamer);
+    return NULL;
+  }
+
+  return streamer;
+}
+
+HTTPStreamer::HTTPStreamer(UsageEnvironment& env, ServerMediaSession& session, unsigned clientSessionId,
+			   HTTPStreamerEndedFunc* endedFunc, void* endedClientData)
+  : MediaSink(env), fSession(session), fClientSessionId(clientSessionId), fIsShared(True), fHasEnded(False),
+    fNumInputs(0), fTSSource(NULL), fWeCreatedTSSource(False),
+    fClients(NULL), fNumClients(0), fNumChunksDropped(0),
+    fEndedFunc(endedFunc), fEndedClientData(endedClientData), fEndedTask(NULL) {
+  fBuffer = new unsigned char[HTTP_STREAMER_CHUNK_SIZE];
+
+  // Get a source for each of our session's subsessions that we can deliver.  If one of these is already a Transport
+  // Stream, then we deliver just that.  Otherwise, we multiplex the Elementary Streams into a new Transport Stream:
+  ServerMediaSubsessionIterator iter(fSession);
+  ServerMediaSubsession* subsession;
+  while ((subsession = iter.next()) != NULL && fNumInputs < HTTP_STREAMER_MAX_INPUT_SOURCES) {
+    Boolean sourceCanBeShared;
+    FramedSource* source = subsession->createNewNonRTPStreamSource(fClientSessionId, sourceCanBeShared);
+    if (source == NULL) continue;
+
+    if (source->isMPEG2TransportStreamFramer()) {
+      if (fTSSource == NULL) {
+	fTSSource = source;
+	fIsShared = sourceCanBeShared;
+	// Close any Elementary Stream sources that we've already created:
+	for (unsigned i = 0; i < fNumInputs; ++i) {
+	  fInputFramers[i]->detachInputSource();
+	  Medium::close(fInputFramers[i]);
+	  fInputSubsessions[i]->closeNonRTPStreamSource(fInputSources[i]);
+	}
+	fNumInputs = 0;
+	fInputSubsessions[fNumInputs] = subsession;
+	fInputSources[fNumInputs] = source;
+	fInputFramers[fNumInputs] = NULL;
+	++fNumInputs;
+	continue;
+      }
+    } else if (fTSSource == NULL) {
+      // Video Elementary Stream sources deliver NAL units without start codes; we add these back, because our
+      // Transport Stream multiplexor needs them:
+      FramedFilter* framer = NULL;
+      if (source->isH264VideoStreamFramer()) {
+	framer = H264VideoStreamDiscreteFramer::createNew(envir(), source, True/*includeStartCodeInOutput*/);
+      } else if (source->isH265VideoStreamFramer()) {
+	framer = H265VideoStreamDiscreteFramer::createNew(envir(), source, True/*includeStartCodeInOutput*/);
+      }
+      if (framer != NULL) {
+	if (!sourceCanBeShared) fIsShared = False;
+	fInputSubsessions[fNumInputs] = subsession;
+	fInputSources[fNumInputs] = source;
+	fInputFramers[fNumInputs] = framer;
+	++fNumInputs;
+	continue;
+      }
+    }
+
+    // We can't use this source:
+    subsession->closeNonRTPStreamSource(source);
+  }
+
+  if (fTSSource == NULL && fNumInputs > 0) {
+    MPEG2TransportStreamFromESSource* multiplexor = MPEG2TransportStreamFromESSource::createNew(envir());
+    for (unsigned i = 0; i < fNumInputs; ++i) {
+      multiplexor->addNewVideoSource(fInputFramers[i], fInputSources[i]->isH264VideoStreamFramer() ? 5 : 6);
+    }
+
+    // Use a 'framer' to compute the duration of each chunk that we read (from the Transport Stream's PCRs):
+    fTSSource = MPEG2TransportStreamFramer::createNew(envir(), multiplexor);
+    fWeCreatedTSSource = True;
+  }
+}
+
+HTTPStreamer::~HTTPStreamer() {
+  envir().taskScheduler().unscheduleDelayedTask(fEndedTask);
+  envir().taskScheduler().unscheduleDelayedTask(nextTask());
+
+  while (fClients != NULL) {
+    HTTPStreamerClient* client = fClients;
+    fClients = client->fNext;
+    delete client;
+  }
+
+  stopPlaying();
+  closeSources();
+  delete[] fBuffer;
+}
+
+void HTTPStreamer::closeSources() {
+  if (fWeCreatedTSSource) {
+    // Close the objects that we created, but not the subsessions' sources (which we close using the subsessions):
+    for (unsigned i = 0; i < fNumInputs; ++i) fInputFramers[i]->detachInputSource();
+    Medium::close(fTSSource); // also closes our multiplexor and "fInputFramers[]"
+  }
+  for (unsigned i = 0; i < fNumInputs; ++i) {
+    fInputSubsessions[i]->closeNonRTPStreamSource(fInputSources[i]);
+  }
+  fNumInputs = 0;
+  fTSSource = NULL;
+}
+
+void HTTPStreamer::addClient(int socketNum) {
+  HTTPStreamerClient* client = new HTTPStreamerClient(*this, socketNum);
+  client->fNext = fClients;
+  fClients = client;
+  ++fNumClients;
+
+  // Begin by sending our response header:
+  char header[300];
+  snprintf(header, sizeof header,
+	   "HTTP/1.1 200 OK\r\n"
+	   "%s"
+	   "Server: LIVE555 Streaming Media v%s\r\n"
+	   "Content-Type: video/mp2t\r\n"
+	   "Transfer-Encoding: chunked\r\n"
+	   "Cache-Control: no-cache\r\n"
+	   "Connection: close\r\n"
+	   "\r\n",
+	   dateHeader(), LIVEMEDIA_LIBRARY_VERSION_STRING);
+  HTTPStreamerChunk* headerChunk = new HTTPStreamerChunk(header, NULL, 0, "");
+  client->enqueue(headerChunk, False);
+  if (!client->sendQueuedData()) {
+    removeClient(client);
+    return;
+  }
+
+  if (fSource == NULL && !fHasEnded) {
+    // This is our first client, so start reading our Transport Stream:
+    gettimeofday(&fNextReadTime, NULL);
+    startPlaying(*fTSSource, afterPlaying, this);
+  }
+}
+
+void HTTPStreamer::removeClient(HTTPStreamerClient* client) {
+  // Remove "client" from our list:
+  if (fClients == client) {
+    fClients = client->fNext;
+  } else {
+    for (HTTPStreamerClient* c = fClients; c != NULL; c = c->fNext) {
+      if (c->fNext == client) {
+	c->fNext = client->fNext;
+	break;
+      }
+    }
+  }
+  delete client;
+
+  if (--fNumClients == 0) noteNoClients();
+}
+
+void HTTPStreamer::noteNoClients() {
+  // Tell our owner - from the event loop (because we might be being called from one of our own member functions) - that
+  // we no longer have any clients:
+  if (fEndedTask == NULL) fEndedTask = envir().taskScheduler().scheduleDelayedTask(0, endedHandler, this);
+}
+
+void HTTPStreamer::endedHandler(void* clientData) {
+  HTTPStreamer* streamer = (HTTPStreamer*)clientData;
+  streamer->fEndedTask = NULL;
+  if (streamer->fNumClients == 0 && streamer->fEndedFunc != NULL) {
+    (*streamer->fEndedFunc)(streamer->fEndedClientData, streamer); // this will probably close "streamer"
+  }
+}
+
+void HTTPStreamer::deliverChunk(HTTPStreamerChunk* chunk, Boolean isFinalChunk) {
+  chunk->incrementReferenceCount(); // so that it doesn't get deleted while we're using it
+
+  HTTPStreamerClient* nextClient;
+  for (HTTPStreamerClient* client = fClients; client != NULL; client = nextClient) {
+    nextClient = client->fNext; // in case "client" gets removed
+    if (!client->enqueue(chunk, isFinalChunk)) {
+      // This client's queue is full (i.e., it's not keeping up with the stream), so it won't get this chunk.
+      // (If this is the final chunk, then we just close the connection.)
+      if (isFinalChunk) removeClient(client); else ++fNumChunksDropped;
+    }
+  }
+  for (HTTPStreamerClient* client = fClients; client != NULL; client = nextClient) {
+    nextClient = client->fNext; // in case "client" gets removed
+    if (!client->sendQueuedData()) removeClient(client);
+  }
+
+  chunk->decrementReferenceCount();
+}
+
+Boolean HTTPStreamer::continuePlaying() {
+  if (fSource == NULL) return False;
+
+  fSource->getNextFrame(fBuffer, HTTP_STREAMER_CHUNK_SIZE, afterGettingFrame, this, onSourceClosure, this);
+  return True;
+}
+
+void HTTPStreamer::afterGettingFrame(void* clientData, unsigned frameSize, unsigned /*numTruncatedBytes*/,
+				     struct timeval /*presentationTime*/, unsigned durationInMicroseconds) {
+  HTTPStreamer* streamer = (HTTPStreamer*)clientData;
+  streamer->afterGettingFrame1(frameSize, durationInMicroseconds);
+}
+
+void HTTPStreamer::afterGettingFrame1(unsigned frameSize, unsigned durationInMicroseconds) {
+  if (frameSize > 0) {
+    char chunkHeader[20];
+    sprintf(chunkHeader, "%X\r\n", frameSize);
+    deliverChunk(new HTTPStreamerChunk(chunkHeader, fBuffer, frameSize, "\r\n"), False);
+  }
+
+  // Read the next chunk - after a delay, if needed, to deliver the stream at its natural rate:
+  fNextReadTime.tv_usec += durationInMicroseconds;
+  fNextReadTime.tv_sec += fNextReadTime.tv_usec/1000000;
+  fNextReadTime.tv_usec %= 1000000;
+
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  int secsDiff = fNextReadTime.tv_sec - timeNow.tv_sec;
+  int64_t uSecondsToGo = (int64_t)secsDiff*1000000 + (fNextReadTime.tv_usec - timeNow.tv_usec);
+  if (uSecondsToGo < 0 || durationInMicroseconds == 0) {
+    // We're behind (or our source is 'live', and so paces itself).  Don't try to catch up later:
+    uSecondsToGo = 0;
+    fNextReadTime = timeNow;
+  }
+  nextTask() = envir().taskScheduler().scheduleDelayedTask(uSecondsToGo, readNext, this);
+}
+
+void HTTPStreamer::readNext(void* clientData) {
+  HTTPStreamer* streamer = (HTTPStreamer*)clientData;
+  streamer->nextTask() = NULL;
+  streamer->continuePlaying();
+}
+
+void HTTPStreamer::afterPlaying(void* clientData) {
+  HTTPStreamer* streamer = (HTTPStreamer*)clientData;
+  streamer->afterPlaying1();
+}
+
+void HTTPStreamer::afterPlaying1() {
+  // Our stream has ended.  End each client's response (after any data that's still queued for it):
+  fHasEnded = True;
+  deliverChunk(new HTTPStreamerChunk("0\r\n\r\n", NULL, 0, ""), True);
+  if (fNumClients == 0) noteNoClients();
+}
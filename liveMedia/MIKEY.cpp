@@ -69,13 +69,15 @@ enum MIKEYPayloadType {
 		       HDR = 255
 };
 
-MIKEYState::MIKEYState(Boolean useEncryption)
+MIKEYState::MIKEYState(Boolean useEncryption, Boolean useAESGCM)
   : // Set default encryption/authentication parameters:
   fEncryptSRTP(useEncryption),
   fEncryptSRTCP(useEncryption),
+  fUseAESGCM(useEncryption && useAESGCM),
+  fKeyDataLength(fUseAESGCM ? 16+12 : 16+14),
   fMKI(our_random32()),
   fInitialROC(0),
-  fUseAuthentication(True),
+  fUseAuthentication(!fUseAESGCM), // because AES-GCM provides its own authentication
 
   fHeaderPayload(NULL), fTailPayload(NULL), fTotalPayloadByteCount(0) {
   // Fill in our 'key data' (30 bytes) with (pseudo-)random bits:
@@ -109,8 +111,8 @@ MIKEYState::~MIKEYState() {
   delete fHeaderPayload; // which will delete all the other payloads as well
 }
 
-MIKEYState* MIKEYState::createNew(Boolean useEncryption) {
-  return new MIKEYState(useEncryption);
+MIKEYState* MIKEYState::createNew(Boolean useEncryption, Boolean useAESGCM) {
+  return new MIKEYState(useEncryption, useAESGCM);
 }
 
 MIKEYState* MIKEYState::createNew(u_int8_t const* messageToParse, unsigned messageSize) {
@@ -172,6 +174,8 @@ MIKEYState::MIKEYState(u_int8_t const* messageToParse, unsigned messageSize, Boo
     // later as we parse the message):
   fEncryptSRTP(False),
   fEncryptSRTCP(False),
+  fUseAESGCM(False),
+  fKeyDataLength(0),
   fUseAuthentication(False),
 
   fHeaderPayload(NULL), fTailPayload(NULL), fTotalPayloadByteCount(0) {
@@ -189,6 +193,9 @@ MIKEYState::MIKEYState(u_int8_t const* messageToParse, unsigned messageSize, Boo
     if (!parseNonHDRPayload(ptr, endPtr, nextPayloadType)) return;
   }
 
+  // Check that the key data is the right size for the ciphersuite:
+  if (fKeyDataLength != (fUseAESGCM ? 16+12u : 16+14u)) return;
+
   // We succeeded in parsing all the data:
   parsedOK = True;
 }
@@ -313,10 +320,11 @@ Boolean MIKEYState
 	  // Check types that we understand:
 	  Boolean policyIsOK = False; // until we learn otherwise
 	  switch (ppType) {
-	    case 0: { // Encryption algorithm: we handle only NULL and AES-CM
+	    case 0: { // Encryption algorithm: we handle only NULL, AES-CM, and AES-GCM (RFC 7714)
 	      if (ppLength != 1) break;
 	      u_int8_t value = ptr[0];
-	      if (value > 1) break; // unsupported algorithm
+	      if (value == 7/*AES-GCM*/) fUseAESGCM = True;
+	      else if (value > 1) break; // unsupported algorithm
 	      if (value > 0) fEncryptSRTP = fEncryptSRTCP = True;
 	          // Note: these might get changed by a subsequent "off/on" entry
 	      policyIsOK = True;
@@ -348,7 +356,7 @@ Boolean MIKEYState
 	    case 4: { // Session Salt key length
 	      if (ppLength != 1) break;
 	      u_int8_t value = ptr[0];
-	      if (value != 14) break; // bad/unsupported value
+	      if (value != 14 && value != 12/*AES-GCM*/) break; // bad/unsupported value
 	      policyIsOK = True;
 	      break;
 	    }
@@ -383,6 +391,13 @@ Boolean MIKEYState
 	      policyIsOK = True;
 	      break;
 	    }
+	    case 20: { // AEAD authentication tag length (RFC 5669)
+	      if (ppLength != 1) break;
+	      u_int8_t value = ptr[0];
+	      if (value != 16) break; // bad/unsupported value
+	      policyIsOK = True;
+	      break;
+	    }
 	    default: { // a policy type that we don't handle; still OK
 	      policyIsOK = True;	
 	      break;
@@ -423,8 +438,10 @@ Boolean MIKEYState
 	      //   to be ignored by clients.
 	  if (*subPtr++ != ((2<<4)|1)) break; // Type 2 (TEK) | KV 1 (SPI/MKI) 
 	  u_int16_t keyDataLen = get2Bytes(subPtr);
-	  // The key data length must be 30 (encryption key length (16) + salt length (14)):
-	  if (keyDataLen != 30) break;
+	  // The key data length must be 30 (encryption key length (16) + salt length (14)), or 28 for AES-GCM (which uses
+	  // a 12-byte salt):
+	  if (keyDataLen != 30 && keyDataLen != 28) break;
+	  fKeyDataLength = keyDataLen;
 
 	  // Make sure we have enough space for the key data and the "SPI Length" field:
 	  if (4+keyDataLen+1 > encrDataLen) break;
@@ -540,6 +557,26 @@ MIKEYPayload
       break;
     }
     case SP: { // RFC 3830, section 6.10
+      if (fOurMIKEYState.useAESGCM()) { // RFC 7714, section 14.3
+	fDataSize = 29;
+	fData = new u_int8_t[fDataSize];
+	u_int8_t* p = fData;
+	*p++ = 0; // no next payload (initially)
+	*p++ = 0; // Policy number
+	*p++ = 0; // Protocol type: SRTP
+	u_int16_t policyParamLen = 24;
+	addHalfWord(p, policyParamLen);
+	// Now add the SRTP policy parameters:
+	add1BytePolicyParam(p, 0/*Encryption algorithm*/, 7/*AES-GCM*/);
+	add1BytePolicyParam(p, 1/*Session Encryption key length*/, 16);
+	add1BytePolicyParam(p, 2/*Authentication algorithm*/, 0/*NULL*/);
+	add1BytePolicyParam(p, 4/*Session Salt key length*/, 12);
+	add1BytePolicyParam(p, 7/*SRTP encryption off/on*/, 1);
+	add1BytePolicyParam(p, 8/*SRTCP encryption off/on*/, 1);
+	add1BytePolicyParam(p, 10/*SRTP authentication off/on*/, 0);
+	add1BytePolicyParam(p, 20/*AEAD authentication tag length*/, 16);
+	break;
+      }
       fDataSize = 32;
       fData = new u_int8_t[fDataSize];
       u_int8_t* p = fData;
@@ -565,19 +602,19 @@ MIKEYPayload
       break;
     }
     case KEMAC: {  // RFC 3830, section 6.2
-      fDataSize = 44;
+      u_int16_t const keyDataLen = fOurMIKEYState.keyDataLength(); // 30 (or 28 for AES-GCM)
+      fDataSize = 14 + keyDataLen;
       fData = new u_int8_t[fDataSize];
       u_int8_t* p = fData;
       *p++ = 0; // no next payload
       *p++ = 0; // Encr alg (NULL)
-      u_int16_t encrDataLen = 39;
+      u_int16_t encrDataLen = 9 + keyDataLen;
       addHalfWord(p, encrDataLen);
       { // Key data sub-payload (RFC 3830, section 6.13):
 	*p++ = 0; // no next payload
 	*p++ = (2<<4)|1; // Type 2 (TEK) | KV 1 (SPI/MKI)
 
 	// Key data len:
-	u_int16_t const keyDataLen = 30;
 	addHalfWord(p, keyDataLen);
 
 	// Key data:
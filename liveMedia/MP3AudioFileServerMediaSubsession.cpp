@@ -178,3 +178,7 @@ void MP3AudioFileServerMediaSubsession::testScaleFactor(float& scale) {
 float MP3AudioFileServerMediaSubsession::duration() const {
   return fFileDuration;
 }
+
+void MP3AudioFileServerMediaSubsession::setDurationFromMetadataCache(float duration) {
+  fFileDuration = duration;
+}
@@ -165,6 +165,10 @@ MPEG1or2AudioStreamParser
 			FramedSource* inputSource)
   : StreamParser(inputSource, FramedSource::handleClosure, usingSource,
 		 &MPEG1or2AudioStreamFramer::continueReadProcessing, usingSource) {
+  if (usingSource->fSyncWithInputSource) {
+    // We need to see the presentation time of each read:
+    disablePrefetching();
+  }
 }
 
 MPEG1or2AudioStreamParser::~MPEG1or2AudioStreamParser() {
@@ -306,6 +306,8 @@ void ClientTrickPlayState::updateStateOnScaleChange() {
     // And generate a Transport Stream from this:
     fTrickPlaySource = MPEG2TransportStreamFromESSource::createNew(env);
     fTrickPlaySource->addNewVideoSource(fTrickModeFilter, fIndexFile->mpegVersion());
+    fTrickPlaySource->setPreferredFrameSize(TRANSPORT_PACKETS_PER_NETWORK_PACKET*TRANSPORT_PACKET_SIZE);
+      // so that each delivery fits in a single RTP packet (as with our original Transport Stream source)
 
     fFramer->changeInputSource(fTrickPlaySource);
   } else {
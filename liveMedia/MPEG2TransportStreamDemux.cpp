@@ -23,16 +23,18 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 MPEG2TransportStreamDemux* MPEG2TransportStreamDemux
 ::createNew(UsageEnvironment& env, FramedSource* inputSource,
-	    FramedSource::onCloseFunc* onCloseFunc, void* onCloseClientData) {
-  return new MPEG2TransportStreamDemux(env, inputSource, onCloseFunc, onCloseClientData);
+	    FramedSource::onCloseFunc* onCloseFunc, void* onCloseClientData,
+	    UsageEnvironment* const* workerEnvs, unsigned numWorkerEnvs) {
+  return new MPEG2TransportStreamDemux(env, inputSource, onCloseFunc, onCloseClientData, workerEnvs, numWorkerEnvs);
 }
 
 MPEG2TransportStreamDemux
 ::MPEG2TransportStreamDemux(UsageEnvironment& env, FramedSource* inputSource,
-			    FramedSource::onCloseFunc* onCloseFunc, void* onCloseClientData)
+			    FramedSource::onCloseFunc* onCloseFunc, void* onCloseClientData,
+			    UsageEnvironment* const* workerEnvs, unsigned numWorkerEnvs)
   : Medium(env),
     fOnCloseFunc(onCloseFunc), fOnCloseClientData(onCloseClientData) {
-  fParser = new MPEG2TransportStreamParser(inputSource, handleEndOfFile, this);
+  fParser = new MPEG2TransportStreamParser(inputSource, handleEndOfFile, this, workerEnvs, numWorkerEnvs);
 }
 
 MPEG2TransportStreamDemux::~MPEG2TransportStreamDemux() {
@@ -44,6 +46,17 @@ void MPEG2TransportStreamDemux::handleEndOfFile(void* clientData) {
 }
 
 void MPEG2TransportStreamDemux::handleEndOfFile() {
+  // If tracks are being delivered by worker threads, then wait until they've finished:
+  if (fParser->endWorkerTracks(handleEndOfTracks, this)) return;
+
+  handleEndOfTracks();
+}
+
+void MPEG2TransportStreamDemux::handleEndOfTracks(void* clientData) {
+  ((MPEG2TransportStreamDemux*)clientData)->handleEndOfTracks();
+}
+
+void MPEG2TransportStreamDemux::handleEndOfTracks() {
   if (fOnCloseFunc != NULL) (*fOnCloseFunc)(fOnCloseClientData);
   delete this;
 }
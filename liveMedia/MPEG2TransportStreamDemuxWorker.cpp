@@ -0,0 +1,280 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// The delivery of a "MPEG2TransportStreamDemux"s elementary streams in other threads (each with its own event loop)
+// Implementation
+
+#include "MPEG2TransportStreamDemuxWorker.hh"
+#include "MPEG2TransportStreamParser.hh"
+#include "FileSink.hh"
+
+////////// MPEG2TransportStreamWorkerSource //////////
+// The source - in the worker's environment - of a track's data (a queue of chunks, handed over by the parser)
+
+class MPEG2TransportStreamWorkerSource: public FramedSource {
+public:
+  MPEG2TransportStreamWorkerSource(UsageEnvironment& workerEnv, MPEG2TransportStreamDemuxWorker& worker);
+  virtual ~MPEG2TransportStreamWorkerSource();
+
+  void enqueue(MPEG2TransportStreamDemuxWorkerChunk* chunk);
+  void noteEnd();
+
+private: // redefined virtual functions:
+  virtual void doGetNextFrame();
+
+private:
+  void returnChunk(MPEG2TransportStreamDemuxWorkerChunk* chunk);
+
+private:
+  MPEG2TransportStreamDemuxWorker& fWorker;
+  MPEG2TransportStreamDemuxWorkerChunk* fHead;
+  MPEG2TransportStreamDemuxWorkerChunk* fTail;
+  unsigned fHeadOffset; // the number of bytes of "fHead" that we've already delivered
+  Boolean fHaveEnded;
+};
+
+MPEG2TransportStreamWorkerSource
+::MPEG2TransportStreamWorkerSource(UsageEnvironment& workerEnv, MPEG2TransportStreamDemuxWorker& worker)
+  : FramedSource(workerEnv),
+    fWorker(worker), fHead(NULL), fTail(NULL), fHeadOffset(0), fHaveEnded(False) {
+}
+
+MPEG2TransportStreamWorkerSource::~MPEG2TransportStreamWorkerSource() {
+  // Return any chunks that we didn't deliver:
+  while (fHead != NULL) {
+    MPEG2TransportStreamDemuxWorkerChunk* chunk = fHead;
+    fHead = fHead->next;
+    returnChunk(chunk);
+  }
+}
+
+void MPEG2TransportStreamWorkerSource::enqueue(MPEG2TransportStreamDemuxWorkerChunk* chunk) {
+  chunk->next = NULL;
+  if (fTail == NULL) fHead = chunk; else fTail->next = chunk;
+  fTail = chunk;
+
+  if (isCurrentlyAwaitingData() && nextTask() == NULL) doGetNextFrame();
+}
+
+void MPEG2TransportStreamWorkerSource::noteEnd() {
+  fHaveEnded = True;
+  if (isCurrentlyAwaitingData() && nextTask() == NULL) doGetNextFrame();
+}
+
+void MPEG2TransportStreamWorkerSource::doGetNextFrame() {
+  if (fHead == NULL) {
+    if (fHaveEnded) handleClosure();
+    return; // we'll continue when the next chunk arrives
+  }
+
+  // Deliver as much of the oldest chunk as will fit:
+  unsigned const numBytesRemaining = fHead->size - fHeadOffset;
+  fFrameSize = numBytesRemaining < fMaxSize ? numBytesRemaining : fMaxSize;
+  fNumTruncatedBytes = 0;
+  memmove(fTo, &fHead->data[fHeadOffset], fFrameSize);
+  fPresentationTime = fHead->presentationTime;
+
+  fHeadOffset += fFrameSize;
+  if (fHeadOffset == fHead->size) {
+    MPEG2TransportStreamDemuxWorkerChunk* chunk = fHead;
+    fHead = fHead->next;
+    if (fHead == NULL) fTail = NULL;
+    fHeadOffset = 0;
+    returnChunk(chunk);
+  }
+
+  // Complete delivery (from the event loop, to avoid deep recursion if many chunks are queued):
+  nextTask() = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)FramedSource::afterGetting, this);
+      // ("afterGetting()" resets "nextTask()", so "enqueue()" and "noteEnd()" can tell whether a delivery is pending)
+}
+
+void MPEG2TransportStreamWorkerSource::returnChunk(MPEG2TransportStreamDemuxWorkerChunk* chunk) {
+  fWorker.fParserEnv.taskScheduler().postWork(MPEG2TransportStreamDemuxWorker::chunkDone, chunk);
+}
+
+
+////////// MPEG2TransportStreamDemuxWorkerTrack implementation //////////
+
+MPEG2TransportStreamDemuxWorkerTrack
+::MPEG2TransportStreamDemuxWorkerTrack(MPEG2TransportStreamDemuxWorker& worker, u_int16_t pid, char const* fileName)
+  : ourWorker(worker), PID(pid), fileName(strDup(fileName)), pendingChunk(NULL), hasEnded(False), next(NULL),
+    source(NULL), sink(NULL) {
+}
+
+MPEG2TransportStreamDemuxWorkerTrack::~MPEG2TransportStreamDemuxWorkerTrack() {
+  delete pendingChunk;
+  delete[] fileName;
+}
+
+
+////////// MPEG2TransportStreamDemuxWorker implementation //////////
+
+MPEG2TransportStreamDemuxWorker
+::MPEG2TransportStreamDemuxWorker(MPEG2TransportStreamParser& parser, UsageEnvironment& workerEnv)
+  : fParser(&parser), fParserEnv(parser.envir()), fWorkerEnv(workerEnv),
+    fTracks(NULL), fFreeChunks(NULL), fNumChunksInFlight(0) {
+}
+
+MPEG2TransportStreamDemuxWorker::~MPEG2TransportStreamDemuxWorker() {
+  while (fTracks != NULL) {
+    MPEG2TransportStreamDemuxWorkerTrack* track = fTracks;
+    fTracks = fTracks->next;
+    delete track;
+  }
+  while (fFreeChunks != NULL) {
+    MPEG2TransportStreamDemuxWorkerChunk* chunk = fFreeChunks;
+    fFreeChunks = fFreeChunks->next;
+    delete chunk;
+  }
+}
+
+MPEG2TransportStreamDemuxWorkerTrack* MPEG2TransportStreamDemuxWorker
+::createTrack(u_int16_t pid, char const* fileName) {
+  MPEG2TransportStreamDemuxWorkerTrack* track = new MPEG2TransportStreamDemuxWorkerTrack(*this, pid, fileName);
+  track->next = fTracks;
+  fTracks = track;
+
+  fWorkerEnv.taskScheduler().postWork(createTrackInWorker, track);
+  return track;
+}
+
+MPEG2TransportStreamDemuxWorkerChunk* MPEG2TransportStreamDemuxWorker
+::getChunk(MPEG2TransportStreamDemuxWorkerTrack* track) {
+  if (fNumChunksInFlight >= MPEG2_TS_DEMUX_WORKER_MAX_CHUNKS_IN_FLIGHT) return NULL;
+
+  MPEG2TransportStreamDemuxWorkerChunk* chunk = fFreeChunks;
+  if (chunk != NULL) {
+    fFreeChunks = chunk->next;
+  } else {
+    chunk = new MPEG2TransportStreamDemuxWorkerChunk;
+  }
+  chunk->track = track;
+  chunk->size = 0;
+  chunk->next = NULL;
+  return chunk;
+}
+
+void MPEG2TransportStreamDemuxWorker::deliverChunk(MPEG2TransportStreamDemuxWorkerChunk* chunk) {
+  ++fNumChunksInFlight;
+  fWorkerEnv.taskScheduler().postWork(deliverChunkInWorker, chunk);
+}
+
+void MPEG2TransportStreamDemuxWorker::flushPendingChunks() {
+  for (MPEG2TransportStreamDemuxWorkerTrack* track = fTracks; track != NULL; track = track->next) {
+    if (track->pendingChunk != NULL && track->pendingChunk->size > 0) {
+      deliverChunk(track->pendingChunk);
+      track->pendingChunk = NULL;
+    }
+  }
+}
+
+unsigned MPEG2TransportStreamDemuxWorker::endTracks() {
+  flushPendingChunks();
+
+  unsigned numTracksEnding = 0;
+  for (MPEG2TransportStreamDemuxWorkerTrack* track = fTracks; track != NULL; track = track->next) {
+    if (!track->hasEnded) {
+      fWorkerEnv.taskScheduler().postWork(endTrackInWorker, track);
+      ++numTracksEnding;
+    }
+  }
+  return numTracksEnding;
+}
+
+void MPEG2TransportStreamDemuxWorker::shutdown() {
+  // After this, the parser's thread no longer uses us (except to handle the work that the worker posts back to it):
+  fParser = NULL;
+  fWorkerEnv.taskScheduler().postWork(shutdownInWorker, this);
+}
+
+void MPEG2TransportStreamDemuxWorker::createTrackInWorker(void* clientData) {
+  MPEG2TransportStreamDemuxWorkerTrack* track = (MPEG2TransportStreamDemuxWorkerTrack*)clientData;
+  MPEG2TransportStreamDemuxWorker& worker = track->ourWorker;
+
+  track->source = new MPEG2TransportStreamWorkerSource(worker.fWorkerEnv, worker);
+  track->sink = FileSink::createNew(worker.fWorkerEnv, track->fileName);
+  if (track->sink == NULL) {
+    // We can't play the track, so end it now.  (Any chunks that are later delivered to it get returned immediately.)
+    worker.closeTrackInWorker(track);
+    worker.fParserEnv.taskScheduler().postWork(trackEnded, track);
+    return;
+  }
+  track->sink->startPlaying(*track->source, afterPlayingInWorker, track);
+}
+
+void MPEG2TransportStreamDemuxWorker::deliverChunkInWorker(void* clientData) {
+  MPEG2TransportStreamDemuxWorkerChunk* chunk = (MPEG2TransportStreamDemuxWorkerChunk*)clientData;
+  MPEG2TransportStreamDemuxWorkerTrack* track = chunk->track;
+
+  if (track->source == NULL) { // the track has already been closed
+    track->ourWorker.fParserEnv.taskScheduler().postWork(chunkDone, chunk);
+    return;
+  }
+  track->source->enqueue(chunk);
+}
+
+void MPEG2TransportStreamDemuxWorker::endTrackInWorker(void* clientData) {
+  MPEG2TransportStreamDemuxWorkerTrack* track = (MPEG2TransportStreamDemuxWorkerTrack*)clientData;
+
+  if (track->source == NULL) return; // the track has already ended (and "trackEnded()" has been posted for it)
+  track->source->noteEnd(); // "afterPlayingInWorker()" will get called once the remaining data has been delivered
+}
+
+void MPEG2TransportStreamDemuxWorker::afterPlayingInWorker(void* clientData) {
+  MPEG2TransportStreamDemuxWorkerTrack* track = (MPEG2TransportStreamDemuxWorkerTrack*)clientData;
+
+  track->ourWorker.closeTrackInWorker(track);
+  track->ourWorker.fParserEnv.taskScheduler().postWork(trackEnded, track);
+}
+
+void MPEG2TransportStreamDemuxWorker::shutdownInWorker(void* clientData) {
+  MPEG2TransportStreamDemuxWorker* worker = (MPEG2TransportStreamDemuxWorker*)clientData;
+
+  for (MPEG2TransportStreamDemuxWorkerTrack* track = worker->fTracks; track != NULL; track = track->next) {
+    worker->closeTrackInWorker(track);
+  }
+
+  // This is the last work that we post to the parser's thread, so it'll be handled after any returned chunks:
+  worker->fParserEnv.taskScheduler().postWork(finalRelease, worker);
+}
+
+void MPEG2TransportStreamDemuxWorker::closeTrackInWorker(MPEG2TransportStreamDemuxWorkerTrack* track) {
+  Medium::close(track->sink); track->sink = NULL;
+  Medium::close(track->source); track->source = NULL; // this returns any chunks that it still has
+}
+
+void MPEG2TransportStreamDemuxWorker::chunkDone(void* clientData) {
+  MPEG2TransportStreamDemuxWorkerChunk* chunk = (MPEG2TransportStreamDemuxWorkerChunk*)clientData;
+  MPEG2TransportStreamDemuxWorker& worker = chunk->track->ourWorker;
+
+  chunk->next = worker.fFreeChunks;
+  worker.fFreeChunks = chunk;
+  --worker.fNumChunksInFlight;
+
+  if (worker.fParser != NULL) worker.fParser->noteWorkerChunkAvailable();
+}
+
+void MPEG2TransportStreamDemuxWorker::trackEnded(void* clientData) {
+  MPEG2TransportStreamDemuxWorkerTrack* track = (MPEG2TransportStreamDemuxWorkerTrack*)clientData;
+
+  track->hasEnded = True;
+  if (track->ourWorker.fParser != NULL) track->ourWorker.fParser->noteWorkerTrackEnded();
+}
+
+void MPEG2TransportStreamDemuxWorker::finalRelease(void* clientData) {
+  delete (MPEG2TransportStreamDemuxWorker*)clientData;
+}
@@ -0,0 +1,113 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// The delivery of a "MPEG2TransportStreamDemux"s elementary streams in other threads (each with its own event loop)
+// C++ header
+
+#ifndef _MPEG2_TRANSPORT_STREAM_DEMUX_WORKER_HH
+#define _MPEG2_TRANSPORT_STREAM_DEMUX_WORKER_HH
+
+#ifndef _FRAMED_SOURCE_HH
+#include "FramedSource.hh"
+#endif
+
+// The parser's thread hands the payload of each track's PES packets to that track's worker in 'chunks' of up to
+// this size.  (A chunk is handed over when a new PES packet begins, when the chunk becomes full, or when the parser
+// has to wait for more input.)
+#ifndef MPEG2_TS_DEMUX_WORKER_CHUNK_SIZE
+#define MPEG2_TS_DEMUX_WORKER_CHUNK_SIZE 32768
+#endif
+// If this many chunks have been handed to a worker - but not yet delivered by it - then the parser pauses:
+#ifndef MPEG2_TS_DEMUX_WORKER_MAX_CHUNKS_IN_FLIGHT
+#define MPEG2_TS_DEMUX_WORKER_MAX_CHUNKS_IN_FLIGHT 64
+#endif
+
+class MPEG2TransportStreamDemuxWorkerChunk {
+public:
+  class MPEG2TransportStreamDemuxWorkerTrack* track;
+  struct timeval presentationTime;
+  unsigned size;
+  unsigned char data[MPEG2_TS_DEMUX_WORKER_CHUNK_SIZE];
+  MPEG2TransportStreamDemuxWorkerChunk* next;
+};
+
+// A track that's delivered by a worker.  It's created (and its 'pending' chunk is filled) by the parser's thread;
+// its source and sink are created, used, and closed only by the worker's thread.
+class MPEG2TransportStreamDemuxWorkerTrack {
+public:
+  MPEG2TransportStreamDemuxWorkerTrack(class MPEG2TransportStreamDemuxWorker& worker, u_int16_t pid,
+				       char const* fileName);
+  virtual ~MPEG2TransportStreamDemuxWorkerTrack();
+
+public:
+  // Used by the parser's thread:
+  MPEG2TransportStreamDemuxWorker& ourWorker;
+  u_int16_t PID;
+  char* fileName;
+  MPEG2TransportStreamDemuxWorkerChunk* pendingChunk;
+  Boolean hasEnded;
+  MPEG2TransportStreamDemuxWorkerTrack* next; // in "ourWorker"s list
+
+  // Used by the worker's thread:
+  class MPEG2TransportStreamWorkerSource* source;
+  class MediaSink* sink;
+};
+
+// One of the (application-supplied) environments in which tracks are delivered.  Each such environment must be
+// running its event loop in its own thread.  The only communication between threads is via "postWork()".
+class MPEG2TransportStreamDemuxWorker {
+public:
+  MPEG2TransportStreamDemuxWorker(class MPEG2TransportStreamParser& parser, UsageEnvironment& workerEnv);
+
+  // Called from the parser's thread:
+  MPEG2TransportStreamDemuxWorkerTrack* createTrack(u_int16_t pid, char const* fileName);
+  MPEG2TransportStreamDemuxWorkerChunk* getChunk(MPEG2TransportStreamDemuxWorkerTrack* track);
+      // Returns NULL (and the parser should wait) if too many chunks are currently in flight
+  void deliverChunk(MPEG2TransportStreamDemuxWorkerChunk* chunk);
+  void flushPendingChunks(); // delivers each track's non-empty 'pending' chunk
+  unsigned endTracks(); // after delivering all data; returns the number of tracks that we'll later report having ended
+  void shutdown(); // closes any remaining tracks; we get deleted (from the parser's thread) later
+
+  UsageEnvironment& workerEnv() const { return fWorkerEnv; }
+
+private:
+  virtual ~MPEG2TransportStreamDemuxWorker(); // called only from "finalRelease()"
+
+  // Functions called (via "postWork()") from the worker's thread:
+  static void createTrackInWorker(void* clientData);
+  static void deliverChunkInWorker(void* clientData);
+  static void endTrackInWorker(void* clientData);
+  static void shutdownInWorker(void* clientData);
+  static void afterPlayingInWorker(void* clientData);
+  void closeTrackInWorker(MPEG2TransportStreamDemuxWorkerTrack* track);
+
+  // Functions called (via "postWork()") from the parser's thread:
+  friend class MPEG2TransportStreamWorkerSource;
+  static void chunkDone(void* clientData);
+  static void trackEnded(void* clientData);
+  static void finalRelease(void* clientData);
+
+private:
+  class MPEG2TransportStreamParser* fParser; // NULL once we've been shut down
+  UsageEnvironment& fParserEnv;
+  UsageEnvironment& fWorkerEnv;
+  MPEG2TransportStreamDemuxWorkerTrack* fTracks; // a linked list
+  MPEG2TransportStreamDemuxWorkerChunk* fFreeChunks; // a linked list
+  unsigned fNumChunksInFlight;
+};
+
+#endif
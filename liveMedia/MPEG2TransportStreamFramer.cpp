@@ -21,10 +21,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "MPEG2TransportStreamFramer.hh"
+#include "MPEG2TransportStreamScanner.hh"
 #include <GroupsockHelper.hh> // for "gettimeofday()"
 
-#define TRANSPORT_PACKET_SIZE 188
-
 ////////// Definitions of constants that control the behavior of this code /////////
 
 #if !defined(NEW_DURATION_WEIGHT)
@@ -101,6 +100,10 @@ void MPEG2TransportStreamFramer::setPCRLimit(float pcrLimit) {
   fLimitTSPacketsToStreamByPCR = pcrLimit != 0.0;
 }
 
+Boolean MPEG2TransportStreamFramer::isMPEG2TransportStreamFramer() const {
+  return True;
+}
+
 void MPEG2TransportStreamFramer::doGetNextFrame() {
   if (fLimitNumTSPacketsToStream) {
     if (fNumTSPacketsToStream == 0) {
@@ -136,8 +139,6 @@ void MPEG2TransportStreamFramer
   framer->afterGettingFrame1(frameSize, presentationTime);
 }
 
-#define TRANSPORT_SYNC_BYTE 0x47
-
 void MPEG2TransportStreamFramer::afterGettingFrame1(unsigned frameSize,
 						    struct timeval presentationTime) {
   fFrameSize += frameSize;
@@ -177,12 +178,38 @@ void MPEG2TransportStreamFramer::afterGettingFrame1(unsigned frameSize,
   struct timeval tvNow;
   gettimeofday(&tvNow, NULL);
   double timeNow = tvNow.tv_sec + tvNow.tv_usec/1000000.0;
-  for (unsigned i = 0; i < numTSPackets; ++i) {
-    if (!updateTSPacketDurationEstimate(&fTo[i*TRANSPORT_PACKET_SIZE], timeNow)) {
-      // We hit a preset limit (based on PCR) within the stream.  Handle this as if the input source has closed:
-      handleClosure();
-      return;
+  // (Only packets that contain a PCR affect this estimate, so we first scan each batch of packets to find them.)
+  for (unsigned i = 0; i < numTSPackets; i += TS_SCAN_BATCH_SIZE) {
+    unsigned char* batch = &fTo[i*TRANSPORT_PACKET_SIZE];
+    unsigned const batchSize
+      = numTSPackets - i < TS_SCAN_BATCH_SIZE ? numTSPackets - i : TS_SCAN_BATCH_SIZE;
+    u_int64_t syncMask;
+    u_int64_t pcrMask = scanTSPacketsForPCRs(batch, batchSize, syncMask);
+
+    if (syncMask != TSScanMaskForPackets(batchSize)) {
+      // Unusual case: Some packets are missing a sync byte.  Process each packet separately:
+      for (unsigned j = 0; j < batchSize; ++j) {
+	if (!updateTSPacketDurationEstimate(&batch[j*TRANSPORT_PACKET_SIZE], timeNow)) {
+	  // We hit a preset limit (based on PCR) within the stream.  Handle this as if the input source has closed:
+	  handleClosure();
+	  return;
+	}
+      }
+      continue;
+    }
+
+    u_int64_t const batchStartPacketCount = fTSPacketCount;
+    for (unsigned j = 0; pcrMask != 0; ++j, pcrMask >>= 1) {
+      if ((pcrMask&1) == 0) continue;
+
+      fTSPacketCount = batchStartPacketCount + j; // because "updateTSPacketDurationEstimate()" counts this packet
+      if (!updateTSPacketDurationEstimate(&batch[j*TRANSPORT_PACKET_SIZE], timeNow)) {
+	// We hit a preset limit (based on PCR) within the stream.  Handle this as if the input source has closed:
+	handleClosure();
+	return;
+      }
     }
+    fTSPacketCount = batchStartPacketCount + batchSize;
   }
 
   fDurationInMicroseconds
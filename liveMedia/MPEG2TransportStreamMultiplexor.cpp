@@ -39,7 +39,7 @@ MPEG2TransportStreamMultiplexor
 ::MPEG2TransportStreamMultiplexor(UsageEnvironment& env)
   : FramedSource(env),
     fHaveVideoStreams(True/*by default*/),
-    fOutgoingPacketCounter(0), fProgramMapVersion(0xFF),
+    fOutgoingPacketCounter(0), fOutgoingFrameCounter(0), fPreferredFrameSize(0), fProgramMapVersion(0xFF),
     fPreviousInputProgramMapVersion(0xFF), fCurrentInputProgramMapVersion(0),
     fPCR_PID(0), fCurrentPID(0),
     fInputBuffer(NULL), fInputBufferSize(0), fInputBufferBytesUsed(0),
@@ -67,6 +67,35 @@ void MPEG2TransportStreamMultiplexor::doGetNextFrame() {
     return;
   }
 
+  fFrameSize = 0;
+  if (fMaxSize < TRANSPORT_PACKET_SIZE) {
+    fNumTruncatedBytes = TRANSPORT_PACKET_SIZE; // the client hasn't given us enough space; deliver nothing
+  } else {
+    unsigned maxFrameSize = fMaxSize;
+    if (fPreferredFrameSize > 0 && fPreferredFrameSize < maxFrameSize) maxFrameSize = fPreferredFrameSize;
+
+    // Deliver as many Transport Stream packets as will fit (stopping early if we run out of input data):
+    do {
+      deliverNextPacket();
+    } while (fFrameSize + TRANSPORT_PACKET_SIZE <= maxFrameSize
+	     && fInputBufferBytesUsed < fInputBufferSize
+	     && !(segmentationIsTimed() && fInputBufferBytesUsed == 0 && fCurrentPID == fPCR_PID));
+	// Note: With timed segmentation, the next packet - if it contains a PCR - might end the current segment (and
+	// our reader might then start writing to a new segment).  So, we deliver that packet in a new frame.
+  }
+
+  // NEED TO SET fPresentationTime, durationInMicroseconds #####
+  // Complete the delivery to the client:
+  if ((++fOutgoingFrameCounter%10) == 0) {
+    // To avoid excessive recursion (and stack overflow) caused by excessively large input frames,
+    // occasionally return to the event loop to do this:
+    nextTask() = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)FramedSource::afterGetting, this);
+  } else {
+    afterGetting(this);
+  }
+}
+
+void MPEG2TransportStreamMultiplexor::deliverNextPacket() {
   do {
     // Periodically return a Program Association Table packet instead:
     if ((segmentationIsTimed() && fSegmentationIndication == 1)
@@ -95,16 +124,6 @@ void MPEG2TransportStreamMultiplexor::doGetNextFrame() {
     deliverDataToClient(fCurrentPID, fInputBuffer, fInputBufferSize,
 			fInputBufferBytesUsed);
   } while (0);
-
-  // NEED TO SET fPresentationTime, durationInMicroseconds #####
-  // Complete the delivery to the client:
-  if ((fOutgoingPacketCounter%10) == 0) {
-    // To avoid excessive recursion (and stack overflow) caused by excessively large input frames,
-    // occasionally return to the event loop to do this:
-    nextTask() = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)FramedSource::afterGetting, this);
-  } else {
-    afterGetting(this);
-  }
 }
 
 void MPEG2TransportStreamMultiplexor
@@ -166,12 +185,9 @@ void MPEG2TransportStreamMultiplexor
 void MPEG2TransportStreamMultiplexor
 ::deliverDataToClient(u_int16_t pid, unsigned char* buffer, unsigned bufferSize,
 		      unsigned& startPositionInBuffer) {
-  // Construct a new Transport packet, and deliver it to the client:
-  if (fMaxSize < TRANSPORT_PACKET_SIZE) {
-    fFrameSize = 0; // the client hasn't given us enough space; deliver nothing
-    fNumTruncatedBytes = TRANSPORT_PACKET_SIZE;
-  } else {
-    fFrameSize = TRANSPORT_PACKET_SIZE;
+  // Construct a new Transport packet, and append it to the data that we're delivering to the client:
+  // (ASSERT: fMaxSize - fFrameSize >= TRANSPORT_PACKET_SIZE)
+  {
     Boolean willAddPCR = pid == fPCR_PID && startPositionInBuffer == 0
       && !(fPCR.highBit == 0 && fPCR.remainingBits == 0 && fPCR.extension == 0);
     unsigned const numBytesAvailable = bufferSize - startPositionInBuffer;
@@ -209,7 +225,8 @@ void MPEG2TransportStreamMultiplexor
     //         == TRANSPORT_PACKET_SIZE
 
     // Fill in the header of the Transport Stream packet:
-    unsigned char* header = fTo;
+    unsigned char* header = &fTo[fFrameSize];
+    fFrameSize += TRANSPORT_PACKET_SIZE;
     *header++ = 0x47; // sync_byte
     *header++ = ((startPositionInBuffer == 0) ? 0x40 : 0x00)|(pid>>8);
       // transport_error_indicator, payload_unit_start_indicator, transport_priority,
@@ -288,9 +305,9 @@ void MPEG2TransportStreamMultiplexor
 #define OUR_PROGRAM_MAP_PID 0x1000
 
 void MPEG2TransportStreamMultiplexor::deliverPATPacket() {
-  // First, create a new buffer for the PAT packet:
+  // First, create a buffer for the PAT packet:
   unsigned const patSize = TRANSPORT_PACKET_SIZE - 4; // allow for the 4-byte header
-  unsigned char* patBuffer = new unsigned char[patSize];
+  unsigned char patBuffer[patSize];
 
   // and fill it in:
   unsigned char* pat = patBuffer;
@@ -316,17 +333,14 @@ void MPEG2TransportStreamMultiplexor::deliverPATPacket() {
   // Deliver the packet:
   unsigned startPosition = 0;
   deliverDataToClient(PAT_PID, patBuffer, patSize, startPosition);
-
-  // Finally, remove the new buffer:
-  delete[] patBuffer;
 }
 
 void MPEG2TransportStreamMultiplexor::deliverPMTPacket(Boolean hasChanged) {
   if (hasChanged) ++fProgramMapVersion;
 
-  // First, create a new buffer for the PMT packet:
+  // First, create a buffer for the PMT packet:
   unsigned const pmtSize = TRANSPORT_PACKET_SIZE - 4; // allow for the 4-byte header
-  unsigned char* pmtBuffer = new unsigned char[pmtSize];
+  unsigned char pmtBuffer[pmtSize];
 
   // and fill it in:
   unsigned char* pmt = pmtBuffer;
@@ -366,9 +380,6 @@ void MPEG2TransportStreamMultiplexor::deliverPMTPacket(Boolean hasChanged) {
   // Deliver the packet:
   unsigned startPosition = 0;
   deliverDataToClient(OUR_PROGRAM_MAP_PID, pmtBuffer, pmtSize, startPosition);
-
-  // Finally, remove the new buffer:
-  delete[] pmtBuffer;
 }
 
 void MPEG2TransportStreamMultiplexor::setProgramStreamMap(unsigned frameSize) {
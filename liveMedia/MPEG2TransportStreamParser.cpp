@@ -19,18 +19,26 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "MPEG2TransportStreamParser.hh"
+#include "MPEG2TransportStreamScanner.hh"
+#include "MPEG2TransportStreamDemuxWorker.hh"
 
 #define NUM_PIDS 0x10000
 
+static void noOp(void* /*clientData*/) {}
+
 StreamType StreamTypes[0x100];
 
 MPEG2TransportStreamParser
 ::MPEG2TransportStreamParser(FramedSource* inputSource,
-			     FramedSource::onCloseFunc* onEndFunc, void* onEndClientData)
+			     FramedSource::onCloseFunc* onEndFunc, void* onEndClientData,
+			     UsageEnvironment* const* workerEnvs, unsigned numWorkerEnvs)
   : StreamParser(inputSource, onEndFunc, onEndClientData, continueParsing, this),
     fInputSource(inputSource), fAmCurrentlyParsing(False),
     fOnEndFunc(onEndFunc), fOnEndClientData(onEndClientData),
-    fLastSeenPCR(0.0) {
+    fLastSeenPCR(0.0),
+    fWorkers(NULL), fNumWorkers(0), fNextWorkerIndex(0), fProgramWorkers(NULL),
+    fIsWaitingForWorkerChunk(False), fNumWorkerTracksEnding(0),
+    fOnWorkerTracksEndedFunc(NULL), fOnWorkerTracksEndedClientData(NULL) {
   if (StreamTypes[0x01].dataType == StreamType::UNKNOWN) { // initialize array with known values
     StreamTypes[0x01] = StreamType("MPEG-1 video", StreamType::VIDEO, ".mpv");
     StreamTypes[0x02] = StreamType("MPEG-2 video", StreamType::VIDEO, ".mpv");
@@ -55,6 +63,21 @@ MPEG2TransportStreamParser
   // Initially, the only PID we know is 0x0000: a Program Association Table:
   fPIDState[0x0000] = new PIDState_PAT(*this, 0x0000);
 
+  // If we were given worker environments, then we use them to deliver tracks - but only if each of them (and our own
+  // environment) supports "postWork()", which is how we communicate with them:
+  Boolean canUseWorkers = numWorkerEnvs > 0 && envir().taskScheduler().postWork(noOp);
+  for (unsigned i = 0; canUseWorkers && i < numWorkerEnvs; ++i) {
+    canUseWorkers = workerEnvs[i] != NULL && workerEnvs[i]->taskScheduler().postWork(noOp);
+  }
+  if (canUseWorkers) {
+    fNumWorkers = numWorkerEnvs;
+    fWorkers = new MPEG2TransportStreamDemuxWorker*[fNumWorkers];
+    for (unsigned i = 0; i < fNumWorkers; ++i) {
+      fWorkers[i] = new MPEG2TransportStreamDemuxWorker(*this, *workerEnvs[i]);
+    }
+    fProgramWorkers = HashTable::create(ONE_WORD_HASH_KEYS);
+  }
+
   // Begin parsing:
   continueParsing();
 }
@@ -62,6 +85,11 @@ MPEG2TransportStreamParser
 MPEG2TransportStreamParser::~MPEG2TransportStreamParser() {
   for (unsigned i = 0; i < NUM_PIDS; ++i) delete fPIDState[i];
   delete[] fPIDState;
+
+  // Each worker gets deleted later, once its thread has closed its tracks:
+  for (unsigned i = 0; i < fNumWorkers; ++i) fWorkers[i]->shutdown();
+  delete[] fWorkers;
+  delete fProgramWorkers;
 }
 
 UsageEnvironment& MPEG2TransportStreamParser::envir() {
@@ -85,6 +113,10 @@ void MPEG2TransportStreamParser::continueParsing() {
       // We didn't complete the parsing, because we had to read more data from the source,
       // or because we're waiting for another read from downstream.
       // Once that happens, we'll get called again.
+      if (isWaitingForInput()) {
+	// Don't make worker threads wait for input to complete any partially-filled chunks:
+	for (unsigned i = 0; i < fNumWorkers; ++i) fWorkers[i]->flushPendingChunks();
+      }
       return;
     }
   }
@@ -93,15 +125,16 @@ void MPEG2TransportStreamParser::continueParsing() {
   if (fOnEndFunc != NULL) (*fOnEndFunc)(fOnEndClientData);
 }
 
-#define TRANSPORT_SYNC_BYTE 0x47
-#define TRANSPORT_PACKET_SIZE 188
-
 Boolean MPEG2TransportStreamParser::parse() {
-  if (fInputSource->isCurrentlyAwaitingData()) return False;
-      // Our input source is currently being read. Wait until that read completes
+  if (isWaitingForInput()) return False;
+      // We're waiting for more data from our input source. Wait until that read completes
 
   try {
     while (1) {
+      // First, skip over any (already read) packets that we won't need to parse:
+      unsigned numBytesToSkip = numTSPacketsToSkip(bufferedBytes(), numBufferedBytes(), (void* const*)fPIDState);
+      if (numBytesToSkip > 0) skipBytes(numBytesToSkip);
+
       // Make sure we start with a 'sync byte':
       do {
 	saveParserState();
@@ -304,6 +337,43 @@ Boolean MPEG2TransportStreamParser
   }  
 }
 
+MPEG2TransportStreamDemuxWorker* MPEG2TransportStreamParser::workerForProgram(u_int16_t program_number) {
+  if (fNumWorkers == 0) return NULL;
+
+  // Assign the workers to programs in turn, as we first see each program:
+  MPEG2TransportStreamDemuxWorker* worker
+    = (MPEG2TransportStreamDemuxWorker*)(fProgramWorkers->Lookup((char const*)(uintptr_t)program_number));
+  if (worker == NULL) {
+    worker = fWorkers[fNextWorkerIndex++%fNumWorkers];
+    fProgramWorkers->Add((char const*)(uintptr_t)program_number, worker);
+  }
+  return worker;
+}
+
+Boolean MPEG2TransportStreamParser
+::endWorkerTracks(FramedSource::onCloseFunc* onTracksEndedFunc, void* onTracksEndedClientData) {
+  fNumWorkerTracksEnding = 0;
+  for (unsigned i = 0; i < fNumWorkers; ++i) fNumWorkerTracksEnding += fWorkers[i]->endTracks();
+  if (fNumWorkerTracksEnding == 0) return False;
+
+  fOnWorkerTracksEndedFunc = onTracksEndedFunc;
+  fOnWorkerTracksEndedClientData = onTracksEndedClientData;
+  return True;
+}
+
+void MPEG2TransportStreamParser::noteWorkerChunkAvailable() {
+  if (fIsWaitingForWorkerChunk) {
+    fIsWaitingForWorkerChunk = False;
+    continueParsing();
+  }
+}
+
+void MPEG2TransportStreamParser::noteWorkerTrackEnded() {
+  if (fNumWorkerTracksEnding > 0 && --fNumWorkerTracksEnding == 0 && fOnWorkerTracksEndedFunc != NULL) {
+    (*fOnWorkerTracksEndedFunc)(fOnWorkerTracksEndedClientData);
+  }
+}
+
 void MPEG2TransportStreamParser::restoreSavedParserState() {
   StreamParser::restoreSavedParserState();
   fAmCurrentlyParsing = False;  
@@ -74,6 +74,7 @@ public:
   double lastSeenPTS;
   MPEG2TransportStreamDemuxedTrack* streamSource;
   MediaSink* streamSink;
+  class MPEG2TransportStreamDemuxWorkerTrack* workerTrack; // non-NULL iff the track is delivered by a worker thread
 };
 
 
@@ -93,11 +94,21 @@ public:
 class MPEG2TransportStreamParser: public StreamParser {
 public:
   MPEG2TransportStreamParser(FramedSource* inputSource,
-			     FramedSource::onCloseFunc* onEndFunc, void* onEndClientData);
+			     FramedSource::onCloseFunc* onEndFunc, void* onEndClientData,
+			     UsageEnvironment* const* workerEnvs = NULL, unsigned numWorkerEnvs = 0);
   virtual ~MPEG2TransportStreamParser();
 
   UsageEnvironment& envir();
 
+  // Support for delivering tracks from worker threads:
+  class MPEG2TransportStreamDemuxWorker* workerForProgram(u_int16_t program_number);
+      // Returns NULL if we're not using worker threads
+  Boolean endWorkerTracks(FramedSource::onCloseFunc* onTracksEndedFunc, void* onTracksEndedClientData);
+      // Called at the end of the input.  Returns True iff tracks are being delivered by worker threads; in that case
+      // "onTracksEndedFunc" will be called once all such tracks have delivered their remaining data.
+  void noteWorkerChunkAvailable();
+  void noteWorkerTrackEnded();
+
   // StreamParser 'client continue' function:
   static void continueParsing(void* clientData, unsigned char* ptr, unsigned size, struct timeval presentationTime);
   void continueParsing();
@@ -114,6 +125,7 @@ private:
   void parsePMT(PIDState_PMT* pidState, Boolean pusi, unsigned numDataBytes);
   void parseStreamDescriptors(unsigned numDescriptorBytes);
   Boolean processStreamPacket(PIDState_STREAM* pidState, Boolean pusi, unsigned numDataBytes);
+  Boolean processStreamPacketForWorker(PIDState_STREAM* pidState, Boolean pusi, unsigned numDataBytes);
   unsigned parsePESHeader(PIDState_STREAM* pidState, unsigned numDataBytes);
 
 private: // redefined virtual functions
@@ -127,6 +139,15 @@ private:
   void* fOnEndClientData;
   PIDState** fPIDState;
   double fLastSeenPCR;
+
+  // State for delivering tracks from worker threads:
+  class MPEG2TransportStreamDemuxWorker** fWorkers;
+  unsigned fNumWorkers, fNextWorkerIndex;
+  HashTable* fProgramWorkers; // maps "program_number" to the worker that delivers that program's tracks
+  Boolean fIsWaitingForWorkerChunk;
+  unsigned fNumWorkerTracksEnding;
+  FramedSource::onCloseFunc* fOnWorkerTracksEndedFunc;
+  void* fOnWorkerTracksEndedClientData;
 };
 
 #endif
@@ -19,6 +19,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "MPEG2TransportStreamParser.hh"
+#include "MPEG2TransportStreamDemuxWorker.hh"
 #include "FileSink.hh"
 #include <time.h> // for time_t
 
@@ -29,6 +30,8 @@ Boolean MPEG2TransportStreamParser
   fprintf(stderr, "\t%s stream (stream_type 0x%02x)\n",
 	  StreamTypes[pidState->stream_type].description, pidState->stream_type);
 #endif
+  if (pidState->workerTrack != NULL) return processStreamPacketForWorker(pidState, pusi, numDataBytes);
+
   do {
     MPEG2TransportStreamDemuxedTrack* streamSource = pidState->streamSource;
     if (streamSource == NULL) {
@@ -71,6 +74,47 @@ Boolean MPEG2TransportStreamParser
   return True;
 }
 
+Boolean MPEG2TransportStreamParser
+::processStreamPacketForWorker(PIDState_STREAM* pidState, Boolean pusi, unsigned numDataBytes) {
+  MPEG2TransportStreamDemuxWorkerTrack* track = pidState->workerTrack;
+  MPEG2TransportStreamDemuxWorker& worker = track->ourWorker;
+
+  // Hand over the chunk that we've been filling if a new PES packet begins, or if this packet's data won't fit:
+  if (track->pendingChunk != NULL && track->pendingChunk->size > 0
+      && (pusi || track->pendingChunk->size + numDataBytes > MPEG2_TS_DEMUX_WORKER_CHUNK_SIZE)) {
+    worker.deliverChunk(track->pendingChunk);
+    track->pendingChunk = NULL;
+  }
+  if (track->pendingChunk == NULL) {
+    track->pendingChunk = worker.getChunk(track);
+    if (track->pendingChunk == NULL) {
+      // The worker is behind.  Wait until it returns a chunk to us.  (The parsing will continue then.)
+      fIsWaitingForWorkerChunk = True;
+      return False;
+    }
+  }
+  MPEG2TransportStreamDemuxWorkerChunk* chunk = track->pendingChunk;
+
+  // If the data begins with a PES header, parse it first
+  unsigned pesHeaderSize = 0;
+  if (pusi && pidState->stream_type != 0x05/*these special private streams don't have PES hdrs*/) {
+    pesHeaderSize = parsePESHeader(pidState, numDataBytes);
+    if (pesHeaderSize == 0) return True; // PES header parsing failed
+  }
+
+  // Append the data to the chunk:
+  unsigned const numBytesToDeliver = numDataBytes - pesHeaderSize;
+  getBytes(&chunk->data[chunk->size], numBytesToDeliver);
+  if (chunk->size == 0) {
+    double pts = pidState->lastSeenPTS == 0.0 ? fLastSeenPCR : pidState->lastSeenPTS;
+    chunk->presentationTime.tv_sec = (time_t)pts;
+    chunk->presentationTime.tv_usec = int(pts*1000000.0)%1000000;
+  }
+  chunk->size += numBytesToDeliver;
+
+  return True;
+}
+
 static Boolean isSpecialStreamId[0x100];
 
 unsigned MPEG2TransportStreamParser
@@ -285,10 +329,8 @@ unsigned MPEG2TransportStreamParser
 PIDState_STREAM::PIDState_STREAM(MPEG2TransportStreamParser& parser,
 				 u_int16_t pid, u_int16_t programNumber, u_int8_t streamType)
   : PIDState(parser, pid, STREAM),
-    program_number(programNumber), stream_type(streamType), lastSeenPTS(0.0) {
-  // Create the 'source' and 'sink' objects for this track, and 'start playing' them:
-  streamSource = new MPEG2TransportStreamDemuxedTrack(parser, pid);
-
+    program_number(programNumber), stream_type(streamType), lastSeenPTS(0.0),
+    streamSource(NULL), streamSink(NULL), workerTrack(NULL) {
   char fileName[100];
   extern StreamType StreamTypes[];
   StreamType& st = StreamTypes[streamType]; // alias
@@ -300,11 +342,22 @@ PIDState_STREAM::PIDState_STREAM(MPEG2TransportStreamParser& parser,
 	  "UNKNOWN",
 	  program_number, pid, st.filenameSuffix);
   fprintf(stderr, "Creating new output file \"%s\"\n", fileName);
+
+  MPEG2TransportStreamDemuxWorker* worker = parser.workerForProgram(program_number);
+  if (worker != NULL) {
+    // The track's 'source' and 'sink' objects get created - and played - by the worker's thread:
+    workerTrack = worker->createTrack(pid, fileName);
+    return;
+  }
+
+  // Create the 'source' and 'sink' objects for this track, and 'start playing' them:
+  streamSource = new MPEG2TransportStreamDemuxedTrack(parser, pid);
   streamSink = FileSink::createNew(parser.envir(), fileName);
   streamSink->startPlaying(*streamSource, NULL, NULL);
 }
 
 PIDState_STREAM::~PIDState_STREAM() {
+  // (Any "workerTrack" is owned - and eventually deleted - by its worker.)
   Medium::close(streamSink);
   Medium::close(streamSource);
 }
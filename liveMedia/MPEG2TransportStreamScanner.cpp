@@ -0,0 +1,52 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// Fast scanning of buffers of (complete, consecutive) MPEG Transport Stream packets, without parsing them byte-by-byte
+// Implementation
+
+#include "MPEG2TransportStreamScanner.hh"
+
+u_int64_t scanTSPacketsForPCRs(unsigned char const* buf, unsigned numPackets, u_int64_t& syncMask) {
+  if (numPackets > TS_SCAN_BATCH_SIZE) numPackets = TS_SCAN_BATCH_SIZE;
+
+  // We test just the first 6 bytes of each packet, accumulating the results - without branching - into bitmasks.
+  // (A packet has a PCR iff "adaptation_field_control" is 2 or 3, "adaptation_field_length" > 0, and "PCR_flag" is set.)
+  u_int64_t sync = 0, pcr = 0;
+  unsigned char const* pkt = buf;
+  for (unsigned i = 0; i < numPackets; ++i, pkt += TRANSPORT_PACKET_SIZE) {
+    sync |= (u_int64_t)(pkt[0] == TRANSPORT_SYNC_BYTE) << i;
+    pcr |= (u_int64_t)(((pkt[3]&0x20) != 0) & (pkt[4] != 0) & ((pkt[5]&0x10) != 0)) << i;
+  }
+
+  syncMask = sync;
+  return pcr&sync;
+}
+
+unsigned numTSPacketsToSkip(unsigned char const* buf, unsigned numBytes, void* const* pidTable) {
+  unsigned numBytesToSkip = 0;
+  while (numBytes - numBytesToSkip >= TRANSPORT_PACKET_SIZE) {
+    unsigned char const* pkt = &buf[numBytesToSkip];
+    if (pkt[0] != TRANSPORT_SYNC_BYTE) break; // let our caller resynchronize
+
+    if (!TSPacketIsRejected(pkt) && TSPacketHasPayload(pkt) && pidTable[TSPacketPID(pkt)] != NULL) break;
+        // this packet needs to be parsed
+
+    numBytesToSkip += TRANSPORT_PACKET_SIZE;
+  }
+
+  return numBytesToSkip;
+}
@@ -0,0 +1,56 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// Fast scanning of buffers of (complete, consecutive) MPEG Transport Stream packets, without parsing them byte-by-byte
+// C++ header
+
+#ifndef _MPEG2_TRANSPORT_STREAM_SCANNER_HH
+#define _MPEG2_TRANSPORT_STREAM_SCANNER_HH
+
+#ifndef _BOOLEAN_HH
+#include "Boolean.hh"
+#endif
+#ifndef _NET_COMMON_H
+#include "NetCommon.h"
+#endif
+
+#define TRANSPORT_SYNC_BYTE 0x47
+#define TRANSPORT_PACKET_SIZE 188
+
+// Accessors for fields of a Transport Stream packet's 4-byte header:
+inline u_int16_t TSPacketPID(unsigned char const* pkt) { return ((pkt[1]&0x1F)<<8)|pkt[2]; }
+inline Boolean TSPacketHasPayload(unsigned char const* pkt) { return (pkt[3]&0x30) != 0x20; }
+    // i.e., "adaptation_field_control" is not 2 (adaptation field only)
+inline Boolean TSPacketIsRejected(unsigned char const* pkt) { return (pkt[1]&0x80) != 0 || (pkt[3]&0xC0) != 0; }
+    // i.e., its "transport_error_indicator" is set, or it's scrambled
+
+// We scan packets in batches of (up to) this many, returning one bit per packet (bit i for packet i):
+#define TS_SCAN_BATCH_SIZE 64
+inline u_int64_t TSScanMaskForPackets(unsigned numPackets) {
+  return numPackets >= TS_SCAN_BATCH_SIZE ? ~(u_int64_t)0 : (((u_int64_t)1)<<numPackets) - 1;
+}
+
+u_int64_t scanTSPacketsForPCRs(unsigned char const* buf, unsigned numPackets, u_int64_t& syncMask);
+    // Scans the (up to "TS_SCAN_BATCH_SIZE") packets at "buf".  Sets "syncMask" to the packets that begin with a sync
+    // byte, and returns those (among them) that contain a PCR.
+
+unsigned numTSPacketsToSkip(unsigned char const* buf, unsigned numBytes, void* const* pidTable);
+    // Returns the number of bytes - a multiple of TRANSPORT_PACKET_SIZE - at the start of "buf" that are complete
+    // packets that can be skipped without parsing them: those that begin with a sync byte, and are rejected, or carry
+    // no payload, or have a PID whose entry in "pidTable" (indexed by PID) is NULL.
+
+#endif
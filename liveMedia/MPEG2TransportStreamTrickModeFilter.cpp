@@ -32,6 +32,155 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 //     will be less than that of the original.)
 #define KEEP_ORIGINAL_FRAME_RATE False
 
+////////// TrickModeCache //////////
+
+// A LRU cache of spans of Transport Stream packets that were recently read by trick mode filters.
+// It's shared by all "MPEG2TransportStreamTrickModeFilter"s in the same environment, and is deleted (along with its
+// contents) when the last of these is deleted.
+
+class TrickModeCacheEntry {
+public:
+  TrickModeCacheEntry(char const* key, unsigned char const* packets, unsigned numPackets)
+    : fPrev(NULL), fNext(NULL), fKey(strDup(key)), fNumPackets(numPackets) {
+    fPackets = new unsigned char[numPackets*TRANSPORT_PACKET_SIZE];
+    memmove(fPackets, packets, numPackets*TRANSPORT_PACKET_SIZE);
+  }
+  virtual ~TrickModeCacheEntry() {
+    delete[] fPackets;
+    delete[] fKey;
+  }
+
+public:
+  TrickModeCacheEntry* fPrev; // more recently used
+  TrickModeCacheEntry* fNext; // less recently used
+  char* fKey;
+  unsigned char* fPackets;
+  unsigned fNumPackets;
+};
+
+class TrickModeCache {
+public:
+  static TrickModeCache* acquire(UsageEnvironment& env);
+  void release();
+
+  unsigned lookup(char const* indexFileName, unsigned long firstTSPacketNum, unsigned char* to, unsigned maxNumPackets);
+      // If we have a span beginning with "firstTSPacketNum", copies (up to "maxNumPackets" of) it to "to", and returns
+      // its size (in packets).  Otherwise returns 0.
+  void add(char const* indexFileName, unsigned long firstTSPacketNum, unsigned char const* packets, unsigned numPackets);
+
+private:
+  TrickModeCache(UsageEnvironment& env);
+  virtual ~TrickModeCache();
+
+  static char* makeKey(char const* indexFileName, unsigned long firstTSPacketNum);
+  void unlink(TrickModeCacheEntry* entry);
+  void linkAtHead(TrickModeCacheEntry* entry);
+  void removeEntry(TrickModeCacheEntry* entry);
+
+private:
+  UsageEnvironment& fEnv;
+  unsigned fReferenceCount;
+  HashTable* fEntries; // indexed by key
+  TrickModeCacheEntry* fHead; // most recently used
+  TrickModeCacheEntry* fTail; // least recently used
+  unsigned fTotalSize; // bytes
+};
+
+TrickModeCache* TrickModeCache::acquire(UsageEnvironment& env) {
+  if (TRICK_MODE_CACHE_SIZE == 0) return NULL;
+
+  _Tables* ourTables = _Tables::getOurTables(env);
+  if (ourTables->trickModeCache == NULL) {
+    ourTables->trickModeCache = new TrickModeCache(env);
+  }
+  TrickModeCache* cache = (TrickModeCache*)(ourTables->trickModeCache);
+  ++cache->fReferenceCount;
+  return cache;
+}
+
+void TrickModeCache::release() {
+  if (--fReferenceCount > 0) return;
+
+  _Tables* ourTables = _Tables::getOurTables(fEnv);
+  delete this;
+  ourTables->trickModeCache = NULL;
+  ourTables->reclaimIfPossible();
+}
+
+TrickModeCache::TrickModeCache(UsageEnvironment& env)
+  : fEnv(env), fReferenceCount(0), fEntries(HashTable::create(STRING_HASH_KEYS)),
+    fHead(NULL), fTail(NULL), fTotalSize(0) {
+}
+
+TrickModeCache::~TrickModeCache() {
+  while (fHead != NULL) removeEntry(fHead);
+  delete fEntries;
+}
+
+unsigned TrickModeCache
+::lookup(char const* indexFileName, unsigned long firstTSPacketNum, unsigned char* to, unsigned maxNumPackets) {
+  char* key = makeKey(indexFileName, firstTSPacketNum);
+  TrickModeCacheEntry* entry = (TrickModeCacheEntry*)(fEntries->Lookup(key));
+  delete[] key;
+  if (entry == NULL) return 0;
+
+  // Move this entry to the head of the LRU list:
+  unlink(entry);
+  linkAtHead(entry);
+
+  unsigned numPackets = entry->fNumPackets;
+  if (numPackets > maxNumPackets) numPackets = maxNumPackets;
+  memmove(to, entry->fPackets, numPackets*TRANSPORT_PACKET_SIZE);
+  return numPackets;
+}
+
+void TrickModeCache
+::add(char const* indexFileName, unsigned long firstTSPacketNum, unsigned char const* packets, unsigned numPackets) {
+  unsigned const entrySize = numPackets*TRANSPORT_PACKET_SIZE;
+  if (numPackets == 0 || entrySize > TRICK_MODE_CACHE_SIZE) return;
+
+  char* key = makeKey(indexFileName, firstTSPacketNum);
+  TrickModeCacheEntry* oldEntry = (TrickModeCacheEntry*)(fEntries->Lookup(key));
+  if (oldEntry != NULL) removeEntry(oldEntry);
+
+  // Make room for the new entry, by removing the least recently used ones:
+  while (fTail != NULL && fTotalSize + entrySize > TRICK_MODE_CACHE_SIZE) removeEntry(fTail);
+
+  TrickModeCacheEntry* entry = new TrickModeCacheEntry(key, packets, numPackets);
+  fEntries->Add(entry->fKey, entry);
+  linkAtHead(entry);
+  fTotalSize += entrySize;
+  delete[] key;
+}
+
+char* TrickModeCache::makeKey(char const* indexFileName, unsigned long firstTSPacketNum) {
+  char* key = new char[strlen(indexFileName) + 25];
+  sprintf(key, "%lu:%s", firstTSPacketNum, indexFileName);
+  return key;
+}
+
+void TrickModeCache::unlink(TrickModeCacheEntry* entry) {
+  if (entry->fPrev != NULL) entry->fPrev->fNext = entry->fNext; else fHead = entry->fNext;
+  if (entry->fNext != NULL) entry->fNext->fPrev = entry->fPrev; else fTail = entry->fPrev;
+  entry->fPrev = entry->fNext = NULL;
+}
+
+void TrickModeCache::linkAtHead(TrickModeCacheEntry* entry) {
+  entry->fNext = fHead;
+  if (fHead != NULL) fHead->fPrev = entry; else fTail = entry;
+  fHead = entry;
+}
+
+void TrickModeCache::removeEntry(TrickModeCacheEntry* entry) {
+  unlink(entry);
+  fEntries->Remove(entry->fKey);
+  fTotalSize -= entry->fNumPackets*TRANSPORT_PACKET_SIZE;
+  delete entry;
+}
+
+
+////////// MPEG2TransportStreamTrickModeFilter //////////
+
 MPEG2TransportStreamTrickModeFilter* MPEG2TransportStreamTrickModeFilter
 ::createNew(UsageEnvironment& env, FramedSource* inputSource,
 	    MPEG2TransportStreamIndexFile* indexFile, int scale) {
@@ -45,14 +194,31 @@ MPEG2TransportStreamTrickModeFilter
     fHaveStarted(False), fIndexFile(indexFile), fScale(scale), fDirection(1),
     fState(SKIPPING_FRAME), fFrameCount(0),
     fNextIndexRecordNum(0), fNextTSPacketNum(0),
-    fCurrentTSPacketNum((unsigned long)(-1)), fUseSavedFrameNextTime(False) {
+    fFirstBufferedTSPacketNum(0), fNumBufferedTSPackets(0), fNumTSPacketsBeingRead(0),
+    fUseSavedFrameNextTime(False) {
   if (fScale < 0) { // reverse play
     fScale = -fScale;
     fDirection = -1;
   }
+  fInputBuffer = new unsigned char[TRICK_MODE_MAX_READ_SIZE*TRANSPORT_PACKET_SIZE];
+  fCache = TrickModeCache::acquire(env);
+
+  // Our input source might have been created to deliver only a few packets at a time.  Let it fill our buffer instead:
+  ByteStreamFileSource* tsFile = (ByteStreamFileSource*)fInputSource;
+  fSavedInputPreferredFrameSize = tsFile->preferredFrameSize();
+  tsFile->setPreferredFrameSize(0);
 }
 
 MPEG2TransportStreamTrickModeFilter::~MPEG2TransportStreamTrickModeFilter() {
+  if (fCache != NULL) fCache->release();
+  delete[] fInputBuffer;
+}
+
+void MPEG2TransportStreamTrickModeFilter::forgetInputSource() {
+  if (fInputSource == NULL) return;
+
+  ((ByteStreamFileSource*)fInputSource)->setPreferredFrameSize(fSavedInputPreferredFrameSize);
+  fInputSource = NULL;
 }
 
 Boolean MPEG2TransportStreamTrickModeFilter::seekTo(unsigned long tsPacketNumber,
@@ -196,10 +362,12 @@ void MPEG2TransportStreamTrickModeFilter::doStopGettingFrames() {
 }
 
 void MPEG2TransportStreamTrickModeFilter::attemptDeliveryToClient() {
-  if (fCurrentTSPacketNum == fDesiredTSPacketNum) {
-    //    fprintf(stderr, "\t\tdelivering ts %d:%d, %d bytes, PCR %f\n", fCurrentTSPacketNum, fDesiredDataOffset, fDesiredDataSize, fDesiredDataPCR);//#####
+  if (fDesiredTSPacketNum >= fFirstBufferedTSPacketNum
+      && fDesiredTSPacketNum < fFirstBufferedTSPacketNum + fNumBufferedTSPackets) {
+    //    fprintf(stderr, "\t\tdelivering ts %d:%d, %d bytes, PCR %f\n", fDesiredTSPacketNum, fDesiredDataOffset, fDesiredDataSize, fDesiredDataPCR);//#####
     // We already have the Transport Packet that we want.  Deliver its data:
-    memmove(fTo, &fInputBuffer[fDesiredDataOffset], fDesiredDataSize);
+    unsigned char* packet = &fInputBuffer[(fDesiredTSPacketNum - fFirstBufferedTSPacketNum)*TRANSPORT_PACKET_SIZE];
+    memmove(fTo, &packet[fDesiredDataOffset], fDesiredDataSize);
     fFrameSize = fDesiredDataSize;
     float deliveryPCR = fDirection*(fDesiredDataPCR - fFirstPCR)/fScale;
     if (deliveryPCR < 0.0) deliveryPCR = 0.0;
@@ -210,8 +378,8 @@ void MPEG2TransportStreamTrickModeFilter::attemptDeliveryToClient() {
 
     afterGetting(this);
   } else {
-    // Arrange to read the Transport Packet that we want:
-    readTransportPacket(fDesiredTSPacketNum);
+    // Arrange to read the Transport Packet that we want (along with the rest of the frame that it's in):
+    readTransportPackets(fDesiredTSPacketNum);
   }
 }
 
@@ -225,13 +393,47 @@ void MPEG2TransportStreamTrickModeFilter::seekToTransportPacket(unsigned long ts
   fNextTSPacketNum = tsPacketNum;
 }
 
-void MPEG2TransportStreamTrickModeFilter::readTransportPacket(unsigned long tsPacketNum) {
+void MPEG2TransportStreamTrickModeFilter::readTransportPackets(unsigned long tsPacketNum) {
+  fNumTSPacketsBeingRead = numTransportPacketsToRead(tsPacketNum);
+
+  if (fCache != NULL) {
+    unsigned numPackets = fCache->lookup(fIndexFile->fileName(), tsPacketNum, fInputBuffer, fNumTSPacketsBeingRead);
+    if (numPackets > 0) {
+      // We already had these packets, so there's no need to read them from the file:
+      fFirstBufferedTSPacketNum = tsPacketNum;
+      fNumBufferedTSPackets = numPackets;
+      attemptDeliveryToClient();
+      return;
+    }
+  }
+
   seekToTransportPacket(tsPacketNum);
-  fInputSource->getNextFrame(fInputBuffer, TRANSPORT_PACKET_SIZE,
+  fInputSource->getNextFrame(fInputBuffer, fNumTSPacketsBeingRead*TRANSPORT_PACKET_SIZE,
 			     afterGettingFrame, this,
 			     onSourceClosure, this);
 }
 
+unsigned MPEG2TransportStreamTrickModeFilter::numTransportPacketsToRead(unsigned long tsPacketNum) {
+  // Look ahead in the index file - up until the start of the next frame - to find the last Transport Stream packet
+  // that contains data from the frame that we're currently delivering.  (Within a frame, the index records are in
+  // increasing Transport Stream packet order.)
+  // ASSERT: The index record that we're currently delivering is "fNextIndexRecordNum-1"
+  unsigned long lastTSPacketNum = tsPacketNum;
+  for (unsigned long ixRecordNum = fNextIndexRecordNum; ; ++ixRecordNum) {
+    unsigned long recordTSPacketNum;
+    u_int8_t offset, size, recordType;
+    float pcr;
+    if (!fIndexFile->readIndexRecordValues(ixRecordNum, recordTSPacketNum, offset, size, pcr, recordType)
+	|| isIFrameStart(recordType) || isNonIFrameStart(recordType)
+	|| recordTSPacketNum < lastTSPacketNum
+	|| recordTSPacketNum - tsPacketNum >= TRICK_MODE_MAX_READ_SIZE) break;
+
+    lastTSPacketNum = recordTSPacketNum;
+  }
+
+  return (unsigned)(lastTSPacketNum - tsPacketNum) + 1;
+}
+
 void MPEG2TransportStreamTrickModeFilter
 ::afterGettingFrame(void* clientData, unsigned frameSize,
 		    unsigned /*numTruncatedBytes*/,
@@ -242,14 +444,24 @@ void MPEG2TransportStreamTrickModeFilter
 }
 
 void MPEG2TransportStreamTrickModeFilter::afterGettingFrame1(unsigned frameSize) {
-  if (frameSize != TRANSPORT_PACKET_SIZE) {
+  if (frameSize < TRANSPORT_PACKET_SIZE) {
     // Treat this as if the input source ended:
     onSourceClosure1();
     return;
   }
 
-  fCurrentTSPacketNum = fNextTSPacketNum; // i.e., the one that we just read
-  ++fNextTSPacketNum;
+  // Note the packets that we just read:
+  fFirstBufferedTSPacketNum = fNextTSPacketNum;
+  fNumBufferedTSPackets = frameSize/TRANSPORT_PACKET_SIZE;
+  if (frameSize%TRANSPORT_PACKET_SIZE == 0) {
+    fNextTSPacketNum += fNumBufferedTSPackets;
+    if (fCache != NULL && fNumBufferedTSPackets == fNumTSPacketsBeingRead) {
+      fCache->add(fIndexFile->fileName(), fFirstBufferedTSPacketNum, fInputBuffer, fNumBufferedTSPackets);
+    }
+  } else {
+    // We read a partial packet (at the end of the file), so we no longer know where we are:
+    fNextTSPacketNum = (unsigned long)(-1);
+  }
 
   // Attempt deliver again:
   attemptDeliveryToClient();
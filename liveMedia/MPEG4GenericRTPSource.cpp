@@ -144,7 +144,7 @@ Boolean MPEG4GenericRTPSource
     if (fNumAUHeaders > 0) {
       fAUHeaders = new AUHeader[fNumAUHeaders];
       // Fill in each header:
-      BitVector bv(&headerStart[2], 0, AU_headers_length);
+      BitReader bv(&headerStart[2], 0, AU_headers_length);
       fAUHeaders[0].size = bv.getBits(fSizeLength);
       fAUHeaders[0].index = bv.getBits(fIndexLength);
 
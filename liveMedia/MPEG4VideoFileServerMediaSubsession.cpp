@@ -82,8 +82,8 @@ void MPEG4VideoFileServerMediaSubsession::checkForAuxSDPLine1() {
   }
 }
 
-char const* MPEG4VideoFileServerMediaSubsession::getAuxSDPLine(RTPSink* rtpSink, FramedSource* inputSource) {
-  if (fAuxSDPLine != NULL) return fAuxSDPLine; // it's already been set up (for a previous client)
+Boolean MPEG4VideoFileServerMediaSubsession::startGettingAuxSDPLine(RTPSink* rtpSink, FramedSource* inputSource) {
+  if (fAuxSDPLine != NULL) return True; // it's already been set up (for a previous client)
 
   if (fDummyRTPSink == NULL) { // we're not already setting it up for another, concurrent stream
     // Note: For MPEG-4 video files, the 'config' information isn't known
@@ -98,7 +98,13 @@ char const* MPEG4VideoFileServerMediaSubsession::getAuxSDPLine(RTPSink* rtpSink,
     checkForAuxSDPLine(this);
   }
 
-  envir().taskScheduler().doEventLoop(&fDoneFlag);
+  return fDoneFlag != 0;
+}
+
+char const* MPEG4VideoFileServerMediaSubsession::getAuxSDPLine(RTPSink* rtpSink, FramedSource* inputSource) {
+  if (!startGettingAuxSDPLine(rtpSink, inputSource)) {
+    envir().taskScheduler().doEventLoop(&fDoneFlag);
+  }
 
   return fAuxSDPLine;
 }
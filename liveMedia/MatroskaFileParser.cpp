@@ -118,13 +118,13 @@ void MatroskaFileParser::continueParsing() {
 Boolean MatroskaFileParser::parse() {
   Boolean areDone = False;
 
-  if (fInputSource->isCurrentlyAwaitingData()) return False;
-      // Our input source is currently being read. Wait until that read completes
+  if (isWaitingForInput()) return False;
+      // We're waiting for more data from our input source. Wait until that read completes
   try {
     skipRemainingHeaderBytes(True); // if any
     do {
-      if (fInputSource->isCurrentlyAwaitingData()) return False;
-          // Our input source is currently being read. Wait until that read completes
+      if (isWaitingForInput()) return False;
+          // We're waiting for more data from our input source. Wait until that read completes
 
       switch (fCurrentParseState) {
         case PARSING_START_OF_FILE: {
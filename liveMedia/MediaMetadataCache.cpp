@@ -0,0 +1,248 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// A persistent (file-backed) cache of the SDP lines and durations of file-based "ServerMediaSubsession"s
+// Implementation
+
+#include "MediaMetadataCache.hh"
+#include "InputFile.hh" // for <sys/stat.h>
+#include "GroupsockHelper.hh" // for "AF_INET6"
+
+// The cache file begins with a header line, followed by one record for each entry:
+//   <key-length> <file-size> <modification-time> <duration> <sdp-lines-length>\n<key><sdp-lines>\n
+// Entries are appended as they're added, so a later record for the same key replaces an earlier one.
+// (The file is rewritten - without such stale records - each time that it's loaded.)
+#define CACHE_FILE_HEADER "LIVE555 media metadata cache, version 1\n"
+
+////////// MediaMetadataCacheEntry //////////
+
+class MediaMetadataCacheEntry {
+public:
+  MediaMetadataCacheEntry(u_int64_t fileSize, int64_t modificationTime, float duration, char const* sdpLines)
+    : fFileSize(fileSize), fModificationTime(modificationTime), fDuration(duration), fSDPLines(strDup(sdpLines)) {
+  }
+  virtual ~MediaMetadataCacheEntry() {
+    delete[] fSDPLines;
+  }
+
+public:
+  u_int64_t fFileSize;
+  int64_t fModificationTime;
+  float fDuration;
+  char* fSDPLines;
+};
+
+static Boolean getFileAttributes(char const* fileName, u_int64_t& fileSize, int64_t& modificationTime) {
+#if !defined(_WIN32_WCE)
+  if (strcmp(fileName, "stdin") == 0) return False; // not a real file
+
+  struct stat sb;
+  if (stat(fileName, &sb) != 0 || (sb.st_mode&S_IFMT) != S_IFREG) return False;
+
+  fileSize = sb.st_size;
+  modificationTime = sb.st_mtime;
+  return True;
+#else
+  return False;
+#endif
+}
+
+static char* makeKey(char const* fileName, unsigned trackNumber, int addressFamily, Boolean rtcpIsMultiplexed) {
+  char* key = new char[strlen(fileName) + 30];
+  sprintf(key, "%u:%d:%d:%s", trackNumber, addressFamily == AF_INET6 ? 6 : 4, rtcpIsMultiplexed != 0, fileName);
+  return key;
+}
+
+
+////////// MediaMetadataCache implementation //////////
+
+MediaMetadataCache* MediaMetadataCache::enable(UsageEnvironment& env, char const* cacheFileName) {
+  _Tables* ourTables = _Tables::getOurTables(env);
+  MediaMetadataCache* cache = (MediaMetadataCache*)(ourTables->mediaMetadataCache);
+  if (cache != NULL) {
+    if (strcmp(cache->fCacheFileName, cacheFileName) == 0) return cache;
+    disable(env);
+    ourTables = _Tables::getOurTables(env);
+  }
+
+  cache = new MediaMetadataCache(env, cacheFileName);
+  cache->loadEntries();
+  if (!cache->rewriteCacheFile()) {
+    delete cache;
+    ourTables->reclaimIfPossible();
+    return NULL;
+  }
+
+  ourTables->mediaMetadataCache = cache;
+  return cache;
+}
+
+void MediaMetadataCache::disable(UsageEnvironment& env) {
+  _Tables* ourTables = _Tables::getOurTables(env, False);
+  if (ourTables == NULL || ourTables->mediaMetadataCache == NULL) return;
+
+  delete (MediaMetadataCache*)(ourTables->mediaMetadataCache);
+  ourTables->mediaMetadataCache = NULL;
+  ourTables->reclaimIfPossible();
+}
+
+MediaMetadataCache* MediaMetadataCache::lookup(UsageEnvironment& env) {
+  _Tables* ourTables = (_Tables*)(env.liveMediaPriv);
+  return ourTables == NULL ? NULL : (MediaMetadataCache*)(ourTables->mediaMetadataCache);
+}
+
+MediaMetadataCache::MediaMetadataCache(UsageEnvironment& env, char const* cacheFileName)
+  : fEnv(env), fCacheFileName(strDup(cacheFileName)), fAppendFid(NULL),
+    fEntries(HashTable::create(STRING_HASH_KEYS)), fNumHits(0), fNumMisses(0) {
+}
+
+MediaMetadataCache::~MediaMetadataCache() {
+  if (fAppendFid != NULL) fclose(fAppendFid);
+
+  MediaMetadataCacheEntry* entry;
+  while ((entry = (MediaMetadataCacheEntry*)fEntries->RemoveNext()) != NULL) {
+    delete entry;
+  }
+  delete fEntries;
+  delete[] fCacheFileName;
+}
+
+char const* MediaMetadataCache
+::lookupSDPLines(char const* fileName, unsigned trackNumber, int addressFamily, Boolean rtcpIsMultiplexed,
+		 float& duration) {
+  u_int64_t fileSize; int64_t modificationTime;
+  if (!getFileAttributes(fileName, fileSize, modificationTime)) return NULL;
+
+  char* key = makeKey(fileName, trackNumber, addressFamily, rtcpIsMultiplexed);
+  MediaMetadataCacheEntry* entry = (MediaMetadataCacheEntry*)(fEntries->Lookup(key));
+  delete[] key;
+
+  if (entry == NULL || entry->fFileSize != fileSize || entry->fModificationTime != modificationTime) {
+    ++fNumMisses;
+    return NULL;
+  }
+
+  ++fNumHits;
+  duration = entry->fDuration;
+  return entry->fSDPLines;
+}
+
+void MediaMetadataCache
+::addSDPLines(char const* fileName, unsigned trackNumber, int addressFamily, Boolean rtcpIsMultiplexed,
+	      char const* sdpLines, float duration) {
+  u_int64_t fileSize; int64_t modificationTime;
+  if (sdpLines == NULL || !getFileAttributes(fileName, fileSize, modificationTime)) return;
+
+  char* key = makeKey(fileName, trackNumber, addressFamily, rtcpIsMultiplexed);
+  MediaMetadataCacheEntry* entry = new MediaMetadataCacheEntry(fileSize, modificationTime, duration, sdpLines);
+  delete (MediaMetadataCacheEntry*)(fEntries->Add(key, entry));
+
+  if (fAppendFid != NULL) {
+    if (writeEntry(fAppendFid, key, *entry)) {
+      fflush(fAppendFid);
+    } else {
+      // Stop trying to update the file (but keep using the in-memory entries):
+      fEnv << "MediaMetadataCache: Failed to write to \"" << fCacheFileName << "\"\n";
+      fclose(fAppendFid); fAppendFid = NULL;
+    }
+  }
+  delete[] key;
+}
+
+unsigned MediaMetadataCache::numEntries() const {
+  return fEntries->numEntries();
+}
+
+void MediaMetadataCache::loadEntries() {
+  FILE* fid = fopen(fCacheFileName, "rb");
+  if (fid == NULL) return; // the cache file doesn't exist yet
+
+  char header[sizeof CACHE_FILE_HEADER];
+  if (fgets(header, sizeof header, fid) == NULL || strcmp(header, CACHE_FILE_HEADER) != 0) {
+    // Not a cache file (or an incompatible version); its contents will be replaced.
+    fclose(fid);
+    return;
+  }
+
+  while (1) {
+    unsigned keyLength, sdpLinesLength;
+    unsigned long long fileSize;
+    long long modificationTime;
+    float duration;
+    if (fscanf(fid, "%u %llu %lld %f %u", &keyLength, &fileSize, &modificationTime, &duration, &sdpLinesLength) != 5
+	|| fgetc(fid) != '\n') break;
+
+    // Note: Any incomplete record (e.g., at the end of a file that was being written when the server stopped) is ignored.
+    char* key = new char[keyLength+1];
+    char* sdpLines = new char[sdpLinesLength+1];
+    Boolean recordIsComplete
+      = fread(key, 1, keyLength, fid) == keyLength && fread(sdpLines, 1, sdpLinesLength, fid) == sdpLinesLength
+      && fgetc(fid) == '\n';
+    if (recordIsComplete) {
+      key[keyLength] = '\0'; sdpLines[sdpLinesLength] = '\0';
+      MediaMetadataCacheEntry* entry
+	= new MediaMetadataCacheEntry((u_int64_t)fileSize, (int64_t)modificationTime, duration, sdpLines);
+      delete (MediaMetadataCacheEntry*)(fEntries->Add(key, entry));
+    }
+    delete[] sdpLines; delete[] key;
+    if (!recordIsComplete) break;
+  }
+
+  fclose(fid);
+}
+
+Boolean MediaMetadataCache::rewriteCacheFile() {
+  // Write the current entries to a temporary file, then replace the cache file with it:
+  char* tmpFileName = new char[strlen(fCacheFileName) + 5];
+  sprintf(tmpFileName, "%s.tmp", fCacheFileName);
+
+  Boolean success = False;
+  FILE* fid = fopen(tmpFileName, "wb");
+  if (fid != NULL) {
+    success = fputs(CACHE_FILE_HEADER, fid) >= 0;
+
+    HashTable::Iterator* iter = HashTable::Iterator::create(*fEntries);
+    char const* key;
+    MediaMetadataCacheEntry* entry;
+    while (success && (entry = (MediaMetadataCacheEntry*)(iter->next(key))) != NULL) {
+      success = writeEntry(fid, key, *entry);
+    }
+    delete iter;
+
+    if (fclose(fid) != 0) success = False;
+#if defined(__WIN32__) || defined(_WIN32)
+    remove(fCacheFileName); // because "rename()" won't replace an existing file
+#endif
+    if (success) success = rename(tmpFileName, fCacheFileName) == 0;
+    if (!success) remove(tmpFileName);
+  }
+
+  if (success) {
+    fAppendFid = fopen(fCacheFileName, "ab");
+    success = fAppendFid != NULL;
+  }
+  if (!success) fEnv.setResultErrMsg("Failed to write media metadata cache file: ");
+
+  delete[] tmpFileName;
+  return success;
+}
+
+Boolean MediaMetadataCache::writeEntry(FILE* fid, char const* key, MediaMetadataCacheEntry const& entry) {
+  return fprintf(fid, "%u %llu %lld %f %u\n%s%s\n",
+		 (unsigned)strlen(key), (unsigned long long)entry.fFileSize, (long long)entry.fModificationTime,
+		 entry.fDuration, (unsigned)strlen(entry.fSDPLines), key, entry.fSDPLines) > 0;
+}
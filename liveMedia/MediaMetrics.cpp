@@ -0,0 +1,455 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// A per-environment registry of run-time metrics (counters, gauges, and fixed-bucket histograms),
+// that can be output in the Prometheus 'text exposition' format.
+// Implementation
+
+#include "MediaMetrics.hh"
+#include <stdarg.h>
+
+////////// MetricsTextBuffer (used internally to build output text) //////////
+
+class MetricsTextBuffer {
+public:
+  MetricsTextBuffer();
+  virtual ~MetricsTextBuffer();
+
+  void append(char const* format, ...);
+  void appendSeriesName(MetricSeries const& series, char const* suffix, char const* extraLabel = NULL);
+      // appends: <familyName><suffix>{<labels>,<extraLabel>}
+
+  char* getResult(); // the caller takes ownership of the returned string
+
+private:
+  char* fBuf;
+  unsigned fSize; // not including the trailing '\0'
+  unsigned fMaxSize;
+};
+
+MetricsTextBuffer::MetricsTextBuffer()
+  : fSize(0), fMaxSize(1000) {
+  fBuf = new char[fMaxSize];
+  fBuf[0] = '\0';
+}
+
+MetricsTextBuffer::~MetricsTextBuffer() {
+  delete[] fBuf;
+}
+
+void MetricsTextBuffer::append(char const* format, ...) {
+  while (1) {
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(&fBuf[fSize], fMaxSize - fSize, format, args);
+    va_end(args);
+    if (len < 0) return; // shouldn't happen
+
+    if (fSize + (unsigned)len < fMaxSize) {
+      fSize += len;
+      return;
+    }
+
+    // The buffer was too small; double its size (or more), and try again:
+    unsigned newMaxSize = 2*fMaxSize;
+    if (newMaxSize < fSize + len + 1) newMaxSize = fSize + len + 1;
+    char* newBuf = new char[newMaxSize];
+    memcpy(newBuf, fBuf, fSize + 1);
+    delete[] fBuf;
+    fBuf = newBuf; fMaxSize = newMaxSize;
+  }
+}
+
+void MetricsTextBuffer
+::appendSeriesName(MetricSeries const& series, char const* suffix, char const* extraLabel) {
+  char const* labels = series.labels();
+  Boolean haveLabels = labels != NULL && labels[0] != '\0';
+
+  append("%s%s", series.familyName(), suffix);
+  if (haveLabels || extraLabel != NULL) {
+    append("{%s%s%s}", haveLabels ? labels : "",
+	   haveLabels && extraLabel != NULL ? "," : "",
+	   extraLabel != NULL ? extraLabel : "");
+  }
+}
+
+char* MetricsTextBuffer::getResult() {
+  char* result = fBuf;
+  fBuf = NULL; fSize = fMaxSize = 0;
+  return result;
+}
+
+
+////////// MetricFamily (all of the series that share a metric name) //////////
+
+class MetricFamily {
+public:
+  MetricFamily(MetricSeries* firstSeries);
+  virtual ~MetricFamily();
+
+  void addSeries(MetricSeries* series);
+  void removeSeries(MetricSeries* series);
+  Boolean isEmpty() const { return fSeriesList == NULL; }
+
+  void appendText(MetricsTextBuffer& buf) const;
+
+private:
+  MetricType fType;
+  char* fName;
+  char* fHelp;
+  MetricSeries* fSeriesList;
+};
+
+MetricFamily::MetricFamily(MetricSeries* firstSeries)
+  : fType(firstSeries->type()),
+    fName(strDup(firstSeries->familyName())), fHelp(strDup(firstSeries->help())),
+    fSeriesList(NULL) {
+  addSeries(firstSeries);
+}
+
+MetricFamily::~MetricFamily() {
+  delete[] fName; delete[] fHelp;
+}
+
+void MetricFamily::addSeries(MetricSeries* series) {
+  series->fNextInFamily = fSeriesList;
+  fSeriesList = series;
+}
+
+void MetricFamily::removeSeries(MetricSeries* series) {
+  MetricSeries** ptr = &fSeriesList;
+  while (*ptr != NULL) {
+    if (*ptr == series) {
+      *ptr = series->fNextInFamily;
+      series->fNextInFamily = NULL;
+      return;
+    }
+    ptr = &((*ptr)->fNextInFamily);
+  }
+}
+
+void MetricFamily::appendText(MetricsTextBuffer& buf) const {
+  static char const* const typeNames[] = { "counter", "gauge", "histogram" };
+
+  if (fHelp != NULL) buf.append("# HELP %s %s\n", fName, fHelp);
+  buf.append("# TYPE %s %s\n", fName, typeNames[fType]);
+  for (MetricSeries* series = fSeriesList; series != NULL; series = series->fNextInFamily) {
+    series->appendText(buf);
+  }
+}
+
+
+////////// MetricsRegistry implementation //////////
+
+MetricsRegistry* MetricsRegistry::enable(UsageEnvironment& env) {
+  _Tables* ourTables = _Tables::getOurTables(env);
+  if (ourTables->metricsRegistry == NULL) {
+    ourTables->metricsRegistry = new MetricsRegistry(env);
+  }
+  return (MetricsRegistry*)(ourTables->metricsRegistry);
+}
+
+void MetricsRegistry::disable(UsageEnvironment& env) {
+  _Tables* ourTables = _Tables::getOurTables(env, False);
+  if (ourTables == NULL || ourTables->metricsRegistry == NULL) return;
+
+  delete (MetricsRegistry*)(ourTables->metricsRegistry);
+  ourTables->metricsRegistry = NULL;
+  ourTables->reclaimIfPossible();
+}
+
+MetricsRegistry* MetricsRegistry::lookup(UsageEnvironment& env) {
+  _Tables* ourTables = (_Tables*)(env.liveMediaPriv);
+  return ourTables == NULL ? NULL : (MetricsRegistry*)(ourTables->metricsRegistry);
+}
+
+RTPOverTCPMetrics* MetricsRegistry::tcpMetrics() {
+  if (fTCPMetrics == NULL) fTCPMetrics = new RTPOverTCPMetrics(*this);
+  return fTCPMetrics;
+}
+
+RTPOverTCPMetrics* MetricsRegistry::tcpMetrics(UsageEnvironment& env) {
+  MetricsRegistry* registry = lookup(env);
+  return registry == NULL ? NULL : registry->tcpMetrics();
+}
+
+StreamParserMetrics* MetricsRegistry::streamParserMetrics() {
+  if (fStreamParserMetrics == NULL) fStreamParserMetrics = new StreamParserMetrics(*this);
+  return fStreamParserMetrics;
+}
+
+StreamParserMetrics* MetricsRegistry::streamParserMetrics(UsageEnvironment& env) {
+  MetricsRegistry* registry = lookup(env);
+  return registry == NULL ? NULL : registry->streamParserMetrics();
+}
+
+char* MetricsRegistry::escapeLabelValue(char const* value) {
+  if (value == NULL) value = "";
+  char* result = new char[2*strlen(value) + 1]; // enough, even if every character needs escaping
+  char* to = result;
+  for (char const* from = value; *from != '\0'; ++from) {
+    if (*from == '\\' || *from == '"') {
+      *to++ = '\\'; *to++ = *from;
+    } else if (*from == '\n') {
+      *to++ = '\\'; *to++ = 'n';
+    } else {
+      *to++ = *from;
+    }
+  }
+  *to = '\0';
+
+  return result;
+}
+
+MetricsRegistry::MetricsRegistry(UsageEnvironment& env)
+  : fEnv(env), fFamilies(HashTable::create(STRING_HASH_KEYS)), fTCPMetrics(NULL), fStreamParserMetrics(NULL) {
+}
+
+MetricsRegistry::~MetricsRegistry() {
+  delete fTCPMetrics;
+  delete fStreamParserMetrics;
+
+  // Any remaining families (from series that are still in use) are deleted now:
+  MetricFamily* family;
+  while ((family = (MetricFamily*)fFamilies->RemoveNext()) != NULL) {
+    delete family;
+  }
+  delete fFamilies;
+}
+
+void MetricsRegistry::addSeries(MetricSeries* series) {
+  MetricFamily* family = (MetricFamily*)(fFamilies->Lookup(series->familyName()));
+  if (family == NULL) {
+    fFamilies->Add(series->familyName(), new MetricFamily(series));
+  } else {
+    family->addSeries(series);
+  }
+}
+
+void MetricsRegistry::removeSeries(MetricSeries* series) {
+  MetricFamily* family = (MetricFamily*)(fFamilies->Lookup(series->familyName()));
+  if (family == NULL) return;
+
+  family->removeSeries(series);
+  if (family->isEmpty()) {
+    fFamilies->Remove(series->familyName());
+    delete family;
+  }
+}
+
+char* MetricsRegistry::generatePrometheusText() {
+  MetricsTextBuffer buf;
+
+  HashTable::Iterator* iter = HashTable::Iterator::create(*fFamilies);
+  MetricFamily* family;
+  char const* key; // dummy
+  while ((family = (MetricFamily*)(iter->next(key))) != NULL) {
+    family->appendText(buf);
+  }
+  delete iter;
+
+  return buf.getResult();
+}
+
+
+////////// MetricSeries (and subclasses) implementation //////////
+
+MetricSeries::MetricSeries(MetricsRegistry& registry, MetricType type,
+			   char const* familyName, char const* help, char const* labels)
+  : fRegistry(registry), fType(type),
+    fFamilyName(strDup(familyName)), fHelp(strDup(help)), fLabels(strDup(labels)),
+    fNextInFamily(NULL) {
+  fRegistry.addSeries(this);
+}
+
+MetricSeries::~MetricSeries() {
+  fRegistry.removeSeries(this);
+  delete[] fFamilyName; delete[] fHelp; delete[] fLabels;
+}
+
+MetricCounter::MetricCounter(MetricsRegistry& registry, char const* familyName,
+			     char const* help, char const* labels)
+  : MetricSeries(registry, METRIC_COUNTER, familyName, help, labels) {
+}
+
+void MetricCounter::appendText(MetricsTextBuffer& buf) const {
+  buf.appendSeriesName(*this, "");
+  buf.append(" %llu\n", (unsigned long long)value());
+}
+
+MetricGauge::MetricGauge(MetricsRegistry& registry, char const* familyName,
+			 char const* help, char const* labels)
+  : MetricSeries(registry, METRIC_GAUGE, familyName, help, labels) {
+}
+
+void MetricGauge::appendText(MetricsTextBuffer& buf) const {
+  buf.appendSeriesName(*this, "");
+  buf.append(" %lld\n", (long long)value());
+}
+
+MetricHistogram::MetricHistogram(MetricsRegistry& registry, char const* familyName,
+				 char const* help, char const* labels,
+				 unsigned const* bucketUpperBounds, unsigned numBuckets)
+  : MetricSeries(registry, METRIC_HISTOGRAM, familyName, help, labels),
+    fBucketUpperBounds(bucketUpperBounds), fNumBuckets(numBuckets) {
+  fBucketCounts = new MetricValue[fNumBuckets+1];
+}
+
+MetricHistogram::~MetricHistogram() {
+  delete[] fBucketCounts;
+}
+
+void MetricHistogram::observe(unsigned value) {
+  // Find the first bucket whose upper bound is >= "value".  (There are only a few buckets, so a linear scan is fine.)
+  unsigned i;
+  for (i = 0; i < fNumBuckets; ++i) {
+    if (value <= fBucketUpperBounds[i]) break;
+  }
+  fBucketCounts[i].add(1);
+  fSum.add(value);
+  fCount.add(1);
+}
+
+void MetricHistogram::appendText(MetricsTextBuffer& buf) const {
+  // Prometheus buckets are cumulative:
+  u_int64_t cumulativeCount = 0;
+  char leLabel[30];
+  for (unsigned i = 0; i <= fNumBuckets; ++i) {
+    cumulativeCount += fBucketCounts[i].get();
+    if (i < fNumBuckets) {
+      sprintf(leLabel, "le=\"%u\"", fBucketUpperBounds[i]);
+    } else {
+      sprintf(leLabel, "le=\"+Inf\"");
+    }
+    buf.appendSeriesName(*this, "_bucket", leLabel);
+    buf.append(" %llu\n", (unsigned long long)cumulativeCount);
+  }
+  buf.appendSeriesName(*this, "_sum");
+  buf.append(" %llu\n", (unsigned long long)fSum.get());
+  buf.appendSeriesName(*this, "_count");
+  buf.append(" %llu\n", (unsigned long long)fCount.get());
+}
+
+
+////////// Metric groups //////////
+
+static unsigned const packetSizeBuckets[] = { 64, 128, 256, 512, 1024, 1200, 1400, 1500 };
+static unsigned const numPacketSizeBuckets = sizeof packetSizeBuckets/sizeof packetSizeBuckets[0];
+
+static unsigned const latenessBuckets[] = { 100, 500, 1000, 5000, 10000, 50000, 100000, 500000 }; // microseconds
+static unsigned const numLatenessBuckets = sizeof latenessBuckets/sizeof latenessBuckets[0];
+
+static unsigned const tcpSendSizeBuckets[] = { 64, 256, 1024, 1500, 4096, 16384, 65536 };
+static unsigned const numTCPSendSizeBuckets = sizeof tcpSendSizeBuckets/sizeof tcpSendSizeBuckets[0];
+
+RTPSinkMetrics::RTPSinkMetrics(MetricsRegistry& registry, char const* labels)
+  : packetsSent(registry, "livemedia_rtp_sink_packets_sent_total",
+		"RTP packets sent", labels),
+    bytesSent(registry, "livemedia_rtp_sink_bytes_sent_total",
+	      "RTP bytes sent (including RTP headers)", labels),
+    sendErrors(registry, "livemedia_rtp_sink_send_errors_total",
+	       "RTP packet sends that failed", labels),
+    framesTruncated(registry, "livemedia_rtp_sink_frames_truncated_total",
+		    "Input frames that were too large for the output packet buffer", labels),
+    packetsRetransmitted(registry, "livemedia_rtp_sink_packets_retransmitted_total",
+			 "RTP packets retransmitted (as RFC 4588 \"rtx\" packets) in response to NACKs", labels),
+    repairPacketsSent(registry, "livemedia_rtp_sink_fec_repair_packets_sent_total",
+		      "FEC (RFC 8627 \"flexfec\") repair packets sent", labels),
+    packetSize(registry, "livemedia_rtp_sink_packet_size_bytes",
+	       "Size of each RTP packet sent", labels, packetSizeBuckets, numPacketSizeBuckets),
+    sendLateness(registry, "livemedia_rtp_sink_send_lateness_microseconds",
+		 "How late each RTP packet was sent, relative to its scheduled time", labels,
+		 latenessBuckets, numLatenessBuckets) {
+}
+
+RTPSourceMetrics::RTPSourceMetrics(MetricsRegistry& registry, char const* labels)
+  : packetsReceived(registry, "livemedia_rtp_source_packets_received_total",
+		    "RTP packets received", labels),
+    bytesReceived(registry, "livemedia_rtp_source_bytes_received_total",
+		  "RTP bytes received (including RTP headers)", labels),
+    packetsDiscarded(registry, "livemedia_rtp_source_packets_discarded_total",
+		     "Received packets that were not delivered as RTP data (bad, duplicate, excessively delayed, or not RTP)", labels),
+    retransmissionsRequested(registry, "livemedia_rtp_source_retransmissions_requested_total",
+			     "Missing RTP packets for which a NACK was sent", labels),
+    retransmissionsReceived(registry, "livemedia_rtp_source_retransmissions_received_total",
+			    "Retransmitted (RFC 4588 \"rtx\") RTP packets received", labels),
+    packetsRecovered(registry, "livemedia_rtp_source_fec_packets_recovered_total",
+		     "Lost RTP packets that were recovered using FEC (RFC 8627 \"flexfec\") repair packets", labels),
+    reorderQueueDepth(registry, "livemedia_rtp_source_reorder_queue_depth",
+		      "RTP packets held in the reordering buffer (as of the most recent packet arrival)", labels),
+    reorderThresholdTime(registry, "livemedia_rtp_source_reorder_threshold_microseconds",
+			 "How long the reordering buffer currently waits for a missing packet before giving up on it", labels) {
+}
+
+BufferedPacketPoolMetrics::BufferedPacketPoolMetrics(MetricsRegistry& registry)
+  : smallSlots(registry, "livemedia_packet_pool_small_slots",
+	       "Small (MTU-sized) incoming packet buffers that have been allocated"),
+    smallSlotsInUse(registry, "livemedia_packet_pool_small_slots_in_use",
+		    "Small (MTU-sized) incoming packet buffers that are currently in use"),
+    largeSlots(registry, "livemedia_packet_pool_large_slots",
+	       "Large incoming packet buffers that have been allocated"),
+    largeSlotsInUse(registry, "livemedia_packet_pool_large_slots_in_use",
+		    "Large incoming packet buffers that are currently in use"),
+    truncatedDatagrams(registry, "livemedia_packet_pool_truncated_datagrams_total",
+		       "Incoming datagrams that didn't fit in a small buffer (after which their source uses large buffers)") {
+}
+
+RTPOverTCPMetrics::RTPOverTCPMetrics(MetricsRegistry& registry)
+  : bytesSent(registry, "livemedia_rtp_over_tcp_bytes_sent_total",
+	      "Bytes of RTP/RTCP data sent over TCP"),
+    blockingSends(registry, "livemedia_rtp_over_tcp_blocking_sends_total",
+		  "RTP/RTCP-over-TCP sends that had to block because the TCP send buffer was full"),
+    sendErrors(registry, "livemedia_rtp_over_tcp_send_errors_total",
+	       "RTP/RTCP-over-TCP sends that failed"),
+    sendSize(registry, "livemedia_rtp_over_tcp_send_size_bytes",
+	     "Size of each RTP/RTCP-over-TCP send", NULL, tcpSendSizeBuckets, numTCPSendSizeBuckets) {
+}
+
+StreamParserMetrics::StreamParserMetrics(MetricsRegistry& registry)
+  : inputReads(registry, "livemedia_stream_parser_reads_total",
+	       "Reads by stream parsers from their input sources"),
+    inputStalls(registry, "livemedia_stream_parser_stalls_total",
+		"Times that a stream parser had to stop, to wait for data from its input source"),
+    prefetches(registry, "livemedia_stream_parser_prefetches_total",
+	       "Stream parser reads that were requested before the parser needed the data"),
+    bankGrowths(registry, "livemedia_stream_parser_bank_growths_total",
+		"Times that a stream parser enlarged its buffers, to hold an unusually large amount of data") {
+}
+
+StreamReplicatorMetrics::StreamReplicatorMetrics(MetricsRegistry& registry, char const* labels)
+  : replicas(registry, "livemedia_stream_replicator_replicas",
+	     "Replicas that currently exist", labels),
+    activeReplicas(registry, "livemedia_stream_replicator_active_replicas",
+		   "Replicas that are currently being read", labels),
+    framesReceived(registry, "livemedia_stream_replicator_frames_received_total",
+		   "Frames received from the input source", labels),
+    framesTruncated(registry, "livemedia_stream_replicator_frames_truncated_total",
+		    "Frames (from the input source) that were truncated", labels) {
+}
+
+MediaServerMetrics::MediaServerMetrics(MetricsRegistry& registry, char const* labels)
+  : connectionsAccepted(registry, "livemedia_server_connections_accepted_total",
+			"Client connections accepted", labels),
+    clientConnections(registry, "livemedia_server_client_connections",
+		      "Client connections currently open", labels),
+    clientSessions(registry, "livemedia_server_client_sessions",
+		   "Client sessions currently active", labels),
+    tlsHandshakes(registry, "livemedia_server_tls_handshakes_total",
+		  "TLS handshakes completed", labels),
+    tlsSessionsResumed(registry, "livemedia_server_tls_sessions_resumed_total",
+		       "TLS handshakes that resumed an earlier session", labels) {
+}
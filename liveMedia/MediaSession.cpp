@@ -630,7 +630,7 @@ MediaSubsession::MediaSubsession(MediaSession& parent)
   : serverPortNum(0), sink(NULL), miscPtr(NULL),
     fParent(parent), fNext(NULL),
     fConnectionEndpointName(NULL), fConnectionEndpointNameAddressFamily(AF_UNSPEC),
-    fClientPortNum(0), fRTPPayloadFormat(0xFF),
+    fClientPortNum(0), fRTPPayloadFormat(0xFF), fRTXPayloadFormat(0), fRTXAssociatedPayloadFormat(0xFF), fFECPayloadFormat(0),
     fSavedSDPLines(NULL), fMediumName(NULL), fCodecName(NULL), fProtocolName(NULL),
     fRTPTimestampFrequency(0), fMultiplexRTCPWithRTP(False), fControlPath(NULL),
     fMIKEYState(NULL), fCrypto(NULL),
@@ -889,6 +889,16 @@ Boolean MediaSubsession::initiate(int useSpecialRTPoffset) {
 	env().setResultMsg("Failed to create RTCP instance");
 	break;
       }
+
+      if (fRTXPayloadFormat != 0 && !useSRTP
+	  && (fRTXAssociatedPayloadFormat == 0xFF || fRTXAssociatedPayloadFormat == fRTPPayloadFormat)) {
+	// The server offers to retransmit lost packets (RFC 4588), so request them:
+	fRTPSource->enableRetransmissionRequests(fRTCPInstance, fRTXPayloadFormat);
+      }
+      if (fFECPayloadFormat != 0 && !useSRTP) {
+	// The server also sends FEC repair packets (RFC 8627), so use them to recover lost packets:
+	fRTPSource->enableFECRecovery(fFECPayloadFormat);
+      }
     }
 
     return True;
@@ -1086,17 +1096,23 @@ Boolean MediaSubsession::parseSDPAttribute_rtpmap(char const* sdpLine) {
       || sscanf(sdpLine, "a=rtpmap: %u %s",
 		&rtpmapPayloadFormat, codecName) == 2) {
     parseSuccess = True;
+    // (First, make sure the codec name is upper case)
+    {
+      Locale l("POSIX");
+      for (char* p = codecName; *p != '\0'; ++p) *p = toupper(*p);
+    }
     if (rtpmapPayloadFormat == fRTPPayloadFormat) {
       // This "rtpmap" matches our payload format, so set our
       // codec name and timestamp frequency:
-      // (First, make sure the codec name is upper case)
-      {
-	Locale l("POSIX");
-	for (char* p = codecName; *p != '\0'; ++p) *p = toupper(*p);
-      }
       delete[] fCodecName; fCodecName = strDup(codecName);
       fRTPTimestampFrequency = rtpTimestampFrequency;
       fNumChannels = numChannels;
+    } else if (strcmp(codecName, "RTX") == 0) {
+      // This describes the payload format used for retransmitted packets (RFC 4588):
+      fRTXPayloadFormat = (unsigned char)rtpmapPayloadFormat;
+    } else if (strcmp(codecName, "FLEXFEC") == 0) {
+      // This describes the payload format used for FEC repair packets (RFC 8627):
+      fFECPayloadFormat = (unsigned char)rtpmapPayloadFormat;
     }
   }
   delete[] codecName;
@@ -1150,7 +1166,21 @@ Boolean MediaSubsession::parseSDPAttribute_fmtp(char const* sdpLine) {
   // Check for a "a=fmtp:" line:
   // Later: Check that payload format number matches; #####
   do {
-    if (strncmp(sdpLine, "a=fmtp:", 7) != 0) break; sdpLine += 7;
+    if (strncmp(sdpLine, "a=fmtp:", 7) != 0) break;
+
+    // If this line describes our "rtx" payload format (RFC 4588), then record the payload format that it retransmits
+    // (rather than treating its parameters as our own):
+    unsigned fmtpPayloadFormat, apt;
+    if (fRTXPayloadFormat != 0 && fRTXPayloadFormat != fRTPPayloadFormat
+	&& sscanf(sdpLine, "a=fmtp:%u", &fmtpPayloadFormat) == 1 && fmtpPayloadFormat == fRTXPayloadFormat) {
+      char const* aptStr = strstr(sdpLine, "apt=");
+      if (aptStr != NULL && sscanf(aptStr, "apt=%u", &apt) == 1 && apt <= 127) {
+	fRTXAssociatedPayloadFormat = (unsigned char)apt;
+      }
+      return True;
+    }
+
+    sdpLine += 7;
     while (isdigit(*sdpLine)) ++sdpLine;
 
     // The remaining "sdpLine" should be a sequence of
@@ -67,6 +67,9 @@ Boolean MediaSource::isAMRAudioSource() const {
 Boolean MediaSource::isMPEG2TransportStreamMultiplexor() const {
   return False; // default implementation
 }
+Boolean MediaSource::isMPEG2TransportStreamFramer() const {
+  return False; // default implementation
+}
 
 Boolean MediaSource::lookupByName(UsageEnvironment& env,
 				  char const* sourceName,
@@ -20,8 +20,77 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "MultiFramedRTPSink.hh"
+#include "MediaMetrics.hh"
+#include "FlexFEC.hh"
 #include "GroupsockHelper.hh"
 
+////////// RTPPacketHistory //////////
+
+// A ring of the most recently sent RTP packets, indexed by sequence number, from which packets can be retransmitted
+// (as RFC 4588 "rtx" packets) in response to NACKs.
+
+#ifndef RTX_MAX_RETRANSMISSIONS_PER_PACKET
+#define RTX_MAX_RETRANSMISSIONS_PER_PACKET 2
+    // (so that a receiver that keeps NACKing the same packet can't make us resend it indefinitely)
+#endif
+
+class RTPPacketHistory {
+public:
+  RTPPacketHistory(unsigned numSlots, unsigned slotSize)
+    : fNumSlots(numSlots), fSlotSize(slotSize) {
+    fPackets = new unsigned char[numSlots*slotSize];
+    fSlots = new Slot[numSlots];
+    for (unsigned i = 0; i < numSlots; ++i) fSlots[i].fPacketSize = 0;
+    fRTXPacket = new unsigned char[slotSize + 2/*for the OSN*/];
+  }
+  virtual ~RTPPacketHistory() {
+    delete[] fRTXPacket;
+    delete[] fSlots;
+    delete[] fPackets;
+  }
+
+  void addPacket(u_int16_t seqNum, unsigned char const* packet, unsigned packetSize) {
+    unsigned slotIndex = seqNum%fNumSlots;
+    Slot& slot = fSlots[slotIndex];
+    if (packetSize > fSlotSize) {
+      slot.fPacketSize = 0; // this packet is too big to be kept
+      return;
+    }
+
+    memcpy(&fPackets[slotIndex*fSlotSize], packet, packetSize);
+    slot.fSeqNum = seqNum;
+    slot.fPacketSize = packetSize;
+    slot.fNumRetransmissions = 0;
+  }
+
+  unsigned char const* lookupPacketToRetransmit(u_int16_t seqNum, unsigned& packetSize) {
+    // Returns NULL if we no longer have the packet (or have already retransmitted it too many times):
+    unsigned slotIndex = seqNum%fNumSlots;
+    Slot& slot = fSlots[slotIndex];
+    if (slot.fPacketSize == 0 || slot.fSeqNum != seqNum
+	|| slot.fNumRetransmissions >= RTX_MAX_RETRANSMISSIONS_PER_PACKET) return NULL;
+
+    ++slot.fNumRetransmissions;
+    packetSize = slot.fPacketSize;
+    return &fPackets[slotIndex*fSlotSize];
+  }
+
+  unsigned char* rtxPacket() const { return fRTXPacket; } // used to build "rtx" packets
+
+private:
+  struct Slot {
+    u_int16_t fSeqNum;
+    unsigned fPacketSize; // 0 if the slot is empty
+    unsigned fNumRetransmissions;
+  };
+
+  unsigned fNumSlots, fSlotSize;
+  unsigned char* fPackets;
+  Slot* fSlots;
+  unsigned char* fRTXPacket;
+};
+
+
 ////////// MultiFramedRTPSink //////////
 
 void MultiFramedRTPSink::setPacketSizes(unsigned preferredPacketSize,
@@ -52,12 +121,78 @@ MultiFramedRTPSink::MultiFramedRTPSink(UsageEnvironment& env,
   : RTPSink(env, rtpGS, rtpPayloadType, rtpTimestampFrequency,
 	    rtpPayloadFormatName, numChannels),
     fOutBuf(NULL), fCurFragmentationOffset(0), fPreviousFrameEndedFragmentation(False),
-    fOnSendErrorFunc(NULL), fOnSendErrorData(NULL) {
+    fOnSendErrorFunc(NULL), fOnSendErrorData(NULL),
+    fPacketHistory(NULL), fRTXSeqNo(0), fRTXSSRC(0),
+    fFECEncoder(NULL), fMetrics(NULL) {
   setPacketSizes((RTP_PAYLOAD_PREFERRED_SIZE), (RTP_PAYLOAD_MAX_SIZE));
+
+  MetricsRegistry* metricsRegistry = MetricsRegistry::lookup(env);
+  if (metricsRegistry != NULL) {
+    char labels[200];
+    snprintf(labels, sizeof labels, "medium=\"%s\",codec=\"%s\"", name(), rtpPayloadFormatName);
+    fMetrics = new RTPSinkMetrics(*metricsRegistry, labels);
+  }
 }
 
 MultiFramedRTPSink::~MultiFramedRTPSink() {
+  delete fFECEncoder;
+  delete fPacketHistory;
   delete fOutBuf;
+  delete fMetrics;
+}
+
+Boolean MultiFramedRTPSink::enableRetransmission(unsigned char rtxPayloadType, unsigned historySize) {
+  if (rtxPayloadType == 0 || rtxPayloadType == rtpPayloadType() || historySize == 0) return False;
+  if (fCrypto != NULL) return False; // we don't support retransmission of SRTP packets
+
+  delete fPacketHistory;
+  fPacketHistory = new RTPPacketHistory(historySize, fOurMaxPacketSize);
+  fRTXPayloadType = rtxPayloadType;
+
+  // The "rtx" stream has its own SSRC and sequence numbers (RFC 4588, section 4):
+  fRTXSeqNo = (u_int16_t)our_random();
+  do {
+    fRTXSSRC = our_random32();
+  } while (fRTXSSRC == SSRC());
+
+  return True;
+}
+
+void MultiFramedRTPSink
+::setMetricsStreamName(char const* streamName, char const* trackId, u_int32_t clientSessionId) {
+  if (fMetrics == NULL) return; // metrics are not enabled
+
+  MetricsRegistry* metricsRegistry = MetricsRegistry::lookup(envir());
+  if (metricsRegistry == NULL) return; // shouldn't happen
+
+  // Replace our metrics with ones that have the new labels.  (We haven't yet sent anything, so no counts are lost.)
+  char* escapedStreamName = MetricsRegistry::escapeLabelValue(streamName);
+  char* escapedTrackId = MetricsRegistry::escapeLabelValue(trackId);
+  unsigned const labelsSize = strlen(escapedStreamName) + strlen(escapedTrackId) + strlen(rtpPayloadFormatName()) + 100;
+  char* labels = new char[labelsSize];
+  if (clientSessionId != 0) {
+    snprintf(labels, labelsSize, "stream=\"%s\",track=\"%s\",session=\"%08X\",codec=\"%s\"",
+	     escapedStreamName, escapedTrackId, clientSessionId, rtpPayloadFormatName());
+  } else {
+    snprintf(labels, labelsSize, "stream=\"%s\",track=\"%s\",codec=\"%s\"",
+	     escapedStreamName, escapedTrackId, rtpPayloadFormatName());
+  }
+  delete fMetrics; fMetrics = new RTPSinkMetrics(*metricsRegistry, labels);
+
+  delete[] labels; delete[] escapedTrackId; delete[] escapedStreamName;
+}
+
+Boolean MultiFramedRTPSink::enableFEC(unsigned char fecPayloadType, unsigned numPacketsPerRepairPacket) {
+  if (fecPayloadType == 0 || fecPayloadType == rtpPayloadType() || fecPayloadType == fRTXPayloadType) return False;
+  if (numPacketsPerRepairPacket == 0 || numPacketsPerRepairPacket > 255/*max "L"*/) return False;
+  if (fCrypto != NULL) return False; // we don't support FEC for SRTP packets
+
+  delete fFECEncoder;
+  fFECEncoder = new FlexFECEncoder(fecPayloadType, numPacketsPerRepairPacket, fOurMaxPacketSize);
+  fFECPayloadType = fecPayloadType;
+  fNumPacketsPerRepairPacket = numPacketsPerRepairPacket;
+
+  return True;
 }
 
 void MultiFramedRTPSink
@@ -250,6 +385,7 @@ void MultiFramedRTPSink
   }    
 
   if (numTruncatedBytes > 0) {
+    if (fMetrics != NULL) fMetrics->framesTruncated.increment();
     unsigned const bufferSize = fOutBuf->totalBytesAvailable();
     envir() << "MultiFramedRTPSink::afterGettingFrame1(): The input frame data was too large for our buffer size ("
 	    << bufferSize << ").  "
@@ -366,6 +502,13 @@ Boolean MultiFramedRTPSink::isTooBigForAPacket(unsigned numBytes) const {
 
 void MultiFramedRTPSink::sendPacketIfNecessary() {
   if (fNumFramesUsedSoFar > 0) {
+    if (fPacketHistory != NULL && fCrypto == NULL) {
+      // Keep a copy of the packet, in case a receiver asks for it to be retransmitted:
+      fPacketHistory->addPacket(fSeqNo, fOutBuf->packet(), fOutBuf->curPacketSize());
+    }
+    Boolean repairPacketIsReady
+      = fFECEncoder != NULL && fCrypto == NULL && fFECEncoder->addPacket(fOutBuf->packet(), fOutBuf->curPacketSize());
+
     // Send the packet:
 #ifdef TEST_LOSS
     if ((our_random()%10) != 0) // simulate 10% packet loss #####
@@ -376,7 +519,7 @@ void MultiFramedRTPSink::sendPacketIfNecessary() {
 	// overwrite any following (still to be sent) frame data, we can't encrypt/tag
 	// the packet in place.  Instead, we have to make a copy (on the stack) of
 	// the packet, before encrypting/tagging/sending it:
-	if (fOutBuf->curPacketSize() + SRTP_MKI_LENGTH + SRTP_AUTH_TAG_LENGTH > MAX_UDP_PACKET_SIZE) {
+	if (fOutBuf->curPacketSize() + SRTP_MAX_OUTGOING_PACKET_OVERHEAD > MAX_UDP_PACKET_SIZE) {
 	  fprintf(stderr, "MultiFramedRTPSink::sendPacketIfNecessary(): Fatal error: packet size %d is too large for SRTP\n", fOutBuf->curPacketSize());
 	  exit(1);
 	}
@@ -388,6 +531,7 @@ void MultiFramedRTPSink::sendPacketIfNecessary() {
 	  if (!fRTPInterface.sendPacket(packet, newPacketSize)) {
 	    // if failure handler has been specified, call it
 	    if (fOnSendErrorFunc != NULL) (*fOnSendErrorFunc)(fOnSendErrorData);
+	    if (fMetrics != NULL) fMetrics->sendErrors.increment();
 	  }
 	}
 #endif
@@ -395,10 +539,27 @@ void MultiFramedRTPSink::sendPacketIfNecessary() {
 	if (!fRTPInterface.sendPacket(fOutBuf->packet(), fOutBuf->curPacketSize())) {
 	  // if failure handler has been specified, call it
 	  if (fOnSendErrorFunc != NULL) (*fOnSendErrorFunc)(fOnSendErrorData);
+	  if (fMetrics != NULL) fMetrics->sendErrors.increment();
 	}
       }
+    if (repairPacketIsReady) {
+      // Also send the FEC repair packet that protects this (and the preceding) packets:
+#ifdef TEST_LOSS
+      if ((our_random()%10) != 0) // simulate 10% packet loss #####
+#endif
+      if (fRTPInterface.sendPacket(fFECEncoder->repairPacket(), fFECEncoder->repairPacketSize())) {
+	if (fMetrics != NULL) fMetrics->repairPacketsSent.increment();
+      } else {
+	if (fMetrics != NULL) fMetrics->sendErrors.increment();
+      }
+    }
     ++fPacketCount;
     fTotalOctetCount += fOutBuf->curPacketSize();
+    if (fMetrics != NULL) {
+      fMetrics->packetsSent.increment();
+      fMetrics->bytesSent.increment(fOutBuf->curPacketSize());
+      fMetrics->packetSize.observe(fOutBuf->curPacketSize());
+    }
     fOctetCount += fOutBuf->curPacketSize()
       - rtpHeaderSize - fSpecialHeaderSize - fTotalFrameSpecificHeaderSizes;
 
@@ -433,7 +594,15 @@ void MultiFramedRTPSink::sendPacketIfNecessary() {
     int secsDiff = fNextSendTime.tv_sec - timeNow.tv_sec;
     int64_t uSecondsToGo = secsDiff*1000000 + (fNextSendTime.tv_usec - timeNow.tv_usec);
     if (uSecondsToGo < 0 || secsDiff < 0) { // sanity check: Make sure that the time-to-delay is non-negative:
+      if (fMetrics != NULL) {
+	// We're running late; record by how much:
+	int64_t uSecondsLate = -uSecondsToGo;
+	fMetrics->sendLateness.observe(uSecondsLate <= 0 ? 0
+				       : uSecondsLate > 0xFFFFFFFF ? 0xFFFFFFFF : (unsigned)uSecondsLate);
+      }
       uSecondsToGo = 0;
+    } else if (fMetrics != NULL) {
+      fMetrics->sendLateness.observe(0);
     }
 
     // Delay this amount of time:
@@ -447,6 +616,33 @@ void MultiFramedRTPSink::sendNext(void* firstArg) {
   sink->buildAndSendPacket(False);
 }
 
+void MultiFramedRTPSink::retransmitPacket(u_int16_t seqNum) {
+  if (fPacketHistory == NULL || fCrypto != NULL) return;
+
+  unsigned packetSize;
+  unsigned char const* packet = fPacketHistory->lookupPacketToRetransmit(seqNum, packetSize);
+  if (packet == NULL) return;
+
+  // Build a "rtx" packet (RFC 4588, section 4): The original RTP header - but with the "rtx" payload type, sequence
+  // number and SSRC - followed by the original sequence number (the "OSN"), followed by the original payload:
+  unsigned char* rtxPacket = fPacketHistory->rtxPacket();
+  rtxPacket[0] = packet[0];
+  rtxPacket[1] = (packet[1]&0x80)|fRTXPayloadType; // keep the original marker bit
+  rtxPacket[2] = fRTXSeqNo>>8; rtxPacket[3] = (unsigned char)fRTXSeqNo;
+  memcpy(&rtxPacket[4], &packet[4], 4); // the original timestamp
+  rtxPacket[8] = fRTXSSRC>>24; rtxPacket[9] = fRTXSSRC>>16; rtxPacket[10] = fRTXSSRC>>8; rtxPacket[11] = fRTXSSRC;
+  rtxPacket[12] = packet[2]; rtxPacket[13] = packet[3]; // the OSN
+  memcpy(&rtxPacket[rtpHeaderSize+2], &packet[rtpHeaderSize], packetSize - rtpHeaderSize);
+
+  if (fRTPInterface.sendPacket(rtxPacket, packetSize + 2)) {
+    if (fMetrics != NULL) fMetrics->packetsRetransmitted.increment();
+  } else {
+    if (fOnSendErrorFunc != NULL) (*fOnSendErrorFunc)(fOnSendErrorData);
+    if (fMetrics != NULL) fMetrics->sendErrors.increment();
+  }
+  ++fRTXSeqNo;
+}
+
 void MultiFramedRTPSink::ourHandleClosure(void* clientData) {
   MultiFramedRTPSink* sink = (MultiFramedRTPSink*)clientData;
   // There are no frames left, but we may have a partially built packet
@@ -21,6 +21,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "MultiFramedRTPSource.hh"
 #include "RTCP.hh"
+#include "MediaMetrics.hh"
+#include "BufferedPacketPool.hh"
+#include "FlexFEC.hh"
 #include "GroupsockHelper.hh"
 #include <string.h>
 
@@ -38,26 +41,50 @@ public:
   void releaseUsedPacket(BufferedPacket* packet);
   void freePacket(BufferedPacket* packet) {
     if (packet != fSavedPacket) {
-      delete packet;
+      // Keep the packet descriptor for reuse, but return its buffer to the pool (so that other sources can use it):
+      packet->releaseBuffer();
+      packet->nextPacket() = fFreePackets;
+      fFreePackets = packet;
     } else {
       fSavedPacketFree = True;
     }
   }
+  void useLargePacketBuffers() { fUseLargePacketBuffers = True; }
   Boolean isEmpty() const { return fHeadPacket == NULL; }
-
-  void setThresholdTime(unsigned uSeconds) { fThresholdTime = uSeconds; }
+  unsigned numPackets() const { return fNumPackets; }
+
+  void setThresholdTime(unsigned uSeconds) { fThresholdTime = uSeconds; fMaxThresholdTime = 0; }
+  void setAdaptiveThresholdTime(unsigned minUSeconds, unsigned maxUSeconds);
+  void updateAdaptiveThresholdTime(unsigned jitterUSeconds);
+      // if the threshold time is adaptive; called after each incoming packet
+  Boolean thresholdTimeIsAdaptive() const { return fMaxThresholdTime != 0; }
+  unsigned thresholdTime() const { return fThresholdTime; }
   void resetHaveSeenFirstPacket() { fHaveSeenFirstPacket = False; }
 
+  Boolean getNewGap(unsigned short& firstMissingSeqNo, unsigned& numMissingPackets);
+      // If the most recent call to "storePacket()" revealed a (new) gap in the sequence numbers - i.e., packets that
+      // are missing - returns True, and describes the gap.
+
 private:
   BufferedPacketFactory* fPacketFactory;
   unsigned fThresholdTime; // uSeconds
+  // Used if the threshold time is adaptive:
+  unsigned fMinThresholdTime, fMaxThresholdTime; // uSeconds; fMaxThresholdTime == 0 if the threshold is fixed
+  unsigned fReorderingDelay; // uSeconds; a (slowly decaying) peak of the delays seen in filling gaps in the queue
+  unsigned short fGaveUpSeqNo; // the first of the most recent run of packets that we stopped waiting for...
+  unsigned short fGaveUpNumPackets; // ...and how many there were
   Boolean fHaveSeenFirstPacket; // used to set initial "fNextExpectedSeqNo"
   unsigned short fNextExpectedSeqNo;
   BufferedPacket* fHeadPacket;
   BufferedPacket* fTailPacket;
+  unsigned fNumPackets; // the number of packets currently in the list
+  unsigned short fGapStartSeqNo;
+  unsigned fGapSize; // 0 if the most recently stored packet didn't reveal a gap
   BufferedPacket* fSavedPacket;
       // to avoid calling new/free in the common case
   Boolean fSavedPacketFree;
+  BufferedPacket* fFreePackets; // previously-used packet descriptors, available for reuse
+  Boolean fUseLargePacketBuffers; // set if we've seen an incoming datagram that didn't fit in a small buffer
 };
 
 
@@ -68,12 +95,21 @@ MultiFramedRTPSource
 		       unsigned char rtpPayloadFormat,
 		       unsigned rtpTimestampFrequency,
 		       BufferedPacketFactory* packetFactory)
-  : RTPSource(env, RTPgs, rtpPayloadFormat, rtpTimestampFrequency) {
+  : RTPSource(env, RTPgs, rtpPayloadFormat, rtpTimestampFrequency),
+    fRTCPInstanceForRetransmissionRequests(NULL), fRTXPayloadFormat(0),
+    fFECDecoder(NULL), fFECPayloadFormat(0), fMetrics(NULL) {
   reset();
   fReorderingBuffer = new ReorderingPacketBuffer(packetFactory);
 
   // Try to use a big receive buffer for RTP:
   increaseReceiveBufferTo(env, RTPgs->socketNum(), 50*1024);
+
+  MetricsRegistry* metricsRegistry = MetricsRegistry::lookup(env);
+  if (metricsRegistry != NULL) {
+    char labels[200];
+    snprintf(labels, sizeof labels, "medium=\"%s\",payload_type=\"%u\"", name(), rtpPayloadFormat);
+    fMetrics = new RTPSourceMetrics(*metricsRegistry, labels);
+  }
 }
 
 void MultiFramedRTPSource::reset() {
@@ -86,7 +122,9 @@ void MultiFramedRTPSource::reset() {
 }
 
 MultiFramedRTPSource::~MultiFramedRTPSource() {
+  delete fFECDecoder;
   delete fReorderingBuffer;
+  delete fMetrics;
 }
 
 Boolean MultiFramedRTPSource
@@ -112,6 +150,7 @@ void MultiFramedRTPSource::doStopGettingFrames() {
   envir().taskScheduler().unscheduleDelayedTask(nextTask());
   fRTPInterface.stopNetworkReading();
   fReorderingBuffer->reset();
+  if (fMetrics != NULL) fMetrics->reorderQueueDepth.set(0);
   reset();
 }
 
@@ -218,8 +257,43 @@ void MultiFramedRTPSource::doGetNextFrame1() {
 void MultiFramedRTPSource
 ::setPacketReorderingThresholdTime(unsigned uSeconds) {
   fReorderingBuffer->setThresholdTime(uSeconds);
+  if (fMetrics != NULL) fMetrics->reorderThresholdTime.set(uSeconds);
+}
+
+Boolean MultiFramedRTPSource
+::setAdaptivePacketReorderingThresholdTime(unsigned minUSeconds, unsigned maxUSeconds) {
+  fReorderingBuffer->setAdaptiveThresholdTime(minUSeconds, maxUSeconds);
+  if (fMetrics != NULL) fMetrics->reorderThresholdTime.set(fReorderingBuffer->thresholdTime());
+  return True;
+}
+
+unsigned MultiFramedRTPSource::packetReorderingThresholdTime() const {
+  return fReorderingBuffer->thresholdTime();
+}
+
+Boolean MultiFramedRTPSource
+::enableRetransmissionRequests(RTCPInstance* rtcpInstance, unsigned char rtxPayloadFormat) {
+  if (rtcpInstance == NULL || rtxPayloadFormat == 0 || rtxPayloadFormat == rtpPayloadFormat()) return False;
+
+  fRTCPInstanceForRetransmissionRequests = rtcpInstance;
+  fRTXPayloadFormat = rtxPayloadFormat;
+  return True;
+}
+
+Boolean MultiFramedRTPSource::enableFECRecovery(unsigned char fecPayloadFormat) {
+  if (fecPayloadFormat == 0 || fecPayloadFormat == rtpPayloadFormat() || fecPayloadFormat == fRTXPayloadFormat) return False;
+
+  if (fFECDecoder == NULL) fFECDecoder = new FlexFECDecoder;
+  fFECPayloadFormat = fecPayloadFormat;
+  return True;
 }
 
+// We don't request retransmission of a larger number of consecutive missing packets than this, because it probably
+// indicates an outage (and the retransmissions would probably arrive too late to be used):
+#ifndef MAX_PACKETS_TO_NACK
+#define MAX_PACKETS_TO_NACK 64
+#endif
+
 #define ADVANCE(n) do { bPacket->skip(n); } while (0)
 
 void MultiFramedRTPSource::networkReadHandler(MultiFramedRTPSource* source, int /*mask*/) {
@@ -235,6 +309,7 @@ void MultiFramedRTPSource::networkReadHandler1() {
 
   // Read the network packet, and perform sanity checks on the RTP header:
   Boolean readSuccess = False;
+  Boolean packetWasRead = False;
   do {
     struct sockaddr_storage fromAddress;
     Boolean packetReadWasIncomplete = fPacketReadInProgress != NULL;
@@ -252,6 +327,20 @@ void MultiFramedRTPSource::networkReadHandler1() {
     } else {
       fPacketReadInProgress = NULL;
     }
+    packetWasRead = True;
+    if (bPacket->bytesAvailable() == 0 && !bPacket->usesLargeBuffer()) {
+      // This datagram filled our (small) buffer, so it was probably truncated.  Discard it, and use large buffers
+      // for this source from now on:
+      BufferedPacketPool* pool = BufferedPacketPool::lookup(envir());
+      if (pool != NULL) pool->noteTruncatedDatagram();
+      fReorderingBuffer->useLargePacketBuffers();
+      bPacket->usesLargeBuffer() = True;
+      break;
+    }
+    if (fMetrics != NULL) {
+      fMetrics->packetsReceived.increment();
+      fMetrics->bytesReceived.increment(bPacket->dataSize());
+    }
 #ifdef TEST_LOSS
     setPacketReorderingThresholdTime(0);
        // don't wait for 'lost' packets to arrive out-of-order later
@@ -265,19 +354,42 @@ void MultiFramedRTPSource::networkReadHandler1() {
       bPacket->removePadding(bPacket->dataSize() - newPacketSize); // treat MKI+auth as padding
     }
 
-    // Check for the 12-byte RTP header:
-    if (bPacket->dataSize() < 12) break;
-    unsigned rtpHdr = ntohl(*(u_int32_t*)(bPacket->data())); ADVANCE(4);
-    Boolean rtpMarkerBit = (rtpHdr&0x00800000) != 0;
-    unsigned rtpTimestamp = ntohl(*(u_int32_t*)(bPacket->data()));ADVANCE(4);
-    unsigned rtpSSRC = ntohl(*(u_int32_t*)(bPacket->data())); ADVANCE(4);
+    if (!processIncomingPacket(bPacket, fromAddress)) break;
+    readSuccess = True;
+  } while (0);
+  if (!readSuccess) {
+    if (packetWasRead && fMetrics != NULL) fMetrics->packetsDiscarded.increment();
+    fReorderingBuffer->freePacket(bPacket);
+  }
 
-    // Check the RTP version number (it should be 2):
-    if ((rtpHdr&0xC0000000) != 0x80000000) break;
+  doGetNextFrame1();
+  // If we didn't get proper data this time, we'll get another chance
+}
 
-    // Check the Payload Type.
-    unsigned char rtpPayloadType = (unsigned char)((rtpHdr&0x007F0000)>>16);
-    if (rtpPayloadType != rtpPayloadFormat()) {
+Boolean MultiFramedRTPSource
+::processIncomingPacket(BufferedPacket* bPacket, struct sockaddr_storage const& fromAddress) {
+  // Check for the 12-byte RTP header:
+  if (bPacket->dataSize() < 12) return False;
+  unsigned rtpHdr = ntohl(*(u_int32_t*)(bPacket->data())); ADVANCE(4);
+  Boolean rtpMarkerBit = (rtpHdr&0x00800000) != 0;
+  unsigned rtpTimestamp = ntohl(*(u_int32_t*)(bPacket->data()));ADVANCE(4);
+  unsigned rtpSSRC = ntohl(*(u_int32_t*)(bPacket->data())); ADVANCE(4);
+
+  // Check the RTP version number (it should be 2):
+  if ((rtpHdr&0xC0000000) != 0x80000000) return False;
+
+  // Check the Payload Type.
+  unsigned char rtpPayloadType = (unsigned char)((rtpHdr&0x007F0000)>>16);
+  Boolean isRetransmission = False;
+  if (rtpPayloadType != rtpPayloadFormat()) {
+    if (fFECPayloadFormat != 0 && rtpPayloadType == fFECPayloadFormat) {
+      // This is a FEC repair packet (RFC 8627).  Use it to recover any (single) lost packet that it protects:
+      recoverPacketUsingFEC(bPacket, fromAddress);
+      return False; // because the repair packet itself isn't stored
+    } else if (fRTXPayloadFormat != 0 && rtpPayloadType == fRTXPayloadFormat) {
+      // This is a retransmitted ("rtx") packet (RFC 4588).  We handle it below, after the rest of its RTP header:
+      isRetransmission = True;
+    } else {
       if (fRTCPInstanceForMultiplexedRTCPPackets != NULL
 	  && rtpPayloadType >= 64 && rtpPayloadType <= 95) {
 	// This is a multiplexed RTCP packet, and we've been asked to deliver such packets.
@@ -285,76 +397,122 @@ void MultiFramedRTPSource::networkReadHandler1() {
 	fRTCPInstanceForMultiplexedRTCPPackets
 	  ->injectReport(bPacket->data()-12, bPacket->dataSize()+12, fromAddress);
       }
-      break;
+      return False;
     }
+  } else if (fFECDecoder != NULL) {
+    // Remember this packet, in case it's needed to recover another (lost) packet later:
+    fFECDecoder->addMediaPacket(bPacket->data()-12, bPacket->dataSize()+12);
+  }
 
-    // Skip over any CSRC identifiers in the header:
-    unsigned cc = (rtpHdr>>24)&0x0F;
-    if (bPacket->dataSize() < cc*4) break;
-    ADVANCE(cc*4);
-
-    // Check for (& ignore) any RTP header extension
-    if (rtpHdr&0x10000000) {
-      if (bPacket->dataSize() < 4) break;
-      unsigned extHdr = ntohl(*(u_int32_t*)(bPacket->data())); ADVANCE(4);
-      unsigned remExtSize = 4*(extHdr&0xFFFF);
-      if (bPacket->dataSize() < remExtSize) break;
-      ADVANCE(remExtSize);
-    }
+  // Skip over any CSRC identifiers in the header:
+  unsigned cc = (rtpHdr>>24)&0x0F;
+  if (bPacket->dataSize() < cc*4) return False;
+  ADVANCE(cc*4);
+
+  // Check for (& ignore) any RTP header extension
+  if (rtpHdr&0x10000000) {
+    if (bPacket->dataSize() < 4) return False;
+    unsigned extHdr = ntohl(*(u_int32_t*)(bPacket->data())); ADVANCE(4);
+    unsigned remExtSize = 4*(extHdr&0xFFFF);
+    if (bPacket->dataSize() < remExtSize) return False;
+    ADVANCE(remExtSize);
+  }
 
-    // Discard any padding bytes:
-    if (rtpHdr&0x20000000) {
-      if (bPacket->dataSize() == 0) break;
-      unsigned numPaddingBytes
-	= (unsigned)(bPacket->data())[bPacket->dataSize()-1];
-      if (bPacket->dataSize() < numPaddingBytes) break;
-      bPacket->removePadding(numPaddingBytes);
-    }
+  // Discard any padding bytes:
+  if (rtpHdr&0x20000000) {
+    if (bPacket->dataSize() == 0) return False;
+    unsigned numPaddingBytes
+      = (unsigned)(bPacket->data())[bPacket->dataSize()-1];
+    if (bPacket->dataSize() < numPaddingBytes) return False;
+    bPacket->removePadding(numPaddingBytes);
+  }
 
-    // The rest of the packet is the usable data.  Record and save it:
-    if (rtpSSRC != fLastReceivedSSRC) {
-      // The SSRC of incoming packets has changed.  Unfortunately we don't yet handle streams that contain multiple SSRCs,
-      // but we can handle a single-SSRC stream where the SSRC changes occasionally:
-      fLastReceivedSSRC = rtpSSRC;
-      fReorderingBuffer->resetHaveSeenFirstPacket();
+  unsigned short rtpSeqNo = (unsigned short)(rtpHdr&0xFFFF);
+  if (isRetransmission) {
+    // The payload begins with the original packet's sequence number (the "OSN"); the rest is the original payload.
+    // Treat the packet as if it were the original (which had the SSRC of the media stream that we're receiving):
+    if (bPacket->dataSize() < 2) return False;
+    if (receptionStatsDB().lookup(fLastReceivedSSRC) == NULL) return False; // we haven't yet received any media packets
+    rtpSeqNo = (bPacket->data()[0]<<8)|bPacket->data()[1]; ADVANCE(2);
+    rtpSSRC = fLastReceivedSSRC;
+    if (fMetrics != NULL) fMetrics->retransmissionsReceived.increment();
+  }
+
+  // The rest of the packet is the usable data.  Record and save it:
+  if (rtpSSRC != fLastReceivedSSRC) {
+    // The SSRC of incoming packets has changed.  Unfortunately we don't yet handle streams that contain multiple SSRCs,
+    // but we can handle a single-SSRC stream where the SSRC changes occasionally:
+    fLastReceivedSSRC = rtpSSRC;
+    fReorderingBuffer->resetHaveSeenFirstPacket();
+  }
+  Boolean usableInJitterCalculation
+    = !isRetransmission // because a retransmitted packet's arrival time says nothing about the network's jitter
+    && packetIsUsableInJitterCalculation((bPacket->data()),
+					 bPacket->dataSize());
+  struct timeval presentationTime; // computed by:
+  Boolean hasBeenSyncedUsingRTCP; // computed by:
+  receptionStatsDB()
+    .noteIncomingPacket(rtpSSRC, rtpSeqNo, rtpTimestamp,
+			timestampFrequency(),
+			usableInJitterCalculation, presentationTime,
+			hasBeenSyncedUsingRTCP, bPacket->dataSize());
+
+  // Fill in the rest of the packet descriptor, and store it:
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  bPacket->assignMiscParams(rtpSeqNo, rtpTimestamp, presentationTime,
+			    hasBeenSyncedUsingRTCP, rtpMarkerBit,
+			    timeNow);
+  Boolean packetWasStored = fReorderingBuffer->storePacket(bPacket);
+
+  // If our reordering threshold time is adaptive, update it using the stream's current jitter estimate:
+  if (fReorderingBuffer->thresholdTimeIsAdaptive() && timestampFrequency() > 0) {
+    RTPReceptionStats* stats = receptionStatsDB().lookup(rtpSSRC);
+    if (stats != NULL) {
+      fReorderingBuffer->updateAdaptiveThresholdTime((unsigned)((stats->jitter()*1000000.0)/timestampFrequency()));
     }
-    unsigned short rtpSeqNo = (unsigned short)(rtpHdr&0xFFFF);
-    Boolean usableInJitterCalculation
-      = packetIsUsableInJitterCalculation((bPacket->data()),
-						  bPacket->dataSize());
-    struct timeval presentationTime; // computed by:
-    Boolean hasBeenSyncedUsingRTCP; // computed by:
-    receptionStatsDB()
-      .noteIncomingPacket(rtpSSRC, rtpSeqNo, rtpTimestamp,
-			  timestampFrequency(),
-			  usableInJitterCalculation, presentationTime,
-			  hasBeenSyncedUsingRTCP, bPacket->dataSize());
-
-    // Fill in the rest of the packet descriptor, and store it:
-    struct timeval timeNow;
-    gettimeofday(&timeNow, NULL);
-    bPacket->assignMiscParams(rtpSeqNo, rtpTimestamp, presentationTime,
-			      hasBeenSyncedUsingRTCP, rtpMarkerBit,
-			      timeNow);
-    if (!fReorderingBuffer->storePacket(bPacket)) break;
+  }
+  if (!packetWasStored) return False;
+  if (fMetrics != NULL) {
+    fMetrics->reorderQueueDepth.set(fReorderingBuffer->numPackets()); // as seen on packet arrival
+    fMetrics->reorderThresholdTime.set(fReorderingBuffer->thresholdTime());
+  }
 
-    readSuccess = True;
-  } while (0);
-  if (!readSuccess) fReorderingBuffer->freePacket(bPacket);
+  unsigned short firstMissingSeqNo; unsigned numMissingPackets;
+  if (fReorderingBuffer->getNewGap(firstMissingSeqNo, numMissingPackets)
+      && fRTCPInstanceForRetransmissionRequests != NULL && numMissingPackets <= MAX_PACKETS_TO_NACK) {
+    // Ask the sender to retransmit the missing packets:
+    fRTCPInstanceForRetransmissionRequests->sendNACK(rtpSSRC, firstMissingSeqNo, numMissingPackets);
+    if (fMetrics != NULL) fMetrics->retransmissionsRequested.increment(numMissingPackets);
+  }
 
-  doGetNextFrame1();
-  // If we didn't get proper data this time, we'll get another chance
+  return True;
+}
+
+void MultiFramedRTPSource
+::recoverPacketUsingFEC(BufferedPacket* repairPacket, struct sockaddr_storage const& fromAddress) {
+  // Note: The repair packet's 12-byte RTP header has already been skipped:
+  unsigned recoveredPacketSize;
+  unsigned char const* recoveredPacket
+    = fFECDecoder->recoverPacket(repairPacket->data()-12, repairPacket->dataSize()+12, recoveredPacketSize);
+  if (recoveredPacket == NULL) return;
+
+  // Process the recovered packet as if it had just been received:
+  BufferedPacket* bPacket = fReorderingBuffer->getFreePacket(this);
+  if (bPacket->fillInData(envir(), recoveredPacket, recoveredPacketSize)
+      && processIncomingPacket(bPacket, fromAddress)) {
+    if (fMetrics != NULL) fMetrics->packetsRecovered.increment();
+  } else {
+    fReorderingBuffer->freePacket(bPacket);
+  }
 }
 
 
 ////////// BufferedPacket and BufferedPacketFactory implementation /////
 
-#define MAX_PACKET_SIZE 65536
-
 BufferedPacket::BufferedPacket()
-  : fPacketSize(MAX_PACKET_SIZE),
-    fBuf(new unsigned char[MAX_PACKET_SIZE]),
-    fNextPacket(NULL) {
+  : fPacketSize(0), fBuf(NULL), fHead(0), fTail(0),
+    fNextPacket(NULL), fPool(NULL), fUsesLargeBuffer(False) {
 }
 
 BufferedPacket::~BufferedPacket() {
@@ -372,7 +530,31 @@ BufferedPacket::~BufferedPacket() {
   }
   /////
 
-  delete[] fBuf;
+  releaseBuffer();
+}
+
+void BufferedPacket::releaseBuffer() {
+  if (fPool != NULL) {
+    fPool->freeSlot(fBuf, fPacketSize);
+    fPool = NULL;
+  }
+  fBuf = NULL;
+  fPacketSize = fHead = fTail = 0;
+}
+
+void BufferedPacket::allocateBuffer(UsageEnvironment& env, unsigned minSize) {
+  // Get a new buffer (of at least "minSize" bytes), copying any existing data into it:
+  BufferedPacketPool* pool = &BufferedPacketPool::ourPool(env);
+  unsigned newPacketSize;
+  unsigned char* newBuf = pool->allocateSlot(minSize, newPacketSize);
+  if (fTail > 0) memmove(newBuf, fBuf, fTail);
+
+  unsigned head = fHead, tail = fTail;
+  releaseBuffer();
+  fBuf = newBuf;
+  fPacketSize = newPacketSize;
+  fPool = pool;
+  fHead = head; fTail = tail;
 }
 
 void BufferedPacket::reset() {
@@ -407,7 +589,20 @@ void BufferedPacket
 
 Boolean BufferedPacket::fillInData(RTPInterface& rtpInterface, struct sockaddr_storage& fromAddress,
 				   Boolean& packetReadWasIncomplete) {
-  if (!packetReadWasIncomplete) reset();
+  if (!packetReadWasIncomplete) {
+    unsigned const desiredSize
+      = fUsesLargeBuffer ? BUFFERED_PACKET_POOL_LARGE_SLOT_SIZE : BUFFERED_PACKET_POOL_SMALL_SLOT_SIZE;
+    if (fBuf == NULL || fPacketSize < desiredSize) {
+      fHead = fTail = 0;
+      allocateBuffer(rtpInterface.envir(), desiredSize);
+    }
+    reset();
+  }
+
+  // If we're about to read a packet over TCP, make sure that it will fit (with at least one byte to spare, so that a
+  // full buffer indicates a truncated datagram):
+  unsigned const nextTCPReadSize = rtpInterface.nextTCPReadSize();
+  if (nextTCPReadSize >= bytesAvailable()) allocateBuffer(rtpInterface.envir(), fTail + nextTCPReadSize + 1);
 
   unsigned const maxBytesToRead = bytesAvailable();
   if (maxBytesToRead == 0) return False; // exceeded buffer size when reading over TCP
@@ -425,6 +620,19 @@ Boolean BufferedPacket::fillInData(RTPInterface& rtpInterface, struct sockaddr_s
   return True;
 }
 
+Boolean BufferedPacket::fillInData(UsageEnvironment& env, unsigned char const* packet, unsigned packetSize) {
+  if (fBuf == NULL || fPacketSize < packetSize) {
+    fHead = fTail = 0;
+    allocateBuffer(env, packetSize);
+  }
+  reset();
+
+  if (packetSize > bytesAvailable()) return False; // shouldn't happen
+  memmove(&fBuf[fTail], packet, packetSize);
+  fTail += packetSize;
+  return True;
+}
+
 void BufferedPacket
 ::assignMiscParams(unsigned short rtpSeqNo, unsigned rtpTimestamp,
 		   struct timeval presentationTime,
@@ -450,6 +658,7 @@ void BufferedPacket::removePadding(unsigned numBytes) {
 
 void BufferedPacket::appendData(unsigned char* newData, unsigned numBytes) {
   if (numBytes > fPacketSize-fTail) numBytes = fPacketSize - fTail;
+  if (numBytes == 0) return;
   memmove(&fBuf[fTail], newData, numBytes);
   fTail += numBytes;
 }
@@ -509,7 +718,9 @@ BufferedPacket* BufferedPacketFactory
 ReorderingPacketBuffer
 ::ReorderingPacketBuffer(BufferedPacketFactory* packetFactory)
   : fThresholdTime(100000) /* default reordering threshold: 100 ms */,
-    fHaveSeenFirstPacket(False), fHeadPacket(NULL), fTailPacket(NULL), fSavedPacket(NULL), fSavedPacketFree(True) {
+    fMinThresholdTime(0), fMaxThresholdTime(0), fReorderingDelay(0), fGaveUpSeqNo(0), fGaveUpNumPackets(0),
+    fHaveSeenFirstPacket(False), fHeadPacket(NULL), fTailPacket(NULL), fNumPackets(0), fGapSize(0),
+    fSavedPacket(NULL), fSavedPacketFree(True), fFreePackets(NULL), fUseLargePacketBuffers(False) {
   fPacketFactory = (packetFactory == NULL)
     ? (new BufferedPacketFactory)
     : packetFactory;
@@ -523,8 +734,10 @@ ReorderingPacketBuffer::~ReorderingPacketBuffer() {
 void ReorderingPacketBuffer::reset() {
   if (fSavedPacketFree) delete fSavedPacket; // because fSavedPacket is not in the list
   delete fHeadPacket; // will also delete fSavedPacket if it's in the list
+  delete fFreePackets; // will also delete the rest of the free list
   resetHaveSeenFirstPacket();
-  fHeadPacket = fTailPacket = fSavedPacket = NULL;
+  fHeadPacket = fTailPacket = fSavedPacket = fFreePackets = NULL;
+  fNumPackets = 0;
 }
 
 BufferedPacket* ReorderingPacketBuffer::getFreePacket(MultiFramedRTPSource* ourSource) {
@@ -533,16 +746,25 @@ BufferedPacket* ReorderingPacketBuffer::getFreePacket(MultiFramedRTPSource* ourS
     fSavedPacketFree = True;
   }
 
+  BufferedPacket* packet;
   if (fSavedPacketFree == True) {
     fSavedPacketFree = False;
-    return fSavedPacket;
+    packet = fSavedPacket;
+  } else if (fFreePackets != NULL) {
+    packet = fFreePackets;
+    fFreePackets = packet->nextPacket();
+    packet->nextPacket() = NULL;
   } else {
-    return fPacketFactory->createNewPacket(ourSource);
+    packet = fPacketFactory->createNewPacket(ourSource);
   }
+
+  if (fUseLargePacketBuffers) packet->usesLargeBuffer() = True;
+  return packet;
 }
 
 Boolean ReorderingPacketBuffer::storePacket(BufferedPacket* bPacket) {
   unsigned short rtpSeqNo = bPacket->rtpSeqNo();
+  fGapSize = 0;
 
   if (!fHaveSeenFirstPacket) {
     fNextExpectedSeqNo = rtpSeqNo; // initialization
@@ -552,20 +774,40 @@ Boolean ReorderingPacketBuffer::storePacket(BufferedPacket* bPacket) {
 
   // Ignore this packet if its sequence number is less than the one
   // that we're looking for (in this case, it's been excessively delayed).
-  if (seqNumLT(rtpSeqNo, fNextExpectedSeqNo)) return False;
+  if (seqNumLT(rtpSeqNo, fNextExpectedSeqNo)) {
+    if (fMaxThresholdTime > 0 && (unsigned short)(rtpSeqNo - fGaveUpSeqNo) < fGaveUpNumPackets) {
+      // We gave up waiting for this packet too soon.  Next time, wait longer:
+      unsigned delay = fThresholdTime + fThresholdTime/2;
+      if (delay > fReorderingDelay) fReorderingDelay = delay;
+    }
+    return False;
+  }
 
   if (fTailPacket == NULL) {
     // Common case: There are no packets in the queue; this will be the first one:
+    if (rtpSeqNo != fNextExpectedSeqNo) {
+      // The packet(s) before this one are missing:
+      fGapStartSeqNo = fNextExpectedSeqNo;
+      fGapSize = (unsigned short)(rtpSeqNo - fNextExpectedSeqNo);
+    }
     bPacket->nextPacket() = NULL;
     fHeadPacket = fTailPacket = bPacket;
+    fNumPackets = 1;
     return True;
   }
 
   if (seqNumLT(fTailPacket->rtpSeqNo(), rtpSeqNo)) {
     // The next-most common case: There are packets already in the queue; this packet arrived in order => put it at the tail:
+    unsigned short nextSeqNoAfterTail = fTailPacket->rtpSeqNo() + 1;
+    if (rtpSeqNo != nextSeqNoAfterTail) {
+      // The packet(s) between the tail and this one are missing:
+      fGapStartSeqNo = nextSeqNoAfterTail;
+      fGapSize = (unsigned short)(rtpSeqNo - nextSeqNoAfterTail);
+    }
     bPacket->nextPacket() = NULL;
     fTailPacket->nextPacket() = bPacket;
     fTailPacket = bPacket;
+    ++fNumPackets;
     return True;
   } 
 
@@ -588,6 +830,15 @@ Boolean ReorderingPacketBuffer::storePacket(BufferedPacket* bPacket) {
     afterPtr = afterPtr->nextPacket();
   }
 
+  if (afterPtr != NULL) {
+    // This packet has filled (part of) a gap in the queue.  Note how long the (earlier received) packet after it has
+    // been waiting, in case we're adapting our threshold time:
+    unsigned delay
+      = (bPacket->timeReceived().tv_sec - afterPtr->timeReceived().tv_sec)*1000000
+      + (bPacket->timeReceived().tv_usec - afterPtr->timeReceived().tv_usec);
+    if ((int)delay > 0 && delay > fReorderingDelay) fReorderingDelay = delay;
+  }
+
   // Link our new packet between "beforePtr" and "afterPtr":
   bPacket->nextPacket() = afterPtr;
   if (beforePtr == NULL) {
@@ -595,7 +846,52 @@ Boolean ReorderingPacketBuffer::storePacket(BufferedPacket* bPacket) {
   } else {
     beforePtr->nextPacket() = bPacket;
   }
+  ++fNumPackets;
+
+  return True;
+}
+
+void ReorderingPacketBuffer::setAdaptiveThresholdTime(unsigned minUSeconds, unsigned maxUSeconds) {
+  if (maxUSeconds < minUSeconds) maxUSeconds = minUSeconds;
+  if (maxUSeconds == 0) { // degenerate case: there's no adapting to do
+    setThresholdTime(0);
+    return;
+  }
+
+  fMinThresholdTime = minUSeconds;
+  fMaxThresholdTime = maxUSeconds;
+  if (fThresholdTime < fMinThresholdTime) fThresholdTime = fMinThresholdTime;
+  else if (fThresholdTime > fMaxThresholdTime) fThresholdTime = fMaxThresholdTime;
+  fReorderingDelay = 0;
+}
+
+// When adapting, we wait at least this many times the current jitter estimate:
+#ifndef REORDERING_THRESHOLD_JITTER_MULTIPLE
+#define REORDERING_THRESHOLD_JITTER_MULTIPLE 4
+#endif
+
+void ReorderingPacketBuffer::updateAdaptiveThresholdTime(unsigned jitterUSeconds) {
+  if (fMaxThresholdTime == 0) return; // the threshold time is fixed
+
+  // Wait long enough to cover both the jitter and the reordering that we've seen recently (with a 25% margin).  The
+  // reordering estimate decays by 1/256 with each packet, so that occasional bursts don't increase the delay for long:
+  unsigned reorderingThreshold = fReorderingDelay + fReorderingDelay/4;
+  fReorderingDelay -= fReorderingDelay>>8;
+
+  unsigned newThresholdTime = REORDERING_THRESHOLD_JITTER_MULTIPLE*jitterUSeconds;
+  if (reorderingThreshold > newThresholdTime) newThresholdTime = reorderingThreshold;
+
+  if (newThresholdTime < fMinThresholdTime) newThresholdTime = fMinThresholdTime;
+  else if (newThresholdTime > fMaxThresholdTime) newThresholdTime = fMaxThresholdTime;
+  fThresholdTime = newThresholdTime;
+}
+
+Boolean ReorderingPacketBuffer::getNewGap(unsigned short& firstMissingSeqNo, unsigned& numMissingPackets) {
+  if (fGapSize == 0) return False;
 
+  firstMissingSeqNo = fGapStartSeqNo;
+  numMissingPackets = fGapSize;
+  fGapSize = 0; // so that we don't report the same gap again
   return True;
 }
 
@@ -608,6 +904,7 @@ void ReorderingPacketBuffer::releaseUsedPacket(BufferedPacket* packet) {
   if (!fHeadPacket) { 
     fTailPacket = NULL;
   }
+  if (fNumPackets > 0) --fNumPackets;
   packet->nextPacket() = NULL;
 
   freePacket(packet);
@@ -641,6 +938,9 @@ BufferedPacket* ReorderingPacketBuffer
     timeThresholdHasBeenExceeded = uSecondsSinceReceived > fThresholdTime;
   }
   if (timeThresholdHasBeenExceeded) {
+    // Remember which packets we gave up on, in case any of them arrive later:
+    fGaveUpSeqNo = fNextExpectedSeqNo;
+    fGaveUpNumPackets = (unsigned short)(fHeadPacket->rtpSeqNo() - fNextExpectedSeqNo);
     fNextExpectedSeqNo = fHeadPacket->rtpSeqNo();
         // we've given up on earlier packets now
     packetLossPreceded = True;
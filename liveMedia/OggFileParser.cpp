@@ -63,8 +63,8 @@ void OggFileParser::continueParsing(void* clientData, unsigned char* ptr, unsign
 
 void OggFileParser::continueParsing() {
   if (fInputSource != NULL) {
-    if (fInputSource->isCurrentlyAwaitingData()) return;
-        // Our input source is currently being read. Wait until that read completes
+    if (isWaitingForInput()) return;
+        // We're waiting for more data from our input source. Wait until that read completes
 
     if (!parse()) {
       // We didn't complete the parsing, because we had to read more data from the source,
@@ -20,6 +20,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "OnDemandServerMediaSubsession.hh"
+#include "MediaMetadataCache.hh"
+#include "ServerPortPool.hh"
 #include <GroupsockHelper.hh>
 
 OnDemandServerMediaSubsession
@@ -30,8 +32,10 @@ OnDemandServerMediaSubsession
   : ServerMediaSubsession(env),
     fSDPLines(NULL), fMIKEYStateMessage(NULL), fMIKEYStateMessageSize(0),
     fReuseFirstSource(reuseFirstSource),
-    fMultiplexRTCPWithRTP(multiplexRTCPWithRTP), fLastStreamToken(NULL),
-    fAppHandlerTask(NULL), fAppHandlerClientData(NULL) {
+    fMultiplexRTCPWithRTP(multiplexRTCPWithRTP), fRetransmissionHistorySize(0), fLastStreamToken(NULL),
+    fAppHandlerTask(NULL), fAppHandlerClientData(NULL),
+    fPreparingInputSource(NULL), fPreparingGroupsock(NULL), fPreparingRTPSink(NULL),
+    fPreparingEstBitrate(0), fPreparingAddressFamily(AF_INET), fSDPLinesPreparedTask(NULL) {
   fDestinationsHashTable = HashTable::create(ONE_WORD_HASH_KEYS);
   if (fMultiplexRTCPWithRTP) {
     fInitialPortNum = initialPortNum;
@@ -44,6 +48,12 @@ OnDemandServerMediaSubsession
 }
 
 OnDemandServerMediaSubsession::~OnDemandServerMediaSubsession() {
+  // Discard any (asynchronous) preparation of our SDP lines that's still in progress:
+  envir().taskScheduler().unscheduleDelayedTask(fSDPLinesPreparedTask);
+  Medium::close(fPreparingRTPSink);
+  delete fPreparingGroupsock;
+  Medium::close(fPreparingInputSource);
+
   delete[] fMIKEYStateMessage;
   delete[] fSDPLines;
 
@@ -66,7 +76,7 @@ OnDemandServerMediaSubsession::sdpLines(int addressFamily) {
     RTPSink* rtpSink = ((StreamState*)fLastStreamToken)->rtpSink();
     if (rtpSink != NULL && rtpSink->srtpROC() != fSRTP_ROC) {
       fSRTP_ROC = rtpSink->srtpROC();
-      rtpSink->setupForSRTP(fParentSession->streamingIsEncrypted, fSRTP_ROC);
+      rtpSink->setupForSRTP(fParentSession->streamingIsEncrypted, fSRTP_ROC, fParentSession->streamingUsesAESGCM);
       setSDPLinesFromRTPSink(rtpSink, getStreamSource(fLastStreamToken), rtpSink->estimatedBitrate());
 
       RTCPInstance* rtcp = ((StreamState*)fLastStreamToken)->rtcpInstance();
@@ -74,42 +84,44 @@ OnDemandServerMediaSubsession::sdpLines(int addressFamily) {
     }
   }
 
-  if (fSDPLines == NULL) {
+  if (fSDPLines == NULL && !setSDPLinesFromMetadataCache(addressFamily)) {
     // We need to construct a set of SDP lines that describe this
     // subsession (as a unicast stream).  To do so, we first create
     // dummy (unused) source and "RTPSink" objects,
     // whose parameters we use for the SDP lines:
-    unsigned estBitrate;
-    FramedSource* inputSource = createNewStreamSource(0, estBitrate);
-    if (inputSource == NULL) return NULL; // file not found
-
-    Groupsock* dummyGroupsock = createGroupsock(nullAddress(addressFamily), 0);
-    unsigned char rtpPayloadType = 96 + trackNumber()-1; // if dynamic
-    RTPSink* dummyRTPSink = createNewRTPSink(dummyGroupsock, rtpPayloadType, inputSource);
-    if (dummyRTPSink != NULL) {
-      if (fParentSession->streamingUsesSRTP) {
-	if (fMIKEYStateMessage != NULL) {
-	  // Use the existing stream's MIKEY info to generate the SDP:
-	  dummyRTPSink->setupForSRTP(fMIKEYStateMessage, fMIKEYStateMessageSize, fSRTP_ROC);
-	} else {
-	  // Create new MIKEY info for this stream:
-	  fMIKEYStateMessage
-	    = dummyRTPSink->setupForSRTP(fParentSession->streamingIsEncrypted, fSRTP_ROC,
-					 fMIKEYStateMessageSize);
-	}
-      }
-
-      if (dummyRTPSink->estimatedBitrate() > 0) estBitrate = dummyRTPSink->estimatedBitrate();
-      setSDPLinesFromRTPSink(dummyRTPSink, inputSource, estBitrate);
-      Medium::close(dummyRTPSink);
+    FramedSource* inputSource; Groupsock* dummyGroupsock; RTPSink* dummyRTPSink; unsigned estBitrate;
+    if (!createDummyStream(addressFamily, inputSource, dummyGroupsock, dummyRTPSink, estBitrate)) {
+      return NULL; // file not found
     }
-    delete dummyGroupsock;
-    closeStreamSource(inputSource);
+    setSDPLinesFromDummyStream(addressFamily, inputSource, dummyGroupsock, dummyRTPSink, estBitrate);
   }
 
   return fSDPLines;
 }
 
+Boolean OnDemandServerMediaSubsession::sdpLinesAreReady(int addressFamily) {
+  return fSDPLines != NULL || setSDPLinesFromMetadataCache(addressFamily);
+}
+
+Boolean OnDemandServerMediaSubsession::prepareSDPLines(int addressFamily) {
+  // This is like the implementation of "sdpLines()", except that - if our subclass needs to read data from the
+  // input source before it knows our 'aux SDP line' - we don't block; instead we keep our dummy objects until
+  // "auxSDPLineIsReady()" is called.
+  FramedSource* inputSource; Groupsock* dummyGroupsock; RTPSink* dummyRTPSink; unsigned estBitrate;
+  if (!createDummyStream(addressFamily, inputSource, dummyGroupsock, dummyRTPSink, estBitrate)) {
+    return True; // file not found
+  }
+
+  if (dummyRTPSink != NULL && !startGettingAuxSDPLine(dummyRTPSink, inputSource)) {
+    fPreparingInputSource = inputSource; fPreparingGroupsock = dummyGroupsock; fPreparingRTPSink = dummyRTPSink;
+    fPreparingEstBitrate = estBitrate; fPreparingAddressFamily = addressFamily;
+    return False;
+  }
+
+  setSDPLinesFromDummyStream(addressFamily, inputSource, dummyGroupsock, dummyRTPSink, estBitrate);
+  return True;
+}
+
 void OnDemandServerMediaSubsession
 ::getStreamParameters(unsigned clientSessionId,
 		      struct sockaddr_storage const& clientAddress,
@@ -153,16 +165,30 @@ void OnDemandServerMediaSubsession
 
     if (clientRTPPort.num() != 0 || tcpSocketNum >= 0) { // Normal case: Create destinations
       portNumBits serverPortNum;
+      // If the server has a port pool, then we first try to get our port(s) from it (as a pre-bound pair of groupsocks):
+      ServerPortPool* portPool = ServerPortPool::lookup(envir());
+      Groupsock* unusedGroupsock; // for when we use only one groupsock from the pool's pair
       if (clientRTCPPort.num() == 0) {
 	// We're streaming raw UDP (not RTP). Create a single groupsock:
-	NoReuse dummy(envir()); // ensures that we skip over ports that are already in use
-	for (serverPortNum = fInitialPortNum; ; ++serverPortNum) {
-	  serverRTPPort = serverPortNum;
-	  rtpGroupsock = createGroupsock(nullAddress(destinationAddress.ss_family), serverRTPPort);
-	  if (rtpGroupsock->socketNum() >= 0) break; // success
+	if (portPool != NULL && portPool->allocate(destinationAddress.ss_family, rtpGroupsock, unusedGroupsock)) {
+	  serverRTPPort = rtpGroupsock->port();
+	} else {
+	  NoReuse dummy(envir()); // ensures that we skip over ports that are already in use
+	  for (serverPortNum = fInitialPortNum; ; ++serverPortNum) {
+	    serverRTPPort = serverPortNum;
+	    rtpGroupsock = createGroupsock(nullAddress(destinationAddress.ss_family), serverRTPPort);
+	    if (rtpGroupsock->socketNum() >= 0) break; // success
+	  }
 	}
 
 	udpSink = BasicUDPSink::createNew(envir(), rtpGroupsock);
+      } else if (portPool != NULL && portPool->allocate(destinationAddress.ss_family, rtpGroupsock,
+							  fMultiplexRTCPWithRTP ? unusedGroupsock : rtcpGroupsock)) {
+	// We're streaming RTP, using a pair of groupsocks from the pool.  (If we're multiplexing RTCP and RTP over the
+	// same port number, then we use just the pair's RTP groupsock.)
+	serverRTPPort = rtpGroupsock->port();
+	if (fMultiplexRTCPWithRTP) rtcpGroupsock = rtpGroupsock;
+	serverRTCPPort = rtcpGroupsock->port();
       } else {
 	// Normal case: We're streaming RTP (over UDP or TCP).  Create a pair of
 	// groupsocks (RTP and RTCP), with adjacent port numbers (RTP port number even).
@@ -193,13 +219,19 @@ void OnDemandServerMediaSubsession
 
 	  break; // success
 	}
+      }
 
+      if (rtcpGroupsock != NULL) { // i.e., we're streaming RTP
 	unsigned char rtpPayloadType = 96 + trackNumber()-1; // if dynamic
 	rtpSink = mediaSource == NULL ? NULL
 	  : createNewRTPSink(rtpGroupsock, rtpPayloadType, mediaSource);
 	if (rtpSink != NULL) {
+	  // Label the sink's metrics (if any) with our stream's name - and, unless the sink will be shared, the client's id:
+	  rtpSink->setMetricsStreamName(fParentSession->streamName(), trackId(), fReuseFirstSource ? 0 : clientSessionId);
 	  if (fParentSession->streamingUsesSRTP) {
 	    rtpSink->setupForSRTP(fMIKEYStateMessage, fMIKEYStateMessageSize, fSRTP_ROC);
+	  } else if (tcpSocketNum < 0) { // (there's no packet loss to recover from if we're streaming over TCP)
+	    setUpRetransmission(rtpSink);
 	  }
 	  if (rtpSink->estimatedBitrate() > 0) streamBitrate = rtpSink->estimatedBitrate();
 	}
@@ -391,6 +423,23 @@ void OnDemandServerMediaSubsession::deleteStream(unsigned clientSessionId,
   delete destinations;
 }
 
+FramedSource* OnDemandServerMediaSubsession
+::createNewNonRTPStreamSource(unsigned clientSessionId, Boolean& sourceCanBeShared) {
+  sourceCanBeShared = False;
+  if (fReuseFirstSource) {
+    // Our input (e.g., a 'live' source, or a proxied stream) can't be read more than once, because it's shared by all of
+    // our RTP clients (via a single "StreamState").  So we don't create another source for it:
+    return NULL;
+  }
+
+  unsigned streamBitrate; // not used
+  return createNewStreamSource(clientSessionId, streamBitrate);
+}
+
+void OnDemandServerMediaSubsession::closeNonRTPStreamSource(FramedSource* source) {
+  closeStreamSource(source);
+}
+
 char const* OnDemandServerMediaSubsession
 ::getAuxSDPLine(RTPSink* rtpSink, FramedSource* /*inputSource*/) {
   // Default implementation:
@@ -425,6 +474,20 @@ void OnDemandServerMediaSubsession::closeStreamSource(FramedSource *inputSource)
   Medium::close(inputSource);
 }
 
+Boolean OnDemandServerMediaSubsession::startGettingAuxSDPLine(RTPSink* /*rtpSink*/, FramedSource* /*inputSource*/) {
+  // Default implementation: "getAuxSDPLine()" doesn't block
+  return True;
+}
+
+char const* OnDemandServerMediaSubsession::metadataCacheFileName() const {
+  // Default implementation:
+  return NULL;
+}
+
+void OnDemandServerMediaSubsession::setDurationFromMetadataCache(float /*duration*/) {
+  // Default implementation: do nothing
+}
+
 Groupsock* OnDemandServerMediaSubsession
 ::createGroupsock(struct sockaddr_storage const& addr, Port port) {
   // Default implementation; may be redefined by subclasses:
@@ -453,6 +516,111 @@ void OnDemandServerMediaSubsession
   }
 }
 
+void OnDemandServerMediaSubsession::auxSDPLineIsReady() {
+  if (fPreparingRTPSink == NULL || fSDPLinesPreparedTask != NULL) return; // we're not preparing our SDP lines asynchronously
+
+  // Finish preparing our SDP lines from a separate event loop task, because we're probably being called from
+  // one of the dummy "RTPSink"s callbacks:
+  fSDPLinesPreparedTask = envir().taskScheduler().scheduleDelayedTask(0, finishPreparingSDPLines, this);
+}
+
+void OnDemandServerMediaSubsession::finishPreparingSDPLines(void* clientData) {
+  ((OnDemandServerMediaSubsession*)clientData)->finishPreparingSDPLines1();
+}
+
+void OnDemandServerMediaSubsession::finishPreparingSDPLines1() {
+  fSDPLinesPreparedTask = NULL;
+
+  setSDPLinesFromDummyStream(fPreparingAddressFamily, fPreparingInputSource, fPreparingGroupsock, fPreparingRTPSink,
+			     fPreparingEstBitrate);
+  fPreparingInputSource = NULL; fPreparingGroupsock = NULL; fPreparingRTPSink = NULL;
+
+  sdpLinesPrepared(); // Note: This might (indirectly) delete us
+}
+
+Boolean OnDemandServerMediaSubsession
+::createDummyStream(int addressFamily, FramedSource*& inputSource, Groupsock*& dummyGroupsock,
+		    RTPSink*& dummyRTPSink, unsigned& estBitrate) {
+  inputSource = createNewStreamSource(0, estBitrate);
+  if (inputSource == NULL) return False;
+
+  dummyGroupsock = createGroupsock(nullAddress(addressFamily), 0);
+  unsigned char rtpPayloadType = 96 + trackNumber()-1; // if dynamic
+  dummyRTPSink = createNewRTPSink(dummyGroupsock, rtpPayloadType, inputSource);
+  if (dummyRTPSink != NULL) {
+    if (fParentSession->streamingUsesSRTP) {
+      if (fMIKEYStateMessage != NULL) {
+	// Use the existing stream's MIKEY info to generate the SDP:
+	dummyRTPSink->setupForSRTP(fMIKEYStateMessage, fMIKEYStateMessageSize, fSRTP_ROC);
+      } else {
+	// Create new MIKEY info for this stream:
+	fMIKEYStateMessage
+	  = dummyRTPSink->setupForSRTP(fParentSession->streamingIsEncrypted, fSRTP_ROC,
+				       fMIKEYStateMessageSize, fParentSession->streamingUsesAESGCM);
+      }
+    } else {
+      setUpRetransmission(dummyRTPSink); // so that the "rtx" payload format appears in our SDP lines
+    }
+
+    if (dummyRTPSink->estimatedBitrate() > 0) estBitrate = dummyRTPSink->estimatedBitrate();
+  }
+
+  return True;
+}
+
+void OnDemandServerMediaSubsession
+::setSDPLinesFromDummyStream(int addressFamily, FramedSource* inputSource, Groupsock* dummyGroupsock,
+			     RTPSink* dummyRTPSink, unsigned estBitrate) {
+  if (dummyRTPSink != NULL) {
+    setSDPLinesFromRTPSink(dummyRTPSink, inputSource, estBitrate);
+    Medium::close(dummyRTPSink);
+  }
+  delete dummyGroupsock;
+  closeStreamSource(inputSource);
+
+  char const* cacheFileName;
+  MediaMetadataCache* metadataCache = metadataCacheToUse(cacheFileName);
+  if (metadataCache != NULL) {
+    metadataCache->addSDPLines(cacheFileName, trackNumber(), addressFamily, fMultiplexRTCPWithRTP,
+			       fSDPLines, duration());
+  }
+}
+
+void OnDemandServerMediaSubsession::setUpRetransmission(RTPSink* rtpSink) {
+  if (fRetransmissionHistorySize == 0) return;
+
+  // Use a dynamic payload type that doesn't clash with those that we use for the media itself (96, 97, ...):
+  unsigned char rtxPayloadType = 127 - (trackNumber()-1);
+  rtpSink->enableRetransmission(rtxPayloadType, fRetransmissionHistorySize);
+}
+
+MediaMetadataCache* OnDemandServerMediaSubsession::metadataCacheToUse(char const*& cacheFileName) {
+  // We don't use the cache for SRTP streams, because their SDP lines include a per-stream key, nor if we offer
+  // retransmission, because the cached SDP lines wouldn't describe it:
+  MediaMetadataCache* metadataCache = fParentSession->streamingUsesSRTP || fRetransmissionHistorySize > 0 ? NULL
+    : MediaMetadataCache::lookup(envir());
+  if (metadataCache == NULL) return NULL;
+
+  cacheFileName = metadataCacheFileName();
+  return cacheFileName == NULL ? NULL : metadataCache;
+}
+
+Boolean OnDemandServerMediaSubsession::setSDPLinesFromMetadataCache(int addressFamily) {
+  // If the SDP lines for our file are in the metadata cache, use them, rather than reading the file:
+  char const* cacheFileName;
+  MediaMetadataCache* metadataCache = metadataCacheToUse(cacheFileName);
+  if (metadataCache == NULL) return False;
+
+  float duration;
+  char const* cachedSDPLines
+    = metadataCache->lookupSDPLines(cacheFileName, trackNumber(), addressFamily, fMultiplexRTCPWithRTP, duration);
+  if (cachedSDPLines == NULL) return False;
+
+  delete[] fSDPLines; fSDPLines = strDup(cachedSDPLines);
+  setDurationFromMetadataCache(duration);
+  return True;
+}
+
 void OnDemandServerMediaSubsession
 ::setSDPLinesFromRTPSink(RTPSink* rtpSink, FramedSource* inputSource, unsigned estBitrate) {
   char const* mediaType = rtpSink->sdpMediaType();
@@ -462,6 +630,9 @@ void OnDemandServerMediaSubsession
 
   AddressString ipAddressStr(addressForSDP);
   char* rtpmapLine = rtpSink->rtpmapLine();
+  char* fmtListSuffix = rtpSink->sdpFmtListSuffix();
+  char* rtxSDPLines = rtpSink->rtxSDPLines();
+  char* fecSDPLines = rtpSink->fecSDPLines();
   char* keyMgmtLine = rtpSink->keyMgmtLine();
   char const* rtcpmuxLine = fMultiplexRTCPWithRTP ? "a=rtcp-mux\r\n" : "";
   char const* rangeLine = rangeSDPLine();
@@ -469,7 +640,7 @@ void OnDemandServerMediaSubsession
   if (auxSDPLine == NULL) auxSDPLine = "";
 
   char const* const sdpFmt =
-    "m=%s %u RTP/%sAVP %d\r\n"
+    "m=%s %u RTP/%sAVP %d%s\r\n"
     "c=IN %s %s\r\n"
     "b=AS:%u\r\n"
     "%s"
@@ -477,12 +648,16 @@ void OnDemandServerMediaSubsession
     "%s"
     "%s"
     "%s"
+    "%s"
+    "%s"
     "a=control:%s\r\n";
   unsigned sdpFmtSize = strlen(sdpFmt)
-    + strlen(mediaType) + 5 /* max short len */ + 1 + 3 /* max char len */
+    + strlen(mediaType) + 5 /* max short len */ + 1 + 3 /* max char len */ + strlen(fmtListSuffix)
     + 3/*IP4 or IP6*/ + strlen(ipAddressStr.val())
     + 20 /* max int len */
     + strlen(rtpmapLine)
+    + strlen(rtxSDPLines)
+    + strlen(fecSDPLines)
     + strlen(keyMgmtLine)
     + strlen(rtcpmuxLine)
     + strlen(rangeLine)
@@ -493,16 +668,19 @@ void OnDemandServerMediaSubsession
 	  mediaType, // m= <media>
 	  portNumForSDP, // m= <port>
 	  fParentSession->streamingUsesSRTP ? "S" : "",
-	  rtpPayloadType, // m= <fmt list>
+	  rtpPayloadType, fmtListSuffix, // m= <fmt list>
 	  addressForSDP.ss_family == AF_INET ? "IP4" : "IP6", ipAddressStr.val(), // c= address
 	  estBitrate, // b=AS:<bandwidth>
 	  rtpmapLine, // a=rtpmap:... (if present)
+	  rtxSDPLines, // a=rtpmap:... rtx/..., etc. (if present)
+	  fecSDPLines, // a=rtpmap:... flexfec/..., etc. (if present)
 	  keyMgmtLine, // a=key-mgmt:... (if present)
 	  rtcpmuxLine, // a=rtcp-mux:... (if present)
 	  rangeLine, // a=range:... (if present)
 	  auxSDPLine, // optional extra SDP line
 	  trackId()); // a=control:<track-id>
-  delete[] (char*)rangeLine; delete[] keyMgmtLine; delete[] rtpmapLine;
+  delete[] (char*)rangeLine; delete[] keyMgmtLine; delete[] fecSDPLines; delete[] rtxSDPLines; delete[] rtpmapLine;
+  delete[] fmtListSuffix;
 
   delete[] fSDPLines; fSDPLines = strDup(sdpLines);
   delete[] sdpLines;
@@ -666,7 +844,12 @@ void StreamState::reclaim() {
   fMaster.closeStreamSource(fMediaSource); fMediaSource = NULL;
   if (fMaster.fLastStreamToken == this) fMaster.fLastStreamToken = NULL;
 
-  delete fRTPgs;
-  if (fRTCPgs != fRTPgs) delete fRTCPgs;
+  ServerPortPool* portPool = ServerPortPool::lookup(fMaster.envir());
+  if (fRTPgs != NULL && portPool != NULL && portPool->release(fRTPgs)) {
+    // Our groupsock(s) came from the server's port pool, and have now been returned to it.
+  } else {
+    delete fRTPgs;
+    if (fRTCPgs != fRTPgs) delete fRTCPgs;
+  }
   fRTPgs = NULL; fRTCPgs = NULL;
 }
@@ -79,7 +79,7 @@ PassiveServerMediaSubsession::sdpLines(int /*addressFamily*/) {
     // Construct a set of SDP lines that describe this subsession:
     // Use the components from "rtpSink".
     if (fParentSession->streamingUsesSRTP) { // Hack to set up for SRTP/SRTCP
-      fRTPSink.setupForSRTP(fParentSession->streamingIsEncrypted, fSRTP_ROC);
+      fRTPSink.setupForSRTP(fParentSession->streamingIsEncrypted, fSRTP_ROC, fParentSession->streamingUsesAESGCM);
 
       if (fRTCPInstance != NULL) fRTCPInstance->setupForSRTCP();
     }
@@ -92,7 +92,10 @@ PassiveServerMediaSubsession::sdpLines(int /*addressFamily*/) {
     char const* mediaType = fRTPSink.sdpMediaType();
     unsigned estBitrate
       = fRTCPInstance == NULL ? 50 : fRTCPInstance->totSessionBW();
+    char* fmtListSuffix = fRTPSink.sdpFmtListSuffix();
     char* rtpmapLine = fRTPSink.rtpmapLine();
+    char* rtxSDPLines = fRTPSink.rtxSDPLines();
+    char* fecSDPLines = fRTPSink.fecSDPLines();
     char* keyMgmtLine = fRTPSink.keyMgmtLine();
     char const* rtcpmuxLine = rtcpIsMuxed() ? "a=rtcp-mux\r\n" : "";
     char const* rangeLine = rangeSDPLine();
@@ -100,7 +103,7 @@ PassiveServerMediaSubsession::sdpLines(int /*addressFamily*/) {
     if (auxSDPLine == NULL) auxSDPLine = "";
 
     char const* const sdpFmt =
-      "m=%s %d RTP/%sAVP %d\r\n"
+      "m=%s %d RTP/%sAVP %d%s\r\n"
       "c=IN %s %s/%d\r\n"
       "b=AS:%u\r\n"
       "%s"
@@ -108,12 +111,16 @@ PassiveServerMediaSubsession::sdpLines(int /*addressFamily*/) {
       "%s"
       "%s"
       "%s"
+      "%s"
+      "%s"
       "a=control:%s\r\n";
     unsigned sdpFmtSize = strlen(sdpFmt)
-      + strlen(mediaType) + 5 /* max short len */ + 1 + 3 /* max char len */
+      + strlen(mediaType) + 5 /* max short len */ + 1 + 3 /* max char len */ + strlen(fmtListSuffix)
       + 3/*IP4 or IP6*/ + strlen(groupAddressStr.val()) + 3 /* max char len */
       + 20 /* max int len */
       + strlen(rtpmapLine)
+      + strlen(rtxSDPLines)
+      + strlen(fecSDPLines)
       + strlen(keyMgmtLine)
       + strlen(rtcpmuxLine)
       + strlen(rangeLine)
@@ -124,18 +131,21 @@ PassiveServerMediaSubsession::sdpLines(int /*addressFamily*/) {
 	    mediaType, // m= <media>
 	    portNum, // m= <port>
 	    fParentSession->streamingUsesSRTP ? "S" : "",
-	    rtpPayloadType, // m= <fmt list>
+	    rtpPayloadType, fmtListSuffix, // m= <fmt list>
 	    gs.groupAddress().ss_family == AF_INET ? "IP4" : "IP6", // c= address type
 	    groupAddressStr.val(), // c= <connection address>
 	    ttl, // c= TTL
 	    estBitrate, // b=AS:<bandwidth>
 	    rtpmapLine, // a=rtpmap:... (if present)
+	    rtxSDPLines, // a=rtpmap:... rtx/..., etc. (if present)
+	    fecSDPLines, // a=rtpmap:... flexfec/..., etc. (if present)
 	    keyMgmtLine, // a=key-mgmt:... (if present)
 	    rtcpmuxLine, // a=rtcp-mux:... (if present)
 	    rangeLine, // a=range:... (if present)
 	    auxSDPLine, // optional extra SDP line
 	    trackId()); // a=control:<track-id>
-    delete[] (char*)rangeLine; delete[] keyMgmtLine; delete[] rtpmapLine;
+    delete[] (char*)rangeLine; delete[] keyMgmtLine;
+    delete[] fecSDPLines; delete[] rtxSDPLines; delete[] rtpmapLine; delete[] fmtListSuffix;
 
     fSDPLines = strDup(sdpLines);
     delete[] sdpLines;
@@ -0,0 +1,459 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// A RTSP server that proxies a (potentially large) registry of back-end RTSP streams, connecting to each back-end
+// stream either at startup (at a limited rate), or only on demand (disconnecting again once the stream becomes idle).
+// Implementation
+
+#include "ProxyRTSPServer.hh"
+#include "GroupsockHelper.hh" // for "our_random()" and "gettimeofday()"
+
+#ifndef MILLION
+#define MILLION 1000000
+#endif
+
+#define BACK_END_DESCRIBE_TIMEOUT_SECONDS 10 // how long a front-end lookup waits for a back-end "DESCRIBE" to complete
+
+////////// ProxyRegistryEntry definition //////////
+
+// The (small) state that we keep for each registered back-end stream.  The (much larger) "ProxyServerMediaSession" -
+// and its "ProxyRTSPClient", sockets and timers - exists only while we're connected to the back-end stream:
+
+class ProxyRegistryEntry {
+public:
+  ProxyRegistryEntry(ProxyRTSPServer* server, char const* streamName, char const* backEndURL);
+  ~ProxyRegistryEntry();
+
+  void addWaiter(lookupServerMediaSessionCompletionFunc* completionFunc, void* completionClientData);
+
+  // A front-end lookup that is waiting for the back-end "DESCRIBE" to complete:
+  class Waiter {
+  public:
+    Waiter(lookupServerMediaSessionCompletionFunc* completionFunc, void* completionClientData)
+      : fNext(NULL), fCompletionFunc(completionFunc), fCompletionClientData(completionClientData) {
+    }
+
+    Waiter* fNext;
+    lookupServerMediaSessionCompletionFunc* fCompletionFunc;
+    void* fCompletionClientData;
+  };
+
+public:
+  ProxyRTSPServer* fServer;
+  char* fStreamName;
+  char* fBackEndURL;
+  ProxyServerMediaSession* fSMS; // non-NULL iff we're currently connected to the back-end stream
+  Boolean fDESCRIBEDone;
+  Waiter* fWaiters; // the front-end lookups that are currently waiting for the back-end "DESCRIBE" of "fWaitedForSMS"
+  unsigned fNumWaiters;
+  ProxyServerMediaSession* fWaitedForSMS; // we hold a reference to this while "fWaiters" is non-empty
+  TaskToken fDESCRIBETimeoutTask;
+  struct timeval fLastActiveTime;
+  ProxyRegistryEntry* fNextPending; // used when we're part of the server's 'pending connection' queue
+  Boolean fIsPending;
+};
+
+ProxyRegistryEntry::ProxyRegistryEntry(ProxyRTSPServer* server, char const* streamName, char const* backEndURL)
+  : fServer(server), fStreamName(strDup(streamName)), fBackEndURL(strDup(backEndURL)), fSMS(NULL),
+    fDESCRIBEDone(False), fWaiters(NULL), fNumWaiters(0), fWaitedForSMS(NULL), fDESCRIBETimeoutTask(NULL),
+    fNextPending(NULL), fIsPending(False) {
+  fLastActiveTime.tv_sec = fLastActiveTime.tv_usec = 0;
+}
+
+ProxyRegistryEntry::~ProxyRegistryEntry() {
+  delete[] fStreamName; delete[] fBackEndURL;
+  while (fWaiters != NULL) {
+    Waiter* next = fWaiters->fNext;
+    delete fWaiters;
+    fWaiters = next;
+  }
+}
+
+void ProxyRegistryEntry
+::addWaiter(lookupServerMediaSessionCompletionFunc* completionFunc, void* completionClientData) {
+  // Add the new waiter to the end of the list, so that waiters get their result in order:
+  Waiter** ptr = &fWaiters;
+  while (*ptr != NULL) ptr = &((*ptr)->fNext);
+  *ptr = new Waiter(completionFunc, completionClientData);
+  ++fNumWaiters;
+}
+
+
+////////// ProxyRTSPServer implementation //////////
+
+ProxyRTSPServer* ProxyRTSPServer
+::createNew(UsageEnvironment& env, Port ourPort,
+	    UserAuthenticationDatabase* authDatabase, unsigned reclamationSeconds,
+	    char const* backEndUsername, char const* backEndPassword,
+	    portNumBits tunnelOverHTTPPortNum, int verbosityLevelForProxying,
+	    unsigned idleTimeoutSeconds, unsigned maxDESCRIBEsPerSecond,
+	    Boolean proxyREGISTERRequests, UserAuthenticationDatabase* authDatabaseForREGISTER) {
+  int ourSocketIPv4 = setUpOurSocket(env, ourPort, AF_INET);
+  int ourSocketIPv6 = setUpOurSocket(env, ourPort, AF_INET6);
+  if (ourSocketIPv4 < 0 && ourSocketIPv6 < 0) return NULL;
+
+  return new ProxyRTSPServer(env, ourSocketIPv4, ourSocketIPv6, ourPort,
+			     authDatabase, authDatabaseForREGISTER, reclamationSeconds,
+			     backEndUsername, backEndPassword,
+			     tunnelOverHTTPPortNum, verbosityLevelForProxying,
+			     idleTimeoutSeconds, maxDESCRIBEsPerSecond, proxyREGISTERRequests);
+}
+
+ProxyRTSPServer
+::ProxyRTSPServer(UsageEnvironment& env, int ourSocketIPv4, int ourSocketIPv6, Port ourPort,
+		  UserAuthenticationDatabase* authDatabase, UserAuthenticationDatabase* authDatabaseForREGISTER,
+		  unsigned reclamationSeconds,
+		  char const* backEndUsername, char const* backEndPassword,
+		  portNumBits tunnelOverHTTPPortNum, int verbosityLevelForProxying,
+		  unsigned idleTimeoutSeconds, unsigned maxDESCRIBEsPerSecond,
+		  Boolean proxyREGISTERRequests)
+  : RTSPServerWithREGISTERProxying(env, ourSocketIPv4, ourSocketIPv6, ourPort,
+				   authDatabase, authDatabaseForREGISTER, reclamationSeconds,
+				   tunnelOverHTTPPortNum == (portNumBits)(~0), verbosityLevelForProxying,
+				   backEndUsername, backEndPassword),
+    fBackEndUsername(strDup(backEndUsername)), fBackEndPassword(strDup(backEndPassword)),
+    fTunnelOverHTTPPortNum(tunnelOverHTTPPortNum), fVerbosityLevelForProxying(verbosityLevelForProxying),
+    fIdleTimeoutSeconds(idleTimeoutSeconds), fMaxDESCRIBEsPerSecond(maxDESCRIBEsPerSecond),
+    fProxyREGISTERRequests(proxyREGISTERRequests),
+    fRegistry(HashTable::create(STRING_HASH_KEYS)), fConnectedEntries(HashTable::create(ONE_WORD_HASH_KEYS)),
+    fPendingHead(NULL), fPendingTail(NULL), fPacingTask(NULL), fIdleCheckTask(NULL) {
+}
+
+ProxyRTSPServer::~ProxyRTSPServer() {
+  envir().taskScheduler().unscheduleDelayedTask(fPacingTask);
+  envir().taskScheduler().unscheduleDelayedTask(fIdleCheckTask);
+
+  // Delete our registry entries.  (The "ProxyServerMediaSession"s that we created will get deleted along with
+  // the rest of our "ServerMediaSession"s.)
+  // (Any front-end lookups that are still waiting for a back-end "DESCRIBE" are dropped; their client connections are
+  // about to be deleted as well.)
+  ProxyRegistryEntry* entry;
+  while ((entry = (ProxyRegistryEntry*)fRegistry->RemoveNext()) != NULL) {
+    if (entry->fSMS != NULL && getServerMediaSession(entry->fStreamName) == entry->fSMS) {
+      entry->fSMS->setOnDESCRIBECompletion(NULL, NULL);
+    }
+    envir().taskScheduler().unscheduleDelayedTask(entry->fDESCRIBETimeoutTask);
+    if (entry->fWaitedForSMS != NULL) entry->fWaitedForSMS->decrementReferenceCount();
+    delete entry;
+  }
+  delete fRegistry;
+  delete fConnectedEntries;
+
+  delete[] fBackEndUsername; delete[] fBackEndPassword;
+}
+
+Boolean ProxyRTSPServer::addProxiedStream(char const* streamName, char const* backEndURL) {
+  if (streamName == NULL || backEndURL == NULL || fRegistry->Lookup(streamName) != NULL) return False;
+
+  ProxyRegistryEntry* entry = new ProxyRegistryEntry(this, streamName, backEndURL);
+  fRegistry->Add(entry->fStreamName, entry);
+
+  if (fIdleTimeoutSeconds == 0) {
+    // We connect to each back-end stream now (or soon), rather than waiting for a front-end client to request it:
+    if (fMaxDESCRIBEsPerSecond == 0) {
+      connectToBackEnd(entry);
+    } else {
+      // Add this entry to our 'pending connection' queue:
+      entry->fIsPending = True;
+      if (fPendingTail == NULL) {
+	fPendingHead = fPendingTail = entry;
+      } else {
+	fPendingTail->fNextPending = entry;
+	fPendingTail = entry;
+      }
+      if (fPacingTask == NULL) scheduleNextPacedConnection();
+    }
+  }
+
+  return True;
+}
+
+static void removeFromPendingQueue(ProxyRegistryEntry* entry, ProxyRegistryEntry*& head, ProxyRegistryEntry*& tail) {
+  if (!entry->fIsPending) return;
+
+  ProxyRegistryEntry* prev = NULL;
+  for (ProxyRegistryEntry* e = head; e != NULL; prev = e, e = e->fNextPending) {
+    if (e == entry) {
+      if (prev == NULL) head = e->fNextPending; else prev->fNextPending = e->fNextPending;
+      if (tail == e) tail = prev;
+      break;
+    }
+  }
+  entry->fNextPending = NULL;
+  entry->fIsPending = False;
+}
+
+Boolean ProxyRTSPServer::removeProxiedStream(char const* streamName) {
+  ProxyRegistryEntry* entry = checkConnection(streamName);
+  if (entry == NULL) return False;
+  if (entry->fNumWaiters > 0) return False; // a front-end lookup is still waiting for this stream's back-end "DESCRIBE"
+
+  removeFromPendingQueue(entry, fPendingHead, fPendingTail);
+  disconnectFromBackEnd(entry);
+
+  fRegistry->Remove(entry->fStreamName);
+  delete entry;
+  return True;
+}
+
+ProxyServerMediaSession* ProxyRTSPServer
+::createNewProxyServerMediaSession(char const* streamName, char const* backEndURL) {
+  // Default implementation; may be redefined by subclasses:
+  return ProxyServerMediaSession::createNew(envir(), this, backEndURL, streamName,
+					    fBackEndUsername, fBackEndPassword,
+					    fTunnelOverHTTPPortNum, fVerbosityLevelForProxying);
+}
+
+void ProxyRTSPServer
+::lookupServerMediaSession(char const* streamName,
+			   lookupServerMediaSessionCompletionFunc* completionFunc,
+			   void* completionClientData,
+			   Boolean isFirstLookupInSession) {
+  ProxyRegistryEntry* entry = checkConnection(streamName);
+  if (entry == NULL) {
+    // This is not one of our registered streams (although it might be a stream that was proxied via "REGISTER"):
+    RTSPServerWithREGISTERProxying::lookupServerMediaSession(streamName, completionFunc, completionClientData,
+							     isFirstLookupInSession);
+    return;
+  }
+
+  if (entry->fSMS == NULL) {
+    // We're not (yet) connected to this back-end stream - either because we're connecting only on demand, or because
+    // its (paced) initial connection has not yet been made.  Connect now:
+    removeFromPendingQueue(entry, fPendingHead, fPendingTail);
+    connectToBackEnd(entry);
+  }
+  gettimeofday(&entry->fLastActiveTime, NULL);
+
+  if (!entry->fDESCRIBEDone) {
+    // The back-end "DESCRIBE" has not yet completed.  Rather than waiting for it here, we remember the completion function,
+    // and call it - from "onDESCRIBECompletion()" or "describeTimeout()" - once the "DESCRIBE" completes, or times out:
+    if (entry->fWaiters != NULL && entry->fWaitedForSMS != entry->fSMS) {
+      // The earlier waiters were waiting for a session that has since been removed from the server.  Let them go first:
+      completeWaitingLookups(entry);
+    }
+    if (entry->fWaiters == NULL) {
+      entry->fWaitedForSMS = entry->fSMS;
+      entry->fWaitedForSMS->incrementReferenceCount(); // so that it doesn't get deleted while lookups are waiting for it
+      entry->fDESCRIBETimeoutTask
+	= envir().taskScheduler().scheduleDelayedTask(BACK_END_DESCRIBE_TIMEOUT_SECONDS*MILLION, describeTimeout, entry);
+    }
+    entry->addWaiter(completionFunc, completionClientData);
+    return;
+  }
+
+  ServerMediaSession* result = lookupResult(entry, entry->fSMS);
+  if (completionFunc != NULL) {
+    (*completionFunc)(completionClientData, result);
+  }
+}
+
+ServerMediaSession* ProxyRTSPServer::lookupResult(ProxyRegistryEntry* entry, ProxyServerMediaSession* sms) {
+  if (sms != NULL && !sms->describeCompletedSuccessfully()) {
+    // We couldn't get a SDP description from the back-end server.
+    if (fIdleTimeoutSeconds > 0 && entry->fSMS == sms && entry->fNumWaiters == 0 && sms->referenceCount() == 0) {
+      // Because we connect only on demand, don't keep retrying the back-end server in the background.
+      // Instead, we'll try again when the next front-end client requests this stream:
+      disconnectFromBackEnd(entry);
+    }
+    return NULL;
+  }
+
+  return sms;
+}
+
+void ProxyRTSPServer::completeWaitingLookups(ProxyRegistryEntry* entry) {
+  envir().taskScheduler().unscheduleDelayedTask(entry->fDESCRIBETimeoutTask);
+  ProxyRegistryEntry::Waiter* waiters = entry->fWaiters;
+  ProxyServerMediaSession* sms = entry->fWaitedForSMS;
+  entry->fWaiters = NULL; entry->fNumWaiters = 0; entry->fWaitedForSMS = NULL;
+  if (waiters == NULL) return;
+
+  sms->decrementReferenceCount();
+  if (sms->referenceCount() == 0 && sms->deleteWhenUnreferenced()) {
+    // The session was removed (e.g., by a "DEREGISTER") while the lookups were waiting:
+    if (entry->fSMS == sms) {
+      entry->fSMS = NULL;
+      fConnectedEntries->Remove((char const*)entry);
+    }
+    Medium::close(sms);
+    sms = NULL;
+  }
+  ServerMediaSession* result = lookupResult(entry, sms);
+
+  // Tell each waiting lookup about the result.  (We detached the waiters from "entry" first, because a completion
+  // function might make a new lookup - which would then get a new list of waiters - on the same stream.)
+  while (waiters != NULL) {
+    ProxyRegistryEntry::Waiter* next = waiters->fNext;
+    if (waiters->fCompletionFunc != NULL) (*waiters->fCompletionFunc)(waiters->fCompletionClientData, result);
+    delete waiters;
+    waiters = next;
+  }
+}
+
+char const* ProxyRTSPServer::allowedCommandNames() {
+  return fProxyREGISTERRequests
+    ? RTSPServerWithREGISTERProxying::allowedCommandNames() : RTSPServer::allowedCommandNames();
+}
+
+Boolean ProxyRTSPServer
+::weImplementREGISTER(char const* cmd/*"REGISTER" or "DEREGISTER"*/,
+		      char const* proxyURLSuffix, char*& responseStr) {
+  if (!fProxyREGISTERRequests) return RTSPServer::weImplementREGISTER(cmd, proxyURLSuffix, responseStr);
+
+  // Don't allow a "REGISTER" to take over the name of one of our registered streams:
+  if (proxyURLSuffix != NULL && strcmp(cmd, "REGISTER") == 0 && fRegistry->Lookup(proxyURLSuffix) != NULL) {
+    responseStr = strDup("451 Invalid parameter");
+    return False;
+  }
+
+  return RTSPServerWithREGISTERProxying::weImplementREGISTER(cmd, proxyURLSuffix, responseStr);
+}
+
+UserAuthenticationDatabase* ProxyRTSPServer::getAuthenticationDatabaseForCommand(char const* cmdName) {
+  return fProxyREGISTERRequests
+    ? RTSPServerWithREGISTERProxying::getAuthenticationDatabaseForCommand(cmdName)
+    : RTSPServer::getAuthenticationDatabaseForCommand(cmdName);
+}
+
+ProxyRegistryEntry* ProxyRTSPServer::checkConnection(char const* streamName) {
+  ProxyRegistryEntry* entry = (ProxyRegistryEntry*)fRegistry->Lookup(streamName);
+  if (entry != NULL && entry->fSMS != NULL && getServerMediaSession(entry->fStreamName) != entry->fSMS) {
+    // Our "ProxyServerMediaSession" was removed from the server (or replaced) behind our back.  Forget about it:
+    entry->fSMS = NULL;
+    fConnectedEntries->Remove((char const*)entry);
+  }
+
+  return entry;
+}
+
+void ProxyRTSPServer::connectToBackEnd(ProxyRegistryEntry* entry) {
+  if (fVerbosityLevelForProxying > 0) {
+    envir() << "ProxyRTSPServer: connecting to back-end stream \"" << entry->fBackEndURL << "\"\n";
+  }
+
+  entry->fSMS = createNewProxyServerMediaSession(entry->fStreamName, entry->fBackEndURL);
+  entry->fDESCRIBEDone = entry->fSMS->describeCompletedFlag != 0; // True iff the initial "DESCRIBE" has already failed
+  entry->fSMS->setOnDESCRIBECompletion(onDESCRIBECompletion, this);
+  addServerMediaSession(entry->fSMS);
+
+  fConnectedEntries->Add((char const*)entry, entry);
+  gettimeofday(&entry->fLastActiveTime, NULL);
+  if (fIdleTimeoutSeconds > 0) scheduleIdleCheck();
+}
+
+void ProxyRTSPServer::disconnectFromBackEnd(ProxyRegistryEntry* entry) {
+  ProxyServerMediaSession* sms = entry->fSMS;
+  if (sms == NULL) return;
+
+  if (fVerbosityLevelForProxying > 0) {
+    envir() << "ProxyRTSPServer: disconnecting from back-end stream \"" << entry->fBackEndURL << "\"\n";
+  }
+
+  entry->fSMS = NULL;
+  fConnectedEntries->Remove((char const*)entry);
+  sms->setOnDESCRIBECompletion(NULL, NULL);
+  deleteServerMediaSession(sms);
+}
+
+void ProxyRTSPServer::onDESCRIBECompletion(void* clientData, ProxyServerMediaSession* sms) {
+  ProxyRTSPServer* server = (ProxyRTSPServer*)clientData;
+
+  ProxyRegistryEntry* entry = (ProxyRegistryEntry*)server->fRegistry->Lookup(sms->streamName());
+  if (entry == NULL) return;
+
+  if (entry->fSMS == sms) entry->fDESCRIBEDone = True;
+  if (entry->fWaitedForSMS == sms) server->completeWaitingLookups(entry);
+}
+
+void ProxyRTSPServer::describeTimeout(void* clientData) {
+  ProxyRegistryEntry* entry = (ProxyRegistryEntry*)clientData;
+  entry->fDESCRIBETimeoutTask = NULL;
+
+  // The waiting lookups will see that the "DESCRIBE" has not (yet) succeeded.  (Later lookups won't wait for it.)
+  if (entry->fSMS == entry->fWaitedForSMS) entry->fDESCRIBEDone = True;
+  entry->fServer->completeWaitingLookups(entry);
+}
+
+void ProxyRTSPServer::scheduleNextPacedConnection() {
+  // Choose a random delay from [d/2..3d/2), where 'd' is the average interval between back-end "DESCRIBE"s:
+  unsigned const uSecondsBetweenDESCRIBEs = MILLION/fMaxDESCRIBEsPerSecond;
+  unsigned const uSecondsToDelay = uSecondsBetweenDESCRIBEs/2 + our_random()%(uSecondsBetweenDESCRIBEs+1);
+  fPacingTask = envir().taskScheduler().scheduleDelayedTask(uSecondsToDelay, connectNextPendingEntry, this);
+}
+
+void ProxyRTSPServer::connectNextPendingEntry(void* clientData) {
+  ((ProxyRTSPServer*)clientData)->connectNextPendingEntry();
+}
+
+void ProxyRTSPServer::connectNextPendingEntry() {
+  fPacingTask = NULL;
+
+  ProxyRegistryEntry* entry = fPendingHead;
+  if (entry == NULL) return;
+  removeFromPendingQueue(entry, fPendingHead, fPendingTail);
+  if (entry->fSMS == NULL) connectToBackEnd(entry);
+
+  if (fPendingHead != NULL) scheduleNextPacedConnection();
+}
+
+void ProxyRTSPServer::scheduleIdleCheck() {
+  if (fIdleCheckTask != NULL || fConnectedEntries->numEntries() == 0) return;
+
+  // We check for idle streams using a single timer for the whole server, about twice per idle timeout period:
+  unsigned secondsToDelay = fIdleTimeoutSeconds/2;
+  if (secondsToDelay == 0) secondsToDelay = 1;
+  fIdleCheckTask = envir().taskScheduler().scheduleDelayedTask(secondsToDelay*MILLION, checkForIdleStreams, this);
+}
+
+void ProxyRTSPServer::checkForIdleStreams(void* clientData) {
+  ((ProxyRTSPServer*)clientData)->checkForIdleStreams();
+}
+
+void ProxyRTSPServer::checkForIdleStreams() {
+  fIdleCheckTask = NULL;
+
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+
+  // First, find the connected entries that have become idle.  (We don't disconnect them while iterating,
+  // because that modifies "fConnectedEntries".)
+  unsigned const numConnected = fConnectedEntries->numEntries();
+  ProxyRegistryEntry** idleEntries = new ProxyRegistryEntry*[numConnected+1];
+  unsigned numIdle = 0;
+
+  HashTable::Iterator* iter = HashTable::Iterator::create(*fConnectedEntries);
+  ProxyRegistryEntry* entry;
+  char const* key; // dummy
+  while ((entry = (ProxyRegistryEntry*)iter->next(key)) != NULL && numIdle < numConnected) {
+    if (getServerMediaSession(entry->fStreamName) != entry->fSMS) {
+      idleEntries[numIdle++] = entry; // it was removed behind our back; "checkConnection()" (below) will clean up
+    } else if (entry->fSMS->referenceCount() > 0 || entry->fNumWaiters > 0) {
+      entry->fLastActiveTime = timeNow; // the stream is currently being used
+    } else if ((unsigned)(timeNow.tv_sec - entry->fLastActiveTime.tv_sec) >= fIdleTimeoutSeconds) {
+      idleEntries[numIdle++] = entry;
+    }
+  }
+  delete iter;
+
+  for (unsigned i = 0; i < numIdle; ++i) {
+    if (checkConnection(idleEntries[i]->fStreamName) != NULL) disconnectFromBackEnd(idleEntries[i]);
+  }
+  delete[] idleEntries;
+
+  scheduleIdleCheck();
+}
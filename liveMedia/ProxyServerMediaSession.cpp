@@ -107,7 +107,8 @@ ProxyServerMediaSession
     fPresentationTimeSessionNormalizer(new PresentationTimeSessionNormalizer(envir())),
     fCreateNewProxyRTSPClientFunc(ourCreateNewProxyRTSPClientFunc),
     fTranscodingTable(transcodingTable),
-    fInitialPortNum(initialPortNum), fMultiplexRTCPWithRTP(multiplexRTCPWithRTP) {
+    fInitialPortNum(initialPortNum), fMultiplexRTCPWithRTP(multiplexRTCPWithRTP),
+    fOnDESCRIBECompletionFunc(NULL), fOnDESCRIBECompletionClientData(NULL) {
   // Open a RTSP connection to the input stream, and send a "DESCRIBE" command.
   // We'll use the SDP description in the response to set ourselves up.
   fProxyRTSPClient
@@ -192,6 +193,11 @@ void ProxyServerMediaSession::resetDESCRIBEState() {
   Medium::close(fClientMediaSession); fClientMediaSession = NULL;
 }
 
+void ProxyServerMediaSession::noteDESCRIBECompletion() {
+  describeCompletedFlag = 1;
+  if (fOnDESCRIBECompletionFunc != NULL) (*fOnDESCRIBECompletionFunc)(fOnDESCRIBECompletionClientData, this);
+}
+
 ///////// RTSP 'response handlers' //////////
 
 static void continueAfterDESCRIBE(RTSPClient* rtspClient, int resultCode, char* resultString) {
@@ -310,6 +316,8 @@ void ProxyRTSPClient::continueAfterDESCRIBE(char const* sdpDescription) {
     scheduleDESCRIBECommand();
   }
   fDoneDESCRIBE = True;
+
+  fOurServerMediaSession.noteDESCRIBECompletion();
 }
 
 void ProxyRTSPClient::continueAfterLivenessCommand(int resultCode, Boolean serverSupportsGetParameter) {
@@ -464,19 +472,22 @@ void ProxyRTSPClient::doReset(void* clientData) {
 }
 
 void ProxyRTSPClient::scheduleDESCRIBECommand() {
-  // Delay 1s, 2s, 4s, 8s ... 256s until sending the next "DESCRIBE".  Then, keep delaying a random time from [256..511] seconds:
-  unsigned secondsToDelay;
+  // Delay 1s, 2s, 4s, 8s ... 256s until sending the next "DESCRIBE".  Then, keep delaying a random time from [256..511] seconds.
+  // Each of the initial delays is also 'jittered' - i.e., chosen randomly from [d/2..d] seconds - so that proxied streams
+  // that fail at the same time (e.g., because of a network outage) don't all retry their "DESCRIBE"s at the same time:
+  unsigned uSecondsToDelay;
   if (fNextDESCRIBEDelay <= 256) {
-    secondsToDelay = fNextDESCRIBEDelay;
+    unsigned const us_half = fNextDESCRIBEDelay*(MILLION/2);
+    uSecondsToDelay = us_half + our_random()%(us_half+1);
     fNextDESCRIBEDelay *= 2;
   } else {
-    secondsToDelay = 256 + (our_random()&0xFF); // [256..511] seconds
+    uSecondsToDelay = (256 + (our_random()&0xFF))*MILLION; // [256..511] seconds
   }
 
   if (fVerbosityLevel > 0) {
-    envir() << *this << ": RTSP \"DESCRIBE\" command failed; trying again in " << secondsToDelay << " seconds\n";
+    envir() << *this << ": RTSP \"DESCRIBE\" command failed; trying again in " << uSecondsToDelay/1000 << " ms\n";
   }
-  fDESCRIBECommandTask = envir().taskScheduler().scheduleDelayedTask(secondsToDelay*MILLION, sendDESCRIBE, this);
+  fDESCRIBECommandTask = envir().taskScheduler().scheduleDelayedTask(uSecondsToDelay, sendDESCRIBE, this);
 }
 
 void ProxyRTSPClient::sendDESCRIBE(void* clientData) {
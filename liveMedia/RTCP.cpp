@@ -128,7 +128,7 @@ RTCPInstance::RTCPInstance(UsageEnvironment& env, Groupsock* RTCPgs,
 			   SRTPCryptographicContext* crypto)
   : Medium(env), fRTCPInterface(this, RTCPgs), fTotSessionBW(totSessionBW),
     fSink(sink), fSource(source), fIsSSMTransmitter(isSSMTransmitter), fCrypto(crypto),
-    fCNAME(RTCP_SDES_CNAME, cname), fOutgoingReportCount(1),
+    fCNAME(RTCP_SDES_CNAME, cname), fSDESPacketSize(0), fSDESPacketSSRC(0), fOutgoingReportCount(1),
     fAveRTCPSize(0), fIsInitial(1), fPrevNumMembers(0),
     fLastSentSize(0), fLastReceivedSize(0), fLastReceivedSSRC(0),
     fTypeOfEvent(EVENT_UNKNOWN), fTypeOfPacket(PACKET_UNKNOWN_TYPE),
@@ -387,6 +387,39 @@ void RTCPInstance::sendAppPacket(u_int8_t subtype, char const* name,
   sendBuiltPacket();
 }
 
+void RTCPInstance::sendNACK(u_int32_t mediaSSRC, u_int16_t firstMissingSeqNum, unsigned numMissingPackets) {
+  if (numMissingPackets == 0) return;
+
+  // A compound RTCP packet must begin with a SR or RR, so begin with an empty RR (one with no report blocks, so that
+  // our regular reports are unaffected):
+  u_int32_t ourSSRC = fSource != NULL ? fSource->SSRC() : fSink != NULL ? fSink->SSRC() : 0;
+  fOutBuf->enqueueWord(0x80000000 | (RTCP_PT_RR<<16) | 1);
+  fOutBuf->enqueueWord(ourSSRC);
+
+  // Then add the Generic NACK (a "RTPFB" packet with FMT 1).  Each of its 'FCI' words identifies one missing packet
+  // (the 'PID'), plus a bitmask of which of the following 16 packets (the 'BLP') are also missing:
+  unsigned numFCIs = (numMissingPackets+16)/17;
+  u_int32_t rtcpHdr = 0x80000000; // version 2, no padding
+  rtcpHdr |= (1<<24); // FMT: Generic NACK
+  rtcpHdr |= (RTCP_PT_RTPFB<<16);
+  rtcpHdr |= (2 + numFCIs);
+  fOutBuf->enqueueWord(rtcpHdr);
+  fOutBuf->enqueueWord(ourSSRC); // SSRC of packet sender
+  fOutBuf->enqueueWord(mediaSSRC); // SSRC of media source
+
+  u_int16_t pid = firstMissingSeqNum;
+  while (numMissingPackets > 0) {
+    unsigned numFollowing = numMissingPackets > 17 ? 16 : numMissingPackets-1;
+    u_int16_t blp = (u_int16_t)((1<<numFollowing) - 1);
+    fOutBuf->enqueueWord(((u_int32_t)pid<<16)|blp);
+
+    pid += numFollowing+1;
+    numMissingPackets -= numFollowing+1;
+  }
+
+  sendBuiltPacket();
+}
+
 void RTCPInstance::setStreamSocket(int sockNum, unsigned char streamChannelId,
 				   TLSState* tlsState) {
   // Turn off background read handling:
@@ -541,11 +574,13 @@ void RTCPInstance
     // Check the RTCP packet for validity:
     // It must at least contain a header (4 bytes), and this header
     // must be version=2, with no padding bit, and a payload type of
-    // SR (200), RR (201), or APP (204):
+    // SR (200), RR (201), APP (204), or RTPFB (205) (because some receivers send feedback
+    // - e.g., NACKs - in 'reduced-size' RTCP packets (RFC 5506)):
     if (packetSize < 4) break;
     unsigned rtcpHdr = ntohl(*(u_int32_t*)pkt);
     if ((rtcpHdr & 0xE0FE0000) != (0x80000000 | (RTCP_PT_SR<<16)) &&
-	(rtcpHdr & 0xE0FF0000) != (0x80000000 | (RTCP_PT_APP<<16))) {
+	(rtcpHdr & 0xE0FF0000) != (0x80000000 | (RTCP_PT_APP<<16)) &&
+	(rtcpHdr & 0xE0FF0000) != (0x80000000 | (RTCP_PT_RTPFB<<16))) {
 #ifdef DEBUG
       fprintf(stderr, "rejected bad RTCP packet: header 0x%08x\n", rtcpHdr);
 #endif
@@ -768,9 +803,29 @@ void RTCPInstance
 	  break;
 	}
         case RTCP_PT_RTPFB: {
+	  u_int8_t& fmt = rc; // In feedback packets, the "rc" field gets used as "FMT"
+#ifdef DEBUG
+	  fprintf(stderr, "RTPFB (FMT %d)\n", fmt);
+#endif
+	  if (length < 4) break;
+	  u_int32_t mediaSSRC = ntohl(*(u_int32_t*)pkt); ADVANCE(4); length -= 4;
+
+	  if (fmt == 1 && fSink != NULL && mediaSSRC == fSink->SSRC()) {
+	    // This is a Generic NACK (RFC 4585, section 6.2.1) for our stream.  Ask our sink to retransmit
+	    // each of the missing packets (if it can):
+	    while (length >= 4) {
+	      u_int16_t pid = (pkt[0]<<8)|pkt[1];
+	      u_int16_t blp = (pkt[2]<<8)|pkt[3];
+	      ADVANCE(4); length -= 4;
 #ifdef DEBUG
-	  fprintf(stderr, "RTPFB(unhandled)\n");
+	      fprintf(stderr, "\tNACK: PID %d, BLP 0x%04x\n", pid, blp);
 #endif
+	      fSink->retransmitPacket(pid);
+	      for (unsigned i = 0; i < 16; ++i) {
+		if ((blp&(1<<i)) != 0) fSink->retransmitPacket(pid+i+1);
+	      }
+	    }
+	  }
 	  subPacketOK = True;
 	  break;
 	}
@@ -1088,11 +1143,14 @@ void RTCPInstance::enqueueCommonReportSuffix() {
     RTPReceptionStatsDB& allReceptionStats
       = fSource->receptionStatsDB();
 
+    struct timeval timeNow; // used for each report block's "DLSR"
+    gettimeofday(&timeNow, NULL);
+
     RTPReceptionStatsDB::Iterator iterator(allReceptionStats);
     while (1) {
       RTPReceptionStats* receptionStats = iterator.next();
       if (receptionStats == NULL) break;
-      enqueueReportBlock(receptionStats);
+      enqueueReportBlock(receptionStats, timeNow);
     }
 
     allReceptionStats.reset(); // because we have just generated a report
@@ -1100,7 +1158,7 @@ void RTCPInstance::enqueueCommonReportSuffix() {
 }
 
 void
-RTCPInstance::enqueueReportBlock(RTPReceptionStats* stats) {
+RTCPInstance::enqueueReportBlock(RTPReceptionStats* stats, struct timeval const& timeNow) {
   fOutBuf->enqueueWord(stats->SSRC());
 
   unsigned highestExtSeqNumReceived = stats->highestExtSeqNumReceived();
@@ -1140,14 +1198,13 @@ RTCPInstance::enqueueReportBlock(RTPReceptionStats* stats) {
 
   // Figure out how long has elapsed since the last SR rcvd from this src:
   struct timeval const& LSRtime = stats->lastReceivedSR_time(); // "last SR"
-  struct timeval timeNow, timeSinceLSR;
-  gettimeofday(&timeNow, NULL);
-  if (timeNow.tv_usec < LSRtime.tv_usec) {
-    timeNow.tv_usec += 1000000;
-    timeNow.tv_sec -= 1;
-  }
+  struct timeval timeSinceLSR;
   timeSinceLSR.tv_sec = timeNow.tv_sec - LSRtime.tv_sec;
   timeSinceLSR.tv_usec = timeNow.tv_usec - LSRtime.tv_usec;
+  if (timeSinceLSR.tv_usec < 0) {
+    timeSinceLSR.tv_usec += 1000000;
+    timeSinceLSR.tv_sec -= 1;
+  }
   // The enqueued time is in units of 1/65536 seconds.
   // (Note that 65536/1000000 == 1024/15625)
   unsigned DLSR;
@@ -1162,7 +1219,23 @@ RTCPInstance::enqueueReportBlock(RTPReceptionStats* stats) {
 
 void RTCPInstance::addSDES() {
   // For now we support only the CNAME item; later support more #####
+  u_int32_t SSRC = 0;
+  Boolean haveSSRC = True;
+  if (fSource != NULL) {
+    SSRC = fSource->SSRC();
+  } else if (fSink != NULL) {
+    SSRC = fSink->SSRC();
+  } else {
+    haveSSRC = False;
+  }
+
+  // (Re)build our SDES packet if we haven't already done so (or if our SSRC has changed):
+  if (fSDESPacketSize == 0 || SSRC != fSDESPacketSSRC) buildSDESPacket(SSRC, haveSSRC);
 
+  fOutBuf->enqueue(fSDESPacket, fSDESPacketSize);
+}
+
+void RTCPInstance::buildSDESPacket(u_int32_t SSRC, Boolean haveSSRC) {
   // Begin by figuring out the size of the entire SDES report:
   unsigned numBytes = 4;
       // counts the SSRC, but not the header; it'll get subtracted out
@@ -1174,21 +1247,24 @@ void RTCPInstance::addSDES() {
   unsigned rtcpHdr = 0x81000000; // version 2, no padding, 1 SSRC chunk
   rtcpHdr |= (RTCP_PT_SDES<<16);
   rtcpHdr |= num4ByteWords;
-  fOutBuf->enqueueWord(rtcpHdr);
 
-  if (fSource != NULL) {
-    fOutBuf->enqueueWord(fSource->SSRC());
-  } else if (fSink != NULL) {
-    fOutBuf->enqueueWord(fSink->SSRC());
+  u_int8_t* ptr = fSDESPacket;
+  *ptr++ = rtcpHdr>>24; *ptr++ = rtcpHdr>>16; *ptr++ = rtcpHdr>>8; *ptr++ = rtcpHdr;
+  if (haveSSRC) {
+    *ptr++ = SSRC>>24; *ptr++ = SSRC>>16; *ptr++ = SSRC>>8; *ptr++ = SSRC;
   }
 
   // Add the CNAME:
-  fOutBuf->enqueue(fCNAME.data(), fCNAME.totalSize());
+  memmove(ptr, fCNAME.data(), fCNAME.totalSize());
+  ptr += fCNAME.totalSize();
 
   // Add the 'END' item (i.e., a zero byte), plus any more needed to pad:
-  unsigned numPaddingBytesNeeded = 4 - (fOutBuf->curPacketSize() % 4);
-  unsigned char const zero = '\0';
-  while (numPaddingBytesNeeded-- > 0) fOutBuf->enqueue(&zero, 1);
+  // (Note that the SR or RR report that precedes us in the packet is a whole number of 4-byte words.)
+  unsigned numPaddingBytesNeeded = 4 - ((ptr - fSDESPacket) % 4);
+  while (numPaddingBytesNeeded-- > 0) *ptr++ = '\0';
+
+  fSDESPacketSize = ptr - fSDESPacket;
+  fSDESPacketSSRC = SSRC;
 }
 
 void RTCPInstance::addBYE(char const* reason) {
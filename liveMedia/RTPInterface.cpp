@@ -21,6 +21,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "RTPInterface.hh"
+#include "MediaMetrics.hh"
 #include <GroupsockHelper.hh>
 #include <stdio.h>
 
@@ -380,7 +381,12 @@ Boolean RTPInterface::sendRTPorRTCPPacketOverTCP(u_int8_t* packet, unsigned pack
 Boolean RTPInterface::sendDataOverTCP(int socketNum, TLSState* tlsState,
 				      u_int8_t const* data, unsigned dataSize,
 				      Boolean forceSendToSucceed) {
-  int sendResult = (tlsState != NULL && tlsState->isNeeded)
+  RTPOverTCPMetrics* metrics = MetricsRegistry::tcpMetrics(envir());
+  if (metrics != NULL) metrics->sendSize.observe(dataSize);
+
+  // Note: If the kernel does our TLS record encryption ("kTLS"), then we can use "send()" directly:
+  Boolean const useTLSWrite = tlsState != NULL && tlsState->isNeeded && !tlsState->sendingIsDoneByKernel();
+  int sendResult = useTLSWrite
     ? tlsState->write((char const*)data, dataSize)
     : send(socketNum, (char const*)data, dataSize, MSG_NOSIGNAL/*flags*/);
   if (sendResult < (int)dataSize) {
@@ -392,11 +398,12 @@ Boolean RTPInterface::sendDataOverTCP(int socketNum, TLSState* tlsState,
       // the capacity of the TCP connection!).
       // Force this data write to succeed, by blocking if necessary until it does:
       unsigned numBytesRemainingToSend = dataSize - numBytesSentSoFar;
+      if (metrics != NULL) metrics->blockingSends.increment();
 #ifdef DEBUG_SEND
       fprintf(stderr, "sendDataOverTCP: resending %d-byte send (blocking)\n", numBytesRemainingToSend); fflush(stderr);
 #endif
       makeSocketBlocking(socketNum, RTPINTERFACE_BLOCKING_WRITE_TIMEOUT_MS);
-      sendResult = (tlsState != NULL && tlsState->isNeeded)
+      sendResult = useTLSWrite
 	? tlsState->write((char const*)(&data[numBytesSentSoFar]), numBytesRemainingToSend)
 	: send(socketNum, (char const*)(&data[numBytesSentSoFar]), numBytesRemainingToSend, MSG_NOSIGNAL/*flags*/);
       makeSocketNonBlocking(socketNum);
@@ -409,10 +416,15 @@ Boolean RTPInterface::sendDataOverTCP(int socketNum, TLSState* tlsState,
 #ifdef DEBUG_SEND
 	fprintf(stderr, "sendDataOverTCP: blocking send() failed (delivering %d bytes out of %d); closing socket %d\n", sendResult, numBytesRemainingToSend, socketNum); fflush(stderr);
 #endif
+	if (metrics != NULL) {
+	  metrics->sendErrors.increment();
+	  metrics->bytesSent.increment(numBytesSentSoFar + (sendResult < 0 ? 0 : sendResult));
+	}
 	removeStreamSocket(socketNum, 0xFF);
 	return False;
       }
 
+      if (metrics != NULL) metrics->bytesSent.increment(dataSize);
       return True;
     } else if (sendResult < 0 && envir().getErrno() != EAGAIN) {
       // Because the "send()" call failed, assume that the socket is now unusable, so stop
@@ -420,9 +432,11 @@ Boolean RTPInterface::sendDataOverTCP(int socketNum, TLSState* tlsState,
       removeStreamSocket(socketNum, 0xFF);
     }
 
+    if (metrics != NULL) metrics->sendErrors.increment();
     return False;
   }
 
+  if (metrics != NULL) metrics->bytesSent.increment(dataSize);
   return True;
 }
 
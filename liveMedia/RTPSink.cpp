@@ -52,18 +52,18 @@ Boolean RTPSink::lookupByName(UsageEnvironment& env, char const* sinkName,
   return True;
 }
 
-void RTPSink::setupForSRTP(Boolean useEncryption, u_int32_t roc) {
+void RTPSink::setupForSRTP(Boolean useEncryption, u_int32_t roc, Boolean useAESGCM) {
   // Set up keying state for streaming via SRTP:
-  if (fMIKEYState == NULL) fMIKEYState = MIKEYState::createNew(useEncryption);
+  if (fMIKEYState == NULL) fMIKEYState = MIKEYState::createNew(useEncryption, useAESGCM);
   fMIKEYState->setROC(roc);
 
   if (fCrypto == NULL) fCrypto = new SRTPCryptographicContext(*fMIKEYState);
 }
 
 u_int8_t* RTPSink::setupForSRTP(Boolean useEncryption, u_int32_t roc,
-				unsigned& resultMIKEYStateMessageSize) {
+				unsigned& resultMIKEYStateMessageSize, Boolean useAESGCM) {
   // Set up keying state for streaming via SRTP:
-  setupForSRTP(useEncryption, roc);
+  setupForSRTP(useEncryption, roc, useAESGCM);
 
   return fMIKEYState->generateMessage(resultMIKEYStateMessageSize);
 }
@@ -132,6 +132,71 @@ char const* RTPSink::auxSDPLine() {
   return NULL; // by default
 }
 
+Boolean RTPSink::enableRetransmission(unsigned char /*rtxPayloadType*/, unsigned /*historySize*/) {
+  return False; // by default
+}
+
+char* RTPSink::rtxSDPLines() const {
+  if (fRTXPayloadType == 0) return strDup("");
+
+  // Describe the "rtx" payload format (RFC 4588, section 8.6).  (We don't also advertise our support for receiving
+  // Generic NACKs with a "a=rtcp-fb:" line, because that attribute is defined only for the "RTP/AVPF" profile, and our
+  // "m=" lines use "RTP/AVP".  Instead, clients take the presence of the "rtx" payload format to mean that they can
+  // request retransmissions.)
+  char const* const rtxFmt =
+    "a=rtpmap:%d rtx/%u\r\n"
+    "a=fmtp:%d apt=%d\r\n";
+  unsigned rtxSDPLinesSize = strlen(rtxFmt) + 4*3 /* max char len */ + 20 /* max int len */;
+  char* rtxSDPLines = new char[rtxSDPLinesSize];
+  sprintf(rtxSDPLines, rtxFmt,
+	  fRTXPayloadType, rtpTimestampFrequency(),
+	  fRTXPayloadType, rtpPayloadType());
+
+  return rtxSDPLines;
+}
+
+Boolean RTPSink::enableFEC(unsigned char /*fecPayloadType*/, unsigned /*numPacketsPerRepairPacket*/) {
+  return False; // by default
+}
+
+void RTPSink::setMetricsStreamName(char const* /*streamName*/, char const* /*trackId*/, u_int32_t /*clientSessionId*/) {
+  // default implementation: do nothing
+}
+
+#ifndef FLEXFEC_REPAIR_WINDOW
+#define FLEXFEC_REPAIR_WINDOW 200000 /* microseconds */
+    // the time that receivers should wait for repair packets (advertised in our SDP "a=fmtp:" line)
+#endif
+
+char* RTPSink::fecSDPLines() const {
+  if (fFECPayloadType == 0) return strDup("");
+
+  // Describe the "flexfec" payload format (RFC 8627, section 5.1), with 1-D, non-interleaved protection:
+  char const* const fecFmt =
+    "a=rtpmap:%d flexfec/%u\r\n"
+    "a=fmtp:%d repair-window=%u; L=%u; D=0\r\n";
+  unsigned fecSDPLinesSize = strlen(fecFmt) + 2*3 /* max char len */ + 3*20 /* max int len */;
+  char* fecSDPLines = new char[fecSDPLinesSize];
+  sprintf(fecSDPLines, fecFmt,
+	  fFECPayloadType, rtpTimestampFrequency(),
+	  fFECPayloadType, FLEXFEC_REPAIR_WINDOW, fNumPacketsPerRepairPacket);
+
+  return fecSDPLines;
+}
+
+char* RTPSink::sdpFmtListSuffix() const {
+  char* suffix = new char[2*(1 + 3 /* max char len */) + 1];
+  suffix[0] = '\0';
+  if (fRTXPayloadType != 0) sprintf(&suffix[strlen(suffix)], " %d", fRTXPayloadType);
+  if (fFECPayloadType != 0) sprintf(&suffix[strlen(suffix)], " %d", fFECPayloadType);
+
+  return suffix;
+}
+
+void RTPSink::retransmitPacket(u_int16_t /*seqNum*/) {
+  // By default, we don't keep any packets for retransmission
+}
+
 u_int32_t RTPSink::presetNextTimestamp() {
   struct timeval timeNow;
   gettimeofday(&timeNow, NULL);
@@ -178,7 +243,8 @@ RTPSink::RTPSink(UsageEnvironment& env,
 		 unsigned numChannels)
   : MediaSink(env), fRTPInterface(this, rtpGS),
     fRTPPayloadType(rtpPayloadType),
-    fPacketCount(0), fOctetCount(0), fTotalOctetCount(0),
+    fPacketCount(0), fOctetCount(0), fTotalOctetCount(0), fRTXPayloadType(0),
+    fFECPayloadType(0), fNumPacketsPerRepairPacket(0),
     fMIKEYState(NULL), fCrypto(NULL),
     fTimestampFrequency(rtpTimestampFrequency), fNextTimestampHasBeenPreset(False), fEnableRTCPReports(True),
     fNumChannels(numChannels), fEstimatedBitrate(0) {
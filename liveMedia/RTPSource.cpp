@@ -44,6 +44,22 @@ Boolean RTPSource::hasBeenSynchronizedUsingRTCP() {
   return fCurPacketHasBeenSynchronizedUsingRTCP;
 }
 
+Boolean RTPSource::setAdaptivePacketReorderingThresholdTime(unsigned /*minUSeconds*/, unsigned /*maxUSeconds*/) {
+  return False; // by default
+}
+
+unsigned RTPSource::packetReorderingThresholdTime() const {
+  return 0; // by default
+}
+
+Boolean RTPSource::enableRetransmissionRequests(RTCPInstance* /*rtcpInstance*/, unsigned char /*rtxPayloadFormat*/) {
+  return False; // by default
+}
+
+Boolean RTPSource::enableFECRecovery(unsigned char /*fecPayloadFormat*/) {
+  return False; // by default
+}
+
 Boolean RTPSource::isRTPSource() const {
   return True;
 }
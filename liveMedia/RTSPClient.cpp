@@ -1687,23 +1687,21 @@ void RTSPClient::incomingDataHandler1() {
   handleResponseBytes(bytesRead);
 }
 
-static char* getLine(char* startOfLine) {
-  // returns the start of the next line, or NULL if none.  Note that this modifies the input string to add '\0' characters.
-  for (char* ptr = startOfLine; *ptr != '\0'; ++ptr) {
-    // Check for the end of line: \r\n (but also accept \r or \n by itself):
-    if (*ptr == '\r' || *ptr == '\n') {
-      // We found the end of the line
-      if (*ptr == '\r') {
-	*ptr++ = '\0';
-	if (*ptr == '\n') ++ptr;
-      } else {
-        *ptr++ = '\0';
-      }
-      return ptr;
-    }
-  }
+static char const* noteHeaderValue(char const* value, unsigned valueLen,
+				   char* msg, char** valueEnds, unsigned& numValueEnds) {
+  // Returns "value" (or NULL, if it's empty), after noting (in "valueEnds") where it should later be '\0'-terminated.
+  // ("value" points into "msg".)
+  if (value == NULL || valueLen == 0) return NULL; // a header with no value is assumed to be bad
 
-  return NULL;
+  valueEnds[numValueEnds++] = &msg[(value - msg) + valueLen];
+  return value;
+}
+
+static char const* lookupResponseHeader(RTSPRequestTokenizer const& response, char const* headerName,
+					char* msg, char** valueEnds, unsigned& numValueEnds) {
+  unsigned valueLen;
+  char const* value = response.lookupHeader(headerName, valueLen);
+  return noteHeaderValue(value, valueLen, msg, valueEnds, numValueEnds);
 }
 
 void RTSPClient::handleResponseBytes(int newBytesRead) {
@@ -1784,114 +1782,124 @@ void RTSPClient::handleResponseBytes(int newBytesRead) {
       strncpy(headerDataCopy, fResponseBuffer, fResponseBytesAlreadySeen);
       headerDataCopy[fResponseBytesAlreadySeen] = '\0';
       
-      char* lineStart;
-      char* nextLineStart = headerDataCopy;
-      do {
-	lineStart = nextLineStart;
-	nextLineStart = getLine(lineStart);
-      } while (lineStart[0] == '\0' && nextLineStart != NULL); // skip over any blank lines at the start
-      if (!parseResponseCode(lineStart, responseCode, responseStr)) {
+      // Tokenize the header (in a single pass), and get the response code from its first line:
+      RTSPRequestTokenizer response;
+      response.tokenize(headerDataCopy, fResponseBytesAlreadySeen);
+      char* firstLine = &headerDataCopy[response.cmdName() - headerDataCopy];
+      char* firstLineEnd = firstLine;
+      while (*firstLineEnd != '\0' && *firstLineEnd != '\r' && *firstLineEnd != '\n') ++firstLineEnd;
+      *firstLineEnd = '\0'; // OK, because the header fields all come after this
+      if (!parseResponseCode(firstLine, responseCode, responseStr)) {
 	// This does not appear to be a RTSP response; perhaps it's a RTSP request instead?
 	handleIncomingRequest();
 	break; // we're done with this data
       }
       
-      // Scan through the headers, handling the ones that we're interested in:
-      Boolean reachedEndOfHeaders;
-      unsigned cseq = 0;
-      unsigned contentLength = 0;
-      
-      while (1) {
-	reachedEndOfHeaders = True; // by default; may get changed below
-	lineStart = nextLineStart;
-	if (lineStart == NULL) break;
-	
-	nextLineStart = getLine(lineStart);
-	if (lineStart[0] == '\0') break; // this is a blank line
-	reachedEndOfHeaders = False;
-	
-	char const* headerParamsStr; 
-	if (checkForHeader(lineStart, "CSeq:", 5, headerParamsStr)) {
-	  if (sscanf(headerParamsStr, "%u", &cseq) != 1 || cseq <= 0) {
-	    envir().setResultMsg("Bad \"CSeq:\" header: \"", lineStart, "\"");
-	    break;
-	  }
-	  // Find the handler function for "cseq":
-	  RequestRecord* request;
-	  while ((request = fRequestsAwaitingResponse.dequeue()) != NULL) {
-	    if (request->cseq() < cseq) { // assumes that the CSeq counter will never wrap around
-	      // We never received (and will never receive) a response for this handler, so delete it:
-	      if (fVerbosityLevel >= 1 && strcmp(request->commandName(), "POST") != 0) {
-		envir() << "WARNING: The server did not respond to our \"" << request->commandName() << "\" request (CSeq: "
-			<< request->cseq() << ").  The server appears to be buggy (perhaps not handling pipelined requests properly).\n";
-	      }
-	      delete request;
-	    } else if (request->cseq() == cseq) {
-	      // This is the handler that we want. Remove its record, but remember it, so that we can later call its handler:
-	      foundRequest = request;
-	      break;
-	    } else { // request->cseq() > cseq
-	      // No handler was registered for this response, so ignore it.
-	      break;
-	    }
-	  }
-	} else if (checkForHeader(lineStart, "Content-Length:", 15, headerParamsStr)) {
-	  if (sscanf(headerParamsStr, "%u", &contentLength) != 1) {
-	    envir().setResultMsg("Bad \"Content-Length:\" header: \"", lineStart, "\"");
-	    break;
-	  }
-	} else if (checkForHeader(lineStart, "Content-Base:", 13, headerParamsStr)) {
-	  setBaseURL(headerParamsStr);
-	} else if (checkForHeader(lineStart, "Session:", 8, sessionParamsStr)) {
-	} else if (checkForHeader(lineStart, "Transport:", 10, transportParamsStr)) {
-	} else if (checkForHeader(lineStart, "Scale:", 6, scaleParamsStr)) {
-	} else if (checkForHeader(lineStart, "Speed:",
+      // Look up the headers that we're interested in.  (Because "response" might need to rescan "headerDataCopy" for
+      // these, we '\0'-terminate their values only after we've looked them all up.)
+      char* valueEnds[16]; unsigned numValueEnds = 0;
+      char const* cseqStr = lookupResponseHeader(response, "CSeq", headerDataCopy, valueEnds, numValueEnds);
+      char const* contentLengthStr = lookupResponseHeader(response, "Content-Length", headerDataCopy, valueEnds, numValueEnds);
+      char const* contentBaseStr = lookupResponseHeader(response, "Content-Base", headerDataCopy, valueEnds, numValueEnds);
+      sessionParamsStr = lookupResponseHeader(response, "Session", headerDataCopy, valueEnds, numValueEnds);
+      transportParamsStr = lookupResponseHeader(response, "Transport", headerDataCopy, valueEnds, numValueEnds);
+      scaleParamsStr = lookupResponseHeader(response, "Scale", headerDataCopy, valueEnds, numValueEnds);
+      speedParamsStr = lookupResponseHeader(response, "Speed",
 // NOTE: Should you feel the need to modify this code,
-				  6,
+					    headerDataCopy,
 // please first email the "live-devel" mailing list
-				  speedParamsStr
+					    valueEnds, numValueEnds
 // (see http://live555.com/liveMedia/faq.html#mailing-list-address for details),
-				  )) {
+					    );
 // to check whether your proposed modification is appropriate/correct,
-	} else if (checkForHeader(lineStart, "Range:",
+      rangeParamsStr = lookupResponseHeader(response, "Range",
 // and, if so, whether instead it could be included in
-				  6,
+					    headerDataCopy,
 // a future release of the "LIVE555 Streaming Media" software,
-				  rangeParamsStr
+					    valueEnds, numValueEnds
 // so that other projects that use the code could benefit (not just your own project).
-				  )) {
-	} else if (checkForHeader(lineStart, "RTP-Info:", 9, rtpInfoParamsStr)) {
-	} else if (checkForHeader(lineStart, "WWW-Authenticate:", 17, headerParamsStr)) {
-	  // If we've already seen a "WWW-Authenticate:" header, then we replace it with this new one only if
-	  // the new one specifies "Digest" authentication:
-	  if (wwwAuthenticateParamsStr == NULL || _strncasecmp(headerParamsStr, "Digest", 6) == 0) {
-	    wwwAuthenticateParamsStr = headerParamsStr;
-	  }
-	} else if (checkForHeader(lineStart, "Public:", 7, publicParamsStr)) {
-	} else if (checkForHeader(lineStart, "Allow:", 6, publicParamsStr)) {
-	  // Note: we accept "Allow:" instead of "Public:", so that "OPTIONS" requests made to HTTP servers will work.
-	} else if (checkForHeader(lineStart, "Location:", 9, headerParamsStr)) {
-	  setBaseURL(headerParamsStr);
-	} else if (checkForHeader(lineStart, "com.ses.streamID:", 17, headerParamsStr)) {
-	  // Replace the tail of the 'base URL' with the value of this header parameter:
-	  char* oldBaseURLTail = strrchr(fBaseURL, '/');
-	  if (oldBaseURLTail != NULL) {
-	    unsigned newBaseURLLen
-	      = (oldBaseURLTail - fBaseURL) + 8/* for "/stream=" */ + strlen(headerParamsStr);
-	    char* newBaseURL = new char[newBaseURLLen + 1];
-	        // Note: We couldn't use "asprintf()", because some compilers don't support it
-	    sprintf(newBaseURL, "%.*s/stream=%s",
-		     (int)(oldBaseURLTail - fBaseURL), fBaseURL, headerParamsStr);
-	    setBaseURL(newBaseURL);
-	    delete[] newBaseURL;
-	  }
-	} else if (checkForHeader(lineStart, "Connection:", 11, headerParamsStr)) {
-	  if (fTunnelOverHTTPPortNum == 0 && _strncasecmp(headerParamsStr, "Close", 5) == 0) {
-	    resetTCPSockets();
+					    );
+      rtpInfoParamsStr = lookupResponseHeader(response, "RTP-Info", headerDataCopy, valueEnds, numValueEnds);
+
+      // If there's more than one "WWW-Authenticate:" header, then we use the first one that specifies "Digest"
+      // authentication (if any):
+      char const* value = NULL; unsigned valueLen;
+      unsigned wwwAuthenticateParamsLen = 0;
+      while ((value = response.lookupNextHeader("WWW-Authenticate", valueLen, value)) != NULL) {
+	if (valueLen == 0) continue;
+	Boolean isDigest = valueLen >= 6 && _strncasecmp(value, "Digest", 6) == 0;
+	if (wwwAuthenticateParamsStr == NULL || isDigest) {
+	  wwwAuthenticateParamsStr = value; wwwAuthenticateParamsLen = valueLen;
+	  if (isDigest) break;
+	}
+      }
+      wwwAuthenticateParamsStr
+	= noteHeaderValue(wwwAuthenticateParamsStr, wwwAuthenticateParamsLen, headerDataCopy, valueEnds, numValueEnds);
+
+      publicParamsStr = lookupResponseHeader(response, "Public", headerDataCopy, valueEnds, numValueEnds);
+      if (publicParamsStr == NULL) {
+	// Note: we accept "Allow:" instead of "Public:", so that "OPTIONS" requests made to HTTP servers will work.
+	publicParamsStr = lookupResponseHeader(response, "Allow", headerDataCopy, valueEnds, numValueEnds);
+      }
+      char const* locationStr = lookupResponseHeader(response, "Location", headerDataCopy, valueEnds, numValueEnds);
+      char const* streamIDStr = lookupResponseHeader(response, "com.ses.streamID", headerDataCopy, valueEnds, numValueEnds);
+      char const* connectionStr = lookupResponseHeader(response, "Connection", headerDataCopy, valueEnds, numValueEnds);
+
+      for (unsigned i = 0; i < numValueEnds; ++i) *valueEnds[i] = '\0';
+
+      // Then handle them:
+      unsigned cseq = 0;
+      unsigned contentLength = 0;
+      if (cseqStr != NULL) {
+	if (sscanf(cseqStr, "%u", &cseq) != 1 || cseq <= 0) {
+	  envir().setResultMsg("Bad \"CSeq:\" header: \"", cseqStr, "\"");
+	  break;
+	}
+	// Find the handler function for "cseq":
+	RequestRecord* request;
+	while ((request = fRequestsAwaitingResponse.dequeue()) != NULL) {
+	  if (request->cseq() < cseq) { // assumes that the CSeq counter will never wrap around
+	    // We never received (and will never receive) a response for this handler, so delete it:
+	    if (fVerbosityLevel >= 1 && strcmp(request->commandName(), "POST") != 0) {
+	      envir() << "WARNING: The server did not respond to our \"" << request->commandName() << "\" request (CSeq: "
+		      << request->cseq() << ").  The server appears to be buggy (perhaps not handling pipelined requests properly).\n";
+	    }
+	    delete request;
+	  } else if (request->cseq() == cseq) {
+	    // This is the handler that we want. Remove its record, but remember it, so that we can later call its handler:
+	    foundRequest = request;
+	    break;
+	  } else { // request->cseq() > cseq
+	    // No handler was registered for this response, so ignore it.
+	    break;
 	  }
 	}
       }
-      if (!reachedEndOfHeaders) break; // an error occurred
+      if (contentLengthStr != NULL && sscanf(contentLengthStr, "%u", &contentLength) != 1) {
+	envir().setResultMsg("Bad \"Content-Length:\" header: \"", contentLengthStr, "\"");
+	break;
+      }
+      if (contentBaseStr != NULL) setBaseURL(contentBaseStr);
+      if (locationStr != NULL) setBaseURL(locationStr);
+      if (streamIDStr != NULL) {
+	// Replace the tail of the 'base URL' with the value of this header parameter:
+	char* oldBaseURLTail = strrchr(fBaseURL, '/');
+	if (oldBaseURLTail != NULL) {
+	  unsigned newBaseURLLen
+	    = (oldBaseURLTail - fBaseURL) + 8/* for "/stream=" */ + strlen(streamIDStr);
+	  char* newBaseURL = new char[newBaseURLLen + 1];
+	      // Note: We couldn't use "asprintf()", because some compilers don't support it
+	  sprintf(newBaseURL, "%.*s/stream=%s",
+		   (int)(oldBaseURLTail - fBaseURL), fBaseURL, streamIDStr);
+	  setBaseURL(newBaseURL);
+	  delete[] newBaseURL;
+	}
+      }
+      if (connectionStr != NULL) {
+	if (fTunnelOverHTTPPortNum == 0 && _strncasecmp(connectionStr, "Close", 5) == 0) {
+	  resetTCPSockets();
+	}
+      }
       
       if (foundRequest == NULL) {
 	// Hack: The response didn't have a "CSeq:" header; assume it's for our most recent request:
@@ -1899,7 +1907,7 @@ void RTSPClient::handleResponseBytes(int newBytesRead) {
       }
       
       // If we saw a "Content-Length:" header, then make sure that we have the amount of data that it specified:
-      unsigned bodyOffset = nextLineStart == NULL ? fResponseBytesAlreadySeen : nextLineStart - headerDataCopy;
+      unsigned bodyOffset = response.headerSize();
       bodyStart = &fResponseBuffer[bodyOffset];
       numBodyBytes = fResponseBytesAlreadySeen - bodyOffset;
       if (contentLength > numBodyBytes) {
@@ -48,6 +48,202 @@ static void decodeURL(char* url) {
   *url = '\0';
 }
 
+static Boolean isSpaceOrTab(char c) { return c == ' ' || c == '\t'; }
+
+RTSPRequestTokenizer::RTSPRequestTokenizer() {
+  reset();
+}
+
+void RTSPRequestTokenizer::reset() {
+  fMsgStr = NULL; fHeaderSize = 0;
+  fCmdName = fURL = fProtocol = NULL;
+  fCmdNameLen = fURLLen = fProtocolLen = 0;
+  fNumHeaderFields = 0;
+  fFirstUnrecordedField = NULL;
+}
+
+Boolean RTSPRequestTokenizer::tokenize(char const* msgStr, unsigned msgStrSize) {
+  reset();
+  fMsgStr = msgStr;
+  char const* p = msgStr;
+  char const* const msgEnd = msgStr + msgStrSize;
+
+  // "Be liberal in what you accept": Skip over any whitespace at the start of the message:
+  while (p < msgEnd && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == '\0')) ++p;
+
+  // The first line is "<command> <URL> <protocol>".  Because some clients don't encode spaces in URLs, we take the
+  // protocol to be the last word on the line, and the URL to be everything between it and the command name:
+  char const* const lineStart = p;
+  while (p < msgEnd && *p != '\r' && *p != '\n') ++p;
+  char const* lineEnd = p;
+
+  char const* q = lineStart;
+  while (q < lineEnd && !isSpaceOrTab(*q)) ++q;
+  fCmdName = lineStart; fCmdNameLen = q - lineStart;
+  while (q < lineEnd && isSpaceOrTab(*q)) ++q;
+
+  char const* r = lineEnd;
+  while (r > q && isSpaceOrTab(r[-1])) --r;
+  char const* const lastWordEnd = r;
+  while (r > q && !isSpaceOrTab(r[-1])) --r;
+  char const* const lastWordStart = r;
+  while (r > q && isSpaceOrTab(r[-1])) --r;
+  fURL = q;
+  if (r > q) { // there are at least two words after the command name
+    fURLLen = r - q;
+    fProtocol = lastWordStart; fProtocolLen = lastWordEnd - lastWordStart;
+  } else {
+    fURLLen = lastWordEnd - q;
+  }
+
+  // Then, the header fields - one per line (except for any continuation lines) - up until an empty line:
+  HeaderField* lastField = NULL; // the most recent field that we recorded
+  while (1) {
+    // Move past the end of the current line:
+    if (p < msgEnd && *p == '\r') ++p;
+    if (p < msgEnd && *p == '\n') ++p;
+    if (p >= msgEnd) break;
+
+    char const* const fieldStart = p;
+    while (p < msgEnd && *p != '\r' && *p != '\n') ++p;
+    lineEnd = p;
+    if (lineEnd == fieldStart) { // this is the empty line that ends the header
+      if (p < msgEnd && *p == '\r') ++p;
+      if (p < msgEnd && *p == '\n') ++p;
+      break;
+    }
+
+    // Ignore any whitespace at the end of the line:
+    while (lineEnd > fieldStart && isSpaceOrTab(lineEnd[-1])) --lineEnd;
+
+    if (isSpaceOrTab(*fieldStart)) {
+      // This is a continuation of the previous field's value:
+      if (lastField != NULL && lineEnd > fieldStart) {
+	if (lastField->valueLen == 0) {
+	  char const* v = fieldStart;
+	  while (isSpaceOrTab(*v)) ++v;
+	  lastField->value = v;
+	}
+	lastField->valueLen = lineEnd - lastField->value;
+      }
+      continue;
+    }
+
+    lastField = NULL;
+    char const* colon = fieldStart;
+    while (colon < lineEnd && *colon != ':') ++colon;
+    if (colon == lineEnd) continue; // not a header field
+    if (fNumHeaderFields == RTSP_MAX_HEADER_FIELDS) {
+      // There's no room to record this field (or any later ones), so "lookupHeader()" will need to scan for them:
+      if (fFirstUnrecordedField == NULL) fFirstUnrecordedField = fieldStart;
+      continue;
+    }
+
+    lastField = &fHeaderFields[fNumHeaderFields++];
+    char const* nameEnd = colon;
+    while (nameEnd > fieldStart && isSpaceOrTab(nameEnd[-1])) --nameEnd;
+    lastField->name = fieldStart; lastField->nameLen = nameEnd - fieldStart;
+
+    char const* value = colon+1;
+    while (value < lineEnd && isSpaceOrTab(*value)) ++value;
+    lastField->value = value; lastField->valueLen = lineEnd - value;
+  }
+  fHeaderSize = p - msgStr;
+
+  return fCmdNameLen > 0 && fURLLen > 0;
+}
+
+char const* RTSPRequestTokenizer::lookupHeader(char const* headerName, unsigned& valueLen) const {
+  return lookupNextHeader(headerName, valueLen, NULL);
+}
+
+char const* RTSPRequestTokenizer
+::lookupNextHeader(char const* headerName, unsigned& valueLen, char const* prevValue) const {
+  unsigned const headerNameLen = strlen(headerName);
+  char const* scanStart = fFirstUnrecordedField; // where to begin scanning, if the field wasn't recorded
+  unsigned i = 0;
+
+  if (prevValue != NULL) {
+    // Begin just after the field whose value was "prevValue":
+    while (i < fNumHeaderFields && fHeaderFields[i].value != prevValue) ++i;
+    if (i < fNumHeaderFields) {
+      ++i;
+    } else if (fFirstUnrecordedField != NULL && prevValue >= fFirstUnrecordedField) {
+      // "prevValue" was in a field that we didn't record; begin scanning at the next line:
+      char const* const headerEnd = fMsgStr + fHeaderSize;
+      scanStart = prevValue;
+      while (scanStart < headerEnd && *scanStart != '\n') ++scanStart;
+      if (scanStart < headerEnd) ++scanStart;
+    } else {
+      valueLen = 0;
+      return NULL; // "prevValue" wasn't the value of a field
+    }
+  }
+
+  for (; i < fNumHeaderFields; ++i) {
+    HeaderField const& field = fHeaderFields[i];
+    if (field.nameLen == headerNameLen && _strncasecmp(field.name, headerName, headerNameLen) == 0) {
+      valueLen = field.valueLen;
+      return field.value;
+    }
+  }
+
+  if (scanStart != NULL) return lookupUnrecordedHeader(headerName, headerNameLen, valueLen, scanStart);
+
+  valueLen = 0;
+  return NULL;
+}
+
+char const* RTSPRequestTokenizer
+::lookupUnrecordedHeader(char const* headerName, unsigned headerNameLen, unsigned& valueLen,
+			 char const* scanStart) const {
+  // Scan (from "scanStart") the header lines that "tokenize()" had no room to record, parsing them in the same way:
+  char const* p = scanStart;
+  char const* const headerEnd = fMsgStr + fHeaderSize;
+  char const* result = NULL;
+  valueLen = 0;
+
+  while (p < headerEnd) {
+    char const* const fieldStart = p;
+    while (p < headerEnd && *p != '\r' && *p != '\n') ++p;
+    char const* lineEnd = p;
+    if (p < headerEnd && *p == '\r') ++p;
+    if (p < headerEnd && *p == '\n') ++p;
+    if (lineEnd == fieldStart) break; // the empty line that ends the header
+
+    while (lineEnd > fieldStart && isSpaceOrTab(lineEnd[-1])) --lineEnd;
+
+    if (isSpaceOrTab(*fieldStart)) {
+      // A continuation line.  If it continues the field that we found, then extend that field's value:
+      if (result != NULL && lineEnd > fieldStart) {
+	if (valueLen == 0) {
+	  char const* v = fieldStart;
+	  while (isSpaceOrTab(*v)) ++v;
+	  result = v;
+	}
+	valueLen = lineEnd - result;
+      }
+      continue;
+    }
+    if (result != NULL) break; // we've seen all of the field that we found
+
+    char const* colon = fieldStart;
+    while (colon < lineEnd && *colon != ':') ++colon;
+    if (colon == lineEnd) continue; // not a header field
+
+    char const* nameEnd = colon;
+    while (nameEnd > fieldStart && isSpaceOrTab(nameEnd[-1])) --nameEnd;
+    if ((unsigned)(nameEnd - fieldStart) != headerNameLen
+	|| _strncasecmp(fieldStart, headerName, headerNameLen) != 0) continue;
+
+    char const* value = colon+1;
+    while (value < lineEnd && isSpaceOrTab(*value)) ++value;
+    result = value; valueLen = lineEnd - value;
+  }
+
+  return result;
+}
+
 Boolean parseRTSPRequestString(char const* reqStr, unsigned reqStrSize,
 			       char* resultCmdName,
 			       unsigned resultCmdNameMaxSize,
@@ -60,157 +256,104 @@ Boolean parseRTSPRequestString(char const* reqStr, unsigned reqStrSize,
                                char* resultSessionIdStr,
                                unsigned resultSessionIdStrMaxSize,
 			       unsigned& contentLength, Boolean& urlIsRTSPS) {
-  // This parser is currently rather dumb; it should be made smarter #####
   urlIsRTSPS = False; // by default
+  RTSPRequestTokenizer request;
+  if (!request.tokenize(reqStr, reqStrSize)) return False;
+
+  return parseRTSPRequestString(request,
+				resultCmdName, resultCmdNameMaxSize,
+				resultURLPreSuffix, resultURLPreSuffixMaxSize,
+				resultURLSuffix, resultURLSuffixMaxSize,
+				resultCSeq, resultCSeqMaxSize,
+				resultSessionIdStr, resultSessionIdStrMaxSize,
+				contentLength, urlIsRTSPS);
+}
 
-  // "Be liberal in what you accept": Skip over any whitespace at the start of the request:
-  unsigned i;
-  for (i = 0; i < reqStrSize; ++i) {
-    char c = reqStr[i];
-    if (!(c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\0')) break;
-  }
-  if (i == reqStrSize) return False; // The request consisted of nothing but whitespace!
-
-  // Then read everything up to the next space (or tab) as the command name:
-  Boolean parseSucceeded = False;
-  unsigned i1 = 0;
-  for (; i1 < resultCmdNameMaxSize-1 && i < reqStrSize; ++i,++i1) {
-    char c = reqStr[i];
-    if (c == ' ' || c == '\t') {
-      parseSucceeded = True;
-      break;
-    }
-
-    resultCmdName[i1] = c;
-  }
-  resultCmdName[i1] = '\0';
-  if (!parseSucceeded) return False;
-
-  // Skip over the prefix of any "rtsp://" or "rtsp:/" (or "rtsps://" or "rtsps:/")
-  // URL that follows:
-  unsigned j = i+1;
-  while (j < reqStrSize && (reqStr[j] == ' ' || reqStr[j] == '\t')) ++j; // skip over any additional white space
-  for (; (int)j < (int)(reqStrSize-8); ++j) {
-    if ((reqStr[j] == 'r' || reqStr[j] == 'R')
-	&& (reqStr[j+1] == 't' || reqStr[j+1] == 'T')
-	&& (reqStr[j+2] == 's' || reqStr[j+2] == 'S')
-	&& (reqStr[j+3] == 'p' || reqStr[j+3] == 'P')) {
-      if (reqStr[j+4] == 's' || reqStr[j+4] == 'S') {
-	urlIsRTSPS = True;
-	++j;
-      }
-      if (reqStr[j+4] == ':' && reqStr[j+5] == '/') {
-	j += 6;
-	if (reqStr[j] == '/') {
-	  // This is a "rtsp(s)://" URL; skip over the host:port part that follows:
-	  ++j;
-	  while (j < reqStrSize && reqStr[j] != '/' && reqStr[j] != ' ') ++j;
-	} else {
-	  // This is a "rtsp(s):/" URL; back up to the "/":
-	  --j;
-	}
-	i = j;
-	break;
-      }
-    }
-  }	
-
-  // Look for the URL suffix (before the following "RTSP/"):
-  parseSucceeded = False;
-  for (unsigned k = i+1; (int)k < (int)(reqStrSize-5); ++k) {
-    if (reqStr[k] == 'R' && reqStr[k+1] == 'T' &&
-	reqStr[k+2] == 'S' && reqStr[k+3] == 'P' && reqStr[k+4] == '/') {
-      while (--k >= i && reqStr[k] == ' ') {} // go back over all spaces before "RTSP/"
-      unsigned k1 = k;
-      while (k1 > i && reqStr[k1] != '/') --k1;
-
-      // ASSERT: At this point
-      //   i: first space or slash after "host" or "host:port"
-      //   k: last non-space before "RTSP/"
-      //   k1: last slash in the range [i,k]
-
-      // The URL suffix comes from [k1+1,k]
-      // Copy "resultURLSuffix":
-      unsigned n = 0, k2 = k1+1;
-      if (k2 <= k) {
-        if (k - k1 + 1 > resultURLSuffixMaxSize) return False; // there's no room
-        while (k2 <= k) resultURLSuffix[n++] = reqStr[k2++];
-      }
-      resultURLSuffix[n] = '\0';
-
-      // The URL 'pre-suffix' comes from [i+1,k1-1]
-      // Copy "resultURLPreSuffix":
-      n = 0; k2 = i+1;
-      if (k2+1 <= k1) {
-        if (k1 - i > resultURLPreSuffixMaxSize) return False; // there's no room
-        while (k2 <= k1-1) resultURLPreSuffix[n++] = reqStr[k2++];
-      }
-      resultURLPreSuffix[n] = '\0';
-      decodeURL(resultURLPreSuffix);
+Boolean parseRTSPRequestString(RTSPRequestTokenizer const& request,
+			       char* resultCmdName, unsigned resultCmdNameMaxSize,
+			       char* resultURLPreSuffix, unsigned resultURLPreSuffixMaxSize,
+			       char* resultURLSuffix, unsigned resultURLSuffixMaxSize,
+			       char* resultCSeq, unsigned resultCSeqMaxSize,
+			       char* resultSessionIdStr, unsigned resultSessionIdStrMaxSize,
+			       unsigned& contentLength, Boolean& urlIsRTSPS) {
+  urlIsRTSPS = False; // by default
 
-      i = k + 7; // to go past " RTSP/"
-      parseSucceeded = True;
-      break;
+  // This must be a RTSP request, with a command name that fits:
+  if (request.cmdNameLen() == 0 || request.urlLen() == 0) return False;
+  if (request.cmdNameLen() >= resultCmdNameMaxSize) return False; // there's no room
+  memmove(resultCmdName, request.cmdName(), request.cmdNameLen());
+  resultCmdName[request.cmdNameLen()] = '\0';
+  if (request.protocolLen() < 5 || strncmp(request.protocol(), "RTSP/", 5) != 0) return False;
+
+  // Skip over the prefix of any "rtsp://" or "rtsp:/" (or "rtsps://" or "rtsps:/") URL, including any "host:port" part.
+  // "base" is then the character just before the URL 'pre-suffix' (or the whitespace before the URL, if there's no prefix):
+  char const* const url = request.url();
+  char const* const urlEnd = url + request.urlLen();
+  char const* base = url - 1;
+  if (urlEnd - url >= 6 && _strncasecmp(url, "rtsp", 4) == 0) {
+    char const* p = url + 4;
+    Boolean isRTSPS = False;
+    if (*p == 's' || *p == 'S') {
+      isRTSPS = True;
+      ++p;
     }
-  }
-  if (!parseSucceeded) return False;
-
-  // Look for "CSeq:" (mandatory, case insensitive), skip whitespace,
-  // then read everything up to the next \r or \n as 'CSeq':
-  parseSucceeded = False;
-  for (j = i; (int)j < (int)(reqStrSize-5); ++j) {
-    if (_strncasecmp("CSeq:", &reqStr[j], 5) == 0) {
-      j += 5;
-      while (j < reqStrSize && (reqStr[j] ==  ' ' || reqStr[j] == '\t')) ++j;
-      unsigned n;
-      for (n = 0; n < resultCSeqMaxSize-1 && j < reqStrSize; ++n,++j) {
-	char c = reqStr[j];
-	if (c == '\r' || c == '\n') {
-	  parseSucceeded = True;
-	  break;
-	}
-
-	resultCSeq[n] = c;
+    if (p+1 < urlEnd && p[0] == ':' && p[1] == '/') {
+      urlIsRTSPS = isRTSPS;
+      p += 2;
+      if (p < urlEnd && *p == '/') {
+	// This is a "rtsp(s)://" URL; skip over the host:port part that follows:
+	++p;
+	while (p < urlEnd && *p != '/') ++p;
+	base = p;
+      } else {
+	// This is a "rtsp(s):/" URL; back up to the "/":
+	base = p-1;
       }
-      resultCSeq[n] = '\0';
-      break;
     }
   }
-  if (!parseSucceeded) return False;
 
-  // Look for "Session:" (optional, case insensitive), skip whitespace,
-  // then read everything up to the next \r or \n as 'Session':
+  // The URL suffix is whatever follows the last "/" (after "base"); the URL 'pre-suffix' is whatever's before it:
+  char const* const k = urlEnd-1; // the last character of the URL
+  char const* k1 = k;
+  while (k1 > base && *k1 != '/') --k1;
+
+  unsigned const suffixLen = k - k1;
+  if (suffixLen+1 > resultURLSuffixMaxSize) return False; // there's no room
+  memmove(resultURLSuffix, k1+1, suffixLen);
+  resultURLSuffix[suffixLen] = '\0';
+
+  unsigned const preSuffixLen = k1 > base+1 ? k1 - (base+1) : 0;
+  if (preSuffixLen+1 > resultURLPreSuffixMaxSize) return False; // there's no room
+  memmove(resultURLPreSuffix, base+1, preSuffixLen);
+  resultURLPreSuffix[preSuffixLen] = '\0';
+  decodeURL(resultURLPreSuffix);
+
+  // "CSeq:" is mandatory:
+  unsigned valueLen;
+  char const* value = request.lookupHeader("CSeq", valueLen);
+  if (value == NULL || valueLen+1 >= resultCSeqMaxSize) return False;
+  memmove(resultCSeq, value, valueLen);
+  resultCSeq[valueLen] = '\0';
+
+  // "Session:" is optional (and is truncated, if necessary):
   resultSessionIdStr[0] = '\0'; // default value (empty string)
-  for (j = i; (int)j < (int)(reqStrSize-8); ++j) {
-    if (_strncasecmp("Session:", &reqStr[j], 8) == 0) {
-      j += 8;
-      while (j < reqStrSize && (reqStr[j] ==  ' ' || reqStr[j] == '\t')) ++j;
-      unsigned n;
-      for (n = 0; n < resultSessionIdStrMaxSize-1 && j < reqStrSize; ++n,++j) {
-	char c = reqStr[j];
-	if (c == '\r' || c == '\n') {
-	  break;
-	}
-
-	resultSessionIdStr[n] = c;
-      }
-      resultSessionIdStr[n] = '\0';
-      break;
-    }
+  value = request.lookupHeader("Session", valueLen);
+  if (value != NULL) {
+    if (valueLen >= resultSessionIdStrMaxSize) valueLen = resultSessionIdStrMaxSize-1;
+    memmove(resultSessionIdStr, value, valueLen);
+    resultSessionIdStr[valueLen] = '\0';
   }
 
-  // Also: Look for "Content-Length:" (optional, case insensitive)
+  // Also: Look for "Content-Length:" (optional)
   contentLength = 0; // default value
-  for (j = i; (int)j < (int)(reqStrSize-15); ++j) {
-    if (_strncasecmp("Content-Length:", &(reqStr[j]), 15) == 0) {
-      j += 15;
-      while (j < reqStrSize && (reqStr[j] ==  ' ' || reqStr[j] == '\t')) ++j;
-      unsigned num;
-      if (sscanf(&reqStr[j], "%u", &num) == 1) {
-	contentLength = num;
-      }
-    }
+  value = request.lookupHeader("Content-Length", valueLen);
+  if (value != NULL) {
+    unsigned num = 0;
+    unsigned i;
+    for (i = 0; i < valueLen && value[i] >= '0' && value[i] <= '9'; ++i) num = 10*num + (value[i] - '0');
+    if (i > 0) contentLength = num;
   }
+
   return True;
 }
 
@@ -296,6 +439,16 @@ Boolean parseRangeHeader(char const* buf,
   return parseRangeParam(fields, rangeStart, rangeEnd, absStartTime, absEndTime, startTimeIsNow);
 }
 
+Boolean parseRangeHeader(RTSPRequestTokenizer const& request,
+			 double& rangeStart, double& rangeEnd,
+			 char*& absStartTime, char*& absEndTime,
+			 Boolean& startTimeIsNow) {
+  char const* fields = request.lookupHeader("Range");
+  if (fields == NULL) return False;
+
+  return parseRangeParam(fields, rangeStart, rangeEnd, absStartTime, absEndTime, startTimeIsNow);
+}
+
 Boolean parseScaleHeader(char const* buf, float& scale) {
   // Initialize the result parameter to a default value:
   scale = 1.0;
@@ -319,6 +472,23 @@ Boolean parseScaleHeader(char const* buf, float& scale) {
   return True;
 }
 
+Boolean parseScaleHeader(RTSPRequestTokenizer const& request, float& scale) {
+  // Initialize the result parameter to a default value:
+  scale = 1.0;
+
+  char const* fields = request.lookupHeader("Scale");
+  if (fields == NULL) return False;
+
+  float sc;
+  if (sscanf(fields, "%f", &sc) == 1) {
+    scale = sc;
+  } else {
+    return False; // The header is malformed
+  }
+
+  return True;
+}
+
 // Used to implement "RTSPOptionIsSupported()":
 static Boolean isSeparator(char c) { return c == ' ' || c == ',' || c == ';' || c == ':'; }
 
@@ -22,6 +22,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "RTSPCommon.hh"
 #include "RTSPRegisterSender.hh"
 #include "Base64.hh"
+#include "MediaMetrics.hh"
+#include "HTTPStreamer.hh"
 #include <GroupsockHelper.hh>
 
 ////////// RTSPServer implementation //////////
@@ -138,11 +140,13 @@ portNumBits RTSPServer::httpServerPortNum() const {
 
 void RTSPServer
 ::setTLSState(char const* certFileName, char const* privKeyFileName,
-	      Boolean weServeSRTP, Boolean weEncryptSRTP) {
-  setTLSFileNames(certFileName, privKeyFileName);
+	      Boolean weServeSRTP, Boolean weEncryptSRTP, Boolean weUseAESGCM,
+	      Boolean useKernelTLS) {
+  setTLSFileNames(certFileName, privKeyFileName, useKernelTLS);
   fOurConnectionsUseTLS = True;
   fWeServeSRTP = weServeSRTP;
   fWeEncryptSRTP = weEncryptSRTP;
+  fWeUseAESGCM = weUseAESGCM;
 
   if (fWeServeSRTP) disableStreamingRTPOverTCP();
     // If you want to stream RTP-over-TCP using a secure TCP connection, then stream over TLS,
@@ -190,7 +194,8 @@ RTSPServer::RTSPServer(UsageEnvironment& env,
     fPendingRegisterOrDeregisterRequests(HashTable::create(ONE_WORD_HASH_KEYS)),
     fRegisterOrDeregisterRequestCounter(0), fAuthDB(authDatabase),
     fAllowStreamingRTPOverTCP(True),
-    fOurConnectionsUseTLS(False), fWeServeSRTP(False) {
+    fOurConnectionsUseTLS(False), fWeServeSRTP(False), fWeUseAESGCM(False),
+    fHTTPStreamingIsEnabled(False), fMetricsOverHTTPIsEnabled(False), fHTTPStreamers(HashTable::create(ONE_WORD_HASH_KEYS)) {
 }
 
 // A data structure that is used to implement "fTCPStreamingDatabase"
@@ -216,6 +221,13 @@ RTSPServer::~RTSPServer() {
   envir().taskScheduler().turnOffBackgroundReadHandling(fHTTPServerSocketIPv6);
   ::closeSocket(fHTTPServerSocketIPv6);
   
+  // Stop any HTTP streaming:
+  HTTPStreamer* streamer;
+  while ((streamer = (HTTPStreamer*)fHTTPStreamers->getFirst()) != NULL) {
+    closeHTTPStreamer(streamer);
+  }
+  delete fHTTPStreamers;
+
   cleanup(); // Removes all "ClientSession" and "ClientConnection" objects, and their tables.
   delete fClientConnectionsForHTTPTunneling;
   
@@ -243,6 +255,7 @@ void RTSPServer::addServerMediaSession(ServerMediaSession* serverMediaSession) {
   if (serverMediaSession != NULL) {
     serverMediaSession->streamingUsesSRTP = fWeServeSRTP;
     serverMediaSession->streamingIsEncrypted = fWeEncryptSRTP;
+    serverMediaSession->streamingUsesAESGCM = fWeUseAESGCM;
   }
 }
 
@@ -331,6 +344,44 @@ void RTSPServer::stopTCPStreamingOnSocket(int socketNum) {
   RTPInterface::clearServerRequestAlternativeByteHandler(envir(), socketNum);
 }
 
+HTTPStreamer* RTSPServer::getHTTPStreamer(ServerMediaSession& session) {
+  // If we're already streaming this session - in a way that can be shared - then the new client joins that stream:
+  HTTPStreamer* streamer = NULL;
+  HashTable::Iterator* iter = HashTable::Iterator::create(*fHTTPStreamers);
+  char const* key; // dummy
+  while ((streamer = (HTTPStreamer*)(iter->next(key))) != NULL) {
+    if (&streamer->session() == &session && streamer->isShared() && !streamer->hasEnded()) break;
+  }
+  delete iter;
+  if (streamer != NULL) return streamer;
+
+  // Otherwise, create a new stream:
+  u_int32_t clientSessionId;
+  do clientSessionId = (u_int32_t)our_random32(); while (clientSessionId == 0);
+  streamer = HTTPStreamer::createNew(envir(), session, clientSessionId, HTTPStreamerEndedHandler, this);
+  if (streamer == NULL) return NULL;
+
+  session.incrementReferenceCount(); // in case someone removes it while we're streaming it
+  fHTTPStreamers->Add((char const*)streamer, streamer);
+  return streamer;
+}
+
+void RTSPServer::HTTPStreamerEndedHandler(void* clientData, HTTPStreamer* streamer) {
+  RTSPServer* server = (RTSPServer*)clientData;
+  server->closeHTTPStreamer(streamer);
+}
+
+void RTSPServer::closeHTTPStreamer(HTTPStreamer* streamer) {
+  fHTTPStreamers->Remove((char const*)streamer);
+  ServerMediaSession& session = streamer->session();
+  Medium::close(streamer);
+
+  session.decrementReferenceCount();
+  if (session.referenceCount() == 0 && session.deleteWhenUnreferenced()) {
+    removeServerMediaSession(&session);
+  }
+}
+
 
 ////////// RTSPServer::RTSPClientConnection implementation //////////
 
@@ -341,7 +392,11 @@ RTSPServer::RTSPClientConnection
   : GenericMediaServer::ClientConnection(ourServer, clientSocket, clientAddr, useTLS),
     fOurRTSPServer(ourServer), fClientInputSocket(fOurSocket), fClientOutputSocket(fOurSocket),
     fPOSTSocketTLS(envir()), fAddressFamily(clientAddr.ss_family),
-    fIsActive(True), fRecursionCount(0), fCurrentCSeq(NULL), fOurSessionCookie(NULL), fScheduledDelayedTask(0) {
+    fIsActive(True), fRequestTokens(new RTSPRequestTokenizer), fRecursionCount(0), fCurrentCSeq(NULL),
+    fOurSessionCookie(NULL), fScheduledDelayedTask(0),
+    fNumPendingOperations(0), fResponseIsDeferred(False), fRequestReadingIsPaused(False),
+    fDeferredRequestSize(0), fDeferredSETUPSessionId(0), fSessionBeingDescribed(NULL),
+    fQueuedResponse(NULL), fQueuedResponseSize(0), fQueuedResponseBytesSent(0), fQueuedResponseTimeoutTask(NULL) {
   resetRequestBuffer();
 }
 
@@ -351,9 +406,22 @@ RTSPServer::RTSPClientConnection::~RTSPClientConnection() {
     fOurRTSPServer.fClientConnectionsForHTTPTunneling->Remove(fOurSessionCookie);
     delete[] fOurSessionCookie;
   }
+
+  if (fSessionBeingDescribed != NULL) {
+    // We were still waiting for this session's SDP description to be prepared.  Stop waiting, and release the session:
+    fSessionBeingDescribed->cancelSDPDescriptionPreparation(this);
+    fSessionBeingDescribed->decrementReferenceCount();
+    if (fSessionBeingDescribed->referenceCount() == 0 && fSessionBeingDescribed->deleteWhenUnreferenced()) {
+      fOurServer.removeServerMediaSession(fSessionBeingDescribed);
+    }
+  }
   
+  envir().taskScheduler().unscheduleDelayedTask(fQueuedResponseTimeoutTask);
+  delete[] fQueuedResponse;
+
   closeSocketsRTSP();
   delete[] fCurrentCSeq;
+  delete fRequestTokens;
 }
 
 // Handler routines for specific RTSP commands:
@@ -397,6 +465,7 @@ void RTSPServer::RTSPClientConnection
   // for "application/sdp", because that's what we're sending back #####
     
   // Begin by looking up the "ServerMediaSession" object for the specified "urlTotalSuffix":
+  beginAsyncOperation();
   fOurServer.lookupServerMediaSession(urlTotalSuffix, DESCRIBELookupCompletionFunction, this);
 }
 
@@ -404,23 +473,42 @@ void RTSPServer::RTSPClientConnection
 ::DESCRIBELookupCompletionFunction(void* clientData, ServerMediaSession* sessionLookedUp) {
   RTSPServer::RTSPClientConnection* connection = (RTSPServer::RTSPClientConnection*)clientData;
   connection->handleCmd_DESCRIBE_afterLookup(sessionLookedUp);
+  connection->endAsyncOperation();
 }
 
 void RTSPServer::RTSPClientConnection
 ::handleCmd_DESCRIBE_afterLookup(ServerMediaSession* session) {
+  if (session == NULL) {
+    handleCmd_notFound();
+    return;
+  }
+
+  // Increment the "ServerMediaSession" object's reference count, in case someone removes it
+  // while we're using it:
+  session->incrementReferenceCount();
+
+  // Then, make sure that the SDP description for this session can be generated without blocking.
+  // (This might require reading from a file, in which case we'll continue handling the command later.)
+  fSessionBeingDescribed = session;
+  beginAsyncOperation();
+  session->prepareSDPDescription(fAddressFamily, DESCRIBEPreparationCompletionFunction, this);
+}
+
+void RTSPServer::RTSPClientConnection::DESCRIBEPreparationCompletionFunction(void* clientData) {
+  RTSPServer::RTSPClientConnection* connection = (RTSPServer::RTSPClientConnection*)clientData;
+  ServerMediaSession* session = connection->fSessionBeingDescribed;
+  connection->fSessionBeingDescribed = NULL;
+
+  connection->handleCmd_DESCRIBE_afterPreparation(session);
+  connection->endAsyncOperation();
+}
+
+void RTSPServer::RTSPClientConnection
+::handleCmd_DESCRIBE_afterPreparation(ServerMediaSession* session) {
   char* sdpDescription = NULL;
   char* rtspURL = NULL;
   do {
-    if (session == NULL) {
-      handleCmd_notFound();
-      break;
-    }
-    
-    // Increment the "ServerMediaSession" object's reference count, in case someone removes it
-    // while we're using it:
-    session->incrementReferenceCount();
-
-    // Then, assemble a SDP description for this session:
+    // Assemble a SDP description for this session:
     sdpDescription = session->generateSDPDescription(fAddressFamily);
     if (sdpDescription == NULL) {
       // This usually means that a file name that was specified for a
@@ -448,38 +536,25 @@ void RTSPServer::RTSPClientConnection
 	     sdpDescription);
   } while (0);
   
-  if (session != NULL) {
-    // Decrement its reference count, now that we're done using it:
-    session->decrementReferenceCount();
-    if (session->referenceCount() == 0 && session->deleteWhenUnreferenced()) {
-      fOurServer.removeServerMediaSession(session);
-    }
+  // Decrement the session's reference count, now that we're done using it:
+  session->decrementReferenceCount();
+  if (session->referenceCount() == 0 && session->deleteWhenUnreferenced()) {
+    fOurServer.removeServerMediaSession(session);
   }
 
   delete[] sdpDescription;
   delete[] rtspURL;
 }
 
-static void lookForHeader(char const* headerName, char const* source, unsigned sourceLen, char* resultStr, unsigned resultMaxSize) {
+static void copyHeaderValue(RTSPRequestTokenizer const& request, char const* headerName,
+			    char* resultStr, unsigned resultMaxSize) {
   resultStr[0] = '\0';  // by default, return an empty string
-  unsigned headerNameLen = strlen(headerName);
-  for (int i = 0; i < (int)(sourceLen-headerNameLen); ++i) {
-    if (strncmp(&source[i], headerName, headerNameLen) == 0 && source[i+headerNameLen] == ':') {
-      // We found the header.  Skip over any whitespace, then copy the rest of the line to "resultStr":
-      for (i += headerNameLen+1; i < (int)sourceLen && (source[i] == ' ' || source[i] == '\t'); ++i) {}
-      for (unsigned j = i; j < sourceLen; ++j) {
-	if (source[j] == '\r' || source[j] == '\n') {
-	  // We've found the end of the line.  Copy it to the result (if it will fit):
-	  if (j-i+1 > resultMaxSize) return; // it wouldn't fit
-	  char const* resultSource = &source[i];
-	  char const* resultSourceEnd = &source[j];
-	  while (resultSource < resultSourceEnd) *resultStr++ = *resultSource++;
-	  *resultStr = '\0';
-	  return;
-	}
-      }
-    }
-  }
+  unsigned valueLen;
+  char const* value = request.lookupHeader(headerName, valueLen);
+  if (value == NULL || valueLen+1 > resultMaxSize) return; // not found, or it wouldn't fit
+
+  memmove(resultStr, value, valueLen);
+  resultStr[valueLen] = '\0';
 }
 
 void RTSPServer::RTSPClientConnection::handleCmd_bad() {
@@ -567,8 +642,8 @@ Boolean RTSPServer::RTSPClientConnection::parseHTTPRequestString(char* resultCmd
   urlSuffix[n] = '\0';
   
   // Look for various headers that we're interested in:
-  lookForHeader("x-sessioncookie", &reqStr[i], reqStrSize-i, sessionCookie, sessionCookieMaxSize);
-  lookForHeader("Accept", &reqStr[i], reqStrSize-i, acceptStr, acceptStrMaxSize);
+  copyHeaderValue(*fRequestTokens, "x-sessioncookie", sessionCookie, sessionCookieMaxSize);
+  copyHeaderValue(*fRequestTokens, "Accept", acceptStr, acceptStrMaxSize);
   
   return True;
 }
@@ -652,16 +727,232 @@ Boolean RTSPServer::RTSPClientConnection
   return True;
 }
 
-void RTSPServer::RTSPClientConnection::handleHTTPCmd_StreamingGET(char const* /*urlSuffix*/, char const* /*fullRequestStr*/) {
-  // By default, we don't support requests to access streams via HTTP:
-  handleHTTPCmd_notSupported();
+void RTSPServer::RTSPClientConnection::handleHTTPCmd_StreamingGET(char const* urlSuffix, char const* /*fullRequestStr*/) {
+  // If metrics (and access to them over HTTP) have been enabled, then a "GET /metrics" request returns them.
+  // (But not if we use authentication - because we can't authenticate HTTP clients - or TLS.)
+  MetricsRegistry* metricsRegistry = MetricsRegistry::lookup(envir());
+  if (metricsRegistry != NULL && fOurRTSPServer.fMetricsOverHTTPIsEnabled && strcmp(urlSuffix, "metrics") == 0) {
+    if (fOurRTSPServer.fAuthDB != NULL || fOutputTLS->isNeeded) {
+      handleHTTPCmd_notSupported();
+    } else {
+      handleHTTPCmd_metrics(*metricsRegistry);
+    }
+    return;
+  }
+
+  // Otherwise, unless it has been enabled, we don't support requests to access streams via HTTP.
+  // (We also can't authenticate HTTP clients, or - yet - stream to them over TLS.)
+  if (!fOurRTSPServer.fHTTPStreamingIsEnabled || fOurRTSPServer.fAuthDB != NULL || fOutputTLS->isNeeded) {
+    handleHTTPCmd_notSupported();
+    return;
+  }
+
+  // Begin by looking up the "ServerMediaSession" object for the specified stream:
+  beginAsyncOperation();
+  fOurServer.lookupServerMediaSession(urlSuffix, StreamingGETLookupCompletionFunction, this);
+}
+
+void RTSPServer::RTSPClientConnection
+::StreamingGETLookupCompletionFunction(void* clientData, ServerMediaSession* sessionLookedUp) {
+  RTSPServer::RTSPClientConnection* connection = (RTSPServer::RTSPClientConnection*)clientData;
+  connection->handleHTTPCmd_StreamingGET_afterLookup(sessionLookedUp);
+  connection->endAsyncOperation();
+}
+
+void RTSPServer::RTSPClientConnection::handleHTTPCmd_StreamingGET_afterLookup(ServerMediaSession* session) {
+  if (session == NULL) {
+    handleHTTPCmd_notFound();
+    return;
+  }
+
+  HTTPStreamer* streamer = fOurRTSPServer.getHTTPStreamer(*session);
+  if (streamer == NULL) {
+    // None of the session's subsessions can be streamed this way (perhaps because their inputs can't be read more than once):
+    handleHTTPCmd_notSupported();
+    return;
+  }
+
+  // Hand our socket over to the streamer, which sends our response (and then the stream):
+  envir().taskScheduler().disableBackgroundHandling(fClientInputSocket);
+  streamer->addClient(fClientOutputSocket);
+  fClientInputSocket = fClientOutputSocket = -1; // so the socket doesn't get closed when we get deleted
+
+  fResponseBuffer[0] = '\0'; // because our response will be sent by the streamer
+  fIsActive = False; // triggers deletion of ourself after we've handled the request
+}
+
+void RTSPServer::RTSPClientConnection::handleHTTPCmd_metrics(MetricsRegistry& metricsRegistry) {
+  // The response body can be much larger than "fResponseBuffer", so we queue the whole response (to be sent without
+  // blocking), and leave "fResponseBuffer" empty:
+  char* body = metricsRegistry.generatePrometheusText();
+  unsigned const bodySize = strlen(body);
+
+  char header[200];
+  snprintf(header, sizeof header,
+	   "HTTP/1.0 200 OK\r\n"
+	   "%s"
+	   "Content-Type: text/plain; version=0.0.4\r\n"
+	   "Content-Length: %u\r\n"
+	   "Cache-Control: no-cache\r\n"
+	   "\r\n",
+	   dateHeader(), bodySize);
+  unsigned const headerSize = strlen(header);
+
+  unsigned const responseSize = headerSize + bodySize;
+  char* response = new char[responseSize];
+  memcpy(response, header, headerSize);
+  memcpy(&response[headerSize], body, bodySize);
+  delete[] body;
+
+  fResponseBuffer[0] = '\0'; // because we're sending our response ourself
+  fIsActive = False; // triggers deletion of ourself once we've sent our response (as for HTTP/1.0)
+  queueResponse(response, responseSize);
 }
 
 void RTSPServer::RTSPClientConnection::resetRequestBuffer() {
   ClientConnection::resetRequestBuffer();
   
-  fLastCRLF = &fRequestBuffer[-3]; // hack: Ensures that we don't think we have end-of-msg if the data starts with <CR><LF>
+  fLastCRLF = NULL; // (no <CR><LF> seen yet) Ensures that we don't think we have end-of-msg if the data starts with <CR><LF>
   fBase64RemainderCount = 0;
+  fRequestTokens->reset();
+}
+
+RTSPRequestTokenizer const& RTSPServer::RTSPClientConnection
+::tokenizedRequest(char const* fullRequestStr, RTSPRequestTokenizer& tmpTokens) {
+  if (fullRequestStr == fRequestTokens->msgStr()) return *fRequestTokens; // the usual case: we've already parsed it
+
+  tmpTokens.tokenize(fullRequestStr, strlen(fullRequestStr));
+  return tmpTokens;
+}
+
+void RTSPServer::RTSPClientConnection::sendResponse() {
+#ifdef DEBUG
+  fprintf(stderr, "sending response: %s", fResponseBuffer);
+#endif
+  unsigned const numBytesToWrite = strlen((char*)fResponseBuffer);
+  if (numBytesToWrite == 0) {
+    // Our response (if any) has already been sent
+  } else if (fOutputTLS->isNeeded) {
+    fOutputTLS->write((char const*)fResponseBuffer, numBytesToWrite);
+  } else {
+    send(fClientOutputSocket, (char const*)fResponseBuffer, numBytesToWrite, MSG_NOSIGNAL);
+  }
+}
+
+#define QUEUED_RESPONSE_TIMEOUT_SECONDS 10 // how long we keep trying to send a queued response to a slow client
+
+void RTSPServer::RTSPClientConnection::queueResponse(char* response, unsigned responseSize) {
+  delete[] fQueuedResponse;
+  fQueuedResponse = response;
+  fQueuedResponseSize = responseSize;
+  fQueuedResponseBytesSent = 0;
+
+  if (sendQueuedResponse()) {
+    finishQueuedResponse(); // the usual case: we've already sent it all
+  } else {
+    // Send the rest as our socket becomes writable (replacing our handling of incoming requests, because this is our final
+    // response), but don't wait forever for a client that has stopped reading:
+    envir().taskScheduler().setBackgroundHandling(fClientOutputSocket, SOCKET_WRITABLE|SOCKET_EXCEPTION,
+						  queuedResponseHandler, this);
+    fQueuedResponseTimeoutTask
+      = envir().taskScheduler().scheduleDelayedTask(QUEUED_RESPONSE_TIMEOUT_SECONDS*1000000, queuedResponseTimeout, this);
+  }
+}
+
+Boolean RTSPServer::RTSPClientConnection::sendQueuedResponse() {
+  while (fQueuedResponseBytesSent < fQueuedResponseSize) {
+    char const* data = &fQueuedResponse[fQueuedResponseBytesSent];
+    unsigned const numBytesToSend = fQueuedResponseSize - fQueuedResponseBytesSent;
+    int result;
+    if (fOutputTLS->isNeeded) {
+      result = fOutputTLS->tryWrite(data, numBytesToSend);
+    } else {
+      result = send(fClientOutputSocket, data, numBytesToSend, MSG_NOSIGNAL);
+      if (result < 0) {
+	int const err = envir().getErrno();
+	if (err == EAGAIN || err == EWOULDBLOCK) result = 0;
+      }
+    }
+    if (result < 0) return True; // the client has gone away; give up
+    if (result == 0) return False; // the socket's send buffer is full; we'll try again when it becomes writable
+
+    fQueuedResponseBytesSent += result;
+  }
+
+  return True;
+}
+
+void RTSPServer::RTSPClientConnection::queuedResponseHandler(void* instance, int /*mask*/) {
+  RTSPClientConnection* connection = (RTSPClientConnection*)instance;
+  if (connection->sendQueuedResponse()) connection->finishQueuedResponse();
+}
+
+void RTSPServer::RTSPClientConnection::queuedResponseTimeout(void* instance) {
+  RTSPClientConnection* connection = (RTSPClientConnection*)instance;
+  connection->fQueuedResponseTimeoutTask = NULL;
+  connection->finishQueuedResponse(); // without sending the rest of the response
+}
+
+void RTSPServer::RTSPClientConnection::finishQueuedResponse() {
+  envir().taskScheduler().unscheduleDelayedTask(fQueuedResponseTimeoutTask);
+  delete[] fQueuedResponse; fQueuedResponse = NULL;
+
+  // If we're no longer handling requests, then we can now be deleted (unless we're called from within
+  // "processRequestBytes()", which will then delete us):
+  if (!fIsActive && fScheduledDelayedTask <= 0 && fNumPendingOperations == 0 && fRecursionCount == 0) {
+    delete this;
+  }
+}
+
+void RTSPServer::RTSPClientConnection::endAsyncOperation() {
+  if (--fNumPendingOperations == 0 && fResponseIsDeferred) sendDeferredResponse();
+}
+
+void RTSPServer::RTSPClientConnection::pauseRequestReading() {
+  // Stop reading our input socket - unless it's also being used for RTP/RTCP-over-TCP streaming (in which case it's
+  // being read by "RTPInterface", and we'll continue to receive - and hold - any request bytes, one at a time):
+  if (fOurRTSPServer.fTCPStreamingDatabase->Lookup((char const*)(intptr_t)fClientInputSocket) == NULL) {
+    envir().taskScheduler().disableBackgroundHandling(fClientInputSocket);
+    fRequestReadingIsPaused = True;
+  }
+}
+
+void RTSPServer::RTSPClientConnection::resumeRequestReading() {
+  if (fRequestReadingIsPaused) {
+    envir().taskScheduler().setBackgroundHandling(fClientInputSocket, SOCKET_READABLE|SOCKET_EXCEPTION,
+						  incomingRequestHandler, this);
+    fRequestReadingIsPaused = False;
+  }
+}
+
+void RTSPServer::RTSPClientConnection::sendDeferredResponse() {
+  fResponseIsDeferred = False;
+  if (fIsActive) {
+    resumeRequestReading();
+    sendResponse();
+
+    if (fDeferredSETUPSessionId != 0) {
+      // Check whether the client asked for streaming to commence now (as in "processRequestBytes()"):
+      RTSPServer::RTSPClientSession* clientSession
+	= (RTSPServer::RTSPClientSession*)(fOurRTSPServer.lookupClientSession(fDeferredSETUPSessionId));
+      if (clientSession != NULL && clientSession->fStreamAfterSETUP) {
+	clientSession->handleCmd_withinSession(this, "PLAY", clientSession->fURLPreSuffix, clientSession->fURLSuffix,
+					       (char const*)fRequestBuffer);
+      }
+      fDeferredSETUPSessionId = 0;
+    }
+  }
+
+  // Then handle any request bytes that we received after the deferred request (as in "processRequestBytes()"):
+  int numBytesRemaining = fRequestBytesAlreadySeen - fDeferredRequestSize;
+  unsigned const requestSize = fDeferredRequestSize;
+  resetRequestBuffer();
+  if (fIsActive && numBytesRemaining > 0) {
+    memmove(fRequestBuffer, &fRequestBuffer[requestSize], numBytesRemaining);
+    processRequestBytes(numBytesRemaining, numBytesRemaining); // Note: This might delete us
+  } else if (!fIsActive && fScheduledDelayedTask <= 0 && fRecursionCount == 0 && fQueuedResponse == NULL) {
+    delete this;
+  }
 }
 
 void RTSPServer::RTSPClientConnection::closeSocketsRTSP() {
@@ -700,7 +991,24 @@ void RTSPServer::RTSPClientConnection::handleAlternativeRequestByte1(u_int8_t re
 }
 
 void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
-  int numBytesRemaining = 0;
+  if (!fResponseIsDeferred) {
+    processRequestBytes(newBytesRead, 0);
+    return;
+  }
+
+  // We haven't yet responded to a previous request, so just hold on to these bytes until we have:
+  if (newBytesRead < 0 || (unsigned)newBytesRead >= fRequestBufferBytesLeft) {
+    // Either the client socket has died, or the request was too big for us.
+    // Terminate this connection (once the previous request's handling has completed):
+    fIsActive = False;
+    envir().taskScheduler().disableBackgroundHandling(fClientInputSocket);
+  } else {
+    fRequestBytesAlreadySeen += newBytesRead;
+    fRequestBufferBytesLeft -= newBytesRead;
+  }
+}
+
+void RTSPServer::RTSPClientConnection::processRequestBytes(int newBytesRead, int numBytesRemaining) {
   ++fRecursionCount;
   
   do {
@@ -742,36 +1050,30 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
       unsigned newBase64RemainderCount = numBytesToDecode%4;
       numBytesToDecode -= newBase64RemainderCount;
       if (numBytesToDecode > 0) {
-	ptr[newBytesRead] = '\0';
-	unsigned decodedSize;
-	unsigned char* decodedBytes = base64Decode((char const*)(ptr-fBase64RemainderCount), numBytesToDecode, decodedSize);
+	// Decode the new bytes in place (we can do this because there are fewer decoded bytes than original):
+	unsigned char* to = ptr-fBase64RemainderCount;
+	unsigned decodedSize = base64DecodeInto((char const*)to, numBytesToDecode, to);
 #ifdef DEBUG
 	fprintf(stderr, "Base64-decoded %d input bytes into %d new bytes:", numBytesToDecode, decodedSize);
-	for (unsigned k = 0; k < decodedSize; ++k) fprintf(stderr, "%c", decodedBytes[k]);
+	for (unsigned k = 0; k < decodedSize; ++k) fprintf(stderr, "%c", to[k]);
 	fprintf(stderr, "\n");
 #endif
 	
-	// Copy the new decoded bytes in place of the old ones (we can do this because there are fewer decoded bytes than original):
-	unsigned char* to = ptr-fBase64RemainderCount;
-	for (unsigned i = 0; i < decodedSize; ++i) *to++ = decodedBytes[i];
-	
 	// Then copy any remaining (undecoded) bytes to the end:
-	for (unsigned j = 0; j < newBase64RemainderCount; ++j) *to++ = (ptr-fBase64RemainderCount+numBytesToDecode)[j];
+	memmove(&to[decodedSize], &to[numBytesToDecode], newBase64RemainderCount);
 	
 	newBytesRead = decodedSize - fBase64RemainderCount + newBase64RemainderCount;
 	  // adjust to allow for the size of the new decoded data (+ remainder)
-	delete[] decodedBytes;
       }
       fBase64RemainderCount = newBase64RemainderCount;
     }
     
-    unsigned char* tmpPtr = fLastCRLF + 2;
+    unsigned char* tmpPtr = fLastCRLF == NULL ? fRequestBuffer : fLastCRLF + 2;
     if (fBase64RemainderCount == 0) { // no more Base-64 bytes remain to be read/decoded
       // Look for the end of the message: <CR><LF><CR><LF>
-      if (tmpPtr < fRequestBuffer) tmpPtr = fRequestBuffer;
       while (tmpPtr < &ptr[newBytesRead-1]) {
 	if (*tmpPtr == '\r' && *(tmpPtr+1) == '\n') {
-	  if (tmpPtr - fLastCRLF == 2) { // This is it:
+	  if (fLastCRLF != NULL && tmpPtr - fLastCRLF == 2) { // This is it:
 	    endOfMsg = True;
 	    break;
 	  }
@@ -796,15 +1098,16 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
     unsigned contentLength = 0;
     Boolean urlIsRTSPS;
     Boolean playAfterSetup = False;
-    fLastCRLF[2] = '\0'; // temporarily, for parsing
-    Boolean parseSucceeded = parseRTSPRequestString((char*)fRequestBuffer, fLastCRLF+2 - fRequestBuffer,
+    // We parse the request's header just once - into its command, URL and header fields - and these 'tokens' are then
+    // also used (without copying or rescanning the request) by the command handlers:
+    fRequestTokens->tokenize((char const*)fRequestBuffer, fLastCRLF+4 - fRequestBuffer);
+    Boolean parseSucceeded = parseRTSPRequestString(*fRequestTokens,
 						    cmdName, sizeof cmdName,
 						    urlPreSuffix, sizeof urlPreSuffix,
 						    urlSuffix, sizeof urlSuffix,
 						    cseq, sizeof cseq,
 						    sessionIdStr, sizeof sessionIdStr,
 						    contentLength, urlIsRTSPS);
-    fLastCRLF[2] = '\r'; // restore its value
     // Check first for a bogus "Content-Length" value that would cause a pointer wraparound:
     if (tmpPtr + 2 + contentLength < tmpPtr + 2) {
 #ifdef DEBUG
@@ -983,15 +1286,18 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
       }
     }
     
-#ifdef DEBUG
-    fprintf(stderr, "sending response: %s", fResponseBuffer);
-#endif
-    unsigned const numBytesToWrite = strlen((char*)fResponseBuffer);
-    if (fOutputTLS->isNeeded) {
-        fOutputTLS->write((char const*)fResponseBuffer, numBytesToWrite);
-    } else {
-        send(fClientOutputSocket, (char const*)fResponseBuffer, numBytesToWrite, MSG_NOSIGNAL);
-   }
+    if (fNumPendingOperations > 0) {
+      // The command is still being handled (asynchronously).  We'll send our response - and handle any subsequent
+      // (pipelined) requests - once it's done (see "sendDeferredResponse()").  Until then, we stop reading new requests:
+      fResponseIsDeferred = True;
+      fDeferredRequestSize = (fLastCRLF+4-fRequestBuffer) + contentLength;
+      fDeferredSETUPSessionId
+	= clientSession != NULL && strcmp(cmdName, "SETUP") == 0 ? clientSession->fOurSessionId : 0;
+      pauseRequestReading();
+      break;
+    }
+
+    sendResponse();
     
     if (playAfterSetup) {
       // The client has asked for streaming to commence now, rather than after a
@@ -1013,7 +1319,9 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
   
   --fRecursionCount;
   // If it has a scheduledDelayedTask, don't delete the instance or close the sockets. The sockets can be reused in the task.
-  if (!fIsActive && fScheduledDelayedTask <= 0) {
+  // (Similarly, if a command is still being handled asynchronously, or a queued response is still being sent, then
+  // we'll get deleted once it's done.)
+  if (!fIsActive && fScheduledDelayedTask <= 0 && fNumPendingOperations == 0 && fQueuedResponse == NULL) {
     if (fRecursionCount > 0) closeSockets(); else delete this;
     // Note: The "fRecursionCount" test is for a pathological situation where we reenter the event loop and get called recursively
     // while handling a command (e.g., while handling a "DESCRIBE", to get a SDP description).
@@ -1023,7 +1331,7 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
 
 #define SKIP_WHITESPACE while (*fields != '\0' && (*fields == ' ' || *fields == '\t')) ++fields
 
-static Boolean parseAuthorizationHeader(char const* buf,
+static Boolean parseAuthorizationHeader(RTSPRequestTokenizer const& request,
 					char const*& username,
 					char const*& realm,
 					char const*& nonce, char const*& uri,
@@ -1031,15 +1339,13 @@ static Boolean parseAuthorizationHeader(char const* buf,
   // Initialize the result parameters to default values:
   username = realm = nonce = uri = response = NULL;
   
-  // First, find "Authorization:"
-  while (1) {
-    if (*buf == '\0') return False; // not found
-    if (_strncasecmp(buf, "Authorization: Digest ", 22) == 0) break;
-    ++buf;
-  }
+  // First, find "Authorization: Digest "
+  unsigned valueLen;
+  char const* buf = request.lookupHeader("Authorization", valueLen);
+  if (buf == NULL || valueLen < 7 || _strncasecmp(buf, "Digest ", 7) != 0) return False; // not found
   
   // Then, run through each of the fields, looking for ones we handle:
-  char const* fields = buf + 22;
+  char const* fields = buf + 7;
   char* parameter = strDupSize(fields);
   char* value = strDupSize(fields);
   char* p;
@@ -1104,7 +1410,8 @@ Boolean RTSPServer::RTSPClientConnection
     // Next, the request needs to contain an "Authorization:" header,
     // containing a username, (our) realm, (our) nonce, uri,
     // and response string:
-    if (!parseAuthorizationHeader(fullRequestStr,
+    RTSPRequestTokenizer tmpTokens;
+    if (!parseAuthorizationHeader(tokenizedRequest(fullRequestStr, tmpTokens),
 				  username, realm, nonce, uri, response)
 	|| username == NULL
 	|| realm == NULL || strcmp(realm, fCurrentAuthenticator.realm()) != 0
@@ -1256,11 +1563,28 @@ RTSPServer::RTSPClientSession
 ::RTSPClientSession(RTSPServer& ourServer, u_int32_t sessionId)
   : GenericMediaServer::ClientSession(ourServer, sessionId),
     fOurRTSPServer(ourServer), fIsMulticast(False), fStreamAfterSETUP(False),
-    fTCPStreamIdCount(0), fNumStreamStates(0), fStreamStates(NULL) {
+    fTCPStreamIdCount(0), fNumStreamStates(0), fStreamStates(NULL),
+    fOurClientConnection(NULL), fURLPreSuffix(NULL), fURLSuffix(NULL), fFullRequestStr(NULL), fTrackId(NULL),
+    fPendingSETUPLookup(NULL) {
 }
 
+// The 'client data' for a stream lookup made by "SETUP".  We don't pass the "RTSPClientSession" itself, because the
+// session might get deleted (e.g., by a liveness timeout, or a "TEARDOWN" on another connection) before the lookup
+// completes.  If that happens, the session's destructor clears "fSession", and the lookup's result gets ignored.
+class SETUPLookupState {
+public:
+  SETUPLookupState(RTSPServer::RTSPClientSession* session, RTSPServer::RTSPClientConnection* connection)
+    : fSession(session), fConnection(connection) {
+  }
+
+  RTSPServer::RTSPClientSession* fSession;
+  RTSPServer::RTSPClientConnection* fConnection;
+};
+
 RTSPServer::RTSPClientSession::~RTSPClientSession() {
+  if (fPendingSETUPLookup != NULL) fPendingSETUPLookup->fSession = NULL; // see above
   reclaimStreamStates();
+  delete[] fURLPreSuffix; delete[] fURLSuffix;
 }
 
 void RTSPServer::RTSPClientSession::deleteStreamByTrack(unsigned trackNum) {
@@ -1298,7 +1622,7 @@ typedef enum StreamingMode {
   RAW_UDP
 } StreamingMode;
 
-static void parseTransportHeader(char const* buf,
+static void parseTransportHeader(RTSPRequestTokenizer const& request,
 				 StreamingMode& streamingMode,
 				 char*& streamingModeString,
 				 char*& destinationAddressStr,
@@ -1321,16 +1645,10 @@ static void parseTransportHeader(char const* buf,
   unsigned ttl, rtpCid, rtcpCid;
   
   // First, find "Transport:"
-  while (1) {
-    if (*buf == '\0') return; // not found
-    if (*buf == '\r' && *(buf+1) == '\n' && *(buf+2) == '\r') return; // end of the headers => not found
-    if (_strncasecmp(buf, "Transport:", 10) == 0) break;
-    ++buf;
-  }
+  char const* fields = request.lookupHeader("Transport");
+  if (fields == NULL) return; // not found
   
   // Then, run through each of the fields, looking for ones we handle:
-  char const* fields = buf + 10;
-  while (*fields == ' ') ++fields;
   char* field = strDupSize(fields);
   while (sscanf(fields, "%[^;\r\n]", field) == 1) {
     if (strcmp(field, "RTP/AVP/TCP") == 0) {
@@ -1362,17 +1680,6 @@ static void parseTransportHeader(char const* buf,
   delete[] field;
 }
 
-static Boolean parsePlayNowHeader(char const* buf) {
-  // Find "x-playNow:" header, if present
-  while (1) {
-    if (*buf == '\0') return False; // not found
-    if (_strncasecmp(buf, "x-playNow:", 10) == 0) break;
-    ++buf;
-  }
-  
-  return True;
-}
-
 void RTSPServer::RTSPClientSession
 ::handleCmd_SETUP(RTSPServer::RTSPClientConnection* ourClientConnection,
 		  char const* urlPreSuffix, char const* urlSuffix, char const* fullRequestStr) {
@@ -1382,19 +1689,34 @@ void RTSPServer::RTSPClientSession
   //    "urlPreSuffix" is empty and "urlSuffix" is the session (stream) name, or
   //    "urlPreSuffix" concatenated with "urlSuffix" (with "/" inbetween) is the session (stream) name.
   fOurClientConnection = ourClientConnection;
-  fURLPreSuffix = urlPreSuffix; fURLSuffix = urlSuffix; fFullRequestStr = fullRequestStr;
-  fTrackId = urlSuffix; // in the normal case
+  delete[] fURLPreSuffix; fURLPreSuffix = strDup(urlPreSuffix);
+  delete[] fURLSuffix; fURLSuffix = strDup(urlSuffix);
+  fFullRequestStr = fullRequestStr;
+  fTrackId = fURLSuffix; // in the normal case
 
   // Begin by checking whether the specified stream name exists:
-  char const* streamName = urlPreSuffix; // in the normal case
-  fOurServer.lookupServerMediaSession(streamName, SETUPLookupCompletionFunction1, this,
+  char const* streamName = fURLPreSuffix; // in the normal case
+  ourClientConnection->beginAsyncOperation();
+  fPendingSETUPLookup = new SETUPLookupState(this, ourClientConnection);
+  fOurServer.lookupServerMediaSession(streamName, SETUPLookupCompletionFunction1, fPendingSETUPLookup,
 				      fOurServerMediaSession == NULL);
 }
 
 void RTSPServer::RTSPClientSession
 ::SETUPLookupCompletionFunction1(void* clientData, ServerMediaSession* sessionLookedUp) {
-  RTSPServer::RTSPClientSession* session = (RTSPServer::RTSPClientSession*)clientData;
-  session->handleCmd_SETUP_afterLookup1(sessionLookedUp);
+  SETUPLookupState* lookup = (SETUPLookupState*)clientData;
+  RTSPServer::RTSPClientSession* session = lookup->fSession;
+  RTSPServer::RTSPClientConnection* ourClientConnection = lookup->fConnection;
+  delete lookup;
+
+  if (session == NULL) {
+    // Our client session was deleted while the lookup was outstanding:
+    ourClientConnection->handleCmd_sessionNotFound();
+  } else {
+    session->fPendingSETUPLookup = NULL;
+    session->handleCmd_SETUP_afterLookup1(sessionLookedUp);
+  }
+  ourClientConnection->endAsyncOperation();
 }
 
 void RTSPServer::RTSPClientSession
@@ -1419,15 +1741,28 @@ void RTSPServer::RTSPClientSession
   fTrackId = NULL;
       
   // Check again:
-  fOurServer.lookupServerMediaSession(streamName, SETUPLookupCompletionFunction2, this,
+  fOurClientConnection->beginAsyncOperation();
+  fPendingSETUPLookup = new SETUPLookupState(this, fOurClientConnection);
+  fOurServer.lookupServerMediaSession(streamName, SETUPLookupCompletionFunction2, fPendingSETUPLookup,
 				      fOurServerMediaSession == NULL);
   delete[] concatenatedStreamName;
 }
 
 void RTSPServer::RTSPClientSession
 ::SETUPLookupCompletionFunction2(void* clientData, ServerMediaSession* sessionLookedUp) {
-  RTSPServer::RTSPClientSession* session = (RTSPServer::RTSPClientSession*)clientData;
-  session->handleCmd_SETUP_afterLookup2(sessionLookedUp);
+  SETUPLookupState* lookup = (SETUPLookupState*)clientData;
+  RTSPServer::RTSPClientSession* session = lookup->fSession;
+  RTSPServer::RTSPClientConnection* ourClientConnection = lookup->fConnection;
+  delete lookup;
+
+  if (session == NULL) {
+    // Our client session was deleted while the lookup was outstanding:
+    ourClientConnection->handleCmd_sessionNotFound();
+  } else {
+    session->fPendingSETUPLookup = NULL;
+    session->handleCmd_SETUP_afterLookup2(sessionLookedUp);
+  }
+  ourClientConnection->endAsyncOperation();
 }
 
 void RTSPServer::RTSPClientSession
@@ -1521,7 +1856,9 @@ void RTSPServer::RTSPClientSession
     u_int8_t clientsDestinationTTL;
     portNumBits clientRTPPortNum, clientRTCPPortNum;
     unsigned char rtpChannelId, rtcpChannelId;
-    parseTransportHeader(fFullRequestStr, streamingMode, streamingModeString,
+    RTSPRequestTokenizer tmpTokens;
+    RTSPRequestTokenizer const& request = fOurClientConnection->tokenizedRequest(fFullRequestStr, tmpTokens);
+    parseTransportHeader(request, streamingMode, streamingModeString,
 			 clientsDestinationAddressStr, clientsDestinationTTL,
 			 clientRTPPortNum, clientRTCPPortNum,
 			 rtpChannelId, rtcpChannelId);
@@ -1544,10 +1881,10 @@ void RTSPServer::RTSPClientSession
     double rangeStart = 0.0, rangeEnd = 0.0;
     char* absStart = NULL; char* absEnd = NULL;
     Boolean startTimeIsNow;
-    if (parseRangeHeader(fFullRequestStr, rangeStart, rangeEnd, absStart, absEnd, startTimeIsNow)) {
+    if (parseRangeHeader(request, rangeStart, rangeEnd, absStart, absEnd, startTimeIsNow)) {
       delete[] absStart; delete[] absEnd;
       fStreamAfterSETUP = True;
-    } else if (parsePlayNowHeader(fFullRequestStr)) {
+    } else if (request.lookupHeader("x-playNow") != NULL) {
       fStreamAfterSETUP = True;
     } else {
       fStreamAfterSETUP = False;
@@ -1785,9 +2122,12 @@ void RTSPServer::RTSPClientSession
     = fOurRTSPServer.rtspURL(fOurServerMediaSession, ourClientConnection->fClientInputSocket);
   unsigned rtspURLSize = strlen(rtspURL);
   
+  RTSPRequestTokenizer tmpTokens;
+  RTSPRequestTokenizer const& request = ourClientConnection->tokenizedRequest(fullRequestStr, tmpTokens);
+
   // Parse the client's "Scale:" header, if any:
   float scale;
-  Boolean sawScaleHeader = parseScaleHeader(fullRequestStr, scale);
+  Boolean sawScaleHeader = parseScaleHeader(request, scale);
   
   // Try to set the stream's scale factor to this value:
   if (subsession == NULL /*aggregate op*/) {
@@ -1811,7 +2151,7 @@ void RTSPServer::RTSPClientSession
   char* absStart = NULL; char* absEnd = NULL;
   Boolean startTimeIsNow;
   Boolean sawRangeHeader
-    = parseRangeHeader(fullRequestStr, rangeStart, rangeEnd, absStart, absEnd, startTimeIsNow);
+    = parseRangeHeader(request, rangeStart, rangeEnd, absStart, absEnd, startTimeIsNow);
   
   if (sawRangeHeader && absStart == NULL/*not seeking by 'absolute' time*/) {
     // Use this information, plus the stream's duration (if known), to create our own "Range:" header, for the response:
@@ -22,7 +22,6 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "SRTPCryptographicContext.hh"
 #ifndef NO_OPENSSL
 #include "HMAC_SHA1.hh"
-#include <openssl/evp.h>
 #endif
 
 #ifdef DEBUG
@@ -38,18 +37,30 @@ SRTPCryptographicContext
     fSRTCPIndex(0) {
   // Begin by doing a key derivation, to generate the keying data that we need:
   performKeyDerivation();
+
+  // Then set up the OpenSSL state that we'll use with each packet:
+  setUpCipherState(fDerivedKeys.srtp);
+  setUpCipherState(fDerivedKeys.srtcp);
+  fHMACCtx = EVP_MD_CTX_create();
 #else
   {
 #endif
 }
 
 SRTPCryptographicContext::~SRTPCryptographicContext() {
+#ifndef NO_OPENSSL
+  EVP_MD_CTX_destroy(fHMACCtx);
+  freeCipherState(fDerivedKeys.srtcp);
+  freeCipherState(fDerivedKeys.srtp);
+#endif
 }
 
 Boolean SRTPCryptographicContext
 ::processIncomingSRTPPacket(u_int8_t* buffer, unsigned inPacketSize,
 			    unsigned& outPacketSize) {
 #ifndef NO_OPENSSL
+  if (weUseAESGCM()) return processIncomingSRTPPacketAEAD(buffer, inPacketSize, outPacketSize);
+
   do {
     if (inPacketSize < 12) { // For SRTP, 12 is the minimum packet size (if unauthenticated)
 #ifdef DEBUG
@@ -73,41 +84,8 @@ Boolean SRTPCryptographicContext
     u_int16_t const rtpSeqNum = (buffer[2]<<8)|buffer[3];
     u_int32_t nextROC, thisPacketsROC;
     u_int16_t nextHighRTPSeqNum;
+    computeIncomingROC(rtpSeqNum, thisPacketsROC, nextROC, nextHighRTPSeqNum);
 
-    if (!fHaveReceivedSRTPPackets) {
-      // First time:
-      nextROC = thisPacketsROC = fReceptionROC = fMIKEYState.initialROC();
-      nextHighRTPSeqNum = rtpSeqNum;
-      fHaveReceivedSRTPPackets = True; // for the future
-    } else {
-      // Check whether the sequence number has rolled over, or is out-of-order:
-      u_int16_t const SEQ_NUM_THRESHOLD = 0x1000;
-      if (rtpSeqNum >= fPreviousHighRTPSeqNum) {
-	// normal case, or out-of-order packet that crosses a rollover:
-	if (rtpSeqNum - fPreviousHighRTPSeqNum < SEQ_NUM_THRESHOLD) {
-	  // normal case:
-	  nextROC = thisPacketsROC = fReceptionROC;
-	  nextHighRTPSeqNum = rtpSeqNum;
-	} else {
-	  // out-of-order packet that crosses a rollover:
-	  nextROC = fReceptionROC;
-	  thisPacketsROC = fReceptionROC-1;
-	  nextHighRTPSeqNum = fPreviousHighRTPSeqNum;
-	}
-      } else {
-	// rollover, or out-of-order packet that crosses a rollover:
-	if (fPreviousHighRTPSeqNum - rtpSeqNum > SEQ_NUM_THRESHOLD) {
-	  // rollover:
-	  nextROC = thisPacketsROC = fReceptionROC+1;
-	  nextHighRTPSeqNum = rtpSeqNum;
-	} else {
-	  // out-of-order packet (that doesn't cross a rollover):
-	  nextROC = thisPacketsROC = fReceptionROC;
-	  nextHighRTPSeqNum = fPreviousHighRTPSeqNum;
-	}
-      }
-    }
-      
     if (weAuthenticate()) {
       // Authenticate the packet.
       unsigned const numBytesToAuthenticate
@@ -172,6 +150,8 @@ Boolean SRTPCryptographicContext
 ::processIncomingSRTCPPacket(u_int8_t* buffer, unsigned inPacketSize,
 			     unsigned& outPacketSize) {
 #ifndef NO_OPENSSL
+  if (weUseAESGCM()) return processIncomingSRTCPPacketAEAD(buffer, inPacketSize, outPacketSize);
+
   do {
     if (inPacketSize < 12) {
       // For SRTCP, 8 is the minumum RTCP packet size, but there's also a mandatory
@@ -240,6 +220,8 @@ Boolean SRTPCryptographicContext
 ::processOutgoingSRTPPacket(u_int8_t* buffer, unsigned inPacketSize,
 			    unsigned& outPacketSize) {
 #ifndef NO_OPENSSL
+  if (weUseAESGCM()) return processOutgoingSRTPPacketAEAD(buffer, inPacketSize, outPacketSize);
+
   do {
     unsigned const minRTPHeaderSize = 12;
     if (inPacketSize < minRTPHeaderSize) { // packet is too small
@@ -276,12 +258,7 @@ Boolean SRTPCryptographicContext
 
       // Figure out this packet's 'index' (ROC|rtpSeqNum):
       u_int16_t const rtpSeqNum = (buffer[2]<<8)|buffer[3];
-      if (!fHaveSentSRTPPackets) {
-	fHaveSentSRTPPackets = True; // for the future
-      } else {
-	if (rtpSeqNum == 0) ++fSendingROC; // increment the ROC when the RTP seq num rolls over
-      }
-      u_int64_t index = (fSendingROC<<16)|rtpSeqNum;
+      u_int64_t index = ((u_int64_t)computeOutgoingROC(rtpSeqNum)<<16)|rtpSeqNum;
 
       unsigned const numEncryptedBytes = inPacketSize - offsetToEncryptedBytes; // ASSERT: >= 0
       u_int32_t const SSRC = (buffer[8]<<24)|(buffer[9]<<16)|(buffer[10]<<8)|buffer[11];
@@ -323,6 +300,8 @@ Boolean SRTPCryptographicContext
 ::processOutgoingSRTCPPacket(u_int8_t* buffer, unsigned inPacketSize,
 			     unsigned& outPacketSize) {
 #ifndef NO_OPENSSL
+  if (weUseAESGCM()) return processOutgoingSRTCPPacketAEAD(buffer, inPacketSize, outPacketSize);
+
   do {
     // Encrypt the appropriate part of the packet.
     u_int8_t eFlag = 0x00;
@@ -458,9 +437,7 @@ unsigned SRTPCryptographicContext
 			    u_int8_t* resultAuthenticationTag) {
   if (SRTP_AUTH_TAG_LENGTH > SHA1_DIGEST_LEN) return 0; // sanity check; shouldn't happen
   u_int8_t computedAuthTag[SHA1_DIGEST_LEN];
-  HMAC_SHA1(keysToUse.authKey, sizeof keysToUse.authKey,
-	    dataToAuthenticate, numBytesToAuthenticate,
-	    computedAuthTag);
+  computeHMAC(keysToUse, dataToAuthenticate, numBytesToAuthenticate, computedAuthTag);
 
   for (unsigned i = 0; i < SRTP_AUTH_TAG_LENGTH; ++i) {
     resultAuthenticationTag[i] = computedAuthTag[i];
@@ -474,9 +451,7 @@ Boolean SRTPCryptographicContext
 			  u_int8_t const* dataToAuthenticate, unsigned numBytesToAuthenticate,
 			  u_int8_t const* authenticationTag) {
   u_int8_t computedAuthTag[SHA1_DIGEST_LEN];
-  HMAC_SHA1(keysToUse.authKey, sizeof keysToUse.authKey,
-	    dataToAuthenticate, numBytesToAuthenticate,
-	    computedAuthTag);
+  computeHMAC(keysToUse, dataToAuthenticate, numBytesToAuthenticate, computedAuthTag);
 
   if (SRTP_AUTH_TAG_LENGTH > SHA1_DIGEST_LEN) return False; // sanity check
   for (unsigned i = 0; i < SRTP_AUTH_TAG_LENGTH; ++i) {
@@ -498,37 +473,11 @@ Boolean SRTPCryptographicContext
 
   iv[sizeof iv-8] ^= index>>40; iv[sizeof iv-7] ^= index>>32; iv[sizeof iv-6] ^= index>>24; iv[sizeof iv-5] ^= index>>16; iv[sizeof iv-4] ^= index>>8; iv[sizeof iv-3] ^= index;
 
-  // Now generate as many blocks of the keystream as we need, by repeatedly encrypting
-  // the IV using our cipher key.  (After each step, we increment the IV by 1.)
-  // We then XOR the keystream into the provided data, to do the en/decryption.
-  do {
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (ctx == NULL) break;
-    
-    if (EVP_EncryptInit(ctx, EVP_aes_128_ecb(), keys.cipherKey, NULL/*no IV*/) != 1) break;
-        // Note: We use ECB mode here, because we're using our "iv" as plaintext
-
-    while (numDataBytes > 0) {
-      u_int8_t keyStream[SRTP_CIPHER_KEY_LENGTH];
-      int numBytesEncrypted;
-      if (EVP_EncryptUpdate(ctx, keyStream, &numBytesEncrypted, iv, SRTP_CIPHER_KEY_LENGTH) != 1) break;
-
-      unsigned numBytesToUse
-	= numDataBytes < numBytesEncrypted ? numDataBytes : numBytesEncrypted;
-      for (unsigned i = 0; i < numBytesToUse; ++i) data[i] ^= keyStream[i];
-      data += numBytesToUse;
-      numDataBytes -= numBytesToUse;
-
-      // Increment the IV by 1:
-      u_int8_t* ptr = &iv[sizeof iv];
-      do {
-	--ptr;
-	++*ptr;
-      } while (*ptr == 0x00);
-    }
-
-    EVP_CIPHER_CTX_free(ctx);
-  } while (0);
+  // Then en/decrypt the data (in place) using AES in counter mode, starting with this IV.  (Our cipher context -
+  // which already has the key - is simply reset to use the new IV.)
+  int numBytesOut;
+  if (keys.cipherCtx == NULL || EVP_EncryptInit_ex(keys.cipherCtx, NULL, NULL, NULL, iv) != 1) return;
+  EVP_EncryptUpdate(keys.cipherCtx, data, &numBytesOut, data, numDataBytes);
 }
 
 void SRTPCryptographicContext::performKeyDerivation() {
@@ -560,8 +509,9 @@ void SRTPCryptographicContext
 		  unsigned resultKeyLength, u_int8_t* resultKey) {
   u_int8_t counter[KDF_PRF_CIPHER_BLOCK_LENGTH];
   // Fill in the first bytes of "counter" with our 'salt'; set the remaining bytes to zero:
-  memmove(counter, salt, SRTP_CIPHER_SALT_LENGTH);
-  for (unsigned i = SRTP_CIPHER_SALT_LENGTH; i < sizeof counter; ++i) {
+  // (For AES-GCM, the (12-byte) salt is padded with zeros in this way to the 14 bytes that the PRF expects.)
+  memmove(counter, salt, masterSaltLength());
+  for (unsigned i = masterSaltLength(); i < sizeof counter; ++i) {
     counter[i] = 0;
   }
 
@@ -596,4 +546,295 @@ void SRTPCryptographicContext
     EVP_CIPHER_CTX_free(ctx);
   } while (0);
 }
+
+void SRTPCryptographicContext::computeHMAC(derivedKeys& keys, u_int8_t const* data, unsigned numDataBytes,
+					    u_int8_t* resultDigest) {
+  // HMAC-SHA1 (RFC 2104), starting from our precomputed SHA-1 states for the inner and outer pads:
+  u_int8_t innerDigest[SHA1_DIGEST_LEN];
+  EVP_MD_CTX_copy_ex(fHMACCtx, keys.hmacInnerCtx);
+  EVP_DigestUpdate(fHMACCtx, data, numDataBytes);
+  EVP_DigestFinal_ex(fHMACCtx, innerDigest, NULL);
+
+  EVP_MD_CTX_copy_ex(fHMACCtx, keys.hmacOuterCtx);
+  EVP_DigestUpdate(fHMACCtx, innerDigest, sizeof innerDigest);
+  EVP_DigestFinal_ex(fHMACCtx, resultDigest, NULL);
+}
+
+void SRTPCryptographicContext::setUpCipherState(derivedKeys& keys) {
+  keys.cipherCtx = EVP_CIPHER_CTX_new();
+  if (keys.cipherCtx != NULL
+      && EVP_EncryptInit_ex(keys.cipherCtx, weUseAESGCM() ? EVP_aes_128_gcm() : EVP_aes_128_ctr(), NULL,
+			    keys.cipherKey, NULL/*the IV is set for each packet*/) != 1) {
+    EVP_CIPHER_CTX_free(keys.cipherCtx); keys.cipherCtx = NULL;
+  }
+
+  keys.hmacInnerCtx = keys.hmacOuterCtx = NULL;
+  if (weUseAESGCM()) return; // AES-GCM does its own authentication
+
+  // Hash the HMAC inner and outer pads (formed from the authentication key) now, rather than for each packet:
+  u_int8_t ipad[HMAC_BLOCK_SIZE];
+  u_int8_t opad[HMAC_BLOCK_SIZE];
+  unsigned i;
+  for (i = 0; i < sizeof keys.authKey; ++i) { // ASSERT: sizeof keys.authKey <= HMAC_BLOCK_SIZE
+    ipad[i] = keys.authKey[i]^0x36;
+    opad[i] = keys.authKey[i]^0x5c;
+  }
+  for (; i < HMAC_BLOCK_SIZE; ++i) {
+    ipad[i] = 0x36;
+    opad[i] = 0x5c;
+  }
+
+  keys.hmacInnerCtx = EVP_MD_CTX_create();
+  EVP_DigestInit_ex(keys.hmacInnerCtx, EVP_sha1(), NULL);
+  EVP_DigestUpdate(keys.hmacInnerCtx, ipad, sizeof ipad);
+
+  keys.hmacOuterCtx = EVP_MD_CTX_create();
+  EVP_DigestInit_ex(keys.hmacOuterCtx, EVP_sha1(), NULL);
+  EVP_DigestUpdate(keys.hmacOuterCtx, opad, sizeof opad);
+}
+
+void SRTPCryptographicContext::freeCipherState(derivedKeys& keys) {
+  if (keys.cipherCtx != NULL) EVP_CIPHER_CTX_free(keys.cipherCtx);
+  if (keys.hmacInnerCtx != NULL) EVP_MD_CTX_destroy(keys.hmacInnerCtx);
+  if (keys.hmacOuterCtx != NULL) EVP_MD_CTX_destroy(keys.hmacOuterCtx);
+}
+
+void SRTPCryptographicContext
+::computeIncomingROC(u_int16_t rtpSeqNum, u_int32_t& thisPacketsROC,
+		     u_int32_t& nextROC, u_int16_t& nextHighRTPSeqNum) {
+  if (!fHaveReceivedSRTPPackets) {
+    // First time:
+    nextROC = thisPacketsROC = fReceptionROC = fMIKEYState.initialROC();
+    nextHighRTPSeqNum = rtpSeqNum;
+    fHaveReceivedSRTPPackets = True; // for the future
+  } else {
+    // Check whether the sequence number has rolled over, or is out-of-order:
+    u_int16_t const SEQ_NUM_THRESHOLD = 0x1000;
+    if (rtpSeqNum >= fPreviousHighRTPSeqNum) {
+      // normal case, or out-of-order packet that crosses a rollover:
+      if (rtpSeqNum - fPreviousHighRTPSeqNum < SEQ_NUM_THRESHOLD) {
+	// normal case:
+	nextROC = thisPacketsROC = fReceptionROC;
+	nextHighRTPSeqNum = rtpSeqNum;
+      } else {
+	// out-of-order packet that crosses a rollover:
+	nextROC = fReceptionROC;
+	thisPacketsROC = fReceptionROC-1;
+	nextHighRTPSeqNum = fPreviousHighRTPSeqNum;
+      }
+    } else {
+      // rollover, or out-of-order packet that crosses a rollover:
+      if (fPreviousHighRTPSeqNum - rtpSeqNum > SEQ_NUM_THRESHOLD) {
+	// rollover:
+	nextROC = thisPacketsROC = fReceptionROC+1;
+	nextHighRTPSeqNum = rtpSeqNum;
+      } else {
+	// out-of-order packet (that doesn't cross a rollover):
+	nextROC = thisPacketsROC = fReceptionROC;
+	nextHighRTPSeqNum = fPreviousHighRTPSeqNum;
+      }
+    }
+  }
+}
+
+u_int32_t SRTPCryptographicContext::computeOutgoingROC(u_int16_t rtpSeqNum) {
+  if (!fHaveSentSRTPPackets) {
+    fHaveSentSRTPPackets = True; // for the future
+  } else {
+    if (rtpSeqNum == 0) ++fSendingROC; // increment the ROC when the RTP seq num rolls over
+  }
+
+  return fSendingROC;
+}
+
+
+////////// Implementation of the AEAD_AES_128_GCM ciphersuite (RFC 7714) //////////
+
+// The layout of a SRTP packet is: RTP header (authenticated only) | encrypted payload | 16-byte tag | MKI
+// The layout of a SRTCP packet is: first 8 bytes (authenticated only) | encrypted rest | 16-byte tag | E+SRTCP index | MKI
+// (The E+SRTCP index is also authenticated.)
+
+static Boolean getRTPHeaderSize(u_int8_t const* buffer, unsigned packetSize, unsigned& resultHeaderSize) {
+  resultHeaderSize = 12 + (buffer[0]&0x0F)*4; // the basic 12-byte header, plus any CSRC identifiers
+  if ((buffer[0]&0x10) != 0) {
+    // There's a RTP extension header.  Add its size:
+    if (packetSize < resultHeaderSize + 4) return False;
+    u_int16_t const hdrExtLength = (buffer[resultHeaderSize+2]<<8)|buffer[resultHeaderSize+3];
+    resultHeaderSize += 4 + hdrExtLength*4;
+  }
+
+  return resultHeaderSize <= packetSize;
+}
+
+static void computeAEADIV(u_int8_t* iv/*SRTP_AEAD_SALT_LENGTH bytes*/, u_int8_t const* salt,
+			  u_int32_t ssrc, u_int32_t word1, u_int16_t word2) {
+  // IV = (0x0000 | SSRC | "word1" | "word2") XOR salt, where - for SRTP - "word1" is the ROC and "word2" is the RTP
+  // sequence number, and - for SRTCP - "word1"|"word2" is 0x0000 followed by the 31-bit SRTCP index:
+  iv[0] = 0; iv[1] = 0;
+  iv[2] = ssrc>>24; iv[3] = ssrc>>16; iv[4] = ssrc>>8; iv[5] = ssrc;
+  iv[6] = word1>>24; iv[7] = word1>>16; iv[8] = word1>>8; iv[9] = word1;
+  iv[10] = word2>>8; iv[11] = (u_int8_t)word2;
+  for (unsigned i = 0; i < SRTP_AEAD_SALT_LENGTH; ++i) iv[i] ^= salt[i];
+}
+
+Boolean SRTPCryptographicContext
+::processIncomingSRTPPacketAEAD(u_int8_t* buffer, unsigned inPacketSize, unsigned& outPacketSize) {
+  unsigned const numBytesPastEncryption = SRTP_AEAD_AUTH_TAG_LENGTH + SRTP_MKI_LENGTH;
+  if (inPacketSize < 12 + numBytesPastEncryption) return False;
+  unsigned const tagPosition = inPacketSize - numBytesPastEncryption;
+
+  unsigned rtpHeaderSize;
+  if (!getRTPHeaderSize(buffer, tagPosition, rtpHeaderSize)) return False;
+
+  u_int16_t const rtpSeqNum = (buffer[2]<<8)|buffer[3];
+  u_int32_t nextROC, thisPacketsROC;
+  u_int16_t nextHighRTPSeqNum;
+  computeIncomingROC(rtpSeqNum, thisPacketsROC, nextROC, nextHighRTPSeqNum);
+
+  u_int8_t iv[SRTP_AEAD_SALT_LENGTH];
+  u_int32_t const SSRC = (buffer[8]<<24)|(buffer[9]<<16)|(buffer[10]<<8)|buffer[11];
+  computeAEADIV(iv, fDerivedKeys.srtp.salt, SSRC, thisPacketsROC, rtpSeqNum);
+  if (!cryptDataAEAD(fDerivedKeys.srtp, False, iv, buffer, rtpHeaderSize, NULL, 0,
+		     &buffer[rtpHeaderSize], tagPosition - rtpHeaderSize, &buffer[tagPosition])) {
+#ifdef DEBUG
+    fprintf(stderr, "SRTPCryptographicContext::processIncomingSRTPPacketAEAD(): Failed to authenticate incoming SRTP packet!\n");
+#endif
+    return False;
+  }
+
+  // Now that we've verified the packet, set the 'index values' for next time:
+  fReceptionROC = nextROC;
+  fPreviousHighRTPSeqNum = nextHighRTPSeqNum;
+
+  outPacketSize = tagPosition; // trim to what we use
+  return True;
+}
+
+Boolean SRTPCryptographicContext
+::processIncomingSRTCPPacketAEAD(u_int8_t* buffer, unsigned inPacketSize, unsigned& outPacketSize) {
+  unsigned const numBytesPastEncryption = SRTP_AEAD_AUTH_TAG_LENGTH + 4/*E+SRTCP index*/ + SRTP_MKI_LENGTH;
+  if (inPacketSize < 8 + numBytesPastEncryption) return False;
+  unsigned const tagPosition = inPacketSize - numBytesPastEncryption;
+
+  u_int8_t const* eIndexPtr = &buffer[tagPosition + SRTP_AEAD_AUTH_TAG_LENGTH];
+  u_int32_t E_plus_SRTCPIndex = (eIndexPtr[0]<<24)|(eIndexPtr[1]<<16)|(eIndexPtr[2]<<8)|eIndexPtr[3];
+
+  u_int8_t iv[SRTP_AEAD_SALT_LENGTH];
+  u_int32_t const SSRC = (buffer[4]<<24)|(buffer[5]<<16)|(buffer[6]<<8)|buffer[7];
+  computeAEADIV(iv, fDerivedKeys.srtcp.salt, SSRC, (E_plus_SRTCPIndex&0x7FFFFFFF)>>16, E_plus_SRTCPIndex&0xFFFF);
+
+  Boolean isOK;
+  if ((E_plus_SRTCPIndex&0x80000000) != 0) { // The packet is encrypted
+    isOK = cryptDataAEAD(fDerivedKeys.srtcp, False, iv, buffer, 8, eIndexPtr, 4,
+			 &buffer[8], tagPosition - 8, &buffer[tagPosition]);
+  } else { // The packet is only authenticated
+    isOK = cryptDataAEAD(fDerivedKeys.srtcp, False, iv, buffer, tagPosition, eIndexPtr, 4,
+			 NULL, 0, &buffer[tagPosition]);
+  }
+  if (!isOK) {
+#ifdef DEBUG
+    fprintf(stderr, "SRTPCryptographicContext::processIncomingSRTCPPacketAEAD(): Failed to authenticate incoming SRTCP packet!\n");
+#endif
+    return False;
+  }
+
+  outPacketSize = tagPosition; // trim to what we use
+  return True;
+}
+
+Boolean SRTPCryptographicContext
+::processOutgoingSRTPPacketAEAD(u_int8_t* buffer, unsigned inPacketSize, unsigned& outPacketSize) {
+  if (inPacketSize < 12) { // packet is too small
+    // Hack: Let small, non RTCP packets through w/o encryption; they may be used to
+    // punch through NATs
+    outPacketSize = inPacketSize;
+    return True;
+  }
+
+  unsigned rtpHeaderSize;
+  if (!getRTPHeaderSize(buffer, inPacketSize, rtpHeaderSize)) return False;
+
+  u_int16_t const rtpSeqNum = (buffer[2]<<8)|buffer[3];
+  u_int32_t const roc = computeOutgoingROC(rtpSeqNum);
+
+  u_int8_t iv[SRTP_AEAD_SALT_LENGTH];
+  u_int32_t const SSRC = (buffer[8]<<24)|(buffer[9]<<16)|(buffer[10]<<8)|buffer[11];
+  computeAEADIV(iv, fDerivedKeys.srtp.salt, SSRC, roc, rtpSeqNum);
+  if (!cryptDataAEAD(fDerivedKeys.srtp, True, iv, buffer, rtpHeaderSize, NULL, 0,
+		     &buffer[rtpHeaderSize], inPacketSize - rtpHeaderSize, &buffer[inPacketSize])) return False;
+  outPacketSize = inPacketSize + SRTP_AEAD_AUTH_TAG_LENGTH;
+
+  // Add the MKI:
+  buffer[outPacketSize++] = MKI()>>24;
+  buffer[outPacketSize++] = MKI()>>16;
+  buffer[outPacketSize++] = MKI()>>8;
+  buffer[outPacketSize++] = MKI();
+
+  return True;
+}
+
+Boolean SRTPCryptographicContext
+::processOutgoingSRTCPPacketAEAD(u_int8_t* buffer, unsigned inPacketSize, unsigned& outPacketSize) {
+  unsigned const unencryptedHeaderSize = 8;
+  if (inPacketSize < unencryptedHeaderSize) { // packet is too small
+    // Hack: Let small, non RTCP packets through w/o encryption; they may be used to
+    // punch through NATs
+    outPacketSize = inPacketSize;
+    return True;
+  }
+
+  u_int8_t eIndex[4];
+  eIndex[0] = (fSRTCPIndex>>24)|0x80/*E: we always encrypt*/;
+  eIndex[1] = fSRTCPIndex>>16;
+  eIndex[2] = fSRTCPIndex>>8;
+  eIndex[3] = fSRTCPIndex;
+
+  u_int8_t iv[SRTP_AEAD_SALT_LENGTH];
+  u_int32_t const SSRC = (buffer[4]<<24)|(buffer[5]<<16)|(buffer[6]<<8)|buffer[7];
+  computeAEADIV(iv, fDerivedKeys.srtcp.salt, SSRC, fSRTCPIndex>>16, fSRTCPIndex&0xFFFF);
+  if (!cryptDataAEAD(fDerivedKeys.srtcp, True, iv, buffer, unencryptedHeaderSize, eIndex, sizeof eIndex,
+		     &buffer[unencryptedHeaderSize], inPacketSize - unencryptedHeaderSize,
+		     &buffer[inPacketSize])) return False;
+  outPacketSize = inPacketSize + SRTP_AEAD_AUTH_TAG_LENGTH;
+
+  // Add the 'E' flag and SRTCP index:
+  memcpy(&buffer[outPacketSize], eIndex, sizeof eIndex);
+  outPacketSize += sizeof eIndex;
+  fSRTCPIndex = (fSRTCPIndex+1)&0x7FFFFFFF; // for next time
+
+  // Add the MKI:
+  buffer[outPacketSize++] = MKI()>>24;
+  buffer[outPacketSize++] = MKI()>>16;
+  buffer[outPacketSize++] = MKI()>>8;
+  buffer[outPacketSize++] = MKI();
+
+  return True;
+}
+
+Boolean SRTPCryptographicContext
+::cryptDataAEAD(derivedKeys& keys, Boolean encrypt, u_int8_t const* iv,
+		u_int8_t const* aad1, unsigned aad1Size, u_int8_t const* aad2, unsigned aad2Size,
+		u_int8_t* data, unsigned numDataBytes, u_int8_t* authenticationTag) {
+  // Reset our cipher context (which already has the key) to use the new IV:
+  EVP_CIPHER_CTX* ctx = keys.cipherCtx;
+  if (ctx == NULL || EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv, encrypt ? 1 : 0) != 1) return False;
+
+  int numBytesOut;
+  if (aad1Size > 0 && EVP_CipherUpdate(ctx, NULL, &numBytesOut, aad1, aad1Size) != 1) return False;
+  if (aad2Size > 0 && EVP_CipherUpdate(ctx, NULL, &numBytesOut, aad2, aad2Size) != 1) return False;
+  if (numDataBytes > 0 && EVP_CipherUpdate(ctx, data, &numBytesOut, data, numDataBytes) != 1) return False;
+
+  if (!encrypt
+      && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, SRTP_AEAD_AUTH_TAG_LENGTH, authenticationTag) != 1) {
+    return False;
+  }
+  u_int8_t finalBlock[16]; // not used (for GCM, there's no final output)
+  if (EVP_CipherFinal_ex(ctx, finalBlock, &numBytesOut) != 1) return False; // (when decrypting: the tag was wrong)
+  if (encrypt
+      && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, SRTP_AEAD_AUTH_TAG_LENGTH, authenticationTag) != 1) {
+    return False;
+  }
+
+  return True;
+}
 #endif
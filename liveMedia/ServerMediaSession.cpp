@@ -55,6 +55,26 @@ Boolean ServerMediaSession
   return True;
 }
 
+////////// SDPPreparationRequest (used to implement "ServerMediaSession::prepareSDPDescription()") //////////
+
+class SDPPreparationRequest {
+public:
+  SDPPreparationRequest(int addressFamily, TaskFunc* completionFunc, void* completionClientData,
+			ServerMediaSubsession* firstSubsession)
+    : fNext(NULL), fAddressFamily(addressFamily),
+      fCompletionFunc(completionFunc), fCompletionClientData(completionClientData),
+      fNextSubsession(firstSubsession), fAwaitedSubsession(NULL) {
+  }
+
+public:
+  SDPPreparationRequest* fNext;
+  int fAddressFamily;
+  TaskFunc* fCompletionFunc;
+  void* fCompletionClientData;
+  ServerMediaSubsession* fNextSubsession; // the next subsession whose SDP lines we check
+  ServerMediaSubsession* fAwaitedSubsession; // non-NULL while we're waiting for this subsession's SDP lines
+};
+
 static char const* const libNameStr = "LIVE555 Streaming Media v";
 
 ServerMediaSession::ServerMediaSession(UsageEnvironment& env,
@@ -62,10 +82,10 @@ ServerMediaSession::ServerMediaSession(UsageEnvironment& env,
 				       char const* info,
 				       char const* description,
 				       Boolean isSSM, char const* miscSDPLines)
-  : Medium(env), streamingUsesSRTP(False), streamingIsEncrypted(False),
+  : Medium(env), streamingUsesSRTP(False), streamingIsEncrypted(False), streamingUsesAESGCM(False),
     fIsSSM(isSSM), fSubsessionsHead(NULL),
     fSubsessionsTail(NULL), fSubsessionCounter(0),
-    fReferenceCount(0), fDeleteWhenUnreferenced(False) {
+    fReferenceCount(0), fDeleteWhenUnreferenced(False), fSDPPreparationRequests(NULL) {
   fStreamName = strDup(streamName == NULL ? "" : streamName);
 
   char* libNamePlusVersionStr = NULL; // by default
@@ -83,6 +103,13 @@ ServerMediaSession::ServerMediaSession(UsageEnvironment& env,
 }
 
 ServerMediaSession::~ServerMediaSession() {
+  // Discard any pending "prepareSDPDescription()" calls (without calling their completion functions):
+  while (fSDPPreparationRequests != NULL) {
+    SDPPreparationRequest* request = fSDPPreparationRequests;
+    fSDPPreparationRequests = request->fNext;
+    delete request;
+  }
+
   deleteAllSubsessions();
   delete[] fStreamName;
   delete[] fInfoSDPString;
@@ -202,12 +229,108 @@ void ServerMediaSession::deleteAllSubsessions() {
   Medium::close(fSubsessionsHead);
   fSubsessionsHead = fSubsessionsTail = NULL;
   fSubsessionCounter = 0;
+
+  // Any pending "prepareSDPDescription()" calls now have nothing left to wait for:
+  SDPPreparationRequest* completedRequests = fSDPPreparationRequests;
+  fSDPPreparationRequests = NULL;
+  completeSDPPreparationRequests(completedRequests);
 }
 
 Boolean ServerMediaSession::isServerMediaSession() const {
   return True;
 }
 
+void ServerMediaSession
+::prepareSDPDescription(int addressFamily, TaskFunc* completionFunc, void* completionClientData) {
+  SDPPreparationRequest* request
+    = new SDPPreparationRequest(addressFamily, completionFunc, completionClientData, fSubsessionsHead);
+  if (continueSDPPreparation(request)) {
+    // All of our subsessions' SDP lines are already available (the usual case):
+    delete request;
+    (*completionFunc)(completionClientData);
+    return;
+  }
+
+  // Add "request" to the end of our list of pending requests (so that they complete in order):
+  SDPPreparationRequest** ptr = &fSDPPreparationRequests;
+  while (*ptr != NULL) ptr = &(*ptr)->fNext;
+  *ptr = request;
+}
+
+void ServerMediaSession::cancelSDPDescriptionPreparation(void* completionClientData) {
+  SDPPreparationRequest** ptr = &fSDPPreparationRequests;
+  while (*ptr != NULL) {
+    SDPPreparationRequest* request = *ptr;
+    if (request->fCompletionClientData == completionClientData) {
+      *ptr = request->fNext;
+      delete request;
+    } else {
+      ptr = &request->fNext;
+    }
+  }
+}
+
+Boolean ServerMediaSession::continueSDPPreparation(SDPPreparationRequest* request) {
+  // Check each remaining subsession in turn, starting the preparation of its SDP lines if necessary.
+  // Returns True iff there are no more subsessions to wait for.
+  while (request->fNextSubsession != NULL) {
+    ServerMediaSubsession* subsession = request->fNextSubsession;
+    if (!subsession->sdpLinesAreReady(request->fAddressFamily)) {
+      if (subsession->fSDPLinesArePreparing) { // another request has already started preparing this subsession
+	request->fAwaitedSubsession = subsession;
+	return False;
+      }
+      if (!subsession->prepareSDPLines(request->fAddressFamily)) {
+	subsession->fSDPLinesArePreparing = True;
+	request->fAwaitedSubsession = subsession;
+	return False;
+      }
+    }
+    request->fNextSubsession = subsession->fNext;
+  }
+
+  return True;
+}
+
+void ServerMediaSession::noteSubsessionSDPLinesPrepared(ServerMediaSubsession* subsession) {
+  // Continue each request that was waiting for "subsession", and collect those that have now completed:
+  SDPPreparationRequest* completedRequests = NULL;
+  SDPPreparationRequest** completedTail = &completedRequests;
+
+  SDPPreparationRequest** ptr = &fSDPPreparationRequests;
+  while (*ptr != NULL) {
+    SDPPreparationRequest* request = *ptr;
+    if (request->fAwaitedSubsession == subsession) {
+      // Note: We move on to the next subsession even if "subsession"s SDP lines could not be prepared; in that case,
+      // "generateSDPDescription()" will fail (as it would have done anyway).
+      request->fAwaitedSubsession = NULL;
+      request->fNextSubsession = subsession->fNext;
+      if (continueSDPPreparation(request)) {
+	*ptr = request->fNext;
+	request->fNext = NULL;
+	*completedTail = request; completedTail = &request->fNext;
+	continue;
+      }
+    }
+    ptr = &request->fNext;
+  }
+
+  completeSDPPreparationRequests(completedRequests);
+      // Note: This might (indirectly) delete us, so we must not access any member fields after this.
+}
+
+void ServerMediaSession::completeSDPPreparationRequests(SDPPreparationRequest* requests) {
+  while (requests != NULL) {
+    SDPPreparationRequest* request = requests;
+    requests = request->fNext;
+
+    TaskFunc* completionFunc = request->fCompletionFunc;
+    void* completionClientData = request->fCompletionClientData;
+    delete request;
+    (*completionFunc)(completionClientData);
+  }
+}
+
 char* ServerMediaSession::generateSDPDescription(int addressFamily) {
   struct sockaddr_storage ourAddress;
   if (addressFamily == AF_INET) {
@@ -359,7 +482,7 @@ void ServerMediaSubsessionIterator::reset() {
 
 ServerMediaSubsession::ServerMediaSubsession(UsageEnvironment& env)
   : Medium(env),
-    fParentSession(NULL), fSRTP_ROC(0), fNext(NULL), fTrackNumber(0), fTrackId(NULL) {
+    fParentSession(NULL), fSRTP_ROC(0), fNext(NULL), fTrackNumber(0), fTrackId(NULL), fSDPLinesArePreparing(False) {
 }
 
 ServerMediaSubsession::~ServerMediaSubsession() {
@@ -415,6 +538,18 @@ void ServerMediaSubsession::deleteStream(unsigned /*clientSessionId*/,
   // default implementation: do nothing
 }
 
+FramedSource* ServerMediaSubsession
+::createNewNonRTPStreamSource(unsigned /*clientSessionId*/, Boolean& sourceCanBeShared) {
+  // default implementation: not supported
+  sourceCanBeShared = False;
+  return NULL;
+}
+
+void ServerMediaSubsession::closeNonRTPStreamSource(FramedSource* source) {
+  // default implementation:
+  Medium::close(source);
+}
+
 void ServerMediaSubsession::testScaleFactor(float& scale) {
   // default implementation: Support scale = 1 only
   scale = 1;
@@ -430,6 +565,22 @@ void ServerMediaSubsession::getAbsoluteTimeRange(char*& absStartTime, char*& abs
   absStartTime = absEndTime = NULL;
 }
 
+Boolean ServerMediaSubsession::sdpLinesAreReady(int /*addressFamily*/) {
+  // default implementation: "sdpLines()" doesn't block
+  return True;
+}
+
+Boolean ServerMediaSubsession::prepareSDPLines(int /*addressFamily*/) {
+  // default implementation: There's nothing to prepare
+  return True;
+}
+
+void ServerMediaSubsession::sdpLinesPrepared() {
+  fSDPLinesArePreparing = False;
+  if (fParentSession != NULL) fParentSession->noteSubsessionSDPLinesPrepared(this);
+      // Note: This might (indirectly) delete us
+}
+
 char const*
 ServerMediaSubsession::rangeSDPLine() const {
   // First, check for the special case where we support seeking by 'absolute' time:
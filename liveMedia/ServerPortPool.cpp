@@ -0,0 +1,227 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// A pool of pre-bound UDP port pairs, for the RTP and RTCP 'groupsocks' of server streams
+// Implementation
+
+#include "ServerPortPool.hh"
+#include "GroupsockHelper.hh"
+
+////////// ServerPortPair //////////
+
+class ServerPortPair {
+public:
+  ServerPortPair(Groupsock* rtpGroupsock, Groupsock* rtcpGroupsock, int familyIndex)
+    : fNext(NULL), fRTPGroupsock(rtpGroupsock), fRTCPGroupsock(rtcpGroupsock), fFamilyIndex(familyIndex),
+      fIsInUse(False) {
+  }
+  virtual ~ServerPortPair() {
+    delete fRTPGroupsock; delete fRTCPGroupsock;
+  }
+
+  ServerPortPair* fNext; // in a free list
+  Groupsock* fRTPGroupsock;
+  Groupsock* fRTCPGroupsock;
+  int fFamilyIndex; // 0 for IPv4; 1 for IPv6
+  Boolean fIsInUse;
+};
+
+static int familyIndex(int addressFamily) { return addressFamily == AF_INET6 ? 1 : 0; }
+
+static void discardPendingInput(UsageEnvironment& env, Groupsock* groupsock) {
+  // Discard any packets - e.g., RTCP reports from the port's previous client - that are waiting to be read from the
+  // groupsock's socket, so that the port's next user doesn't see them:
+  int const socketNum = groupsock->socketNum();
+  if (!makeSocketNonBlocking(socketNum)) return;
+
+  unsigned char buffer[2048]; // any longer packets get truncated, which is fine here
+  struct sockaddr_storage fromAddress;
+  while (readSocket(env, socketNum, buffer, sizeof buffer, fromAddress) > 0) {}
+
+  makeSocketBlocking(socketNum);
+}
+
+
+////////// ServerPortPool implementation //////////
+
+ServerPortPool* ServerPortPool::enable(UsageEnvironment& env, portNumBits firstPortNum, unsigned numPortPairs) {
+  disable(env);
+
+  _Tables* ourTables = _Tables::getOurTables(env);
+  ServerPortPool* pool = (ServerPortPool*)(ourTables->serverPortPool);
+  if (pool == NULL) {
+    // (Otherwise, there's a disabled pool whose ports are still in use; we reuse it.)
+    pool = new ServerPortPool(env);
+    ourTables->serverPortPool = pool;
+  }
+
+  unsigned numBound = pool->bindPortPairs(AF_INET, firstPortNum, numPortPairs);
+  if (weHaveAnIPv6Address(env)) numBound += pool->bindPortPairs(AF_INET6, firstPortNum, numPortPairs);
+  if (numBound == 0) {
+    env.setResultMsg("ServerPortPool::enable(): Unable to bind any port pairs");
+    pool->reclaimIfPossible();
+    return NULL;
+  }
+
+  pool->fIsEnabled = True;
+  return pool;
+}
+
+void ServerPortPool::disable(UsageEnvironment& env) {
+  ServerPortPool* pool = lookup(env);
+  if (pool == NULL) return;
+
+  pool->fIsEnabled = False;
+  pool->closeFreePortPairs();
+  pool->reclaimIfPossible();
+}
+
+ServerPortPool* ServerPortPool::lookup(UsageEnvironment& env) {
+  _Tables* ourTables = (_Tables*)(env.liveMediaPriv);
+  return ourTables == NULL ? NULL : (ServerPortPool*)(ourTables->serverPortPool);
+}
+
+Boolean ServerPortPool::allocate(int addressFamily, Groupsock*& rtpGroupsock, Groupsock*& rtcpGroupsock) {
+  int const i = familyIndex(addressFamily);
+  ServerPortPair* pair = fFreePortPairs[i];
+  if (!fIsEnabled || pair == NULL) {
+    ++fNumAllocationFailures;
+    return False;
+  }
+
+  fFreePortPairs[i] = pair->fNext;
+  --fNumFreePortPairs[i];
+  pair->fNext = NULL;
+  pair->fIsInUse = True;
+
+  rtpGroupsock = pair->fRTPGroupsock;
+  rtcpGroupsock = pair->fRTCPGroupsock;
+  return True;
+}
+
+Boolean ServerPortPool::release(Groupsock* rtpGroupsock) {
+  ServerPortPair* pair = (ServerPortPair*)(fPortPairsByRTPGroupsock->Lookup((char const*)rtpGroupsock));
+  if (pair == NULL || !pair->fIsInUse) return False;
+  pair->fIsInUse = False;
+
+  if (!fIsEnabled) {
+    // Close the pair's ports, instead of returning it to the pool:
+    fPortPairsByRTPGroupsock->Remove((char const*)rtpGroupsock);
+    --fNumPortPairs[pair->fFamilyIndex];
+    delete pair;
+    reclaimIfPossible();
+    return True;
+  }
+
+  // Reset the groupsocks, so that they're as if newly created:
+  pair->fRTPGroupsock->removeAllDestinations();
+  pair->fRTCPGroupsock->removeAllDestinations();
+  discardPendingInput(fEnv, pair->fRTPGroupsock);
+  discardPendingInput(fEnv, pair->fRTCPGroupsock);
+
+  pair->fNext = fFreePortPairs[pair->fFamilyIndex];
+  fFreePortPairs[pair->fFamilyIndex] = pair;
+  ++fNumFreePortPairs[pair->fFamilyIndex];
+  return True;
+}
+
+unsigned ServerPortPool::numPortPairs(int addressFamily) const {
+  return fNumPortPairs[familyIndex(addressFamily)];
+}
+
+unsigned ServerPortPool::numFreePortPairs(int addressFamily) const {
+  return fNumFreePortPairs[familyIndex(addressFamily)];
+}
+
+ServerPortPool::ServerPortPool(UsageEnvironment& env)
+  : fEnv(env), fIsEnabled(False),
+    fPortPairsByRTPGroupsock(HashTable::create(ONE_WORD_HASH_KEYS)), fNumAllocationFailures(0) {
+  for (unsigned i = 0; i < 2; ++i) {
+    fNumPortPairs[i] = 0;
+    fFreePortPairs[i] = NULL;
+    fNumFreePortPairs[i] = 0;
+  }
+}
+
+ServerPortPool::~ServerPortPool() {
+  // Note: We get deleted only when none of our pairs are in use, so this deletes any remaining (i.e., free) pairs:
+  ServerPortPair* pair;
+  while ((pair = (ServerPortPair*)(fPortPairsByRTPGroupsock->RemoveNext())) != NULL) {
+    delete pair;
+  }
+  delete fPortPairsByRTPGroupsock;
+}
+
+unsigned ServerPortPool::bindPortPairs(int addressFamily, portNumBits firstPortNum, unsigned numPortPairs) {
+  int const i = familyIndex(addressFamily);
+  NoReuse dummy(fEnv); // ensures that we skip over ports that are already in use (including by other event loops)
+
+  // (We add the new pairs to the end of the free list, so that - initially - pairs get allocated in port number order.)
+  ServerPortPair** freeListTail = &fFreePortPairs[i];
+  while (*freeListTail != NULL) freeListTail = &((*freeListTail)->fNext);
+
+  unsigned numBound = 0;
+  for (unsigned portNum = (firstPortNum+1)&~1; numBound < numPortPairs && portNum < 65535; portNum += 2) {
+    Groupsock* rtpGroupsock = new Groupsock(fEnv, nullAddress(addressFamily), Port(portNum), 255);
+    if (rtpGroupsock->socketNum() < 0) {
+      delete rtpGroupsock;
+      continue;
+    }
+    Groupsock* rtcpGroupsock = new Groupsock(fEnv, nullAddress(addressFamily), Port(portNum+1), 255);
+    if (rtcpGroupsock->socketNum() < 0) {
+      delete rtpGroupsock; delete rtcpGroupsock;
+      continue;
+    }
+    rtpGroupsock->removeAllDestinations(); rtcpGroupsock->removeAllDestinations();
+
+    ServerPortPair* pair = new ServerPortPair(rtpGroupsock, rtcpGroupsock, i);
+    fPortPairsByRTPGroupsock->Add((char const*)rtpGroupsock, pair);
+    *freeListTail = pair;
+    freeListTail = &(pair->fNext);
+    ++fNumFreePortPairs[i];
+    ++fNumPortPairs[i];
+    ++numBound;
+  }
+
+  return numBound;
+}
+
+void ServerPortPool::closeFreePortPairs() {
+  for (unsigned i = 0; i < 2; ++i) {
+    while (fFreePortPairs[i] != NULL) {
+      ServerPortPair* pair = fFreePortPairs[i];
+      fFreePortPairs[i] = pair->fNext;
+
+      fPortPairsByRTPGroupsock->Remove((char const*)(pair->fRTPGroupsock));
+      delete pair;
+      --fNumPortPairs[i];
+    }
+    fNumFreePortPairs[i] = 0;
+  }
+}
+
+Boolean ServerPortPool::reclaimIfPossible() {
+  if (fIsEnabled || fPortPairsByRTPGroupsock->numEntries() > 0) return False;
+
+  _Tables* ourTables = _Tables::getOurTables(fEnv, False);
+  if (ourTables != NULL) {
+    ourTables->serverPortPool = NULL;
+    ourTables->reclaimIfPossible();
+  }
+  delete this;
+  return True;
+}
@@ -19,13 +19,20 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "StreamParser.hh"
+#include "MediaMetrics.hh"
 
 #include <string.h>
 #include <stdlib.h>
 
-#define BANK_SIZE 150000
+#define BANK_SIZE 150000 // the initial size of each bank
 
 void StreamParser::flushInput() {
+  if (fInputSource != NULL && fInputSource->isCurrentlyAwaitingData() && !fParserIsWaitingForInput) {
+    // Cancel the prefetch that's under way.  (Its data - if any - would follow data that we're discarding.)
+    fInputSource->stopGettingFrames();
+  }
+  fPrefetchSawEOF = False;
+
   fCurParserIndex = fSavedParserIndex = 0;
   fSavedRemainingUnparsedBits = fRemainingUnparsedBits = 0;
   fTotNumValidBytes = 0;
@@ -43,11 +50,23 @@ StreamParser::StreamParser(FramedSource* inputSource,
     fSavedParserIndex(0), fSavedRemainingUnparsedBits(0),
     fCurParserIndex(0), fRemainingUnparsedBits(0),
     fTotNumValidBytes(0), fHaveSeenEOF(False) {
-  fBank[0] = new unsigned char[BANK_SIZE];
-  fBank[1] = new unsigned char[BANK_SIZE];
+  fBankSize = BANK_SIZE;
+  fBank[0] = new unsigned char[fBankSize];
+  fBank[1] = new unsigned char[fBankSize];
   fCurBankNum = 0;
   fCurBank = fBank[fCurBankNum];
 
+  fParserIsWaitingForInput = fPrefetchSawEOF = False;
+  fNumInputReads = fNumInputStalls = fNumPrefetches = 0;
+  if (fInputSource == NULL) {
+    fMinPrefetchSize = ~0; // never prefetch
+    fMetrics = NULL;
+  } else {
+    fMinPrefetchSize = fInputSource->maxFrameSize();
+    if (fMinPrefetchSize < STREAM_PARSER_MIN_PREFETCH_SIZE) fMinPrefetchSize = STREAM_PARSER_MIN_PREFETCH_SIZE;
+    fMetrics = MetricsRegistry::streamParserMetrics(fInputSource->envir());
+  }
+
   fLastSeenPresentationTime.tv_sec = 0; fLastSeenPresentationTime.tv_usec = 0;
 }
 
@@ -55,11 +74,6 @@ StreamParser::~StreamParser() {
   delete[] fBank[0]; delete[] fBank[1];
 }
 
-void StreamParser::saveParserState() {
-  fSavedParserIndex = fCurParserIndex;
-  fSavedRemainingUnparsedBits = fRemainingUnparsedBits;
-}
-
 void StreamParser::restoreSavedParserState() {
   fCurParserIndex = fSavedParserIndex;
   fRemainingUnparsedBits = fSavedRemainingUnparsedBits;
@@ -112,21 +126,32 @@ unsigned StreamParser::getBits(unsigned numBits) {
   }
 }
 
-unsigned StreamParser::bankSize() const {
-  return BANK_SIZE;
-}
-
 #define NO_MORE_BUFFERED_INPUT 1
 
 void StreamParser::ensureValidBytes1(unsigned numBytesNeeded) {
   // We need to read some more bytes from the input source.
+  if (fInputSource->isCurrentlyAwaitingData()) {
+    // A prefetch is already under way.  Wait for it to complete:
+    fParserIsWaitingForInput = True;
+    ++fNumInputStalls;
+    if (fMetrics != NULL) fMetrics->inputStalls.increment();
+    throw NO_MORE_BUFFERED_INPUT;
+  }
+  if (fPrefetchSawEOF) {
+    // Our input source closed during a prefetch.  Handle this now, as if we'd just tried to read from it:
+    fPrefetchSawEOF = False;
+    fParserIsWaitingForInput = True;
+    onInputClosure1();
+    throw NO_MORE_BUFFERED_INPUT;
+  }
+
   // First, clarify how much data to ask for:
   unsigned maxInputFrameSize = fInputSource->maxFrameSize();
   if (maxInputFrameSize > numBytesNeeded) numBytesNeeded = maxInputFrameSize;
 
   // First, check whether these new bytes would overflow the current
   // bank.  If so, start using a new bank now.
-  if (fCurParserIndex + numBytesNeeded > BANK_SIZE) {
+  if (fCurParserIndex + numBytesNeeded > fBankSize) {
     // Swap banks, but save any still-needed bytes from the old bank:
     unsigned numBytesToSave = fTotNumValidBytes - fSavedParserIndex;
     unsigned char const* from = &curBank()[fSavedParserIndex];
@@ -139,26 +164,70 @@ void StreamParser::ensureValidBytes1(unsigned numBytesNeeded) {
     fTotNumValidBytes = numBytesToSave;
   }
 
+  if (fCurParserIndex + numBytesNeeded > fBankSize) {
+    // We have too much saved parser state to fit in our banks.  Make them larger:
+    growBanks(fCurParserIndex + numBytesNeeded);
+  }
   // ASSERT: fCurParserIndex + numBytesNeeded > fTotNumValidBytes
-  //      && fCurParserIndex + numBytesNeeded <= BANK_SIZE
-  if (fCurParserIndex + numBytesNeeded > BANK_SIZE) {
+  //      && fCurParserIndex + numBytesNeeded <= fBankSize
+
+  ++fNumInputStalls;
+  if (fMetrics != NULL) fMetrics->inputStalls.increment();
+  readFromInputSource(True);
+
+  throw NO_MORE_BUFFERED_INPUT;
+}
+
+void StreamParser::growBanks(unsigned minBankSize) {
+  if (minBankSize > STREAM_PARSER_MAX_BANK_SIZE) {
     // If this happens, it means that we have too much saved parser state.
-    // To fix this, increase BANK_SIZE as appropriate.
+    // To fix this, increase STREAM_PARSER_MAX_BANK_SIZE as appropriate.
     fInputSource->envir() << "StreamParser internal error ("
 			  << fCurParserIndex << " + "
-			  << numBytesNeeded << " > "
-			  << BANK_SIZE << ")\n";
+			  << minBankSize - fCurParserIndex << " > "
+			  << STREAM_PARSER_MAX_BANK_SIZE << ")\n";
     fInputSource->envir().internalError();
   }
 
+  unsigned newBankSize = fBankSize;
+  while (newBankSize < minBankSize) newBankSize *= 2;
+  if (newBankSize > STREAM_PARSER_MAX_BANK_SIZE) newBankSize = STREAM_PARSER_MAX_BANK_SIZE;
+
+  // Replace both banks, copying our valid bytes to the new current bank:
+  unsigned char* newBank[2];
+  newBank[0] = new unsigned char[newBankSize];
+  newBank[1] = new unsigned char[newBankSize];
+  memmove(newBank[fCurBankNum], curBank(), fTotNumValidBytes);
+
+  delete[] fBank[0]; delete[] fBank[1];
+  fBank[0] = newBank[0]; fBank[1] = newBank[1];
+  fCurBank = fBank[fCurBankNum];
+  fBankSize = newBankSize;
+
+  if (fMetrics != NULL) fMetrics->bankGrowths.increment();
+}
+
+void StreamParser::prefetch() {
+  // Our current bank has room for more data.  Unless it's already being read (or has closed), read from our input
+  // source now, without waiting until the parser runs out of data:
+  if (fInputSource->isCurrentlyAwaitingData() || fHaveSeenEOF || fPrefetchSawEOF) return;
+
+  ++fNumPrefetches;
+  if (fMetrics != NULL) fMetrics->prefetches.increment();
+  readFromInputSource(False);
+}
+
+void StreamParser::readFromInputSource(Boolean parserIsWaiting) {
+  fParserIsWaitingForInput = parserIsWaiting;
+  ++fNumInputReads;
+  if (fMetrics != NULL) fMetrics->inputReads.increment();
+
   // Try to read as many new bytes as will fit in the current bank:
-  unsigned maxNumBytesToRead = BANK_SIZE - fTotNumValidBytes;
+  unsigned maxNumBytesToRead = fBankSize - fTotNumValidBytes;
   fInputSource->getNextFrame(&curBank()[fTotNumValidBytes],
 			     maxNumBytesToRead,
 			     afterGettingBytes, this,
 			     onInputClosure, this);
-
-  throw NO_MORE_BUFFERED_INPUT;
 }
 
 void StreamParser::afterGettingBytes(void* clientData,
@@ -172,11 +241,11 @@ void StreamParser::afterGettingBytes(void* clientData,
 
 void StreamParser::afterGettingBytes1(unsigned numBytesRead, struct timeval presentationTime) {
   // Sanity check: Make sure we didn't get too many bytes for our bank:
-  if (fTotNumValidBytes + numBytesRead > BANK_SIZE) {
+  if (fTotNumValidBytes + numBytesRead > fBankSize) {
     fInputSource->envir()
       << "StreamParser::afterGettingBytes() warning: read "
       << numBytesRead << " bytes; expected no more than "
-      << BANK_SIZE - fTotNumValidBytes << "\n";
+      << fBankSize - fTotNumValidBytes << "\n";
   }
 
   fLastSeenPresentationTime = presentationTime;
@@ -184,6 +253,9 @@ void StreamParser::afterGettingBytes1(unsigned numBytesRead, struct timeval pres
   unsigned char* ptr = &curBank()[fTotNumValidBytes];
   fTotNumValidBytes += numBytesRead;
 
+  if (!fParserIsWaitingForInput) return; // this was a prefetch; the parser will use the new data when it gets to it
+  fParserIsWaitingForInput = False;
+
   // Continue our original calling source where it left off:
   restoreSavedParserState();
       // Sigh... this is a crock; things would have been a lot simpler
@@ -197,6 +269,12 @@ void StreamParser::onInputClosure(void* clientData) {
 }
 
 void StreamParser::onInputClosure1() {
+  if (!fParserIsWaitingForInput) {
+    // Our input source closed during a prefetch.  Don't tell the parser about this until it runs out of data:
+    fPrefetchSawEOF = True;
+    return;
+  }
+
   if (!fHaveSeenEOF) {
     // We're hitting EOF for the first time.  Set our 'EOF' flag, and continue parsing, as if we'd just read 0 bytes of data.
     // This allows the parser to re-parse any remaining unparsed data (perhaps while testing for EOF at the end):
@@ -204,6 +282,7 @@ void StreamParser::onInputClosure1() {
     afterGettingBytes1(0, fLastSeenPresentationTime);
   } else {
     // We're hitting EOF for the second time.  Now, we handle the source input closure:
+    fParserIsWaitingForInput = False;
     fHaveSeenEOF = False;
     if (fClientOnInputCloseFunc != NULL) (*fClientOnInputCloseFunc)(fClientOnInputCloseClientData);
   }
@@ -25,10 +25,28 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "FramedSource.hh"
 #endif
 
+// Each of our two 'banks' starts at this size, but grows (by doubling) whenever a parser's saved state - plus the data
+// that it still needs - no longer fits, up to this maximum:
+#ifndef STREAM_PARSER_MAX_BANK_SIZE
+#define STREAM_PARSER_MAX_BANK_SIZE (16*1024*1024)
+#endif
+// Whenever our current bank has at least this much free space (after a read), we ask our input source for more data
+// right away - rather than waiting until the parser runs out - so that the read overlaps with parsing:
+#ifndef STREAM_PARSER_MIN_PREFETCH_SIZE
+#define STREAM_PARSER_MIN_PREFETCH_SIZE 4096
+#endif
+
 class StreamParser {
 public:
   virtual void flushInput();
 
+  // Statistics:
+  u_int64_t numInputReads() const { return fNumInputReads; }
+  u_int64_t numInputStalls() const { return fNumInputStalls; }
+      // the number of times that parsing had to stop, to wait for data from the input source
+  u_int64_t numPrefetches() const { return fNumPrefetches; }
+      // the number of reads that were requested before the parser needed the data
+
 protected: // we're a virtual base class
   typedef void (clientContinueFunc)(void* clientData,
 				    unsigned char* ptr, unsigned size,
@@ -40,9 +58,18 @@ protected: // we're a virtual base class
 	       void* clientContinueClientData);
   virtual ~StreamParser();
 
-  void saveParserState();
+  void saveParserState() {
+    fSavedParserIndex = fCurParserIndex;
+    fSavedRemainingUnparsedBits = fRemainingUnparsedBits;
+
+    if (fBankSize - fTotNumValidBytes >= fMinPrefetchSize) prefetch();
+  }
   virtual void restoreSavedParserState();
 
+  void disablePrefetching() { fMinPrefetchSize = ~0; }
+      // Prefetched data is not passed to the 'client continue' function, so a parser must call this if that function
+      // needs to see (e.g., to edit, or to get the presentation time of) the data from each read.
+
   u_int32_t get4Bytes() { // byte-aligned; returned in big-endian order
     u_int32_t result = test4Bytes();
     fCurParserIndex += 4;
@@ -106,11 +133,20 @@ protected: // we're a virtual base class
 
   unsigned curOffset() const { return fCurParserIndex; }
 
+  unsigned numBufferedBytes() const { return fTotNumValidBytes - fCurParserIndex; }
+      // the number of not-yet-parsed bytes that we can access without reading more data from our input source
+  unsigned char const* bufferedBytes() { return nextToParse(); }
+      // direct access to these bytes (valid only until we next read from our input source)
+
   unsigned& totNumValidBytes() { return fTotNumValidBytes; }
 
   Boolean haveSeenEOF() const { return fHaveSeenEOF; }
 
-  unsigned bankSize() const;
+  Boolean isWaitingForInput() const { return fParserIsWaitingForInput && fInputSource->isCurrentlyAwaitingData(); }
+      // True iff parsing stopped because we ran out of data, and will be continued (via the 'client continue' function)
+      // once more data arrives.  (Our input source might also be being read at other times, because of a prefetch.)
+
+  unsigned bankSize() const { return fBankSize; }
 
 private:
   unsigned char* curBank() { return fCurBank; }
@@ -125,6 +161,9 @@ private:
     ensureValidBytes1(numBytesNeeded);
   }
   void ensureValidBytes1(unsigned numBytesNeeded);
+  void growBanks(unsigned minBankSize);
+  void prefetch();
+  void readFromInputSource(Boolean parserIsWaiting);
 
   static void afterGettingBytes(void* clientData, unsigned numBytesRead,
 				unsigned numTruncatedBytes,
@@ -146,6 +185,16 @@ private:
   unsigned char* fBank[2];
   unsigned char fCurBankNum;
   unsigned char* fCurBank;
+  unsigned fBankSize; // of each bank
+
+  // A read from our input source is pending iff "fInputSource->isCurrentlyAwaitingData()".  It's either a 'prefetch',
+  // or a read that the parser needs before it can continue:
+  Boolean fParserIsWaitingForInput;
+  Boolean fPrefetchSawEOF; // the input source closed during a prefetch; the parser will be told when it next runs out
+  unsigned fMinPrefetchSize; // > our bank size, if prefetching is not possible (or has been disabled)
+
+  u_int64_t fNumInputReads, fNumInputStalls, fNumPrefetches;
+  class StreamParserMetrics* fMetrics; // NULL if metrics are not enabled
 
   // The most recent 'saved' parse position:
   unsigned fSavedParserIndex; // <= fCurParserIndex
@@ -156,7 +205,7 @@ private:
   unsigned char fRemainingUnparsedBits; // in previous byte: [0,7]
 
   // The total number of valid bytes stored in the current bank:
-  unsigned fTotNumValidBytes; // <= BANK_SIZE
+  unsigned fTotNumValidBytes; // <= fBankSize
 
   // Whether we have seen EOF on the input source:
   Boolean fHaveSeenEOF;
@@ -19,6 +19,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation.
 
 #include "StreamReplicator.hh"
+#include "MediaMetrics.hh"
 
 ////////// Definition of "StreamReplica": The class that implements each stream replica //////////
 
@@ -54,15 +55,24 @@ StreamReplicator::StreamReplicator(UsageEnvironment& env, FramedSource* inputSou
   : Medium(env),
     fInputSource(inputSource), fDeleteWhenLastReplicaDies(deleteWhenLastReplicaDies), fInputSourceHasClosed(False),
     fNumReplicas(0), fNumActiveReplicas(0), fNumDeliveriesMadeSoFar(0),
-    fFrameIndex(0), fPrimaryReplica(NULL), fReplicasAwaitingCurrentFrame(NULL), fReplicasAwaitingNextFrame(NULL) {
+    fFrameIndex(0), fPrimaryReplica(NULL), fReplicasAwaitingCurrentFrame(NULL), fReplicasAwaitingNextFrame(NULL),
+    fMetrics(NULL) {
+  MetricsRegistry* metricsRegistry = MetricsRegistry::lookup(env);
+  if (metricsRegistry != NULL) {
+    char labels[100];
+    snprintf(labels, sizeof labels, "medium=\"%s\"", name());
+    fMetrics = new StreamReplicatorMetrics(*metricsRegistry, labels);
+  }
 }
 
 StreamReplicator::~StreamReplicator() {
   Medium::close(fInputSource);
+  delete fMetrics;
 }
 
 FramedSource* StreamReplicator::createStreamReplica() {
   ++fNumReplicas;
+  if (fMetrics != NULL) fMetrics->replicas.set(fNumReplicas);
   return new StreamReplica(*this);
 }
 
@@ -76,6 +86,7 @@ void StreamReplicator::getNextFrame(StreamReplica* replica) {
     // This replica had stopped playing (or had just been created), but is now actively reading.  Note this:
     replica->fFrameIndex = fFrameIndex;
     ++fNumActiveReplicas;
+    if (fMetrics != NULL) fMetrics->activeReplicas.set(fNumActiveReplicas);
   }
 
   if (fPrimaryReplica == NULL) {
@@ -108,6 +119,7 @@ void StreamReplicator::deactivateStreamReplica(StreamReplica* replicaBeingDeacti
   // Assert: fNumActiveReplicas > 0
   if (fNumActiveReplicas == 0) fprintf(stderr, "StreamReplicator::deactivateStreamReplica() Internal Error!\n"); // should not happen
   --fNumActiveReplicas;
+  if (fMetrics != NULL) fMetrics->activeReplicas.set(fNumActiveReplicas);
 
   // Forget about any frame delivery that might have just been made to this replica:
   if (replicaBeingDeactivated->fFrameIndex != fFrameIndex && fNumDeliveriesMadeSoFar > 0) --fNumDeliveriesMadeSoFar;
@@ -197,6 +209,7 @@ void StreamReplicator::removeStreamReplica(StreamReplica* replicaBeingRemoved) {
   // Assert: fNumReplicas > 0
   if (fNumReplicas == 0) fprintf(stderr, "StreamReplicator::removeStreamReplica() Internal Error!\n"); // should not happen
   --fNumReplicas;
+  if (fMetrics != NULL) fMetrics->replicas.set(fNumReplicas);
 
   // If this was the last replica, then delete ourselves (if we were set up to do so):
   if (fNumReplicas == 0 && fDeleteWhenLastReplicaDies) {
@@ -218,6 +231,10 @@ void StreamReplicator::afterGettingFrame(unsigned frameSize, unsigned numTruncat
   fPrimaryReplica->fNumTruncatedBytes = numTruncatedBytes;
   fPrimaryReplica->fPresentationTime = presentationTime;
   fPrimaryReplica->fDurationInMicroseconds = durationInMicroseconds;
+  if (fMetrics != NULL) {
+    fMetrics->framesReceived.increment();
+    if (numTruncatedBytes > 0) fMetrics->framesTruncated.increment();
+  }
 
   deliverReceivedFrame();
 }
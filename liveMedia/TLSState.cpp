@@ -29,7 +29,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 TLSState::TLSState()
   : isNeeded(False)
 #ifndef NO_OPENSSL
-  , fHasBeenSetup(False), fCtx(NULL), fCon(NULL)
+  , fHasBeenSetup(False), fSendingIsDoneByKernel(False), fCtx(NULL), fCon(NULL)
 #endif
 {
 }
@@ -48,6 +48,16 @@ int TLSState::write(const char* data, unsigned count) {
 #endif
 }
 
+int TLSState::tryWrite(const char* data, unsigned count) {
+#ifndef NO_OPENSSL
+  int result = SSL_write(fCon, data, count);
+  if (result <= 0 && SSL_get_error(fCon, result) == SSL_ERROR_WANT_WRITE) return 0; // try again later
+  return result;
+#else
+  return -1;
+#endif
+}
+
 int TLSState::read(u_int8_t* buffer, unsigned bufferSize) {
 #ifndef NO_OPENSSL
   int result = SSL_read(fCon, buffer, bufferSize);
@@ -64,16 +74,32 @@ int TLSState::read(u_int8_t* buffer, unsigned bufferSize) {
 #endif
 }
 
+Boolean TLSState::sendingIsDoneByKernel() const {
+#ifndef NO_OPENSSL
+  return fSendingIsDoneByKernel;
+#else
+  return False;
+#endif
+}
+
+Boolean TLSState::sessionWasResumed() const {
+#ifndef NO_OPENSSL
+  return fCon != NULL && SSL_session_reused(fCon) == 1;
+#else
+  return False;
+#endif
+}
+
 void TLSState::nullify() {
 #ifndef NO_OPENSSL
-  isNeeded = fHasBeenSetup = False;
+  isNeeded = fHasBeenSetup = fSendingIsDoneByKernel = False;
   fCtx = NULL;
   fCon = NULL;
 #endif
 }
 
 #ifndef NO_OPENSSL
-void TLSState::initLibrary() {
+static void initSSLLibrary() {
   static Boolean SSLLibraryHasBeenInitialized = False;
   if (!SSLLibraryHasBeenInitialized) {
     (void)SSL_library_init();
@@ -81,6 +107,10 @@ void TLSState::initLibrary() {
   }
 }
 
+void TLSState::initLibrary() {
+  initSSLLibrary();
+}
+
 void TLSState::reset() {
   if (fHasBeenSetup) SSL_shutdown(fCon);
 
@@ -178,6 +208,69 @@ Boolean ClientTLSState::setupContinue(int socketNum) {
 #endif
 
 
+////////// ServerTLSContext implementation //////////
+
+ServerTLSContext* ServerTLSContext
+::createNew(UsageEnvironment& env, char const* certFileName, char const* privKeyFileName,
+	    Boolean useKernelTLS) {
+#ifndef NO_OPENSSL
+  ServerTLSContext* context = new ServerTLSContext;
+  do {
+    initSSLLibrary();
+
+    SSL_METHOD const* meth = SSLv23_server_method();
+    if (meth == NULL) break;
+
+    SSL_CTX* ctx = context->fCtx = SSL_CTX_new(meth);
+    if (ctx == NULL) break;
+
+    if (SSL_CTX_set_ecdh_auto(ctx, 1) != 1) break;
+
+    if (SSL_CTX_use_certificate_chain_file(ctx, certFileName) != 1) break;
+
+    if (SSL_CTX_use_PrivateKey_file(ctx, privKeyFileName, SSL_FILETYPE_PEM) != 1) break;
+
+    // Allow sessions to be resumed - using either our (server-side) session cache, or session tickets (which are
+    // enabled by default, and encrypted using keys that belong to this context):
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    static unsigned char const sessionIdContext[] = "LIVE555 Streaming Media";
+    if (SSL_CTX_set_session_id_context(ctx, sessionIdContext, sizeof sessionIdContext - 1) != 1) break;
+
+    if (useKernelTLS) {
+#ifdef SSL_OP_ENABLE_KTLS
+      SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#else
+      env << "ServerTLSContext: Warning: This version of OpenSSL does not support kernel TLS\n";
+#endif
+    }
+
+    return context;
+  } while (0);
+
+  // An error occurred:
+  env.setResultMsg("Failed to set up TLS context (check the certificate and private key files)");
+  ERR_print_errors_fp(stderr);
+  delete context;
+#endif
+  return NULL;
+}
+
+ServerTLSContext::ServerTLSContext()
+#ifndef NO_OPENSSL
+  : fCtx(NULL)
+#endif
+{
+}
+
+ServerTLSContext::~ServerTLSContext() {
+#ifndef NO_OPENSSL
+  // Note: Each connection that uses our "SSL_CTX" holds its own reference to it, so it remains valid (for them)
+  // after we're gone.
+  if (fCtx != NULL) SSL_CTX_free(fCtx);
+#endif
+}
+
+
 ////////// ServerTLSState implementation //////////
 
 ServerTLSState::ServerTLSState(UsageEnvironment& env)
@@ -199,10 +292,21 @@ void ServerTLSState
 #endif
 }
 
+void ServerTLSState::setContext(ServerTLSContext* context) {
+#ifndef NO_OPENSSL
+  // Take our own reference to the context's "SSL_CTX" now - rather than later, in "setup()" - because the
+  // "ServerTLSContext" might get deleted (e.g., if the server's certificate is changed) before then:
+  if (fCtx != NULL) SSL_CTX_free(fCtx);
+  fCtx = context == NULL ? NULL : context->ctx();
+  if (fCtx != NULL) SSL_CTX_up_ref(fCtx);
+#endif
+}
+
 void ServerTLSState::assignStateFrom(ServerTLSState const& from) {
 #ifndef NO_OPENSSL
   isNeeded = from.isNeeded;
   fHasBeenSetup = from.fHasBeenSetup;
+  fSendingIsDoneByKernel = from.fSendingIsDoneByKernel;
   fCtx = from.fCtx;
   fCon = from.fCon;
 
@@ -219,6 +323,12 @@ int ServerTLSState::accept(int socketNum) {
   int sslGetErrorResult = SSL_get_error(fCon, sslAcceptResult);
 
   if (sslAcceptResult > 0) {
+    // Check whether the kernel will now be doing our TLS record encryption:
+#ifdef BIO_get_ktls_send
+    fSendingIsDoneByKernel = BIO_get_ktls_send(SSL_get_wbio(fCon)) != 0;
+#else
+    fSendingIsDoneByKernel = False; // this version of OpenSSL doesn't support kernel TLS
+#endif
     return sslAcceptResult; // success
   } else if (sslAcceptResult < 0 && sslGetErrorResult == SSL_ERROR_WANT_READ) {
     // We need to wait until the socket is readable:
@@ -237,17 +347,19 @@ Boolean ServerTLSState::setup(int socketNum) {
   do {
     initLibrary();
 
-    SSL_METHOD const* meth = SSLv23_server_method();
-    if (meth == NULL) break;
+    if (fCtx == NULL) { // we weren't given the server's shared context (see "setContext()"), so set up our own:
+      SSL_METHOD const* meth = SSLv23_server_method();
+      if (meth == NULL) break;
 
-    fCtx = SSL_CTX_new(meth);
-    if (fCtx == NULL) break;
+      fCtx = SSL_CTX_new(meth);
+      if (fCtx == NULL) break;
 
-    if (SSL_CTX_set_ecdh_auto(fCtx, 1) != 1) break;
+      if (SSL_CTX_set_ecdh_auto(fCtx, 1) != 1) break;
 
-    if (SSL_CTX_use_certificate_chain_file(fCtx, fCertificateFileName) != 1) break;
+      if (SSL_CTX_use_certificate_chain_file(fCtx, fCertificateFileName) != 1) break;
 
-    if (SSL_CTX_use_PrivateKey_file(fCtx, fPrivateKeyFileName, SSL_FILETYPE_PEM) != 1) break;
+      if (SSL_CTX_use_PrivateKey_file(fCtx, fPrivateKeyFileName, SSL_FILETYPE_PEM) != 1) break;
+    }
 
     fCon = SSL_new(fCtx);
     if (fCon == NULL) break;
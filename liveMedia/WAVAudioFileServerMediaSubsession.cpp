@@ -226,3 +226,7 @@ void WAVAudioFileServerMediaSubsession::testScaleFactor(float& scale) {
 float WAVAudioFileServerMediaSubsession::duration() const {
   return fFileDuration;
 }
+
+void WAVAudioFileServerMediaSubsession::setDurationFromMetadataCache(float duration) {
+  fFileDuration = duration;
+}
@@ -36,8 +36,22 @@ unsigned char* base64Decode(char const* in, unsigned inSize,
     // As above, but includes the size of the input string (i.e., the number of bytes to decode) as a parameter.
     // This saves an extra call to "strlen()" if we already know the length of the input string.
 
+unsigned base64DecodeInto(char const* in, unsigned inSize, unsigned char* out,
+			  Boolean trimTrailingZeros = True);
+    // As above, but - rather than allocating a new array - decodes into "out", which must have space for at least
+    // "base64DecodedMaxSize(inSize)" bytes.  Returns the number of bytes decoded.
+    // "out" may be the same as "in" (i.e., the data may be decoded in place).
+
+inline unsigned base64DecodedMaxSize(unsigned inSize) { return (inSize/4)*3; }
+
 char* base64Encode(char const* orig, unsigned origLength);
     // returns a 0-terminated string that
     // the caller is responsible for delete[]ing.
 
+unsigned base64EncodeInto(char const* orig, unsigned origLength, char* out);
+    // As above, but - rather than allocating a new string - encodes into "out", which must have space for at least
+    // "base64EncodedSize(origLength)" + 1 bytes (allowing for the trailing '\0').  Returns the length of the result.
+
+inline unsigned base64EncodedSize(unsigned origLength) { return 4*((origLength+2)/3); }
+
 #endif
@@ -24,6 +24,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _BOOLEAN_HH
 #include "Boolean.hh"
 #endif
+#ifndef _NET_COMMON_H
+#include "NetCommon.h"
+#endif
 
 class BitVector {
 public:
@@ -59,6 +62,60 @@ private:
   unsigned fCurBitIndex;
 };
 
+// A read-only alternative to "BitVector", for parsing headers (e.g., H.264/H.265 parameter sets and SEI messages).
+// The next (up to 64) bits are cached in a word, so the common cases - reading a field of up to 32 bits, a single bit,
+// or a (short) exponential-Golomb code - are inline shifts and masks, rather than bit-at-a-time copies.
+// As with "BitVector", bits beyond the end of the data are read as 0.
+class BitReader {
+public:
+  BitReader(u_int8_t const* baseBytePtr,
+	    unsigned baseBitOffset,
+	    unsigned totNumBits);
+
+  unsigned getBits(unsigned numBits) { // "numBits" <= 32
+    if (numBits == 0) return 0;
+    if (numBits > 32) numBits = 32;
+    if (numBits > fNumCachedBits) refill();
+
+    unsigned result = (unsigned)(fCache >> (64-numBits));
+    fCache <<= numBits; fNumCachedBits -= numBits;
+    fCurBitIndex += numBits;
+    return result;
+  }
+  unsigned get1Bit() {
+    if (fNumCachedBits == 0) refill();
+
+    unsigned result = (unsigned)(fCache >> 63);
+    fCache <<= 1; --fNumCachedBits;
+    ++fCurBitIndex;
+    return result;
+  }
+  Boolean get1BitBoolean() { return get1Bit() != 0; }
+
+  void skipBits(unsigned numBits);
+
+  unsigned curBitIndex() const { return fCurBitIndex < fTotNumBits ? fCurBitIndex : fTotNumBits; }
+  unsigned totNumBits() const { return fTotNumBits; }
+  unsigned numBitsRemaining() const { return fTotNumBits - curBitIndex(); }
+
+  unsigned get_expGolomb();
+      // Returns the value of the next bits, assuming that they were encoded using an exponential-Golomb code of order 0
+  int get_expGolombSigned(); // signed version of the above
+
+private:
+  void refill(); // ensures that at least 57 bits are cached (with 0s beyond the end of the data)
+  unsigned get_expGolomb1(); // the general (slow) case of "get_expGolomb()"
+
+private:
+  u_int8_t const* fNextByte; // the next byte to be cached
+  u_int8_t const* fLimit; // just past the last byte of data
+  u_int8_t fLastByteMask; // selects the bits of the last byte that lie within the data
+  u_int64_t fCache; // the next "fNumCachedBits" bits, in the high-order bits of the word; then 0s
+  unsigned fNumCachedBits;
+  unsigned fTotNumBits;
+  unsigned fCurBitIndex; // may exceed "fTotNumBits", if we've read past the end
+};
+
 // A general bit copy operation:
 void shiftBits(unsigned char* toBasePtr, unsigned toBitOffset,
 	       unsigned char const* fromBasePtr, unsigned fromBitOffset,
@@ -0,0 +1,83 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// A per-environment pool of buffers for incoming RTP packets (used by "BufferedPacket")
+// C++ header
+
+#ifndef _BUFFERED_PACKET_POOL_HH
+#define _BUFFERED_PACKET_POOL_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+
+// Most incoming RTP packets fit within a 'small' slot.  (The default size allows for an Ethernet-MTU-sized packet,
+// plus the headroom that some "BufferedPacket" subclasses reserve in front of the packet data (e.g., JPEG's 1024 bytes).)
+// Small slots are allocated in 'slabs', and are recycled through a free list.
+// 'Large' slots - big enough for any packet - are used only for packets that don't fit in a small slot (e.g., large
+// packets interleaved over TCP).
+#ifndef BUFFERED_PACKET_POOL_SMALL_SLOT_SIZE
+#define BUFFERED_PACKET_POOL_SMALL_SLOT_SIZE 4096
+#endif
+#ifndef BUFFERED_PACKET_POOL_SLOTS_PER_SLAB
+#define BUFFERED_PACKET_POOL_SLOTS_PER_SLAB 16
+#endif
+#define BUFFERED_PACKET_POOL_LARGE_SLOT_SIZE 65536
+#ifndef BUFFERED_PACKET_POOL_MAX_FREE_LARGE_SLOTS
+#define BUFFERED_PACKET_POOL_MAX_FREE_LARGE_SLOTS 4
+    // any more free large slots than this are deleted, rather than kept for reuse
+#endif
+
+class BufferedPacketPool {
+public:
+  static BufferedPacketPool& ourPool(UsageEnvironment& env); // creates the pool for "env", if it doesn't already exist
+  static BufferedPacketPool* lookup(UsageEnvironment& env); // returns NULL if there's currently no pool for "env"
+
+  unsigned char* allocateSlot(unsigned minSize, unsigned& resultSlotSize);
+      // Returns a slot of at least "minSize" bytes (or BUFFERED_PACKET_POOL_LARGE_SLOT_SIZE bytes, if that's smaller).
+  void freeSlot(unsigned char* slot, unsigned slotSize);
+      // Note: When the last allocated slot is freed, the pool deletes itself.
+
+  void noteTruncatedDatagram(); // called if an incoming datagram didn't fit in a small slot
+
+  // Pool occupancy statistics:
+  unsigned numSmallSlots() const { return fNumSmallSlots; }
+  unsigned numSmallSlotsInUse() const { return fNumSmallSlotsInUse; }
+  unsigned numLargeSlots() const { return fNumLargeSlots; }
+  unsigned numLargeSlotsInUse() const { return fNumLargeSlotsInUse; }
+  u_int64_t numTruncatedDatagrams() const { return fNumTruncatedDatagrams; }
+
+private:
+  BufferedPacketPool(UsageEnvironment& env);
+  virtual ~BufferedPacketPool();
+
+  void addSlab();
+  void updateMetrics();
+
+private:
+  UsageEnvironment& fEnv;
+  class BufferedPacketPoolSlab* fSlabs;
+  unsigned char* fFreeSmallSlots; // a list, linked through the first bytes of each free slot
+  unsigned char* fFreeLargeSlots; // ditto
+  unsigned fNumFreeLargeSlots;
+  unsigned fNumSmallSlots, fNumSmallSlotsInUse;
+  unsigned fNumLargeSlots, fNumLargeSlotsInUse;
+  u_int64_t fNumTruncatedDatagrams;
+  class BufferedPacketPoolMetrics* fMetrics; // NULL unless metrics are enabled
+};
+
+#endif
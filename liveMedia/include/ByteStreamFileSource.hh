@@ -49,6 +49,10 @@ public:
   void seekToByteRelative(int64_t offset, u_int64_t numBytesToStream = 0);
   void seekToEnd(); // to force EOF handling on the next read
 
+  unsigned preferredFrameSize() const { return fPreferredFrameSize; }
+  void setPreferredFrameSize(unsigned preferredFrameSize) { fPreferredFrameSize = preferredFrameSize; }
+      // takes effect from the next read
+
 protected:
   ByteStreamFileSource(UsageEnvironment& env,
 		       FILE* fid,
@@ -57,6 +57,7 @@ private:
 private:
   static void deliverFrame0(void* clientData);
   void deliverFrame();
+  static void releaseFrame(void* clientData, unsigned char* frame);
 
 private:
   static unsigned referenceCount; // used to count how many instances of this class currently exist
@@ -35,6 +35,9 @@ protected: // we're a virtual base class
 			    Boolean reuseFirstSource);
   virtual ~FileServerMediaSubsession();
 
+protected: // redefined virtual functions
+  virtual char const* metadataCacheFileName() const;
+
 protected:
   char const* fFileName;
   u_int64_t fFileSize; // if known
@@ -0,0 +1,107 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// XOR-based Forward Error Correction for RTP streams ("flexfec": RFC 8627)
+// C++ header
+
+#ifndef _FLEX_FEC_HH
+#define _FLEX_FEC_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+
+// We implement the simplest form of "flexfec": 1-D, non-interleaved ('row') protection, using the fixed ("F=1") FEC
+// header, with "D" = 0.  Each repair packet is the XOR of "L" consecutive media packets, so a receiver can recover
+// any single packet that's lost from each such group.  Repair packets are sent in the same RTP session as the media,
+// but with their own payload type, SSRC and sequence numbers; their CSRC list contains the SSRC of the protected stream.
+
+class FlexFECEncoder {
+public:
+  FlexFECEncoder(unsigned char fecPayloadType, unsigned numPacketsPerRepairPacket /* "L" */, unsigned maxPacketSize);
+  virtual ~FlexFECEncoder();
+
+  Boolean addPacket(unsigned char const* packet, unsigned packetSize);
+      // Adds a (just sent) media packet to those being protected.  Returns True if a repair packet is now ready to be
+      // sent (because we've now seen "L" media packets since the last one).
+  unsigned char* repairPacket() const { return fRepairPacket; }
+  unsigned repairPacketSize() const { return fRepairPacketSize; }
+
+  unsigned numPacketsPerRepairPacket() const { return fNumPacketsPerRepairPacket; }
+  u_int32_t SSRC() const { return fSSRC; }
+
+private:
+  void buildRepairPacket(u_int32_t protectedSSRC);
+
+private:
+  unsigned char fFECPayloadType;
+  unsigned fNumPacketsPerRepairPacket;
+  unsigned fMaxPayloadSize;
+  u_int16_t fSeqNo;
+  u_int32_t fSSRC;
+
+  // The XOR of the media packets protected so far in the current group:
+  unsigned fNumPacketsProtected;
+  u_int16_t fSNBase;
+  u_int32_t fLastTimestamp;
+  unsigned char fHeaderBitsXOR[2]; // the first two bytes of each RTP header (P, X, CC, M, PT)
+  u_int16_t fLengthXOR;
+  u_int32_t fTimestampXOR;
+  unsigned char* fPayloadXOR;
+  unsigned fMaxPayloadSizeProtected;
+
+  unsigned char* fRepairPacket;
+  unsigned fRepairPacketSize;
+};
+
+#ifndef FLEXFEC_DECODER_HISTORY_SIZE
+#define FLEXFEC_DECODER_HISTORY_SIZE 128 // media packets
+#endif
+#ifndef FLEXFEC_DECODER_MAX_PACKET_SIZE
+#define FLEXFEC_DECODER_MAX_PACKET_SIZE 2048 // larger media packets can't be used to recover others
+#endif
+
+class FlexFECDecoder {
+public:
+  FlexFECDecoder();
+  virtual ~FlexFECDecoder();
+
+  void addMediaPacket(unsigned char const* packet, unsigned packetSize);
+      // Remembers a received media packet, in case it's needed to recover another (lost) packet later.
+
+  unsigned char const* recoverPacket(unsigned char const* repairPacket, unsigned repairPacketSize,
+				     unsigned& recoveredPacketSize);
+      // If exactly one of the media packets protected by "repairPacket" is missing, then returns it (rebuilt from the
+      // repair packet and the others).  Otherwise (or if the repair packet isn't of a form that we handle), returns NULL.
+      // The result remains valid only until the next call to "recoverPacket()".
+
+private:
+  struct Slot {
+    u_int16_t fSeqNum;
+    u_int32_t fSSRC;
+    unsigned fPacketSize; // 0 if the slot is empty
+  };
+  Slot* lookupSlot(u_int16_t seqNum, u_int32_t SSRC);
+  unsigned char* slotPacket(u_int16_t seqNum) { return &fPackets[(seqNum%FLEXFEC_DECODER_HISTORY_SIZE)*FLEXFEC_DECODER_MAX_PACKET_SIZE]; }
+
+private:
+  unsigned char* fPackets;
+  Slot fSlots[FLEXFEC_DECODER_HISTORY_SIZE];
+  unsigned char* fRecoveredPacket;
+};
+
+#endif
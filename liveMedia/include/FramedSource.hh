@@ -51,6 +51,17 @@ public:
 
   void stopGettingFrames();
 
+  // Optional 'zero-copy' delivery.  A source whose frames already sit in memory that it owns (e.g., a hardware encoder's
+  // output buffers) can 'lend' a frame to the downstream object, instead of copying it to the "to" buffer:
+  typedef void (releaseFrameFunc)(void* clientData, unsigned char* frame);
+  void allowBorrowedFrame() { fBorrowedFrameIsAllowed = True; }
+      // Called by a downstream object (that supports borrowed frames) just before each call to "getNextFrame()"
+  Boolean takeBorrowedFrame(unsigned char*& frame, releaseFrameFunc*& releaseFunc, void*& releaseClientData);
+      // Called by the downstream object from its 'after getting' function.  Returns True iff the frame that was just
+      // delivered was borrowed.  In that case, the frame's "frameSize" bytes are at "frame" (nothing was written to "to"),
+      // and the caller must call "(*releaseFunc)(releaseClientData, frame)" when it has finished with the data.
+      // (If the downstream object doesn't take a borrowed frame, it gets released when the next frame is requested.)
+
   virtual unsigned maxFrameSize() const;
       // size of the largest possible frame that we may serve, or 0
       // if no such maximum is known (default)
@@ -70,6 +81,14 @@ protected:
 
   virtual void doStopGettingFrames();
 
+  Boolean borrowedFrameIsAllowed() const { return fBorrowedFrameIsAllowed; }
+  void deliverBorrowedFrame(unsigned char* frame, unsigned frameSize,
+			    releaseFrameFunc* releaseFunc, void* releaseClientData);
+      // Can be called (instead of copying the frame to "fTo") by "doGetNextFrame()" (or code that it schedules),
+      // but only if "borrowedFrameIsAllowed()".  Sets "fFrameSize"; "afterGetting()" must still be called afterwards.
+  void releaseBorrowedFrame(); // releases any borrowed frame that the downstream object didn't take
+      // (A subclass that lends frames should call this in its destructor, while "releaseFunc" can still be called safely.)
+
 protected:
   // The following variables are typically accessed/set by doGetNextFrame()
   unsigned char* fTo; // in
@@ -90,6 +109,11 @@ private:
   void* fOnCloseClientData;
 
   Boolean fIsCurrentlyAwaitingData;
+
+  Boolean fBorrowedFrameIsAllowed;
+  unsigned char* fBorrowedFrame; // non-NULL iff a borrowed frame has been delivered, but not yet taken
+  releaseFrameFunc* fBorrowedFrameReleaseFunc;
+  void* fBorrowedFrameReleaseClientData;
 };
 
 #endif
@@ -96,7 +96,7 @@ protected:
   void incomingConnectionHandlerIPv6();
   void incomingConnectionHandlerOnSocket(int serverSocket);
 
-  void setTLSFileNames(char const* certFileName, char const* privKeyFileName);
+  void setTLSFileNames(char const* certFileName, char const* privKeyFileName, Boolean useKernelTLS = False);
 
 public: // should be protected, but some old compilers complain otherwise
   // The state of a TCP connection used by a client:
@@ -193,6 +193,10 @@ private:
 
   char const* fTLSCertificateFileName;
   char const* fTLSPrivateKeyFileName;
+  Boolean fTLSUsesKernelTLS;
+  ServerTLSContext* fTLSContext; // shared by our TLS connections; created when the first is accepted
+
+  class MediaServerMetrics* fMetrics; // NULL unless metrics are enabled
 };
 
 // A data structure used for optional user/password authentication:
@@ -41,11 +41,12 @@ protected:
       // called only by createNew();
   virtual ~H265VideoFileServerMediaSubsession();
 
-  void setDoneFlag() { fDoneFlag = ~0; }
+  void setDoneFlag() { fDoneFlag = ~0; auxSDPLineIsReady(); }
 
 protected: // redefined virtual functions
   virtual char const* getAuxSDPLine(RTPSink* rtpSink,
 				    FramedSource* inputSource);
+  virtual Boolean startGettingAuxSDPLine(RTPSink* rtpSink, FramedSource* inputSource);
   virtual FramedSource* createNewStreamSource(unsigned clientSessionId,
 					      unsigned& estBitrate);
   virtual RTPSink* createNewRTPSink(Groupsock* rtpGroupsock,
@@ -0,0 +1,114 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// A sink that delivers a "ServerMediaSession" - as a MPEG Transport Stream - to one or more HTTP clients
+// C++ header
+
+#ifndef _HTTP_STREAMER_HH
+#define _HTTP_STREAMER_HH
+
+#ifndef _MEDIA_SINK_HH
+#include "MediaSink.hh"
+#endif
+#ifndef _SERVER_MEDIA_SESSION_HH
+#include "ServerMediaSession.hh"
+#endif
+
+// We read the session's Transport Stream - paced using its PCRs - in 'chunks' of this size.  Each chunk is sent (using
+// HTTP 'chunked' transfer encoding) to each of our clients; a single copy of the chunk is shared by all of them.
+#ifndef HTTP_STREAMER_CHUNK_SIZE
+#define HTTP_STREAMER_CHUNK_SIZE (20*188)
+#endif
+// Each client has its own queue of chunks that are waiting to be sent.  If a (slow) client's queue is full, then new
+// chunks are not sent to that client.  (Each chunk contains only complete Transport Stream packets, so its receiver
+// will see a discontinuity, rather than corrupt data.)
+#ifndef HTTP_STREAMER_MAX_QUEUED_CHUNKS
+#define HTTP_STREAMER_MAX_QUEUED_CHUNKS 128 // per client
+#endif
+#ifndef HTTP_STREAMER_MAX_INPUT_SOURCES
+#define HTTP_STREAMER_MAX_INPUT_SOURCES 4
+#endif
+
+typedef void HTTPStreamerEndedFunc(void* clientData, class HTTPStreamer* streamer);
+
+class HTTPStreamer: public MediaSink {
+public:
+  static HTTPStreamer* createNew(UsageEnvironment& env, ServerMediaSession& session, unsigned clientSessionId,
+				 HTTPStreamerEndedFunc* endedFunc, void* endedClientData);
+      // Returns NULL if none of "session"s subsessions can be delivered as (or within) a Transport Stream.
+      // (Currently, we deliver a subsession that's already a Transport Stream, or else multiplex any H.264 and
+      // H.265 video subsessions into a new Transport Stream.)
+      // "endedFunc" is called (from the event loop) when we no longer have any clients; it should close us.
+
+  void addClient(int socketNum);
+      // Begins streaming (with a HTTP response header) to the (already connected, non-blocking) socket "socketNum".
+      // We take ownership of the socket, and close it when the client goes away, or when the stream ends.
+
+  ServerMediaSession& session() const { return fSession; }
+  Boolean isShared() const { return fIsShared; } // i.e., whether new clients may join this stream
+  Boolean hasEnded() const { return fHasEnded; }
+  unsigned numClients() const { return fNumClients; }
+  u_int64_t numChunksDropped() const { return fNumChunksDropped; } // because a client's queue was full
+
+protected:
+  HTTPStreamer(UsageEnvironment& env, ServerMediaSession& session, unsigned clientSessionId,
+	       HTTPStreamerEndedFunc* endedFunc, void* endedClientData);
+      // called only by createNew()
+  virtual ~HTTPStreamer();
+
+private: // redefined virtual functions:
+  virtual Boolean continuePlaying();
+
+private:
+  friend class HTTPStreamerClient;
+  void removeClient(class HTTPStreamerClient* client); // also deletes it
+  void noteNoClients();
+  void closeSources();
+  void deliverChunk(class HTTPStreamerChunk* chunk, Boolean isFinalChunk);
+
+  static void afterGettingFrame(void* clientData, unsigned frameSize, unsigned numTruncatedBytes,
+				struct timeval presentationTime, unsigned durationInMicroseconds);
+  void afterGettingFrame1(unsigned frameSize, unsigned durationInMicroseconds);
+  static void readNext(void* clientData);
+  static void afterPlaying(void* clientData);
+  void afterPlaying1();
+  static void endedHandler(void* clientData);
+
+private:
+  ServerMediaSession& fSession;
+  unsigned fClientSessionId;
+  Boolean fIsShared, fHasEnded;
+
+  // The subsessions' sources (and the objects that we use to deliver them as a Transport Stream):
+  unsigned fNumInputs;
+  ServerMediaSubsession* fInputSubsessions[HTTP_STREAMER_MAX_INPUT_SOURCES];
+  FramedSource* fInputSources[HTTP_STREAMER_MAX_INPUT_SOURCES];
+  class FramedFilter* fInputFramers[HTTP_STREAMER_MAX_INPUT_SOURCES]; // NULL if we deliver the input directly
+  FramedSource* fTSSource;
+  Boolean fWeCreatedTSSource; // if True, "fTSSource" (and any "fInputFramers[]") are our own, not the subsessions'
+
+  unsigned char* fBuffer;
+  struct timeval fNextReadTime;
+  class HTTPStreamerClient* fClients; // a linked list
+  unsigned fNumClients;
+  u_int64_t fNumChunksDropped;
+  HTTPStreamerEndedFunc* fEndedFunc;
+  void* fEndedClientData;
+  TaskToken fEndedTask;
+};
+
+#endif
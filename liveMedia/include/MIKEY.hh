@@ -30,8 +30,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 class MIKEYState {
 public:
-  static MIKEYState* createNew(Boolean useEncryption = True);
-      // initialize with default parameters
+  static MIKEYState* createNew(Boolean useEncryption = True, Boolean useAESGCM = False);
+      // initialize with default parameters.  If "useEncryption" and "useAESGCM" are both True, then the AEAD_AES_128_GCM
+      // ciphersuite (RFC 7714) is used; otherwise AES_CM_128_HMAC_SHA1_80.
   static MIKEYState* createNew(u_int8_t const* messageToParse, unsigned messageSize);
       // (Attempts to) parse a binary MIKEY message, returning a new "MIKEYState" if successful
       // (or NULL if unsuccessful).
@@ -47,13 +48,15 @@ public:
   // Accessors for the encryption/authentication parameters:
   Boolean encryptSRTP() const { return fEncryptSRTP; }
   Boolean encryptSRTCP() const { return fEncryptSRTCP; }
+  Boolean useAESGCM() const { return fUseAESGCM; }
   u_int8_t const* keyData() const { return fKeyData; }
+  unsigned keyDataLength() const { return fKeyDataLength; } // encryption key length (16) + salt length (14, or 12 for AES-GCM)
   u_int32_t MKI() const { return fMKI; }
   u_int32_t initialROC() const { return fInitialROC; }
   Boolean useAuthentication() const { return fUseAuthentication; }
 
 protected:
-  MIKEYState(Boolean useEncryption);
+  MIKEYState(Boolean useEncryption, Boolean useAESGCM);
       // called only by "createNew()"
   MIKEYState(u_int8_t const* messageToParse, unsigned messageSize, Boolean& parsedOK);
       // called only by "createNew()"
@@ -68,7 +71,9 @@ private:
   // (if the second constructor is used):
   Boolean fEncryptSRTP;
   Boolean fEncryptSRTCP;
+  Boolean fUseAESGCM;
   u_int8_t fKeyData[16+14]; // encryption key + salt
+  unsigned fKeyDataLength;
   u_int32_t fMKI; // used only if encryption is used. (We assume a MKI length of 4.)
   u_int32_t fInitialROC; // initial SRTP roll-over-counter (assumes just one crypto session)
   Boolean fUseAuthentication;
@@ -30,16 +30,26 @@ public:
   static MPEG2TransportStreamDemux* createNew(UsageEnvironment& env,
 					      FramedSource* inputSource,
 					      FramedSource::onCloseFunc* onCloseFunc,
-					      void* onCloseClientData);
+					      void* onCloseClientData,
+					      UsageEnvironment* const* workerEnvs = NULL,
+					      unsigned numWorkerEnvs = 0);
+      // If "workerEnvs" is given, then each program's tracks are delivered (i.e., written to their files) by one of
+      // these environments - assigned to programs in turn - rather than by "env".  Each of these environments must
+      // already be running its event loop, in its own thread; and both they and "env" must support "postWork()".
+      // (Only the parsing of the Transport Stream - and the reassembly of each track's PES packets - is done by "env".)
+      // "onCloseFunc" is then called only after each worker has delivered all of its tracks' data.
 
 private:
   MPEG2TransportStreamDemux(UsageEnvironment& env, FramedSource* inputSource,
-			    FramedSource::onCloseFunc* onCloseFunc, void* onCloseClientData);
+			    FramedSource::onCloseFunc* onCloseFunc, void* onCloseClientData,
+			    UsageEnvironment* const* workerEnvs, unsigned numWorkerEnvs);
       // called only by createNew()
   virtual ~MPEG2TransportStreamDemux();
 
   static void handleEndOfFile(void* clientData);
   void handleEndOfFile();
+  static void handleEndOfTracks(void* clientData);
+  void handleEndOfTracks();
 
 private:
   class MPEG2TransportStreamParser* fParser;
@@ -51,6 +51,7 @@ protected:
 
 private:
   // Redefined virtual functions:
+  virtual Boolean isMPEG2TransportStreamFramer() const;
   virtual void doGetNextFrame();
   virtual void doStopGettingFrames();
 
@@ -63,6 +63,8 @@ public:
       // returns the best guess for the version of MPEG being used for data within the underlying Transport Stream file.
       // (1,2,4, or 5 (representing H.264).  0 means 'don't know' (usually because the index file is empty))
 
+  char const* fileName() const { return fFileName; }
+
 private:
   MPEG2TransportStreamIndexFile(UsageEnvironment& env, char const* indexFileName);
 
@@ -48,6 +48,12 @@ public:
       // Can be used by a downstream reader to test whether the next call to "doGetNextFrame()"
       // will deliver data immediately).
 
+  void setPreferredFrameSize(unsigned preferredFrameSize) { fPreferredFrameSize = preferredFrameSize; }
+      // Each delivery fills the reader's buffer with as many (whole) Transport Stream packets as are available and fit.
+      // If "preferredFrameSize" is nonzero, then each delivery is also limited to this many bytes (but always includes
+      // at least one Transport Stream packet).  (For example, a reader that sends each delivery in a single network
+      // packet might set this to 7*188.)
+
 protected:
   MPEG2TransportStreamMultiplexor(UsageEnvironment& env);
   virtual ~MPEG2TransportStreamMultiplexor();
@@ -71,6 +77,7 @@ private:
   virtual void doGetNextFrame();
 
 private:
+  void deliverNextPacket();
   void deliverDataToClient(u_int16_t pid, unsigned char* buffer, unsigned bufferSize,
 			   unsigned& startPositionInBuffer);
 
@@ -84,6 +91,8 @@ protected:
 
 private:
   unsigned fOutgoingPacketCounter;
+  unsigned fOutgoingFrameCounter; // each 'frame' that we deliver contains one or more Transport Stream packets
+  unsigned fPreferredFrameSize;
   unsigned fProgramMapVersion;
   u_int8_t fPreviousInputProgramMapVersion, fCurrentInputProgramMapVersion;
       // These two fields are used if we see "program_stream_map"s in the input.
@@ -35,6 +35,17 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #define TRANSPORT_PACKET_SIZE 188
 #endif
 
+// Rather than reading (and seeking to) each needed Transport Stream packet separately, we use the index file to find
+// the span of packets that contains each I-frame, and read it - up to this many packets at a time - in a single read:
+#ifndef TRICK_MODE_MAX_READ_SIZE
+#define TRICK_MODE_MAX_READ_SIZE 256 // Transport Stream packets
+#endif
+// Spans that have been read recently are kept in a per-environment cache (shared by all trick mode filters), so that
+// clients that are scanning the same parts of a file don't have to read them again.  (0 disables the cache.)
+#ifndef TRICK_MODE_CACHE_SIZE
+#define TRICK_MODE_CACHE_SIZE 2000000 // bytes
+#endif
+
 class MPEG2TransportStreamTrickModeFilter: public FramedFilter {
 public:
   static MPEG2TransportStreamTrickModeFilter*
@@ -45,7 +56,7 @@ public:
 
   unsigned long nextIndexRecordNum() const { return fNextIndexRecordNum; }
 
-  void forgetInputSource() { fInputSource = NULL; }
+  void forgetInputSource();
       // this lets us delete this without also deleting the input Transport Stream
 
 protected:
@@ -62,7 +73,8 @@ private:
 private:
   void attemptDeliveryToClient();
   void seekToTransportPacket(unsigned long tsPacketNum);
-  void readTransportPacket(unsigned long tsPacketNum); // asynchronously
+  void readTransportPackets(unsigned long tsPacketNum); // asynchronously (unless they're in our cache)
+  unsigned numTransportPacketsToRead(unsigned long tsPacketNum);
 
   static void afterGettingFrame(void* clientData, unsigned frameSize,
 				unsigned numTruncatedBytes,
@@ -86,8 +98,12 @@ private:
   unsigned fFrameCount;
   unsigned long fNextIndexRecordNum; // next to be read from the index file
   unsigned long fNextTSPacketNum; // next to be read from the transport stream file
-  unsigned char fInputBuffer[TRANSPORT_PACKET_SIZE];
-  unsigned long fCurrentTSPacketNum; // corresponding to data currently in the buffer
+  unsigned char* fInputBuffer; // TRICK_MODE_MAX_READ_SIZE Transport Stream packets
+  unsigned long fFirstBufferedTSPacketNum; // corresponding to data currently in the buffer
+  unsigned fNumBufferedTSPackets;
+  unsigned fNumTSPacketsBeingRead;
+  unsigned fSavedInputPreferredFrameSize;
+  class TrickModeCache* fCache; // NULL if TRICK_MODE_CACHE_SIZE is 0
   unsigned long fDesiredTSPacketNum;
   u_int8_t fDesiredDataOffset, fDesiredDataSize;
   float fDesiredDataPCR, fFirstPCR;
@@ -125,6 +125,11 @@ public:
 
   MediaLookupTable* mediaTable;
   void* socketTable;
+  void* metricsRegistry; // a "MetricsRegistry*"; non-NULL only if metrics have been enabled
+  void* bufferedPacketPool; // a "BufferedPacketPool*"; non-NULL only while incoming packet buffers are allocated
+  void* mediaMetadataCache; // a "MediaMetadataCache*"; non-NULL only if the cache has been enabled
+  void* trickModeCache; // a "TrickModeCache*"; non-NULL only while "MPEG2TransportStreamTrickModeFilter"s exist
+  void* serverPortPool; // a "ServerPortPool*"; non-NULL only if the pool has been enabled (or its ports are still in use)
 
 protected:
   _Tables(UsageEnvironment& env);
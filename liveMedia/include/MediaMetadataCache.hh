@@ -0,0 +1,77 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// A persistent (file-backed) cache of the SDP lines and durations of file-based "ServerMediaSubsession"s
+// C++ header
+
+#ifndef _MEDIA_METADATA_CACHE_HH
+#define _MEDIA_METADATA_CACHE_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+
+// Generating the SDP description of a file-based stream can be expensive: For some file types (e.g., H.264 or H.265
+// Video Elementary Stream files), the file must be read - within a nested event loop - until the stream's parameters
+// have been seen.  If the cache is enabled, then "OnDemandServerMediaSubsession::sdpLines()" first looks up each
+// file-based subsession's SDP lines (and duration) here, and adds them after they have been generated.
+//
+// Entries are keyed by file name, track number, address family, and whether RTCP is multiplexed with RTP, and are valid
+// only while the file's size and modification time remain unchanged.  (Note that file names are used as given - i.e.,
+// usually relative to the server's current directory - and that a file is assumed to always be streamed using the same
+// kind of "ServerMediaSubsession" (with the same parameters).)
+//
+// The cache is disabled by default.  To enable it, call "MediaMetadataCache::enable()" - before any
+// "ServerMediaSession"s are created.
+
+class MediaMetadataCache {
+public:
+  static MediaMetadataCache* enable(UsageEnvironment& env, char const* cacheFileName);
+      // Loads any existing entries from "cacheFileName"; new entries are appended to it.  If the cache is already enabled
+      // (using the same file), returns the existing cache.  Returns NULL (setting "env"s result message) on failure.
+  static void disable(UsageEnvironment& env);
+  static MediaMetadataCache* lookup(UsageEnvironment& env); // returns NULL if the cache is not enabled
+
+  char const* lookupSDPLines(char const* fileName, unsigned trackNumber, int addressFamily, Boolean rtcpIsMultiplexed,
+			     float& duration);
+      // Returns NULL if there's no valid entry for this file and track (e.g., because the file has changed since
+      // the entry was added).  The result remains valid only until the next call to "addSDPLines()".
+  void addSDPLines(char const* fileName, unsigned trackNumber, int addressFamily, Boolean rtcpIsMultiplexed,
+		   char const* sdpLines, float duration);
+
+  char const* cacheFileName() const { return fCacheFileName; }
+  unsigned numEntries() const;
+  unsigned numHits() const { return fNumHits; }
+  unsigned numMisses() const { return fNumMisses; }
+
+private:
+  MediaMetadataCache(UsageEnvironment& env, char const* cacheFileName);
+  virtual ~MediaMetadataCache();
+
+  void loadEntries(); // from the cache file
+  Boolean rewriteCacheFile(); // with just the current entries (discarding any stale ones)
+  Boolean writeEntry(FILE* fid, char const* key, class MediaMetadataCacheEntry const& entry);
+
+private:
+  UsageEnvironment& fEnv;
+  char* fCacheFileName;
+  FILE* fAppendFid; // the cache file, open for appending new entries
+  HashTable* fEntries; // indexed by a string formed from the file name, track number, etc.
+  unsigned fNumHits, fNumMisses;
+};
+
+#endif
@@ -0,0 +1,265 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// A per-environment registry of run-time metrics (counters, gauges, and fixed-bucket histograms),
+// that can be output in the Prometheus 'text exposition' format.
+// C++ header
+
+#ifndef _MEDIA_METRICS_HH
+#define _MEDIA_METRICS_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+
+// Metrics are disabled by default.  To enable them, call "MetricsRegistry::enable()" - *before* creating
+// the objects (sinks, sources, servers, etc.) that you want to be instrumented.  Each instrumented object
+// checks - once, when it is created - whether a registry exists; if not, its instrumentation is just a
+// NULL pointer, so the cost of having metrics disabled is a single pointer test at each instrumentation point.
+// (Metric values are updated using 'relaxed' atomic operations - which, on most CPUs, cost no more than plain
+// arithmetic - so they can be read (e.g., for "/metrics") while objects in other threads' environments update them.)
+
+class MetricSeries; // forward
+class RTPOverTCPMetrics; // forward
+class StreamParserMetrics; // forward
+
+class MetricsRegistry {
+public:
+  static MetricsRegistry* enable(UsageEnvironment& env);
+      // creates the registry for "env", if it doesn't already exist
+  static void disable(UsageEnvironment& env);
+      // deletes the registry for "env".  This must be done only after all instrumented objects have been deleted.
+  static MetricsRegistry* lookup(UsageEnvironment& env);
+      // returns NULL if metrics are not enabled for "env"
+
+  char* generatePrometheusText();
+      // returns a (dynamically-allocated) string describing all current metrics;
+      // the caller is responsible for delete[]ing it.
+
+  RTPOverTCPMetrics* tcpMetrics(); // metrics for the environment's RTP/RTCP-over-TCP sends (created on first use)
+  static RTPOverTCPMetrics* tcpMetrics(UsageEnvironment& env); // returns NULL if metrics are not enabled
+  StreamParserMetrics* streamParserMetrics(); // metrics shared by all of the environment's stream parsers (ditto)
+  static StreamParserMetrics* streamParserMetrics(UsageEnvironment& env); // returns NULL if metrics are not enabled
+
+  static char* escapeLabelValue(char const* value);
+      // Returns a copy of "value" - e.g., a stream name - that can be used (within "...") in a "labels" string.
+      // (Any '\\', '"' or newline characters are escaped.)  The caller is responsible for delete[]ing it.
+
+private:
+  friend class MetricSeries;
+  MetricsRegistry(UsageEnvironment& env);
+  virtual ~MetricsRegistry();
+
+  void addSeries(MetricSeries* series);
+  void removeSeries(MetricSeries* series);
+
+private:
+  UsageEnvironment& fEnv;
+  HashTable* fFamilies; // maps family names to "MetricFamily" records
+  RTPOverTCPMetrics* fTCPMetrics;
+  StreamParserMetrics* fStreamParserMetrics;
+};
+
+
+////////// Individual metric series //////////
+
+typedef enum { METRIC_COUNTER, METRIC_GAUGE, METRIC_HISTOGRAM } MetricType;
+
+class MetricSeries {
+public:
+  virtual ~MetricSeries();
+
+  MetricType type() const { return fType; }
+  char const* familyName() const { return fFamilyName; }
+  char const* help() const { return fHelp; }
+  char const* labels() const { return fLabels; }
+
+protected:
+  MetricSeries(MetricsRegistry& registry, MetricType type,
+	       char const* familyName, char const* help, char const* labels);
+      // "labels" (if not NULL) is a string like: medium="liveMedia3",codec="H264"
+
+private:
+  friend class MetricsRegistry;
+  friend class MetricFamily;
+  virtual void appendText(class MetricsTextBuffer& buf) const = 0;
+
+private:
+  MetricsRegistry& fRegistry;
+  MetricType fType;
+  char* fFamilyName;
+  char* fHelp;
+  char* fLabels;
+  MetricSeries* fNextInFamily;
+};
+
+// A 64-bit value that can be updated and read - without locking - from any thread:
+class MetricValue {
+public:
+  MetricValue() : fValue(0) {}
+
+#ifndef NO_STD_LIB
+  void add(u_int64_t delta) { fValue.fetch_add(delta, std::memory_order_relaxed); }
+  void set(u_int64_t value) { fValue.store(value, std::memory_order_relaxed); }
+  u_int64_t get() const { return fValue.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<u_int64_t> fValue;
+#else
+  void add(u_int64_t delta) { __atomic_fetch_add(&fValue, delta, __ATOMIC_RELAXED); }
+  void set(u_int64_t value) { __atomic_store_n(&fValue, value, __ATOMIC_RELAXED); }
+  u_int64_t get() const { return __atomic_load_n(&fValue, __ATOMIC_RELAXED); }
+
+private:
+  u_int64_t fValue; // updated using the compiler's atomic builtins
+#endif
+};
+
+class MetricCounter: public MetricSeries {
+public:
+  MetricCounter(MetricsRegistry& registry, char const* familyName, char const* help, char const* labels = NULL);
+
+  void increment(u_int64_t delta = 1) { fValue.add(delta); }
+  u_int64_t value() const { return fValue.get(); }
+
+private:
+  virtual void appendText(class MetricsTextBuffer& buf) const;
+
+private:
+  MetricValue fValue;
+};
+
+class MetricGauge: public MetricSeries {
+public:
+  MetricGauge(MetricsRegistry& registry, char const* familyName, char const* help, char const* labels = NULL);
+
+  void set(int64_t value) { fValue.set((u_int64_t)value); }
+  void add(int64_t delta) { fValue.add((u_int64_t)delta); } // (two's complement arithmetic, so "delta" may be < 0)
+  int64_t value() const { return (int64_t)fValue.get(); }
+
+private:
+  virtual void appendText(class MetricsTextBuffer& buf) const;
+
+private:
+  MetricValue fValue;
+};
+
+class MetricHistogram: public MetricSeries {
+public:
+  MetricHistogram(MetricsRegistry& registry, char const* familyName, char const* help, char const* labels,
+		  unsigned const* bucketUpperBounds, unsigned numBuckets);
+      // "bucketUpperBounds" must be an increasing array (of size "numBuckets") that remains valid for the lifetime of
+      // this object.  (An additional '+Inf' bucket is implicit.)
+  virtual ~MetricHistogram();
+
+  void observe(unsigned value);
+
+private:
+  virtual void appendText(class MetricsTextBuffer& buf) const;
+
+private:
+  unsigned const* fBucketUpperBounds;
+  unsigned fNumBuckets;
+  MetricValue* fBucketCounts; // size is fNumBuckets+1; not cumulative
+  MetricValue fSum;
+  MetricValue fCount;
+};
+
+
+////////// Groups of metrics used to instrument specific classes //////////
+
+class RTPSinkMetrics {
+public:
+  RTPSinkMetrics(MetricsRegistry& registry, char const* labels);
+
+  MetricCounter packetsSent;
+  MetricCounter bytesSent;
+  MetricCounter sendErrors;
+  MetricCounter framesTruncated;
+  MetricCounter packetsRetransmitted; // RFC 4588 "rtx" packets sent in response to NACKs
+  MetricCounter repairPacketsSent; // RFC 8627 ("flexfec") repair packets
+  MetricHistogram packetSize; // bytes
+  MetricHistogram sendLateness; // microseconds
+};
+
+class RTPSourceMetrics {
+public:
+  RTPSourceMetrics(MetricsRegistry& registry, char const* labels);
+
+  MetricCounter packetsReceived;
+  MetricCounter bytesReceived;
+  MetricCounter packetsDiscarded; // bad, duplicate, or excessively-delayed packets
+  MetricCounter retransmissionsRequested; // packets for which we sent a NACK
+  MetricCounter retransmissionsReceived; // RFC 4588 "rtx" packets that we received
+  MetricCounter packetsRecovered; // lost packets that we rebuilt from RFC 8627 ("flexfec") repair packets
+  MetricGauge reorderQueueDepth;
+  MetricGauge reorderThresholdTime; // microseconds
+};
+
+class BufferedPacketPoolMetrics {
+public:
+  BufferedPacketPoolMetrics(MetricsRegistry& registry);
+
+  MetricGauge smallSlots;
+  MetricGauge smallSlotsInUse;
+  MetricGauge largeSlots;
+  MetricGauge largeSlotsInUse;
+  MetricCounter truncatedDatagrams;
+};
+
+class RTPOverTCPMetrics {
+public:
+  RTPOverTCPMetrics(MetricsRegistry& registry);
+
+  MetricCounter bytesSent;
+  MetricCounter blockingSends; // sends that filled the OS's TCP buffer, and had to be completed by blocking
+  MetricCounter sendErrors;
+  MetricHistogram sendSize; // bytes
+};
+
+class StreamParserMetrics {
+public:
+  StreamParserMetrics(MetricsRegistry& registry);
+
+  MetricCounter inputReads;
+  MetricCounter inputStalls; // times that parsing had to stop, to wait for input data
+  MetricCounter prefetches; // reads that were requested before the parser needed the data
+  MetricCounter bankGrowths;
+};
+
+class StreamReplicatorMetrics {
+public:
+  StreamReplicatorMetrics(MetricsRegistry& registry, char const* labels);
+
+  MetricGauge replicas;
+  MetricGauge activeReplicas;
+  MetricCounter framesReceived;
+  MetricCounter framesTruncated;
+};
+
+class MediaServerMetrics {
+public:
+  MediaServerMetrics(MetricsRegistry& registry, char const* labels);
+
+  MetricCounter connectionsAccepted;
+  MetricGauge clientConnections;
+  MetricGauge clientSessions;
+  MetricCounter tlsHandshakes;
+  MetricCounter tlsSessionsResumed; // TLS handshakes that resumed an earlier session
+};
+
+#endif
@@ -194,6 +194,10 @@ public:
   RTCPInstance* rtcpInstance() { return fRTCPInstance; }
   unsigned rtpTimestampFrequency() const { return fRTPTimestampFrequency; }
   Boolean rtcpIsMuxed() const { return fMultiplexRTCPWithRTP; }
+  unsigned char rtxPayloadFormat() const { return fRTXPayloadFormat; }
+      // the payload format of RFC 4588 retransmission ("rtx") packets for this stream; 0 if the stream doesn't offer them
+  unsigned char fecPayloadFormat() const { return fFECPayloadFormat; }
+      // the payload format of RFC 8627 FEC ("flexfec") repair packets for this stream; 0 if the stream doesn't send them
   FramedSource* readSource() { return fReadSource; }
     // This is the source that client sinks read from.  It is usually
     // (but not necessarily) the same as "rtpSource()"
@@ -327,6 +331,9 @@ protected:
   unsigned short fClientPortNum; // in host byte order
       // This field is also set by initiate()
   unsigned char fRTPPayloadFormat;
+  unsigned char fRTXPayloadFormat;
+  unsigned char fRTXAssociatedPayloadFormat; // the "apt" parameter of the "rtx" payload format; 0xFF if not given
+  unsigned char fFECPayloadFormat;
   char* fSavedSDPLines;
   char* fMediumName;
   char* fCodecName;
@@ -46,6 +46,7 @@ public:
   virtual Boolean isJPEGVideoSource() const;
   virtual Boolean isAMRAudioSource() const;
   virtual Boolean isMPEG2TransportStreamMultiplexor() const;
+  virtual Boolean isMPEG2TransportStreamFramer() const;
 
 protected:
   MediaSource(UsageEnvironment& env); // abstract base class
@@ -93,9 +93,13 @@ protected:
 
 public: // redefined virtual functions:
   virtual void stopPlaying();
+  virtual Boolean enableRetransmission(unsigned char rtxPayloadType, unsigned historySize = 256);
+  virtual Boolean enableFEC(unsigned char fecPayloadType, unsigned numPacketsPerRepairPacket);
+  virtual void setMetricsStreamName(char const* streamName, char const* trackId, u_int32_t clientSessionId = 0);
 
 protected: // redefined virtual functions:
   virtual Boolean continuePlaying();
+  virtual void retransmitPacket(u_int16_t seqNum);
 
 private:
   void buildAndSendPacket(Boolean isFirstPacket);
@@ -135,6 +139,15 @@ private:
 
   onSendErrorFunc* fOnSendErrorFunc;
   void* fOnSendErrorData;
+
+  // Used if retransmission (RFC 4588) has been enabled:
+  class RTPPacketHistory* fPacketHistory; // NULL if retransmission is not enabled
+  u_int16_t fRTXSeqNo;
+  u_int32_t fRTXSSRC;
+
+  class FlexFECEncoder* fFECEncoder; // NULL unless FEC (RFC 8627) has been enabled
+
+  class RTPSinkMetrics* fMetrics; // NULL unless metrics are enabled
 };
 
 #endif
@@ -56,6 +56,13 @@ protected:
   virtual void doGetNextFrame();
   virtual void doStopGettingFrames();
 
+public:
+  // redefined virtual functions:
+  virtual Boolean setAdaptivePacketReorderingThresholdTime(unsigned minUSeconds, unsigned maxUSeconds);
+  virtual unsigned packetReorderingThresholdTime() const;
+  virtual Boolean enableRetransmissionRequests(class RTCPInstance* rtcpInstance, unsigned char rtxPayloadFormat);
+  virtual Boolean enableFECRecovery(unsigned char fecPayloadFormat);
+
 private:
   // redefined virtual functions:
   virtual void setPacketReorderingThresholdTime(unsigned uSeconds);
@@ -66,6 +73,9 @@ private:
 
   static void networkReadHandler(MultiFramedRTPSource* source, int /*mask*/);
   void networkReadHandler1();
+  Boolean processIncomingPacket(BufferedPacket* bPacket, struct sockaddr_storage const& fromAddress);
+      // Checks the RTP header of a received (or recovered) packet, and stores it.  Returns False if it wasn't stored.
+  void recoverPacketUsingFEC(BufferedPacket* repairPacket, struct sockaddr_storage const& fromAddress);
 
   Boolean fAreDoingNetworkReads;
   BufferedPacket* fPacketReadInProgress;
@@ -76,6 +86,16 @@ private:
 
   // A buffer to (optionally) hold incoming pkts that have been reorderered
   class ReorderingPacketBuffer* fReorderingBuffer;
+
+  // Used if retransmission (RFC 4588) has been enabled:
+  class RTCPInstance* fRTCPInstanceForRetransmissionRequests; // NULL if retransmission is not enabled
+  unsigned char fRTXPayloadFormat;
+
+  // Used if FEC (RFC 8627) has been enabled:
+  class FlexFECDecoder* fFECDecoder; // NULL if FEC is not enabled
+  unsigned char fFECPayloadFormat;
+
+  class RTPSourceMetrics* fMetrics; // NULL unless metrics are enabled
 };
 
 
@@ -92,6 +112,8 @@ public:
   unsigned useCount() const { return fUseCount; }
 
   Boolean fillInData(RTPInterface& rtpInterface, struct sockaddr_storage& fromAddress, Boolean& packetReadWasIncomplete);
+  Boolean fillInData(UsageEnvironment& env, unsigned char const* packet, unsigned packetSize);
+      // used for a packet that didn't come from the network (i.e., one that was recovered using FEC)
   void assignMiscParams(unsigned short rtpSeqNo, unsigned rtpTimestamp,
 			struct timeval presentationTime,
 			Boolean hasBeenSyncedUsingRTCP,
@@ -116,6 +138,12 @@ public:
   Boolean& isFirstPacket() { return fIsFirstPacket; }
   unsigned bytesAvailable() const { return fPacketSize - fTail; }
 
+  // Our data buffer comes from our environment's "BufferedPacketPool".  It's allocated when "fillInData()" is first
+  // called - and is normally a small (MTU-sized) slot, unless "usesLargeBuffer()" has been set, or a larger packet is
+  // arriving over TCP:
+  Boolean& usesLargeBuffer() { return fUsesLargeBuffer; }
+  void releaseBuffer(); // returns our buffer to the pool (e.g., while we're not being used)
+
 protected:
   virtual void reset();
   virtual unsigned nextEnclosedFrameSize(unsigned char*& framePtr,
@@ -131,8 +159,13 @@ protected:
   unsigned fHead;
   unsigned fTail;
 
+private:
+  void allocateBuffer(UsageEnvironment& env, unsigned minSize);
+
 private:
   BufferedPacket* fNextPacket; // used to link together packets
+  class BufferedPacketPool* fPool; // the pool that "fBuf" came from; NULL if we don't currently have a buffer
+  Boolean fUsesLargeBuffer;
 
   unsigned fUseCount;
   unsigned short fRTPSeqNo;
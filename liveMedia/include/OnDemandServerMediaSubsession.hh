@@ -44,6 +44,8 @@ protected: // we're a virtual base class
 
 protected: // redefined virtual functions
   virtual char const* sdpLines(int addressFamily);
+  virtual Boolean sdpLinesAreReady(int addressFamily);
+  virtual Boolean prepareSDPLines(int addressFamily);
   virtual void getStreamParameters(unsigned clientSessionId,
 				   struct sockaddr_storage const& clientAddress,
                                    Port const& clientRTPPort,
@@ -76,10 +78,17 @@ protected: // redefined virtual functions
   virtual void getRTPSinkandRTCP(void* streamToken,
 				 RTPSink*& rtpSink, RTCPInstance*& rtcp);
   virtual void deleteStream(unsigned clientSessionId, void*& streamToken);
+  virtual FramedSource* createNewNonRTPStreamSource(unsigned clientSessionId, Boolean& sourceCanBeShared);
+      // Note: This returns NULL if we were created with "reuseFirstSource" (because our input can then be read only once).
+  virtual void closeNonRTPStreamSource(FramedSource* source);
 
 protected: // new virtual functions, possibly redefined by subclasses
   virtual char const* getAuxSDPLine(RTPSink* rtpSink,
 				    FramedSource* inputSource);
+  virtual Boolean startGettingAuxSDPLine(RTPSink* rtpSink, FramedSource* inputSource);
+      // Called when our SDP lines are being prepared asynchronously (see "ServerMediaSession::prepareSDPDescription()").
+      // Returns True if "getAuxSDPLine()" can now be called without blocking.  Otherwise, returns False, and the subclass
+      // must call "auxSDPLineIsReady()" once it can.  (The default implementation returns True.)
   virtual void seekStreamSource(FramedSource* inputSource, double& seekNPT, double streamDuration, u_int64_t& numBytes);
     // This routine is used to seek by relative (i.e., NPT) time.
     // "streamDuration", if >0.0, specifies how much data to stream, past "seekNPT".  (If <=0.0, all remaining data is streamed.)
@@ -102,6 +111,12 @@ protected: // new virtual functions, defined by all subclasses
 				    FramedSource* inputSource) = 0;
 
 protected: // new virtual functions, may be redefined by a subclass:
+  virtual char const* metadataCacheFileName() const;
+      // The name of the file from which this subsession's stream is read - or NULL (the default) if its SDP lines
+      // should not be stored in the "MediaMetadataCache"
+  virtual void setDurationFromMetadataCache(float duration);
+      // Called (instead of "createNewStreamSource()") when our SDP lines have been found in the "MediaMetadataCache".
+      // Subclasses that compute their "duration()" only when a stream source is created should redefine this.
   virtual Groupsock* createGroupsock(struct sockaddr_storage const& addr, Port port);
   virtual RTCPInstance* createRTCP(Groupsock* RTCPgs, unsigned totSessionBW, /* in kbps */
 				   unsigned char const* cname, RTPSink* sink);
@@ -110,6 +125,11 @@ public:
   void multiplexRTCPWithRTP() { fMultiplexRTCPWithRTP = True; }
     // An alternative to passing the "multiplexRTCPWithRTP" parameter as True in the constructor
 
+  void enableRetransmission(unsigned historySize = 256) { fRetransmissionHistorySize = historySize; }
+    // Offers (in our SDP description) to retransmit lost RTP packets (RFC 4588) to clients that request them (using
+    // RTCP Generic NACKs), and keeps the most recent "historySize" packets sent in each (non-SRTP) UDP stream so that
+    // they can be.  Call this before our SDP description is first generated.
+
   void setRTCPAppPacketHandler(RTCPAppHandlerFunc* handler, void* clientData);
     // Sets a handler to be called if a RTCP "APP" packet arrives from any future client.
     // (Any current clients are not affected; any "APP" packets from them will continue to be
@@ -130,6 +150,20 @@ protected:
   void setSDPLinesFromRTPSink(RTPSink* rtpSink, FramedSource* inputSource,
 			      unsigned estBitrate);
       // used to implement "sdpLines()"
+  void auxSDPLineIsReady(); // see "startGettingAuxSDPLine()" above
+
+private:
+  Boolean createDummyStream(int addressFamily, FramedSource*& inputSource, Groupsock*& dummyGroupsock,
+			    RTPSink*& dummyRTPSink, unsigned& estBitrate);
+      // Returns False if no input source could be created (e.g., because the file was not found)
+  void setSDPLinesFromDummyStream(int addressFamily, FramedSource* inputSource, Groupsock* dummyGroupsock,
+				  RTPSink* dummyRTPSink, unsigned estBitrate);
+      // also closes the dummy objects
+  void setUpRetransmission(RTPSink* rtpSink);
+  class MediaMetadataCache* metadataCacheToUse(char const*& cacheFileName);
+  Boolean setSDPLinesFromMetadataCache(int addressFamily);
+  static void finishPreparingSDPLines(void* clientData);
+  void finishPreparingSDPLines1();
 
 protected:
   char* fSDPLines;
@@ -141,10 +175,18 @@ private:
   Boolean fReuseFirstSource;
   portNumBits fInitialPortNum;
   Boolean fMultiplexRTCPWithRTP;
+  unsigned fRetransmissionHistorySize; // 0 if retransmission is not enabled
   void* fLastStreamToken;
   char fCNAME[100]; // for RTCP
   RTCPAppHandlerFunc* fAppHandlerTask;
   void* fAppHandlerClientData;
+  // The dummy objects that we use while preparing our SDP lines asynchronously:
+  FramedSource* fPreparingInputSource;
+  Groupsock* fPreparingGroupsock;
+  RTPSink* fPreparingRTPSink;
+  unsigned fPreparingEstBitrate;
+  int fPreparingAddressFamily;
+  TaskToken fSDPLinesPreparedTask;
   friend class StreamState;
 };
 
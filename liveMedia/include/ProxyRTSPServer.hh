@@ -0,0 +1,123 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// A RTSP server that proxies a (potentially large) registry of back-end RTSP streams, connecting to each back-end
+// stream either at startup (at a limited rate), or only on demand (disconnecting again once the stream becomes idle).
+// C++ header
+
+#ifndef _PROXY_RTSP_SERVER_HH
+#define _PROXY_RTSP_SERVER_HH
+
+#ifndef _RTSP_SERVER_HH
+#include "RTSPServer.hh"
+#endif
+#ifndef _PROXY_SERVER_MEDIA_SESSION_HH
+#include "ProxyServerMediaSession.hh"
+#endif
+
+class ProxyRTSPServer: public RTSPServerWithREGISTERProxying {
+public:
+  static ProxyRTSPServer* createNew(UsageEnvironment& env, Port ourPort = 554,
+				    UserAuthenticationDatabase* authDatabase = NULL,
+				    unsigned reclamationSeconds = 65,
+				    char const* backEndUsername = NULL, char const* backEndPassword = NULL,
+				    portNumBits tunnelOverHTTPPortNum = 0,
+				        // for streaming the *proxied* (i.e., back-end) streams; see "ProxyServerMediaSession.hh"
+				    int verbosityLevelForProxying = 0,
+				    unsigned idleTimeoutSeconds = 0,
+				    unsigned maxDESCRIBEsPerSecond = 0,
+				    Boolean proxyREGISTERRequests = False,
+				    UserAuthenticationDatabase* authDatabaseForREGISTER = NULL);
+      // If "idleTimeoutSeconds" is 0 (the default), then - like a set of "ProxyServerMediaSession"s - we connect to each
+      //     back-end stream when it is added, and remain connected to it.
+      // If "idleTimeoutSeconds" > 0, then we connect to each back-end stream only when a front-end client first requests it,
+      //     and we disconnect from it once it has had no front-end clients for at least "idleTimeoutSeconds".
+      // If "maxDESCRIBEsPerSecond" > 0, then the initial back-end connections (when "idleTimeoutSeconds" is 0) are paced
+      //     (with random jitter) so that no more than this many back-end "DESCRIBE"s are sent each second.
+      //     (If "maxDESCRIBEsPerSecond" is 0, then we connect to each back-end stream immediately.)
+      // If "proxyREGISTERRequests" is True, then we also handle incoming "REGISTER" requests
+      //     (exactly like "RTSPServerWithREGISTERProxying").
+
+  Boolean addProxiedStream(char const* streamName, char const* backEndURL);
+      // Registers a back-end stream, to be proxied using the front-end stream name "streamName".
+      // Returns False if a stream with this name has already been registered.
+  Boolean removeProxiedStream(char const* streamName);
+      // Unregisters a back-end stream (first closing any front-end clients that are currently using it).
+
+  unsigned numRegisteredStreams() const { return fRegistry->numEntries(); }
+  unsigned numConnectedStreams() const { return fConnectedEntries->numEntries(); }
+
+protected:
+  ProxyRTSPServer(UsageEnvironment& env, int ourSocketIPv4, int ourSocketIPv6, Port ourPort,
+		  UserAuthenticationDatabase* authDatabase, UserAuthenticationDatabase* authDatabaseForREGISTER,
+		  unsigned reclamationSeconds,
+		  char const* backEndUsername, char const* backEndPassword,
+		  portNumBits tunnelOverHTTPPortNum, int verbosityLevelForProxying,
+		  unsigned idleTimeoutSeconds, unsigned maxDESCRIBEsPerSecond,
+		  Boolean proxyREGISTERRequests);
+  // called only by createNew();
+  virtual ~ProxyRTSPServer();
+
+  virtual ProxyServerMediaSession* createNewProxyServerMediaSession(char const* streamName, char const* backEndURL);
+      // Subclasses may redefine this, if they want to create a subclass of "ProxyServerMediaSession"
+
+protected: // redefined virtual functions
+  virtual void lookupServerMediaSession(char const* streamName,
+					lookupServerMediaSessionCompletionFunc* completionFunc,
+					void* completionClientData,
+					Boolean isFirstLookupInSession);
+  virtual char const* allowedCommandNames();
+  virtual Boolean weImplementREGISTER(char const* cmd/*"REGISTER" or "DEREGISTER"*/,
+				      char const* proxyURLSuffix, char*& responseStr);
+  virtual UserAuthenticationDatabase* getAuthenticationDatabaseForCommand(char const* cmdName);
+
+private:
+  class ProxyRegistryEntry* checkConnection(char const* streamName);
+  void connectToBackEnd(class ProxyRegistryEntry* entry);
+  void disconnectFromBackEnd(class ProxyRegistryEntry* entry);
+
+  ServerMediaSession* lookupResult(class ProxyRegistryEntry* entry, ProxyServerMediaSession* sms);
+  void completeWaitingLookups(class ProxyRegistryEntry* entry);
+  static void onDESCRIBECompletion(void* clientData, ProxyServerMediaSession* sms);
+  static void describeTimeout(void* clientData);
+
+  void scheduleNextPacedConnection();
+  static void connectNextPendingEntry(void* clientData);
+  void connectNextPendingEntry();
+
+  void scheduleIdleCheck();
+  static void checkForIdleStreams(void* clientData);
+  void checkForIdleStreams();
+
+private:
+  char* fBackEndUsername;
+  char* fBackEndPassword;
+  portNumBits fTunnelOverHTTPPortNum;
+  int fVerbosityLevelForProxying;
+  unsigned fIdleTimeoutSeconds;
+  unsigned fMaxDESCRIBEsPerSecond;
+  Boolean fProxyREGISTERRequests;
+
+  HashTable* fRegistry; // maps front-end stream names to "ProxyRegistryEntry"s
+  HashTable* fConnectedEntries; // the subset of "fRegistry" that is currently connected to its back-end stream
+  class ProxyRegistryEntry* fPendingHead; // queue of entries waiting for a (paced) initial connection
+  class ProxyRegistryEntry* fPendingTail;
+  TaskToken fPacingTask;
+  TaskToken fIdleCheckTask;
+};
+
+#endif
@@ -120,11 +120,20 @@ public:
   char const* url() const;
 
   char describeCompletedFlag;
-    // initialized to 0; set to 1 when the back-end "DESCRIBE" completes.
+    // initialized to 0; set to 1 when the back-end "DESCRIBE" completes (whether successfully or not).
     // (This can be used as a 'watch variable' in "doEventLoop()".)
   Boolean describeCompletedSuccessfully() const { return fClientMediaSession != NULL; }
     // This can be used - along with "describeCompletedFlag" - to check whether the back-end "DESCRIBE" completed *successfully*.
 
+  typedef void (onDESCRIBECompletionFunc)(void* clientData, ProxyServerMediaSession* sms);
+  void setOnDESCRIBECompletion(onDESCRIBECompletionFunc* func, void* clientData) {
+    fOnDESCRIBECompletionFunc = func; fOnDESCRIBECompletionClientData = clientData;
+  }
+    // Arranges for "func" to be called each time that a back-end "DESCRIBE" completes (whether successfully or not).
+    // (Note that - if the back-end server could not be reached at all - the first "DESCRIBE" might complete (unsuccessfully)
+    //  before "createNew()" returns.  Therefore, callers should also check "describeCompletedFlag" after setting this.)
+    // Note: "func" must not close "sms" directly; if it wants to do this, it should schedule a delayed task to do so.
+
 protected:
   ProxyServerMediaSession(UsageEnvironment& env, GenericMediaServer* ourMediaServer,
 			  char const* inputStreamURL, char const* streamName,
@@ -165,6 +174,7 @@ private:
   friend class ProxyServerMediaSubsession;
   void continueAfterDESCRIBE(char const* sdpDescription);
   void resetDESCRIBEState(); // undoes what was done by "contineAfterDESCRIBE()"
+  void noteDESCRIBECompletion();
 
 private:
   int fVerbosityLevel;
@@ -173,6 +183,8 @@ private:
   MediaTranscodingTable* fTranscodingTable;
   portNumBits fInitialPortNum;
   Boolean fMultiplexRTCPWithRTP;
+  onDESCRIBECompletionFunc* fOnDESCRIBECompletionFunc;
+  void* fOnDESCRIBECompletionClientData;
 };
 
 
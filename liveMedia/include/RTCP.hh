@@ -109,6 +109,10 @@ public:
       // Note that only the low-order 5 bits of "subtype" are used, and only the first 4 bytes
       // of "name" are used.  (If "name" has fewer than 4 bytes, or is NULL,
       // then the remaining bytes are '\0'.)
+  void sendNACK(u_int32_t mediaSSRC, u_int16_t firstMissingSeqNum, unsigned numMissingPackets);
+      // Sends a RTCP Generic NACK (RFC 4585, section 6.2.1) - asking the sender of the RTP stream "mediaSSRC" to
+      // retransmit the "numMissingPackets" packets beginning with sequence number "firstMissingSeqNum".
+      // (Used by "RTPSource"s for which retransmission (RFC 4588) has been enabled.)
 
   Groupsock* RTCPgs() const { return fRTCPInterface.gs(); }
 
@@ -153,8 +157,9 @@ private:
       void enqueueCommonReportPrefix(unsigned char packetType, u_int32_t SSRC,
 				     unsigned numExtraWords = 0);
       void enqueueCommonReportSuffix();
-        void enqueueReportBlock(RTPReceptionStats* receptionStats);
+        void enqueueReportBlock(RTPReceptionStats* receptionStats, struct timeval const& timeNow);
   void addSDES();
+    void buildSDESPacket(u_int32_t SSRC, Boolean haveSSRC);
   void addBYE(char const* reason);
 
   void sendBuiltPacket();
@@ -179,6 +184,10 @@ private:
   SRTPCryptographicContext* fCrypto;
 
   SDESItem fCNAME;
+  // Our SDES packet doesn't change (unless our SSRC does), so we build it just once, and copy it into each report:
+  u_int8_t fSDESPacket[4/*header*/ + 4/*SSRC*/ + sizeof (SDESItem) + 4/*END, and padding*/];
+  unsigned fSDESPacketSize; // 0 until the packet has been built
+  u_int32_t fSDESPacketSSRC;
   RTCPMemberDatabase* fKnownMembers;
   unsigned fOutgoingReportCount; // used for SSRC member aging
 
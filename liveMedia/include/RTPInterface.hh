@@ -74,6 +74,10 @@ public:
 
   void stopNetworkReading();
 
+  unsigned nextTCPReadSize() const { return fNextTCPReadStreamSocketNum < 0 ? 0 : fNextTCPReadSize; }
+      // If the next "handleRead()" will read (the rest of) a packet from a TCP stream, the number of bytes remaining;
+      // otherwise 0.
+
   UsageEnvironment& envir() const { return fOwner->envir(); }
 
   void setAuxilliaryReadHandler(AuxHandlerFunc* handlerFunc,
@@ -49,10 +49,12 @@ public:
 
   unsigned numChannels() const { return fNumChannels; }
 
-  void setupForSRTP(Boolean useEncryption, u_int32_t roc);
+  void setupForSRTP(Boolean useEncryption, u_int32_t roc, Boolean useAESGCM = False);
       // sets up keying/encryption state for streaming via SRTP, using default values.
+      // (If "useAESGCM" (and "useEncryption") is True, then the AEAD_AES_128_GCM ciphersuite (RFC 7714) is used,
+      //  rather than AES_CM_128_HMAC_SHA1_80.)
   u_int8_t* setupForSRTP(Boolean useEncryption, u_int32_t roc,
-			 unsigned& resultMIKEYStateMessageSize);
+			 unsigned& resultMIKEYStateMessageSize, Boolean useAESGCM = False);
       // as above, but returns the binary MIKEY state
   void setupForSRTP(u_int8_t const* MIKEYStateMessage, unsigned MIKEYStateMessageSize,
 		    u_int32_t roc);
@@ -64,6 +66,32 @@ public:
   virtual char const* auxSDPLine();
       // optional SDP line (e.g. a=fmtp:...)
 
+  // Support for RTP retransmission (RFC 4588):
+  virtual Boolean enableRetransmission(unsigned char rtxPayloadType, unsigned historySize = 256);
+      // Keeps the most recent "historySize" packets that we've sent, so that any that a receiver reports missing
+      // (using a RTCP Generic NACK) can be resent - as "rtx" packets, with payload type "rtxPayloadType".
+      // Returns False if this kind of sink does not support retransmission (the default).
+  unsigned char rtxPayloadType() const { return fRTXPayloadType; } // 0 if retransmission is not enabled
+  char* rtxSDPLines() const; // returns a string to be delete[]d ("" if retransmission is not enabled)
+
+  // Support for Forward Error Correction ("flexfec": RFC 8627):
+  virtual Boolean enableFEC(unsigned char fecPayloadType, unsigned numPacketsPerRepairPacket);
+      // After each "numPacketsPerRepairPacket" packets that we send, also sends a repair packet (with payload type
+      // "fecPayloadType") from which a receiver can recover any one of those packets, if it was lost.  (So smaller
+      // values give more protection, at the cost of more overhead.)
+      // Returns False if this kind of sink does not support FEC (the default).
+  unsigned char fecPayloadType() const { return fFECPayloadType; } // 0 if FEC is not enabled
+  char* fecSDPLines() const; // returns a string to be delete[]d ("" if FEC is not enabled)
+
+  virtual void setMetricsStreamName(char const* streamName, char const* trackId, u_int32_t clientSessionId = 0);
+      // If metrics are enabled, labels this sink's metrics with the name (and track id) of the stream that it's delivering
+      // - and, if non-zero, the id of the client session that it's delivering to - rather than with our medium name.
+      // This should be called before we start playing.  (The default implementation does nothing.)
+
+  char* sdpFmtListSuffix() const;
+      // returns (as a string to be delete[]d) the payload types of our "rtx" and FEC packets (if enabled),
+      // each preceded by " ", for appending to a SDP "m=" line
+
   u_int16_t currentSeqNo() const { return fSeqNo; }
   u_int32_t presetNextTimestamp();
       // ensures that the next timestamp to be used will correspond to
@@ -119,6 +147,7 @@ protected:
   u_int32_t convertToRTPTimestamp(struct timeval tv);
   unsigned packetCount() const {return fPacketCount;}
   unsigned octetCount() const {return fOctetCount;}
+  virtual void retransmitPacket(u_int16_t seqNum); // in response to a NACK; by default, does nothing
 
 protected:
   RTPInterface fRTPInterface;
@@ -127,6 +156,9 @@ protected:
   struct timeval fTotalOctetCountStartTime, fInitialPresentationTime, fMostRecentPresentationTime;
   u_int32_t fCurrentTimestamp;
   u_int16_t fSeqNo;
+  unsigned char fRTXPayloadType; // 0 unless retransmission is enabled
+  unsigned char fFECPayloadType; // 0 unless FEC is enabled
+  unsigned fNumPacketsPerRepairPacket; // used if FEC is enabled
 
   // Optional key management and crypto state; used if we are streaming SRTP
   MIKEYState* fMIKEYState;
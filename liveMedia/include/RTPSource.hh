@@ -47,6 +47,13 @@ public:
   Groupsock* RTPgs() const { return fRTPInterface.gs(); }
 
   virtual void setPacketReorderingThresholdTime(unsigned uSeconds) = 0;
+  virtual Boolean setAdaptivePacketReorderingThresholdTime(unsigned minUSeconds, unsigned maxUSeconds);
+      // Asks that the reordering threshold time be adjusted continually - between "minUSeconds" and "maxUSeconds" -
+      // according to the jitter and the reordering that we see in incoming packets.  (A later call to
+      // "setPacketReorderingThresholdTime()" reverts to a fixed threshold.)
+      // Returns False if this kind of source does not support this (the default).
+  virtual unsigned packetReorderingThresholdTime() const;
+      // the current threshold: how long (in microseconds) we'll wait for a missing packet before giving up on it
 
   void setCrypto(SRTPCryptographicContext* crypto) { fCrypto = crypto; }
 
@@ -59,6 +66,14 @@ public:
   }
   void deregisterForMultiplexedRTCPPackets() { registerForMultiplexedRTCPPackets(NULL); }
 
+  virtual Boolean enableRetransmissionRequests(class RTCPInstance* rtcpInstance, unsigned char rtxPayloadFormat);
+      // Asks that any packets that we find to be missing be requested (using RTCP Generic NACKs, sent by "rtcpInstance"),
+      // and that retransmitted packets - of the RFC 4588 "rtx" payload format "rtxPayloadFormat" - be accepted.
+      // Returns False if this kind of source does not support retransmission (the default).
+  virtual Boolean enableFECRecovery(unsigned char fecPayloadFormat);
+      // Asks that FEC repair packets - of the RFC 8627 "flexfec" payload format "fecPayloadFormat" - be used to recover
+      // lost packets.  Returns False if this kind of source does not support FEC (the default).
+
   unsigned timestampFrequency() const {return fTimestampFrequency;}
 
   RTPReceptionStatsDB& receptionStatsDB() const {
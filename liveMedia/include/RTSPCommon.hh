@@ -38,6 +38,62 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #define RTSP_PARAM_STRING_MAX 200
 
+// A single-pass, zero-copy parse of the first line - e.g., "<command> <URL> <protocol>" - and header fields of a
+// RTSP (or HTTP) message.  The resulting strings point into the message (and are not '\0'-terminated), so the
+// message must remain valid - and unchanged - while they are being used.
+#ifndef RTSP_MAX_HEADER_FIELDS
+#define RTSP_MAX_HEADER_FIELDS 40 // any more header fields than this are found (more slowly) by scanning the message
+#endif
+
+class RTSPRequestTokenizer {
+public:
+  RTSPRequestTokenizer();
+
+  Boolean tokenize(char const* msgStr, unsigned msgStrSize);
+      // Parses the message up to (and including) the empty line that ends its header, or up to "msgStrSize" bytes.
+      // Returns False if the first line doesn't contain (at least) a command name and a URL.
+  void reset(); // forgets any previously-tokenized message
+
+  char const* msgStr() const { return fMsgStr; }
+  unsigned headerSize() const { return fHeaderSize; } // up to and including the empty line, if we saw one
+
+  // The three parts of the first line (the URL is everything between the command name and the protocol name, and might
+  // therefore contain spaces):
+  char const* cmdName() const { return fCmdName; }
+  unsigned cmdNameLen() const { return fCmdNameLen; }
+  char const* url() const { return fURL; }
+  unsigned urlLen() const { return fURLLen; }
+  char const* protocol() const { return fProtocol; } // e.g., "RTSP/1.0"
+  unsigned protocolLen() const { return fProtocolLen; } // 0 if there was none
+
+  char const* lookupHeader(char const* headerName, unsigned& valueLen) const;
+      // "headerName" does not include the ':', and is compared case-insensitively.  Returns the value of the header
+      // field (without surrounding whitespace; this includes any continuation lines), or NULL if there was no such field.
+  char const* lookupHeader(char const* headerName) const { unsigned valueLen; return lookupHeader(headerName, valueLen); }
+  char const* lookupNextHeader(char const* headerName, unsigned& valueLen, char const* prevValue) const;
+      // Like "lookupHeader()", but for a header that may appear more than once: Returns the value of the next field
+      // (with this name) after the one whose value was "prevValue" (a result of a previous lookup of the same header).
+
+  unsigned numHeaderFields() const { return fNumHeaderFields; }
+
+private:
+  char const* fMsgStr;
+  unsigned fHeaderSize;
+  char const* fCmdName; unsigned fCmdNameLen;
+  char const* fURL; unsigned fURLLen;
+  char const* fProtocol; unsigned fProtocolLen;
+
+  char const* lookupUnrecordedHeader(char const* headerName, unsigned headerNameLen, unsigned& valueLen,
+				     char const* scanStart) const;
+
+  unsigned fNumHeaderFields;
+  char const* fFirstUnrecordedField; // the first header line that didn't fit in "fHeaderFields", or NULL
+  struct HeaderField {
+    char const* name; unsigned nameLen;
+    char const* value; unsigned valueLen;
+  } fHeaderFields[RTSP_MAX_HEADER_FIELDS];
+};
+
 Boolean parseRTSPRequestString(char const *reqStr, unsigned reqStrSize, // in
 			       char *resultCmdName, // out
 			       unsigned resultCmdNameMaxSize, // in
@@ -50,11 +106,21 @@ Boolean parseRTSPRequestString(char const *reqStr, unsigned reqStrSize, // in
 			       char* resultSessionId, // out
 			       unsigned resultSessionIdMaxSize, // in
 			       unsigned& contentLength, Boolean& urlIsRTSPS); // out
+Boolean parseRTSPRequestString(RTSPRequestTokenizer const& request, // in: an already-tokenized request
+			       char *resultCmdName, unsigned resultCmdNameMaxSize,
+			       char* resultURLPreSuffix, unsigned resultURLPreSuffixMaxSize,
+			       char* resultURLSuffix, unsigned resultURLSuffixMaxSize,
+			       char* resultCSeq, unsigned resultCSeqMaxSize,
+			       char* resultSessionId, unsigned resultSessionIdMaxSize,
+			       unsigned& contentLength, Boolean& urlIsRTSPS); // as above
 
 Boolean parseRangeParam(char const* paramStr, double& rangeStart, double& rangeEnd, char*& absStartTime, char*& absEndTime, Boolean& startTimeIsNow);
 Boolean parseRangeHeader(char const* buf, double& rangeStart, double& rangeEnd, char*& absStartTime, char*& absEndTime, Boolean& startTimeIsNow);
 
+Boolean parseRangeHeader(RTSPRequestTokenizer const& request, double& rangeStart, double& rangeEnd, char*& absStartTime, char*& absEndTime, Boolean& startTimeIsNow);
+
 Boolean parseScaleHeader(char const* buf, float& scale);
+Boolean parseScaleHeader(RTSPRequestTokenizer const& request, float& scale);
 
 Boolean RTSPOptionIsSupported(char const* commandName, char const* optionsResponseString);
     // Returns True iff the RTSP command "commandName" is mentioned as one of the commands supported in "optionsResponseString"
@@ -109,8 +109,27 @@ public:
       //  and http://images.apple.com/br/quicktime/pdf/QTSS_Modules.pdf
   portNumBits httpServerPortNum() const; // in host byte order.  (Returns 0 if not present.)
 
+  void enableHTTPStreaming(Boolean enable = True) { fHTTPStreamingIsEnabled = enable; }
+      // If enabled, then a HTTP "GET" request (on our RTSP port, or our RTSP-over-HTTP tunneling port) for the name of one
+      // of our "ServerMediaSession"s delivers that session - as a MPEG Transport Stream, using 'chunked' transfer encoding -
+      // over the HTTP connection.  (See "HTTPStreamer".)  This is disabled by default, and is not available if we use
+      // authentication or TLS.  Note that sessions whose subsessions were created with "reuseFirstSource" (e.g., 'live' or
+      // proxied sessions) can't be delivered this way, because their inputs can't be read more than once.
+
+  void enableMetricsOverHTTP(Boolean enable = True) { fMetricsOverHTTPIsEnabled = enable; }
+      // If enabled - and if metrics have been enabled (see "MediaMetrics.hh") - then a HTTP "GET" request for "/metrics"
+      // (on our RTSP port, or our RTSP-over-HTTP tunneling port) returns our environment's metrics, in Prometheus text
+      // format.  This is disabled by default, and is not available if we use authentication (because we can't
+      // authenticate HTTP clients) or TLS.  Because the metrics are then visible to anyone who can reach the port (and
+      // include stream names), enable this only if the port is not reachable by untrusted clients.
+
   void setTLSState(char const* certFileName, char const* privKeyFileName,
-		   Boolean weServeSRTP = True, Boolean weEncryptSRTP = True);
+		   Boolean weServeSRTP = True, Boolean weEncryptSRTP = True, Boolean weUseAESGCM = False,
+		   Boolean useKernelTLS = False);
+      // If "weUseAESGCM" is True, then encrypted SRTP streams use the AEAD_AES_128_GCM ciphersuite (RFC 7714).
+      // If "useKernelTLS" is True, then - on Linux, if supported - TLS record encryption (e.g., for RTP-over-TCP data)
+      // is done by the kernel ("kTLS").  In any case, our TLS connections share a session cache (and session ticket
+      // keys), so that clients that reconnect can resume their earlier TLS sessions.
 
 protected:
   RTSPServer(UsageEnvironment& env,
@@ -192,6 +211,8 @@ public: // should be protected, but some old compilers complain otherwise
     virtual void handleCmd_DESCRIBE(char const* urlPreSuffix, char const* urlSuffix, char const* fullRequestStr);
     static void DESCRIBELookupCompletionFunction(void* clientData, ServerMediaSession* sessionLookedUp);
     virtual void handleCmd_DESCRIBE_afterLookup(ServerMediaSession* session);
+    static void DESCRIBEPreparationCompletionFunction(void* clientData);
+    virtual void handleCmd_DESCRIBE_afterPreparation(ServerMediaSession* session);
     virtual void handleCmd_REGISTER(char const* cmd/*"REGISTER" or "DEREGISTER"*/,
 				    char const* url, char const* urlSuffix, char const* fullRequestStr,
 				    Boolean reuseConnection, Boolean deliverViaTCP, char const* proxyURLSuffix);
@@ -214,12 +235,38 @@ public: // should be protected, but some old compilers complain otherwise
     virtual void handleHTTPCmd_TunnelingGET(char const* sessionCookie);
     virtual Boolean handleHTTPCmd_TunnelingPOST(char const* sessionCookie, unsigned char const* extraData, unsigned extraDataSize);
     virtual void handleHTTPCmd_StreamingGET(char const* urlSuffix, char const* fullRequestStr);
+    static void StreamingGETLookupCompletionFunction(void* clientData, ServerMediaSession* sessionLookedUp);
+    virtual void handleHTTPCmd_StreamingGET_afterLookup(ServerMediaSession* session);
+    virtual void handleHTTPCmd_metrics(class MetricsRegistry& metricsRegistry);
   protected:
     void resetRequestBuffer();
     void closeSocketsRTSP();
+    void processRequestBytes(int newBytesRead, int numBytesRemaining);
+        // "numBytesRemaining" is non-zero if the new bytes are left over from a previous (pipelined) request
+    void sendResponse(); // sends the contents of "fResponseBuffer"
+    void queueResponse(char* response, unsigned responseSize);
+      // Sends a response (that may be too large for "fResponseBuffer"; we take ownership of it) without blocking.  Any part
+      // that can't be sent immediately gets sent as our socket becomes writable.  Used only for a final (HTTP) response.
+    Boolean sendQueuedResponse(); // returns True iff the queued response has been sent (or can no longer be)
+    static void queuedResponseHandler(void* instance, int /*mask*/);
+    static void queuedResponseTimeout(void* instance);
+    void finishQueuedResponse();
+
+    // Support for handling a request asynchronously - e.g., if the lookup of its "ServerMediaSession", or the
+    // preparation of its SDP description, doesn't complete immediately.  Each such operation is bracketed by calls to
+    // "beginAsyncOperation()" and "endAsyncOperation()".  If any operation is still pending once the request handler
+    // returns, then the response is sent (and subsequent requests are handled) only after the last one ends:
+    void beginAsyncOperation() { ++fNumPendingOperations; }
+    void endAsyncOperation();
+    void pauseRequestReading();
+    void resumeRequestReading();
+    void sendDeferredResponse();
     static void handleAlternativeRequestByte(void*, u_int8_t requestByte);
     void handleAlternativeRequestByte1(u_int8_t requestByte);
     Boolean authenticationOK(char const* cmdName, char const* urlSuffix, char const* fullRequestStr);
+    class RTSPRequestTokenizer const& tokenizedRequest(char const* fullRequestStr, class RTSPRequestTokenizer& tmpTokens);
+      // Returns "fullRequestStr", parsed into its command, URL and header fields.  Normally, this is the request that
+      // we're currently handling, which we've already parsed; otherwise we parse it now (into "tmpTokens").
     void changeClientInputSocket(int newSocketNum, ServerTLSState const* newTLSState,
 				 unsigned char const* extraData, unsigned extraDataSize);
       // used to implement RTSP-over-HTTP tunneling
@@ -239,12 +286,21 @@ public: // should be protected, but some old compilers complain otherwise
     int fAddressFamily;
     Boolean fIsActive;
     unsigned char* fLastCRLF;
+    class RTSPRequestTokenizer* fRequestTokens; // the current request, parsed (once) into its command, URL and header fields
     unsigned fRecursionCount;
     char const* fCurrentCSeq;
     Authenticator fCurrentAuthenticator; // used if access control is needed
     char* fOurSessionCookie; // used for optional RTSP-over-HTTP tunneling
     unsigned fBase64RemainderCount; // used for optional RTSP-over-HTTP tunneling (possible values: 0,1,2,3)
     unsigned fScheduledDelayedTask;
+    unsigned fNumPendingOperations;
+    Boolean fResponseIsDeferred, fRequestReadingIsPaused;
+    unsigned fDeferredRequestSize; // any request bytes beyond this were received after the deferred request
+    u_int32_t fDeferredSETUPSessionId; // if the deferred request was a "SETUP"; used to implement 'play after SETUP'
+    ServerMediaSession* fSessionBeingDescribed; // while we're preparing its SDP description
+    char* fQueuedResponse; // non-NULL while a response from "queueResponse()" is still being sent
+    unsigned fQueuedResponseSize, fQueuedResponseBytesSent;
+    TaskToken fQueuedResponseTimeoutTask;
   };
 
   // The state of an individual client session (using one or more sequential TCP connections) handled by a RTSP server:
@@ -301,7 +357,9 @@ public: // should be protected, but some old compilers complain otherwise
 
     // Member variables used to implement "handleCmd_SETUP()":
     RTSPServer::RTSPClientConnection* fOurClientConnection;
-    char const* fURLPreSuffix; char const* fURLSuffix; char const* fFullRequestStr; char const* fTrackId;
+    char* fURLPreSuffix; char* fURLSuffix; // copies, because the stream lookup might not complete immediately
+    char const* fFullRequestStr; char const* fTrackId;
+    class SETUPLookupState* fPendingSETUPLookup; // non-NULL while a "SETUP"s stream lookup is outstanding
   };
 
 protected: // redefined virtual functions
@@ -324,6 +382,10 @@ private:
   void unnoteTCPStreamingOnSocket(int socketNum, RTSPClientSession* clientSession, unsigned trackNum);
   void stopTCPStreamingOnSocket(int socketNum);
 
+  class HTTPStreamer* getHTTPStreamer(ServerMediaSession& session); // for a new HTTP client of "session"
+  static void HTTPStreamerEndedHandler(void* clientData, class HTTPStreamer* streamer);
+  void closeHTTPStreamer(class HTTPStreamer* streamer);
+
 private:
   friend class RTSPClientConnection;
   friend class RTSPClientSession;
@@ -342,6 +404,10 @@ private:
   Boolean fOurConnectionsUseTLS; // by default, False
   Boolean fWeServeSRTP; // used only if "fOurConnectionsUseTLS" is True
   Boolean fWeEncryptSRTP; // used only if "fWeServeSRTP" is True
+  Boolean fWeUseAESGCM; // used only if "fWeEncryptSRTP" is True
+  Boolean fHTTPStreamingIsEnabled; // by default, False
+  Boolean fMetricsOverHTTPIsEnabled; // by default, False
+  HashTable* fHTTPStreamers; // indexed by "HTTPStreamer*"; used only if "fHTTPStreamingIsEnabled" is True
 };
 
 
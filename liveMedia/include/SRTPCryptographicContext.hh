@@ -23,6 +23,14 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _MIKEY_HH
 #include "MIKEY.hh"
 #endif
+#ifndef NO_OPENSSL
+#include <openssl/evp.h>
+#endif
+
+// We support two SRTP ciphersuites (chosen by the "MIKEYState"): AES_CM_128_HMAC_SHA1_80 (RFC 3711), and
+// AEAD_AES_128_GCM (RFC 7714).  The OpenSSL cipher and HMAC state for each session key is set up just once (when the
+// keys are derived), so the per-packet cost is just that of the encryption and authentication themselves (which OpenSSL
+// performs using the CPU's AES instructions (e.g., AES-NI or ARMv8 CE), if present).
 
 class SRTPCryptographicContext {
 public:
@@ -41,7 +49,8 @@ public:
   // RTP and RTCP packet.
   // Returns True iff the packet is well-formed.
   // ("outPacketSize" will be >= "inPacketSize"; there must be enough space at the end of
-  //  "buffer" for the extra (4+10 bytes for SRTP; 4+4+10 bytes for SRTCP).)
+  //  "buffer" for the extra (4+10 bytes for SRTP; 4+4+10 bytes for SRTCP - or, if AES-GCM is used,
+  //  16+4 bytes for SRTP; 16+4+4 bytes for SRTCP).)
   Boolean processOutgoingSRTPPacket(u_int8_t* buffer, unsigned inPacketSize,
 				    unsigned& outPacketSize);
   Boolean processOutgoingSRTCPPacket(u_int8_t* buffer, unsigned inPacketSize,
@@ -58,11 +67,21 @@ private:
 #define SRTP_MKI_LENGTH 4 // in bytes
 #define SRTP_AUTH_KEY_LENGTH (160/8) // in bytes
 #define SRTP_AUTH_TAG_LENGTH (80/8) // in bytes
+  // Definitions specific to the "AEAD_AES_128_GCM" ciphersuite:
+#define SRTP_AEAD_SALT_LENGTH (96/8) // in bytes
+#define SRTP_AEAD_AUTH_TAG_LENGTH (128/8) // in bytes
+  // The most that's added to the end of an outgoing SRTP packet:
+#define SRTP_MAX_OUTGOING_PACKET_OVERHEAD (SRTP_MKI_LENGTH + SRTP_AEAD_AUTH_TAG_LENGTH)
 
   struct derivedKeys {
     u_int8_t cipherKey[SRTP_CIPHER_KEY_LENGTH];
-    u_int8_t salt[SRTP_CIPHER_SALT_LENGTH];
-    u_int8_t authKey[SRTP_AUTH_KEY_LENGTH];
+    u_int8_t salt[SRTP_CIPHER_SALT_LENGTH]; // (only the first SRTP_AEAD_SALT_LENGTH bytes are used with AES-GCM)
+    u_int8_t authKey[SRTP_AUTH_KEY_LENGTH]; // (not used with AES-GCM)
+
+    // OpenSSL state that's set up (once) from the above keys:
+    EVP_CIPHER_CTX* cipherCtx; // AES-128, in counter mode (or GCM mode)
+    EVP_MD_CTX* hmacInnerCtx; // SHA-1 state, after hashing the HMAC inner pad (not used with AES-GCM)
+    EVP_MD_CTX* hmacOuterCtx; // SHA-1 state, after hashing the HMAC outer pad (not used with AES-GCM)
   };
 
   struct allDerivedKeys {
@@ -109,6 +128,28 @@ private:
   void cryptData(derivedKeys& keys, u_int64_t index, u_int32_t ssrc,
 		 u_int8_t* data, unsigned numDataBytes);
 
+  // Used to implement the AES-GCM ciphersuite:
+  Boolean processIncomingSRTPPacketAEAD(u_int8_t* buffer, unsigned inPacketSize, unsigned& outPacketSize);
+  Boolean processIncomingSRTCPPacketAEAD(u_int8_t* buffer, unsigned inPacketSize, unsigned& outPacketSize);
+  Boolean processOutgoingSRTPPacketAEAD(u_int8_t* buffer, unsigned inPacketSize, unsigned& outPacketSize);
+  Boolean processOutgoingSRTCPPacketAEAD(u_int8_t* buffer, unsigned inPacketSize, unsigned& outPacketSize);
+  Boolean cryptDataAEAD(derivedKeys& keys, Boolean encrypt, u_int8_t const* iv,
+			u_int8_t const* aad1, unsigned aad1Size, u_int8_t const* aad2, unsigned aad2Size,
+			u_int8_t* data, unsigned numDataBytes, u_int8_t* authenticationTag);
+      // En/decrypts "data" (in place), authenticating it along with the 'additional authenticated data' "aad1"+"aad2".
+      // When encrypting, the resulting tag is written to "authenticationTag"; when decrypting, "authenticationTag" is
+      // checked, and False is returned if it's wrong.
+
+  void computeIncomingROC(u_int16_t rtpSeqNum, u_int32_t& thisPacketsROC,
+			  u_int32_t& nextROC, u_int16_t& nextHighRTPSeqNum);
+      // Figures out an incoming SRTP packet's ROC, and the (ROC, highest seq num) state to use if it authenticates OK
+  u_int32_t computeOutgoingROC(u_int16_t rtpSeqNum);
+
+  void computeHMAC(derivedKeys& keys, u_int8_t const* data, unsigned numDataBytes,
+		   u_int8_t* resultDigest/*must be SHA1_DIGEST_LEN bytes in size*/);
+  void setUpCipherState(derivedKeys& keys);
+  void freeCipherState(derivedKeys& keys);
+
   void performKeyDerivation();
 
   void deriveKeysFromMaster(u_int8_t const* masterKey, u_int8_t const* salt,
@@ -128,6 +169,9 @@ private:
 
   u_int8_t const* masterKey() const { return &masterKeyPlusSalt()[0]; }
   u_int8_t const* masterSalt() const { return &masterKeyPlusSalt()[SRTP_CIPHER_KEY_LENGTH]; }
+  unsigned masterSaltLength() const { return fMIKEYState.keyDataLength() - SRTP_CIPHER_KEY_LENGTH; }
+
+  Boolean weUseAESGCM() const { return fMIKEYState.useAESGCM(); }
 
   Boolean weEncryptSRTP() const { return fMIKEYState.encryptSRTP(); }
   Boolean weEncryptSRTCP() const { return fMIKEYState.encryptSRTCP(); }
@@ -136,6 +180,7 @@ private:
 
   // Derived (i.e., session) keys:
   allDerivedKeys fDerivedKeys;
+  EVP_MD_CTX* fHMACCtx; // scratch state, used to compute each HMAC
 
   // State used for handling the reception of SRTP packets:
   Boolean fHaveReceivedSRTPPackets;
@@ -46,6 +46,14 @@ public:
   char* generateSDPDescription(int addressFamily); // based on the entire session
       // Note: The caller is responsible for freeing the returned string
 
+  void prepareSDPDescription(int addressFamily, TaskFunc* completionFunc, void* completionClientData);
+      // Arranges for "completionFunc(completionClientData)" to be called once the SDP lines of each subsession have been
+      // prepared, so that a subsequent call to "generateSDPDescription()" will not block (e.g., while reading a file).
+      // Note: If the SDP lines are already available, then "completionFunc" is called immediately (from this function).
+  void cancelSDPDescriptionPreparation(void* completionClientData);
+      // Cancels any pending "prepareSDPDescription()" calls with this "completionClientData" (without calling their
+      // "completionFunc"s)
+
   char const* streamName() const { return fStreamName; }
 
   Boolean addSubsession(ServerMediaSubsession* subsession);
@@ -75,6 +83,7 @@ public:
 
   Boolean streamingUsesSRTP; // by default, False
   Boolean streamingIsEncrypted; // by default, False
+  Boolean streamingUsesAESGCM; // by default, False (used only if "streamingIsEncrypted" is True)
 
 protected:
   ServerMediaSession(UsageEnvironment& env, char const* streamName,
@@ -87,6 +96,12 @@ protected:
 private: // redefined virtual functions
   virtual Boolean isServerMediaSession() const;
 
+private:
+  friend class ServerMediaSubsession;
+  void noteSubsessionSDPLinesPrepared(ServerMediaSubsession* subsession);
+  Boolean continueSDPPreparation(class SDPPreparationRequest* request);
+  static void completeSDPPreparationRequests(class SDPPreparationRequest* requests);
+
 private:
   Boolean fIsSSM;
 
@@ -103,6 +118,7 @@ private:
   struct timeval fCreationTime;
   unsigned fReferenceCount;
   Boolean fDeleteWhenUnreferenced;
+  class SDPPreparationRequest* fSDPPreparationRequests; // pending calls to "prepareSDPDescription()"
 };
 
 
@@ -172,6 +188,14 @@ public:
      // using the "startStream()" and "deleteStream()" functions.
   virtual void deleteStream(unsigned clientSessionId, void*& streamToken);
 
+  virtual FramedSource* createNewNonRTPStreamSource(unsigned clientSessionId, Boolean& sourceCanBeShared);
+     // Returns a new source for this subsession's media - to be delivered other than by RTP (e.g., over HTTP) - or NULL
+     // (the default) if this isn't supported.  "sourceCanBeShared" is set to True iff the source's data may be delivered
+     // to more than one client.  The new source must not interfere with any that's used for RTP delivery, so a subsession
+     // whose input can't be read more than once (e.g., a 'live' or proxied input) should return NULL - unless it can give
+     // each caller a 'replica' of its input (e.g., using a "StreamReplicator").
+  virtual void closeNonRTPStreamSource(FramedSource* source);
+
   virtual void testScaleFactor(float& scale); // sets "scale" to the actual supported scale
   virtual float duration() const;
     // returns 0 for an unbounded session (the default)
@@ -186,6 +210,15 @@ protected: // we're a virtual base class
   char const* rangeSDPLine() const;
       // returns a string to be delete[]d
 
+  // Support for preparing our SDP lines asynchronously (used to implement "ServerMediaSession::prepareSDPDescription()"):
+  virtual Boolean sdpLinesAreReady(int addressFamily);
+      // Returns True iff "sdpLines()" can be called without blocking.  The default implementation returns True.
+  virtual Boolean prepareSDPLines(int addressFamily);
+      // Called if "sdpLinesAreReady()" returned False.  Returns True if the SDP lines were prepared (or could not be
+      // prepared) immediately.  Otherwise, returns False, and "sdpLinesPrepared()" must be called - from a later
+      // event loop task - when preparation has finished.  The default implementation returns True.
+  void sdpLinesPrepared();
+
   ServerMediaSession* fParentSession;
   u_int32_t fSRTP_ROC; // horrible hack for SRTP; when the ROC changes, regenerate the SDP
 
@@ -196,6 +229,7 @@ private:
 
   unsigned fTrackNumber; // within an enclosing ServerMediaSession
   char const* fTrackId;
+  Boolean fSDPLinesArePreparing; // True while an asynchronous "prepareSDPLines()" is in progress
 };
 
 #endif
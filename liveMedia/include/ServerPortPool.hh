@@ -0,0 +1,88 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2025 Live Networks, Inc.  All rights reserved.
+// A pool of pre-bound UDP port pairs, for the RTP and RTCP 'groupsocks' of server streams
+// C++ header
+
+#ifndef _SERVER_PORT_POOL_HH
+#define _SERVER_PORT_POOL_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+#ifndef _GROUPSOCK_HH
+#include "Groupsock.hh"
+#endif
+
+// Normally, each time that a "OnDemandServerMediaSubsession" sets up a (non-shared) stream, it finds a pair of free UDP
+// ports by creating 'groupsocks' on successive port numbers until it succeeds - which can take many "socket()" and
+// "bind()" calls when many ports are already in use.  If a port pool is enabled, then a range of (even, odd) port pairs
+// is bound ahead of time, and streams take - and later give back - a pair from the pool instead.  (If the pool has
+// no free pair, then streams find their ports as before.)
+//
+// The pool is per-"UsageEnvironment" (i.e., per event loop).  Its ports are bound exclusively (i.e., without
+// "SO_REUSEADDR" or "SO_REUSEPORT"), so that incoming RTCP packets for a stream always reach that stream's socket.
+// Therefore, if a server runs several event loops, they can each enable a pool with the same port range; the range
+// then gets divided among them (each pool skips ports that are already bound by the others).
+//
+// The pool is disabled by default.  To enable it, call "ServerPortPool::enable()" - before any streams are set up.
+// Note that if it's enabled, then "OnDemandServerMediaSubsession::createGroupsock()" is not called for streams that
+// get their ports from the pool.
+
+class ServerPortPool {
+public:
+  static ServerPortPool* enable(UsageEnvironment& env, portNumBits firstPortNum, unsigned numPortPairs);
+      // Binds up to "numPortPairs" RTP/RTCP port pairs (for IPv4, and also for IPv6 if we have an IPv6 address),
+      // beginning at the first even port number >= "firstPortNum".  Returns NULL (setting "env"s result message) if no
+      // ports could be bound.  If a pool is already enabled, then it's first disabled.
+  static void disable(UsageEnvironment& env);
+      // Closes the pool's free ports.  (Any ports that are still in use get closed when their streams end.)
+  static ServerPortPool* lookup(UsageEnvironment& env);
+      // Returns NULL if there's no pool (i.e., it was never enabled, or it was disabled and all of its ports are closed)
+
+  Boolean isEnabled() const { return fIsEnabled; }
+
+  Boolean allocate(int addressFamily, Groupsock*& rtpGroupsock, Groupsock*& rtcpGroupsock);
+      // Returns a pair of groupsocks (with adjacent port numbers; RTP's is even), or False if none is free (or if the
+      // pool is disabled)
+  Boolean release(Groupsock* rtpGroupsock);
+      // Returns a pair (given its RTP groupsock) to the pool.  Returns False if the groupsock isn't one of ours.
+
+  unsigned numPortPairs(int addressFamily) const;
+  unsigned numFreePortPairs(int addressFamily) const;
+  unsigned numAllocationFailures() const { return fNumAllocationFailures; } // because no pair was free
+
+private:
+  ServerPortPool(UsageEnvironment& env);
+  virtual ~ServerPortPool();
+
+  unsigned bindPortPairs(int addressFamily, portNumBits firstPortNum, unsigned numPortPairs);
+  void closeFreePortPairs();
+  Boolean reclaimIfPossible(); // returns True iff we were deleted
+
+private:
+  UsageEnvironment& fEnv;
+  Boolean fIsEnabled;
+  // For each of IPv4 and IPv6:
+  unsigned fNumPortPairs[2]; // including those in use
+  class ServerPortPair* fFreePortPairs[2]; // a linked list
+  unsigned fNumFreePortPairs[2];
+  HashTable* fPortPairsByRTPGroupsock; // all of our pairs, both free and in use
+  unsigned fNumAllocationFailures;
+};
+
+#endif
@@ -80,5 +80,7 @@ private:
   StreamReplica* fPrimaryReplica; // the first replica that requests each frame.  We use its buffer when copying to the others.
   StreamReplica* fReplicasAwaitingCurrentFrame; // other than the 'primary' replica
   StreamReplica* fReplicasAwaitingNextFrame; // replicas that have already received the current frame, and have asked for the next
+
+  class StreamReplicatorMetrics* fMetrics; // NULL unless metrics are enabled
 };
 #endif
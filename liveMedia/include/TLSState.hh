@@ -39,8 +39,16 @@ public:
   Boolean isNeeded;
 
   int write(const char* data, unsigned count);
+  int tryWrite(const char* data, unsigned count);
+      // Like "write()", except that it returns 0 (rather than an error) if the data can't be written yet, because the
+      // (non-blocking) socket's send buffer is full.  (If so, call it again - with the same data - later.)
   int read(u_int8_t* buffer, unsigned bufferSize);
 
+  Boolean sendingIsDoneByKernel() const;
+      // True iff - after the handshake - the OS kernel ("kTLS") does our TLS record encryption.  If so, data may be
+      // written to the socket using plain "send()" (rather than "write()").
+  Boolean sessionWasResumed() const; // True iff the handshake resumed an earlier TLS session
+
   void nullify(); // clear the state so that the destructor will have no effect
 
 protected: // we're an abstract base class
@@ -53,6 +61,7 @@ protected: // we're an abstract base class
 
 protected:
   Boolean fHasBeenSetup;
+  Boolean fSendingIsDoneByKernel;
   SSL_CTX* fCtx;
   SSL* fCon;
 #endif
@@ -82,12 +91,41 @@ private:
 #endif
 };
 
+// The TLS state that's shared by all of a server's connections.  The certificate and private key are loaded just once,
+// and - because they're shared - the server's session cache and session ticket keys let a client that reconnects resume
+// its earlier TLS session (rather than doing a full handshake).
+// Optionally, Linux kernel TLS ("kTLS") can also be enabled, so that - after the handshake - the kernel does the TLS
+// record encryption for data that we send.  (This works only if OpenSSL was built with kTLS support, and the kernel's
+// "tls" module is loaded; otherwise, TLS is done by OpenSSL, as usual.)
+class ServerTLSContext {
+public:
+  static ServerTLSContext* createNew(UsageEnvironment& env,
+				     char const* certFileName, char const* privKeyFileName,
+				     Boolean useKernelTLS = False);
+      // Returns NULL (setting "env"s result message) if the certificate or private key could not be loaded
+  virtual ~ServerTLSContext();
+
+#ifndef NO_OPENSSL
+  SSL_CTX* ctx() const { return fCtx; }
+#endif
+
+private:
+  ServerTLSContext();
+
+#ifndef NO_OPENSSL
+  SSL_CTX* fCtx;
+#endif
+};
+
 class ServerTLSState: public TLSState {
 public:
   ServerTLSState(UsageEnvironment& env);
   virtual ~ServerTLSState();
 
   void setCertificateAndPrivateKeyFileNames(char const* certFileName, char const* privKeyFileName);
+  void setContext(ServerTLSContext* context);
+      // If set, then the connection uses this (shared) context, rather than its own (loaded from the file names above).
+      // (The connection keeps its own reference to the context's state, so "context" may be deleted afterwards.)
   void assignStateFrom(ServerTLSState const& from);
 
   int accept(int socketNum); // returns: <0 (error), 0 (pending), >0 (success)
@@ -131,7 +131,14 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "OggFileServerDemux.hh"
 #include "MPEG2TransportStreamDemux.hh"
 #include "ProxyServerMediaSession.hh"
+#include "ProxyRTSPServer.hh"
 #include "HLSSegmenter.hh"
 #include "MPEG2TransportStreamAccumulator.hh"
+#include "MediaMetrics.hh"
+#include "BufferedPacketPool.hh"
+#include "MediaMetadataCache.hh"
+#include "FlexFEC.hh"
+#include "HTTPStreamer.hh"
+#include "ServerPortPool.hh"
 
 #endif
@@ -21,6 +21,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "DynamicRTSPServer.hh"
 #include <liveMedia.hh>
 #include <string.h>
+#include <sys/stat.h>
 
 DynamicRTSPServer*
 DynamicRTSPServer::createNew(UsageEnvironment& env, Port ourPort,
@@ -34,17 +35,100 @@ DynamicRTSPServer::createNew(UsageEnvironment& env, Port ourPort,
 			       authDatabase, reclamationTestSeconds);
 }
 
+// A "ServerMediaSession" is created using a callback, because - for some file types - it can't be done immediately:
+typedef void onSMSCreationFunc(ServerMediaSession* newSMS, void* clientData);
+static void createNewSMS(UsageEnvironment& env, char const* fileName,
+			 onSMSCreationFunc* onCreation, void* onCreationClientData); // forward
+
+// The state of a (possibly asynchronous) creation of a "ServerMediaSession", and of the lookups that are waiting for it:
+class SMSCreation {
+public:
+  SMSCreation(DynamicRTSPServer* server, char const* streamName)
+    : fServer(server), fStreamName(strDup(streamName)), fWaiters(NULL) {
+  }
+  virtual ~SMSCreation() {
+    delete[] fStreamName;
+    while (fWaiters != NULL) {
+      Waiter* next = fWaiters->fNext;
+      delete fWaiters;
+      fWaiters = next;
+    }
+  }
+
+  void addWaiter(lookupServerMediaSessionCompletionFunc* completionFunc, void* completionClientData) {
+    // Add the new waiter to the end of the list, so that waiters get their result in order:
+    Waiter** ptr = &fWaiters;
+    while (*ptr != NULL) ptr = &((*ptr)->fNext);
+    *ptr = new Waiter(completionFunc, completionClientData);
+  }
+
+  class Waiter {
+  public:
+    Waiter(lookupServerMediaSessionCompletionFunc* completionFunc, void* completionClientData)
+      : fNext(NULL), fCompletionFunc(completionFunc), fCompletionClientData(completionClientData) {
+    }
+
+    Waiter* fNext;
+    lookupServerMediaSessionCompletionFunc* fCompletionFunc;
+    void* fCompletionClientData;
+  };
+
+  DynamicRTSPServer* fServer; // NULL if the server was deleted while we were pending
+  char* fStreamName;
+  Waiter* fWaiters;
+  u_int64_t fFileSize; int64_t fModificationTime; // when the creation began
+};
+
+// The size and modification time of the file that each of our "ServerMediaSession"s was created from:
+class FileAttributes {
+public:
+  FileAttributes(u_int64_t fileSize, int64_t modificationTime)
+    : fFileSize(fileSize), fModificationTime(modificationTime) {
+  }
+
+  u_int64_t fFileSize;
+  int64_t fModificationTime;
+};
+
+static Boolean getFileAttributes(char const* fileName, u_int64_t& fileSize, int64_t& modificationTime) {
+  // Returns False if "fileName" doesn't exist (as a readable file):
+  FILE* fid = fopen(fileName, "rb");
+  if (fid == NULL) return False;
+  fclose(fid);
+
+  fileSize = 0; modificationTime = 0; // by default (if we can't get the actual values)
+#if !defined(_WIN32_WCE)
+  struct stat sb;
+  if (stat(fileName, &sb) == 0) {
+    fileSize = sb.st_size;
+    modificationTime = sb.st_mtime;
+  }
+#endif
+  return True;
+}
+
 DynamicRTSPServer::DynamicRTSPServer(UsageEnvironment& env, int ourSocketIPv4, int ourSocketIPv6,
 				     Port ourPort,
 				     UserAuthenticationDatabase* authDatabase, unsigned reclamationTestSeconds)
-  : RTSPServer(env, ourSocketIPv4, ourSocketIPv6, ourPort, authDatabase, reclamationTestSeconds) {
+  : RTSPServer(env, ourSocketIPv4, ourSocketIPv6, ourPort, authDatabase, reclamationTestSeconds),
+    fFileAttributes(HashTable::create(STRING_HASH_KEYS)), fPendingSMSCreations(HashTable::create(STRING_HASH_KEYS)),
+    fRetransmissionHistorySize(0) {
 }
 
 DynamicRTSPServer::~DynamicRTSPServer() {
-}
+  // Any "ServerMediaSession"s that are still being created will get closed (rather than added to us) when they're done:
+  SMSCreation* creation;
+  while ((creation = (SMSCreation*)fPendingSMSCreations->RemoveNext()) != NULL) {
+    creation->fServer = NULL;
+  }
+  delete fPendingSMSCreations;
 
-static ServerMediaSession* createNewSMS(UsageEnvironment& env,
-					char const* fileName, FILE* fid); // forward
+  FileAttributes* fileAttributes;
+  while ((fileAttributes = (FileAttributes*)fFileAttributes->RemoveNext()) != NULL) {
+    delete fileAttributes;
+  }
+  delete fFileAttributes;
+}
 
 void DynamicRTSPServer
 ::lookupServerMediaSession(char const* streamName,
@@ -52,8 +136,8 @@ void DynamicRTSPServer
 			   void* completionClientData,
 			   Boolean isFirstLookupInSession) {
   // First, check whether the specified "streamName" exists as a local file:
-  FILE* fid = fopen(streamName, "rb");
-  Boolean const fileExists = fid != NULL;
+  u_int64_t fileSize; int64_t modificationTime;
+  Boolean const fileExists = getFileAttributes(streamName, fileSize, modificationTime);
 
   // Next, check whether we already have a "ServerMediaSession" for this file:
   ServerMediaSession* sms = getServerMediaSession(streamName);
@@ -64,51 +148,150 @@ void DynamicRTSPServer
     if (smsExists) {
       // "sms" was created for a file that no longer exists. Remove it:
       removeServerMediaSession(sms);
+      delete (FileAttributes*)fFileAttributes->Lookup(streamName);
+      fFileAttributes->Remove(streamName);
     }
 
-    sms = NULL;
-  } else {
-    if (smsExists && isFirstLookupInSession) { 
-      // Remove the existing "ServerMediaSession" and create a new one, in case the underlying
-      // file has changed in some way:
-      removeServerMediaSession(sms); 
+    if (completionFunc != NULL) (*completionFunc)(completionClientData, NULL);
+    return;
+  }
+
+  if (smsExists && isFirstLookupInSession) {
+    // Remove the existing "ServerMediaSession" and create a new one - but only if the underlying file
+    // has changed since we created it:
+    FileAttributes* fileAttributes = (FileAttributes*)fFileAttributes->Lookup(streamName);
+    if (fileAttributes == NULL
+	|| fileAttributes->fFileSize != fileSize || fileAttributes->fModificationTime != modificationTime) {
+      removeServerMediaSession(sms);
       sms = NULL;
-    } 
+    }
+  }
+
+  if (sms != NULL) {
+    if (completionFunc != NULL) (*completionFunc)(completionClientData, sms);
+    return;
+  }
+
+  // We need to create a new "ServerMediaSession".  Because this might not complete immediately, we'll call the
+  // completion function later.  (If a "ServerMediaSession" is already being created for this file, then we just wait
+  // for that.)
+  SMSCreation* creation = (SMSCreation*)fPendingSMSCreations->Lookup(streamName);
+  if (creation != NULL) {
+    creation->addWaiter(completionFunc, completionClientData);
+    return;
+  }
+
+  creation = new SMSCreation(this, streamName);
+  creation->fFileSize = fileSize; creation->fModificationTime = modificationTime;
+  creation->addWaiter(completionFunc, completionClientData);
+  fPendingSMSCreations->Add(streamName, creation);
+
+  createNewSMS(envir(), creation->fStreamName, onSMSCreation, creation);
+}
 
-    if (sms == NULL) {
-      sms = createNewSMS(envir(), streamName, fid); 
-      addServerMediaSession(sms);
+void DynamicRTSPServer::onSMSCreation(ServerMediaSession* newSMS, void* clientData) {
+  SMSCreation* creation = (SMSCreation*)clientData;
+  if (creation->fServer == NULL) {
+    // Our server was deleted while we were pending, so there's no longer any use for "newSMS":
+    Medium::close(newSMS);
+  } else {
+    creation->fServer->completeSMSCreation(creation, newSMS);
+  }
+  delete creation;
+}
+
+void DynamicRTSPServer::completeSMSCreation(SMSCreation* creation, ServerMediaSession* newSMS) {
+  fPendingSMSCreations->Remove(creation->fStreamName);
+
+  if (newSMS != NULL) {
+    if (fRetransmissionHistorySize > 0) {
+      // (Each of the subsessions that we create is an "OnDemandServerMediaSubsession".)
+      ServerMediaSubsessionIterator iter(*newSMS);
+      ServerMediaSubsession* subsession;
+      while ((subsession = iter.next()) != NULL) {
+	((OnDemandServerMediaSubsession*)subsession)->enableRetransmission(fRetransmissionHistorySize);
+      }
     }
+    addServerMediaSession(newSMS);
 
-    fclose(fid);
+    FileAttributes* fileAttributes = new FileAttributes(creation->fFileSize, creation->fModificationTime);
+    delete (FileAttributes*)fFileAttributes->Add(creation->fStreamName, fileAttributes);
   }
 
-  if (completionFunc != NULL) {
-    (*completionFunc)(completionClientData, sms);
+  // Tell each waiting lookup about the result:
+  for (SMSCreation::Waiter* waiter = creation->fWaiters; waiter != NULL; waiter = waiter->fNext) {
+    if (waiter->fCompletionFunc != NULL) (*waiter->fCompletionFunc)(waiter->fCompletionClientData, newSMS);
   }
 }
 
+// Used to implement "prewarmMetadataCache()":
+struct PrewarmSMSCreationState {
+  ServerMediaSession* sms;
+  EventLoopWatchVariable watchVariable;
+};
+static void onPrewarmSMSCreation(ServerMediaSession* newSMS, void* clientData) {
+  PrewarmSMSCreationState* creationState = (PrewarmSMSCreationState*)clientData;
+  creationState->sms = newSMS;
+  creationState->watchVariable = 1;
+}
+
+Boolean DynamicRTSPServer::prewarmMetadataCache(UsageEnvironment& env, char const* fileName) {
+  // Generating a SDP description adds each subsession's SDP lines to the cache.  Because a subsession generates its SDP
+  // lines only once, we use a separate "ServerMediaSession" for each address family.
+  // (Note that - because this is done before the server starts - we can use the event loop to wait for each step.)
+  u_int64_t fileSize; int64_t modificationTime;
+  if (!getFileAttributes(fileName, fileSize, modificationTime)) return False;
+
+  int const addressFamilies[2] = { AF_INET, AF_INET6 };
+  for (unsigned i = 0; i < 2; ++i) {
+    PrewarmSMSCreationState creationState;
+    creationState.watchVariable = 0;
+    createNewSMS(env, fileName, onPrewarmSMSCreation, &creationState);
+    env.taskScheduler().doEventLoop(&creationState.watchVariable);
+    if (creationState.sms == NULL) return False;
+
+    delete[] creationState.sms->generateSDPDescription(addressFamilies[i]);
+    Medium::close(creationState.sms);
+  }
+
+  return True;
+}
+
 // Special code for handling Matroska files:
 struct MatroskaDemuxCreationState {
-  MatroskaFileServerDemux* demux;
-  EventLoopWatchVariable watchVariable;
+  ServerMediaSession* sms;
+  onSMSCreationFunc* onCreation;
+  void* onCreationClientData;
 };
 static void onMatroskaDemuxCreation(MatroskaFileServerDemux* newDemux, void* clientData) {
   MatroskaDemuxCreationState* creationState = (MatroskaDemuxCreationState*)clientData;
-  creationState->demux = newDemux;
-  creationState->watchVariable = 1;
+
+  ServerMediaSubsession* smss;
+  while ((smss = newDemux->newServerMediaSubsession()) != NULL) {
+    creationState->sms->addSubsession(smss);
+  }
+
+  (*creationState->onCreation)(creationState->sms, creationState->onCreationClientData);
+  delete creationState;
 }
 // END Special code for handling Matroska files:
 
 // Special code for handling Ogg files:
 struct OggDemuxCreationState {
-  OggFileServerDemux* demux;
-  EventLoopWatchVariable watchVariable;
+  ServerMediaSession* sms;
+  onSMSCreationFunc* onCreation;
+  void* onCreationClientData;
 };
 static void onOggDemuxCreation(OggFileServerDemux* newDemux, void* clientData) {
   OggDemuxCreationState* creationState = (OggDemuxCreationState*)clientData;
-  creationState->demux = newDemux;
-  creationState->watchVariable = 1;
+
+  ServerMediaSubsession* smss;
+  while ((smss = newDemux->newServerMediaSubsession()) != NULL) {
+    creationState->sms->addSubsession(smss);
+  }
+
+  (*creationState->onCreation)(creationState->sms, creationState->onCreationClientData);
+  delete creationState;
 }
 // END Special code for handling Ogg files:
 
@@ -118,11 +301,14 @@ char const* descStr = description\
 sms = ServerMediaSession::createNew(env, fileName, fileName, descStr);\
 } while(0)
 
-static ServerMediaSession* createNewSMS(UsageEnvironment& env,
-					char const* fileName, FILE* /*fid*/) {
+static void createNewSMS(UsageEnvironment& env, char const* fileName,
+			 onSMSCreationFunc* onCreation, void* onCreationClientData) {
   // Use the file name extension to determine the type of "ServerMediaSession":
   char const* extension = strrchr(fileName, '.');
-  if (extension == NULL) return NULL;
+  if (extension == NULL) {
+    (*onCreation)(NULL, onCreationClientData);
+    return;
+  }
 
   ServerMediaSession* sms = NULL;
   Boolean const reuseSource = False;
@@ -216,32 +402,24 @@ static ServerMediaSession* createNewSMS(UsageEnvironment& env,
     NEW_SMS("Matroska video+audio+(optional)subtitles");
 
     // Create a Matroska file server demultiplexor for the specified file.
-    // (We enter the event loop to wait for this to complete.)
-    MatroskaDemuxCreationState creationState;
-    creationState.watchVariable = 0;
-    MatroskaFileServerDemux::createNew(env, fileName, onMatroskaDemuxCreation, &creationState);
-    env.taskScheduler().doEventLoop(&creationState.watchVariable);
-
-    ServerMediaSubsession* smss;
-    while ((smss = creationState.demux->newServerMediaSubsession()) != NULL) {
-      sms->addSubsession(smss);
-    }
+    // (This might not complete immediately, so we add its subsessions - and finish - in the callback.)
+    MatroskaDemuxCreationState* creationState = new MatroskaDemuxCreationState;
+    creationState->sms = sms;
+    creationState->onCreation = onCreation; creationState->onCreationClientData = onCreationClientData;
+    MatroskaFileServerDemux::createNew(env, fileName, onMatroskaDemuxCreation, creationState);
+    return;
   } else if (strcmp(extension, ".ogg") == 0 || strcmp(extension, ".ogv") == 0 || strcmp(extension, ".opus") == 0) {
     // Assumed to be an Ogg file
     NEW_SMS("Ogg video and/or audio");
 
     // Create a Ogg file server demultiplexor for the specified file.
-    // (We enter the event loop to wait for this to complete.)
-    OggDemuxCreationState creationState;
-    creationState.watchVariable = 0;
-    OggFileServerDemux::createNew(env, fileName, onOggDemuxCreation, &creationState);
-    env.taskScheduler().doEventLoop(&creationState.watchVariable);
-
-    ServerMediaSubsession* smss;
-    while ((smss = creationState.demux->newServerMediaSubsession()) != NULL) {
-      sms->addSubsession(smss);
-    }
+    // (This might not complete immediately, so we add its subsessions - and finish - in the callback.)
+    OggDemuxCreationState* creationState = new OggDemuxCreationState;
+    creationState->sms = sms;
+    creationState->onCreation = onCreation; creationState->onCreationClientData = onCreationClientData;
+    OggFileServerDemux::createNew(env, fileName, onOggDemuxCreation, creationState);
+    return;
   }
 
-  return sms;
+  (*onCreation)(sms, onCreationClientData);
 }
@@ -31,6 +31,14 @@ public:
 				      UserAuthenticationDatabase* authDatabase,
 				      unsigned reclamationTestSeconds = 65);
 
+  static Boolean prewarmMetadataCache(UsageEnvironment& env, char const* fileName);
+      // Generates the SDP description for the file "fileName", to add it to the (already enabled) "MediaMetadataCache".
+      // Returns False if the file doesn't exist, or has an unknown type.
+
+  void enableRetransmission(unsigned historySize = 256) { fRetransmissionHistorySize = historySize; }
+      // Offers RTP retransmission (RFC 4588) in each stream that we create from now on
+      // (see "OnDemandServerMediaSubsession::enableRetransmission()").
+
 protected:
   DynamicRTSPServer(UsageEnvironment& env, int ourSocketIPv4, int ourSocketIPv6, Port ourPort,
 		    UserAuthenticationDatabase* authDatabase, unsigned reclamationTestSeconds);
@@ -42,6 +50,15 @@ protected: // redefined virtual functions
 					lookupServerMediaSessionCompletionFunc* completionFunc,
 					void* completionClientData,
 					Boolean isFirstLookupInSession);
+
+private:
+  static void onSMSCreation(ServerMediaSession* newSMS, void* clientData);
+  void completeSMSCreation(class SMSCreation* creation, ServerMediaSession* newSMS);
+
+private:
+  HashTable* fFileAttributes; // for each stream (file) name: the file's size and modification time, when its SMS was created
+  HashTable* fPendingSMSCreations; // for each stream (file) name whose "ServerMediaSession" is still being created
+  unsigned fRetransmissionHistorySize; // 0 if retransmission is not enabled
 };
 
 #endif
@@ -21,12 +21,83 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "DynamicRTSPServer.hh"
 #include "version.hh"
 #include <GroupsockHelper.hh> // for "weHaveAnIPv*Address()"
+#include <MediaMetrics.hh> // for "MetricsRegistry"
+#include <MediaMetadataCache.hh>
+#include <ServerPortPool.hh>
+#include <signal.h>
 
 int main(int argc, char** argv) {
   // Begin by setting up our usage environment:
   TaskScheduler* scheduler = BasicTaskScheduler::createNew();
   UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
 
+  // Options:
+  //   -m: enable run-time metrics (available via "http://<server>:<http-port>/metrics")
+  //   -p: enable event loop profiling (the profile is output whenever we receive a SIGUSR1 signal)
+  //   -c <cache-file>: cache each file's SDP description (and duration) in <cache-file>, so that files don't need to be
+  //                    read again to answer later "DESCRIBE"s
+  //   -r: offer RTP retransmission (RFC 4588) to clients that support it, so that they can recover lost packets
+  //   -s: also stream each file - as a MPEG Transport Stream - in response to a plain HTTP "GET" of its URL
+  //   -u [<first-port>:]<num-port-pairs>: bind this many RTP/RTCP (UDP) port pairs - from <first-port> (default: 6970) -
+  //                        in advance, so that streams can be set up without searching for free ports
+  //   -w <file>...: (with "-c") add the specified files to the cache, then exit (rather than running the server)
+  Boolean enableMetrics = False;
+  Boolean enableRetransmission = False;
+  Boolean enableHTTPStreaming = False;
+  char const* metadataCacheFileName = NULL;
+  unsigned serverPortPoolFirstPortNum = 6970;
+  unsigned numServerPortPairs = 0;
+  int firstFileToPrewarm = 0;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-m") == 0) {
+      enableMetrics = True;
+    } else if (strcmp(argv[i], "-p") == 0) {
+      env->enableEventLoopProfiling();
+#ifdef SIGUSR1
+      env->reportEventLoopProfileOnSignal(SIGUSR1);
+#endif
+    } else if (strcmp(argv[i], "-c") == 0 && i+1 < argc) {
+      metadataCacheFileName = argv[++i];
+    } else if (strcmp(argv[i], "-r") == 0) {
+      enableRetransmission = True;
+    } else if (strcmp(argv[i], "-s") == 0) {
+      enableHTTPStreaming = True;
+    } else if (strcmp(argv[i], "-u") == 0 && i+1 < argc) {
+      char const* arg = argv[++i];
+      if (strchr(arg, ':') != NULL) {
+	if (sscanf(arg, "%u:%u", &serverPortPoolFirstPortNum, &numServerPortPairs) != 2
+	    || serverPortPoolFirstPortNum == 0 || serverPortPoolFirstPortNum > 65534) {
+	  *env << "Bad \"-u\" argument: \"" << arg << "\"\n";
+	  exit(1);
+	}
+      } else if (sscanf(arg, "%u", &numServerPortPairs) != 1) {
+	numServerPortPairs = 0;
+      }
+    } else if (strcmp(argv[i], "-w") == 0) {
+      firstFileToPrewarm = i+1;
+      break; // the remaining arguments are file names
+    }
+  }
+  // Metrics must be enabled before the RTSP server (and its streams) are created:
+  if (enableMetrics) MetricsRegistry::enable(*env);
+  if (metadataCacheFileName != NULL && MediaMetadataCache::enable(*env, metadataCacheFileName) == NULL) {
+    *env << "Failed to enable the media metadata cache: " << env->getResultMsg() << "\n";
+    exit(1);
+  }
+
+  if (firstFileToPrewarm > 0) {
+    if (metadataCacheFileName == NULL) {
+      *env << "\"-w\" requires \"-c <cache-file>\"\n";
+      exit(1);
+    }
+    for (int i = firstFileToPrewarm; i < argc; ++i) {
+      *env << argv[i] << (DynamicRTSPServer::prewarmMetadataCache(*env, argv[i]) ? ": cached\n" : ": skipped (missing, or not a known file type)\n");
+    }
+    *env << "\"" << metadataCacheFileName << "\" now has "
+	 << MediaMetadataCache::lookup(*env)->numEntries() << " entries\n";
+    exit(0);
+  }
+
   UserAuthenticationDatabase* authDB = NULL;
 #ifdef ACCESS_CONTROL
   // To implement client access control to the RTSP server, do the following:
@@ -38,7 +109,7 @@ int main(int argc, char** argv) {
 
   // Create the RTSP server.  Try first with the default port number (554),
   // and then with the alternative port number (8554):
-  RTSPServer* rtspServer;
+  DynamicRTSPServer* rtspServer;
   portNumBits rtspServerPortNum = 554;
   rtspServer = DynamicRTSPServer::createNew(*env, rtspServerPortNum, authDB);
   if (rtspServer == NULL) {
@@ -49,6 +120,18 @@ int main(int argc, char** argv) {
     *env << "Failed to create RTSP server: " << env->getResultMsg() << "\n";
     exit(1);
   }
+  if (enableRetransmission) rtspServer->enableRetransmission();
+  if (enableMetrics) rtspServer->enableMetricsOverHTTP();
+  if (enableHTTPStreaming) rtspServer->enableHTTPStreaming();
+  if (numServerPortPairs > 0) {
+    ServerPortPool* portPool = ServerPortPool::enable(*env, (portNumBits)serverPortPoolFirstPortNum, numServerPortPairs);
+    if (portPool == NULL) {
+      *env << "Failed to enable the server port pool: " << env->getResultMsg() << "\n";
+    } else {
+      *env << "(Bound " << portPool->numPortPairs(AF_INET) << " RTP/RTCP port pairs - from port "
+	   << serverPortPoolFirstPortNum << " - in advance.)\n";
+    }
+  }
 
   *env << "LIVE555 Media Server\n";
   *env << "\tversion " << MEDIA_SERVER_VERSION_STRING
@@ -94,6 +177,12 @@ int main(int argc, char** argv) {
 
   if (rtspServer->setUpTunnelingOverHTTP(80) || rtspServer->setUpTunnelingOverHTTP(8000) || rtspServer->setUpTunnelingOverHTTP(8080)) {
     *env << "(We use port " << rtspServer->httpServerPortNum() << " for optional RTSP-over-HTTP tunneling).)\n";
+    if (enableMetrics) {
+      *env << "(Metrics are available at \"http://<server>:" << rtspServer->httpServerPortNum() << "/metrics\".)\n";
+    }
+    if (enableHTTPStreaming) {
+      *env << "(Files can also be streamed using the URL \"http://<server>:" << rtspServer->httpServerPortNum() << "/<filename>\".)\n";
+    }
   } else {
     *env << "(RTSP-over-HTTP tunneling is not available.)\n";
   }
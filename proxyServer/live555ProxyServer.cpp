@@ -35,13 +35,14 @@ char* password = NULL;
 Boolean proxyREGISTERRequests = False;
 char* usernameForREGISTER = NULL;
 char* passwordForREGISTER = NULL;
-
-static RTSPServer* createRTSPServer(Port port) {
-  if (proxyREGISTERRequests) {
-    return RTSPServerWithREGISTERProxying::createNew(*env, port, authDB, authDBForREGISTER, 65, streamRTPOverTCP, verbosityLevel, username, password);
-  } else {
-    return RTSPServer::createNew(*env, port, authDB);
-  }
+unsigned idleTimeoutSeconds = 0; // by default, connect to each back-end stream at startup, and stay connected
+unsigned maxDESCRIBEsPerSecond = 0; // by default, don't pace the back-end "DESCRIBE"s done at startup
+
+static ProxyRTSPServer* createRTSPServer(Port port) {
+  return ProxyRTSPServer::createNew(*env, port, authDB, 65, username, password,
+				    tunnelOverHTTPPortNum, verbosityLevel,
+				    idleTimeoutSeconds, maxDESCRIBEsPerSecond,
+				    proxyREGISTERRequests, authDBForREGISTER);
 }
 
 void usage() {
@@ -51,6 +52,7 @@ void usage() {
        << " [-p <rtspServer-port>]"
        << " [-u <username> <password>]"
        << " [-R] [-U <username-for-REGISTER> <password-for-REGISTER>]"
+       << " [-d <idle-timeout-seconds>] [-r <max-DESCRIBEs-per-second>]"
        << " <rtsp-url-1> ... <rtsp-url-n>\n";
   exit(1);
 }
@@ -151,6 +153,35 @@ int main(int argc, char** argv) {
       break;
     }
 
+    case 'd': {
+      // Connect to each back-end stream only on demand (i.e., when a front-end client first requests it),
+      // and disconnect from it again after it has had no front-end clients for <idle-timeout-seconds>:
+      if (argc > 2 && argv[2][0] != '-') {
+	if (sscanf(argv[2], "%u", &idleTimeoutSeconds) == 1 && idleTimeoutSeconds > 0) {
+	  ++argv; --argc;
+	  break;
+	}
+      }
+
+      // If we get here, the option was specified incorrectly:
+      usage();
+      break;
+    }
+
+    case 'r': {
+      // Limit the rate at which we connect to back-end streams at startup (to avoid a 'storm' of "DESCRIBE"s):
+      if (argc > 2 && argv[2][0] != '-') {
+	if (sscanf(argv[2], "%u", &maxDESCRIBEsPerSecond) == 1 && maxDESCRIBEsPerSecond > 0) {
+	  ++argv; --argc;
+	  break;
+	}
+      }
+
+      // If we get here, the option was specified incorrectly:
+      usage();
+      break;
+    }
+
     default: {
       usage();
       break;
@@ -189,7 +220,7 @@ int main(int argc, char** argv) {
   // Create the RTSP server. Try first with the configured port number,
   // and then with the default port number (554) if different,
   // and then with the alternative port number (8554):
-  RTSPServer* rtspServer;
+  ProxyRTSPServer* rtspServer;
   rtspServer = createRTSPServer(rtspServerPortNum);
   if (rtspServer == NULL) {
     if (rtspServerPortNum != 554) {
@@ -209,7 +240,8 @@ int main(int argc, char** argv) {
     exit(1);
   }
 
-  // Create a proxy for each "rtsp://" URL specified on the command line:
+  // Register a proxy for each "rtsp://" URL specified on the command line:
+  char* proxyStreamURLPrefix = rtspServer->rtspURLPrefix();
   for (i = 1; i < argc; ++i) {
     char const* proxiedStreamURL = argv[i];
     char streamName[30];
@@ -218,18 +250,17 @@ int main(int argc, char** argv) {
     } else {
       sprintf(streamName, "proxyStream-%d", i); // there's more than one stream; distinguish them by name
     }
-    ServerMediaSession* sms
-      = ProxyServerMediaSession::createNew(*env, rtspServer,
-					   proxiedStreamURL, streamName,
-					   username, password, tunnelOverHTTPPortNum, verbosityLevel);
-    rtspServer->addServerMediaSession(sms);
+    rtspServer->addProxiedStream(streamName, proxiedStreamURL);
 
-    char* proxyStreamURL = rtspServer->rtspURL(sms);
     *env << "RTSP stream, proxying the stream \"" << proxiedStreamURL << "\"\n";
-    *env << "\tPlay this stream using the URL: " << proxyStreamURL << "\n";
-    delete[] proxyStreamURL;
+    *env << "\tPlay this stream using the URL: " << proxyStreamURLPrefix << streamName << "\n";
   }
+  delete[] proxyStreamURLPrefix;
 
+  if (idleTimeoutSeconds > 0) {
+    *env << "(We connect to each back-end stream only on demand, and disconnect from it after "
+	 << idleTimeoutSeconds << " idle seconds)\n";
+  }
   if (proxyREGISTERRequests) {
     *env << "(We handle incoming \"REGISTER\" requests on port " << rtspServerPortNum << ")\n";
   }
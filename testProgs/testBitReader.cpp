@@ -0,0 +1,223 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2025, Live Networks, Inc.  All rights reserved
+// A microbenchmark that compares "BitVector" and "BitReader", by repeatedly parsing a H.264 SPS (including its VUI and
+// HRD parameters) - in the same way as "H264or5VideoStreamFramer" - with each.  It also checks that the two give the
+// same results.
+// main program
+
+#include "BitVector.hh"
+#include "GroupsockHelper.hh" // for "gettimeofday()"
+#include <stdio.h>
+#include <stdlib.h>
+
+// A typical SPS (with its 'emulation prevention' bytes already removed) for 1080p25 High Profile (level 4.0) video,
+// with VUI (aspect ratio, colour description, timing, NAL HRD, and bitstream restriction) parameters:
+static unsigned char const sps[] = {
+  0x67, 0x64, 0x00, 0x28, 0xac, 0xd9, 0x40, 0x78, 0x02, 0x27, 0xe5, 0xc0, 0x5a, 0x80, 0x80, 0x80,
+  0xa0, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x06, 0x5d, 0x18, 0x00, 0x4e, 0x20, 0x00, 0x27, 0x10,
+  0x5e, 0xf7, 0xc1, 0xf1, 0x83, 0x19, 0x60
+};
+
+// The fields that we extract from the SPS:
+struct SPSFields {
+  unsigned profile_idc, level_idc;
+  unsigned width, height; // in pixels (before cropping)
+  unsigned num_units_in_tick, time_scale;
+  unsigned cpb_removal_delay_length_minus1, dpb_output_delay_length_minus1;
+  Boolean pic_struct_present_flag;
+  unsigned checksum; // of every value that we read
+};
+
+// The parsing code is the same for each class, so we define it (for each class) using a macro:
+#define DEFINE_SPS_PARSER(parserName, BitClass) \
+static void parserName##_hrd(BitClass& bv, SPSFields& f) { \
+  unsigned cpb_cnt_minus1 = bv.get_expGolomb(); f.checksum += cpb_cnt_minus1; \
+  f.checksum += bv.getBits(4); /* bit_rate_scale */ \
+  f.checksum += bv.getBits(4); /* cpb_size_scale */ \
+  for (unsigned i = 0; i <= cpb_cnt_minus1; ++i) { \
+    f.checksum += bv.get_expGolomb(); /* bit_rate_value_minus1 */ \
+    f.checksum += bv.get_expGolomb(); /* cpb_size_value_minus1 */ \
+    f.checksum += bv.get1Bit(); /* cbr_flag */ \
+  } \
+  f.checksum += bv.getBits(5); /* initial_cpb_removal_delay_length_minus1 */ \
+  f.cpb_removal_delay_length_minus1 = bv.getBits(5); \
+  f.dpb_output_delay_length_minus1 = bv.getBits(5); \
+  f.checksum += bv.getBits(5); /* time_offset_length */ \
+} \
+\
+static void parserName(unsigned char* data, unsigned dataSize, SPSFields& f) { \
+  BitClass bv(data, 0, 8*dataSize); \
+  f.checksum = 0; \
+  f.num_units_in_tick = f.time_scale = 0; \
+  f.cpb_removal_delay_length_minus1 = f.dpb_output_delay_length_minus1 = 0; \
+  f.pic_struct_present_flag = False; \
+\
+  bv.skipBits(8); /* forbidden_zero_bit; nal_ref_idc; nal_unit_type */ \
+  f.profile_idc = bv.getBits(8); \
+  f.checksum += bv.getBits(8); /* constraint_setN_flag */ \
+  f.level_idc = bv.getBits(8); \
+  f.checksum += bv.get_expGolomb(); /* seq_parameter_set_id */ \
+  if (f.profile_idc == 100 || f.profile_idc == 110 || f.profile_idc == 122 || f.profile_idc == 244) { \
+    unsigned chroma_format_idc = bv.get_expGolomb(); f.checksum += chroma_format_idc; \
+    if (chroma_format_idc == 3) f.checksum += bv.get1Bit(); /* separate_colour_plane_flag */ \
+    f.checksum += bv.get_expGolomb(); /* bit_depth_luma_minus8 */ \
+    f.checksum += bv.get_expGolomb(); /* bit_depth_chroma_minus8 */ \
+    bv.skipBits(1); /* qpprime_y_zero_transform_bypass_flag */ \
+    if (bv.get1BitBoolean()) { /* seq_scaling_matrix_present_flag */ \
+      for (int i = 0; i < ((chroma_format_idc != 3) ? 8 : 12); ++i) { \
+	if (bv.get1BitBoolean()) { /* seq_scaling_list_present_flag */ \
+	  unsigned sizeOfScalingList = i < 6 ? 16 : 64; \
+	  unsigned lastScale = 8, nextScale = 8; \
+	  for (unsigned j = 0; j < sizeOfScalingList; ++j) { \
+	    if (nextScale != 0) nextScale = (lastScale + bv.get_expGolombSigned() + 256) % 256; \
+	    lastScale = (nextScale == 0) ? lastScale : nextScale; \
+	  } \
+	  f.checksum += lastScale; \
+	} \
+      } \
+    } \
+  } \
+  f.checksum += bv.get_expGolomb(); /* log2_max_frame_num_minus4 */ \
+  unsigned pic_order_cnt_type = bv.get_expGolomb(); f.checksum += pic_order_cnt_type; \
+  if (pic_order_cnt_type == 0) { \
+    f.checksum += bv.get_expGolomb(); /* log2_max_pic_order_cnt_lsb_minus4 */ \
+  } else if (pic_order_cnt_type == 1) { \
+    bv.skipBits(1); /* delta_pic_order_always_zero_flag */ \
+    f.checksum += bv.get_expGolombSigned(); /* offset_for_non_ref_pic */ \
+    f.checksum += bv.get_expGolombSigned(); /* offset_for_top_to_bottom_field */ \
+    unsigned num_ref_frames_in_pic_order_cnt_cycle = bv.get_expGolomb(); \
+    for (unsigned i = 0; i < num_ref_frames_in_pic_order_cnt_cycle; ++i) { \
+      f.checksum += bv.get_expGolombSigned(); /* offset_for_ref_frame[i] */ \
+    } \
+  } \
+  f.checksum += bv.get_expGolomb(); /* max_num_ref_frames */ \
+  f.checksum += bv.get1Bit(); /* gaps_in_frame_num_value_allowed_flag */ \
+  f.width = 16*(bv.get_expGolomb() + 1); /* pic_width_in_mbs_minus1 */ \
+  unsigned pic_height_in_map_units_minus1 = bv.get_expGolomb(); \
+  Boolean frame_mbs_only_flag = bv.get1BitBoolean(); \
+  f.height = 16*(pic_height_in_map_units_minus1 + 1)*(frame_mbs_only_flag ? 1 : 2); \
+  if (!frame_mbs_only_flag) bv.skipBits(1); /* mb_adaptive_frame_field_flag */ \
+  bv.skipBits(1); /* direct_8x8_inference_flag */ \
+  if (bv.get1BitBoolean()) { /* frame_cropping_flag */ \
+    for (unsigned i = 0; i < 4; ++i) f.checksum += bv.get_expGolomb(); /* frame_crop_*_offset */ \
+  } \
+  if (!bv.get1BitBoolean()) return; /* vui_parameters_present_flag */ \
+\
+  if (bv.get1BitBoolean()) { /* aspect_ratio_info_present_flag */ \
+    unsigned aspect_ratio_idc = bv.getBits(8); f.checksum += aspect_ratio_idc; \
+    if (aspect_ratio_idc == 255/*Extended_SAR*/) bv.skipBits(32); /* sar_width; sar_height */ \
+  } \
+  if (bv.get1BitBoolean()) bv.skipBits(1); /* overscan_info_present_flag; overscan_appropriate_flag */ \
+  if (bv.get1BitBoolean()) { /* video_signal_type_present_flag */ \
+    bv.skipBits(4); /* video_format; video_full_range_flag */ \
+    if (bv.get1BitBoolean()) bv.skipBits(24); /* colour_description_present_flag; colour_primaries; etc. */ \
+  } \
+  if (bv.get1BitBoolean()) { /* chroma_loc_info_present_flag */ \
+    f.checksum += bv.get_expGolomb(); /* chroma_sample_loc_type_top_field */ \
+    f.checksum += bv.get_expGolomb(); /* chroma_sample_loc_type_bottom_field */ \
+  } \
+  if (bv.get1BitBoolean()) { /* timing_info_present_flag */ \
+    f.num_units_in_tick = bv.getBits(32); \
+    f.time_scale = bv.getBits(32); \
+    f.checksum += bv.get1Bit(); /* fixed_frame_rate_flag */ \
+  } \
+  Boolean nal_hrd_parameters_present_flag = bv.get1BitBoolean(); \
+  if (nal_hrd_parameters_present_flag) parserName##_hrd(bv, f); \
+  Boolean vcl_hrd_parameters_present_flag = bv.get1BitBoolean(); \
+  if (vcl_hrd_parameters_present_flag) parserName##_hrd(bv, f); \
+  if (nal_hrd_parameters_present_flag || vcl_hrd_parameters_present_flag) bv.skipBits(1); /* low_delay_hrd_flag */ \
+  f.pic_struct_present_flag = bv.get1BitBoolean(); \
+}
+
+DEFINE_SPS_PARSER(parseSPSUsingBitVector, BitVector)
+DEFINE_SPS_PARSER(parseSPSUsingBitReader, BitReader)
+
+typedef void SPSParser(unsigned char* data, unsigned dataSize, SPSFields& f);
+
+static double timeParser(SPSParser* parser, unsigned char* data, unsigned dataSize, unsigned numIterations,
+			 SPSFields& fields, unsigned& sum) {
+  struct timeval startTime, endTime;
+  gettimeofday(&startTime, NULL);
+  for (unsigned i = 0; i < numIterations; ++i) {
+    (*parser)(data, dataSize, fields);
+    sum += fields.checksum; // so that the compiler can't optimize away the parsing
+  }
+  gettimeofday(&endTime, NULL);
+
+  double uSeconds = (endTime.tv_sec - startTime.tv_sec)*1000000.0 + (endTime.tv_usec - startTime.tv_usec);
+  return 1000.0*uSeconds/numIterations; // nanoseconds per parse
+}
+
+static void printFields(char const* name, SPSFields const& f) {
+  fprintf(stderr, "%s: profile_idc %u, level_idc %u, %ux%u, num_units_in_tick %u, time_scale %u, "
+	  "cpb_removal_delay_length_minus1 %u, dpb_output_delay_length_minus1 %u, pic_struct_present_flag %d, "
+	  "checksum %u\n",
+	  name, f.profile_idc, f.level_idc, f.width, f.height, f.num_units_in_tick, f.time_scale,
+	  f.cpb_removal_delay_length_minus1, f.dpb_output_delay_length_minus1, f.pic_struct_present_flag, f.checksum);
+}
+
+int main(int argc, char** argv) {
+  unsigned numIterations = 1000000;
+  unsigned numRounds = 5;
+  if (argc > 1 && (sscanf(argv[1], "%u", &numIterations) != 1 || numIterations == 0)) {
+    fprintf(stderr, "Usage: %s [<num-iterations-per-round> [<num-rounds>]]\n", argv[0]);
+    exit(1);
+  }
+  if (argc > 2 && (sscanf(argv[2], "%u", &numRounds) != 1 || numRounds == 0)) numRounds = 5;
+
+  // Make a (non-const) copy of the SPS, because "BitVector" takes a non-const pointer:
+  unsigned char data[sizeof sps];
+  for (unsigned i = 0; i < sizeof sps; ++i) data[i] = sps[i];
+
+  // First, check that the two classes give the same results:
+  SPSFields bitVectorFields, bitReaderFields;
+  parseSPSUsingBitVector(data, sizeof data, bitVectorFields);
+  parseSPSUsingBitReader(data, sizeof data, bitReaderFields);
+  printFields("BitVector", bitVectorFields);
+  printFields("BitReader", bitReaderFields);
+  if (bitVectorFields.checksum != bitReaderFields.checksum
+      || bitVectorFields.width != bitReaderFields.width || bitVectorFields.height != bitReaderFields.height
+      || bitVectorFields.num_units_in_tick != bitReaderFields.num_units_in_tick
+      || bitVectorFields.time_scale != bitReaderFields.time_scale
+      || bitVectorFields.cpb_removal_delay_length_minus1 != bitReaderFields.cpb_removal_delay_length_minus1
+      || bitVectorFields.dpb_output_delay_length_minus1 != bitReaderFields.dpb_output_delay_length_minus1
+      || bitVectorFields.pic_struct_present_flag != bitReaderFields.pic_struct_present_flag) {
+    fprintf(stderr, "MISMATCH: \"BitVector\" and \"BitReader\" parsed the SPS differently!\n");
+    exit(1);
+  }
+
+  // Then, time each class (alternately, in several rounds, to reduce the effect of other activity on the machine):
+  fprintf(stderr, "Parsing the SPS %u times per round (ns per parse):\n", numIterations);
+  unsigned sum = 0;
+  double bestBitVectorTime = 0.0, bestBitReaderTime = 0.0;
+  for (unsigned round = 0; round < numRounds; ++round) {
+    double bitVectorTime
+      = timeParser(parseSPSUsingBitVector, data, sizeof data, numIterations, bitVectorFields, sum);
+    double bitReaderTime
+      = timeParser(parseSPSUsingBitReader, data, sizeof data, numIterations, bitReaderFields, sum);
+    fprintf(stderr, "\tround %u: BitVector %.1f, BitReader %.1f\n", round+1, bitVectorTime, bitReaderTime);
+
+    if (round == 0 || bitVectorTime < bestBitVectorTime) bestBitVectorTime = bitVectorTime;
+    if (round == 0 || bitReaderTime < bestBitReaderTime) bestBitReaderTime = bitReaderTime;
+  }
+  fprintf(stderr, "Best: BitVector %.1f ns; BitReader %.1f ns (%.2fx as fast)\n",
+	  bestBitVectorTime, bestBitReaderTime,
+	  bestBitReaderTime > 0.0 ? bestBitVectorTime/bestBitReaderTime : 0.0);
+  fprintf(stderr, "(checksum: %u)\n", sum);
+
+  return 0;
+}